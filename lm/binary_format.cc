@@ -220,6 +220,9 @@ uint8_t *SetupBinary(const Config &config, const Parameters &params, uint64_t me
     UTIL_THROW(FormatLoadException, "Binary file has size " << file_size << " but the headers say it should be at least " << total_map);
 
   util::MapRead(config.load_method, backing.file.get(), 0, total_map, backing.search);
+  // Lookups hit pages all over the file.  Read ahead would only evict pages
+  // that this and other processes mapping the same binary still need.
+  if (config.load_method == util::LAZY) util::AdviseRandom(backing.search.get(), total_map);
 
   if (config.enumerate_vocab && !params.fixed.has_vocabulary)
     UTIL_THROW(FormatLoadException, "The decoder requested all the vocabulary strings, but this binary file does not have them.  You may need to rebuild the binary file with an updated version of build_binary.");
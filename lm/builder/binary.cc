@@ -0,0 +1,114 @@
+#include "lm/builder/binary.hh"
+
+#include "lm/builder/ngram_stream.hh"
+#include "lm/builder/print.hh"
+#include "lm/model.hh"
+#include "lm/ngram_source.hh"
+#include "util/exception.hh"
+#include "util/stream/timer.hh"
+
+#include <algorithm>
+
+#include <boost/scoped_ptr.hpp>
+
+namespace lm { namespace builder {
+
+namespace {
+
+// The final streams, read order by order.  An n-gram is not passed on until
+// the next is asked for, so its words stay put while the model reads them.
+class StreamSource : public NGramSource {
+  public:
+    StreamSource(const VocabReconstitute &vocab, const std::vector<uint64_t> &counts, const ChainPositions &positions)
+      : vocab_(vocab), counts_(counts), positions_(positions), order_(0), started_(false) {}
+
+    void ReadCounts(std::vector<uint64_t> &counts) {
+      counts = counts_;
+    }
+
+    void BeginOrder(unsigned int n) {
+      FinishOrder();
+      UTIL_THROW_IF(n != order_ + 1 || n > positions_.size(), util::Exception, "Asked for " << n << "-grams after " << order_ << "-grams of a model with order " << positions_.size());
+      order_ = n;
+      stream_.reset(new NGramStream(positions_[n - 1]));
+      started_ = false;
+    }
+
+    const WordIndex *Next(float &prob, float &backoff) {
+      NGramStream &stream = *stream_;
+      if (started_) ++stream;
+      started_ = true;
+      UTIL_THROW_IF(!stream, util::Exception, "Fewer " << order_ << "-grams than the " << counts_[order_ - 1] << " counted");
+      const ProbBackoff &value = stream->Value().complete;
+      // Correcting for numerical precision issues, as PrintARPA does.
+      prob = std::min(0.0f, value.prob);
+      backoff = value.backoff;
+      return stream->begin();
+    }
+
+    void End() {
+      FinishOrder();
+      UTIL_THROW_IF(order_ != positions_.size(), util::Exception, "Only " << order_ << " of " << positions_.size() << " orders were read");
+    }
+
+    StringPiece Word(WordIndex id) const {
+      return vocab_.LookupPiece(id);
+    }
+
+  private:
+    // The model reads as many n-grams as were counted.  Step past the last so
+    // the chain ends.
+    void FinishOrder() {
+      if (!order_) return;
+      if (started_) ++*stream_;
+      UTIL_THROW_IF(*stream_, util::Exception, "More " << order_ << "-grams than the " << counts_[order_ - 1] << " counted");
+    }
+
+    const VocabReconstitute &vocab_;
+    const std::vector<uint64_t> &counts_;
+    const ChainPositions &positions_;
+
+    unsigned int order_;
+    boost::scoped_ptr<NGramStream> stream_;
+    bool started_;
+};
+
+} // namespace
+
+void CheckBinaryConfig(const BinaryConfig &config) {
+  UTIL_THROW_IF(config.type != "probing" && config.type != "trie", util::Exception, "Binary type should be probing or trie, not " << config.type);
+  UTIL_THROW_IF(config.type == "probing" && (config.quantize || config.bhiksha), util::Exception, "Quantization and pointer compression are only supported by the trie");
+}
+
+WriteBinary::WriteBinary(const VocabReconstitute &vocab, const std::vector<uint64_t> &counts, const BinaryConfig &config, const std::string &temp_prefix)
+  : vocab_(vocab), counts_(counts), config_(config), temp_prefix_(temp_prefix) {
+  CheckBinaryConfig(config_);
+}
+
+void WriteBinary::Run(const ChainPositions &positions) {
+  UTIL_TIMER("(%w s) Wrote binary file\n");
+  // Set here because the pipeline runs a copy of this object.
+  lm::ngram::Config &model = config_.model;
+  model.write_mmap = config_.file.c_str();
+  if (!model.temporary_directory_prefix) model.temporary_directory_prefix = temp_prefix_.c_str();
+  model.write_method = (config_.type == "probing") ? lm::ngram::Config::WRITE_AFTER : lm::ngram::Config::WRITE_MMAP;
+
+  StreamSource source(vocab_, counts_, positions);
+  if (config_.type == "probing") {
+    lm::ngram::ProbingModel(source, model);
+  } else if (config_.quantize) {
+    if (config_.bhiksha) {
+      lm::ngram::QuantArrayTrieModel(source, model);
+    } else {
+      lm::ngram::QuantTrieModel(source, model);
+    }
+  } else {
+    if (config_.bhiksha) {
+      lm::ngram::ArrayTrieModel(source, model);
+    } else {
+      lm::ngram::TrieModel(source, model);
+    }
+  }
+}
+
+}} // namespaces
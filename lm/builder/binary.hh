@@ -0,0 +1,60 @@
+#ifndef LM_BUILDER_BINARY__
+#define LM_BUILDER_BINARY__
+
+#include "lm/builder/multi_stream.hh"
+#include "lm/config.hh"
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace lm { namespace builder {
+
+class VocabReconstitute;
+
+struct BinaryConfig {
+  BinaryConfig() : type("probing"), quantize(false), bhiksha(false) {}
+
+  // Where to write the binary.  The ARPA file is written instead if empty.
+  std::string file;
+
+  // probing or trie, as in build_binary.
+  std::string type;
+
+  // Trie only: use model.prob_bits and model.backoff_bits.
+  bool quantize;
+  // Trie only: use model.pointer_bhiksha_bits.
+  bool bhiksha;
+
+  // Passed to the model.  write_mmap, write_method, and
+  // temporary_directory_prefix are filled in by WriteBinary.
+  lm::ngram::Config model;
+};
+
+// Throws if config asks for something build_binary would not build.
+void CheckBinaryConfig(const BinaryConfig &config);
+
+// Builds a binary model from the final n-gram streams, where PrintARPA would
+// print them.  The model reads the streams as it would read the ARPA file:
+// the probing tables are filled, or the trie's n-grams sorted, as they go by.
+// Nothing is formatted or parsed.  The result is the same as build_binary's.
+class WriteBinary {
+  public:
+    // The trie sorts under temp_prefix.
+    WriteBinary(const VocabReconstitute &vocab, const std::vector<uint64_t> &counts, const BinaryConfig &config, const std::string &temp_prefix);
+
+    void Run(const ChainPositions &positions);
+
+  private:
+    const VocabReconstitute &vocab_;
+
+    std::vector<uint64_t> counts_;
+
+    BinaryConfig config_;
+
+    std::string temp_prefix_;
+};
+
+}} // namespaces
+#endif // LM_BUILDER_BINARY__
@@ -9,6 +9,9 @@
 #include "util/stream/chain.hh"
 #include "util/stream/stream.hh"
 
+#include <map>
+#include <vector>
+
 #define BOOST_TEST_MODULE CorpusCountTest
 #include <boost/test/unit_test.hpp>
 
@@ -73,4 +76,47 @@ BOOST_AUTO_TEST_CASE(Short) {
   BOOST_CHECK_EQUAL(sizeof(v) / sizeof(const char*), type_count);
 }
 
+typedef std::map<std::vector<WordIndex>, uint64_t> CountMap;
+
+void CountShard(const char *input, std::size_t input_size, const Shard &shard, CountMap &out) {
+  util::scoped_fd input_file(util::MakeTemp("corpus_count_test_temp"));
+  util::WriteOrThrow(input_file.get(), input, input_size);
+  util::FilePiece input_piece(input_file.release(), "temp file");
+
+  util::stream::ChainConfig config;
+  config.entry_size = NGram::TotalSize(3);
+  config.total_memory = config.entry_size * 20;
+  config.block_count = 2;
+
+  util::scoped_fd vocab(util::MakeTemp("corpus_count_test_vocab"));
+
+  util::stream::Chain chain(config);
+  NGramStream stream;
+  uint64_t token_count;
+  WordIndex type_count = 10;
+  CorpusCount counter(input_piece, vocab.get(), token_count, type_count, chain.BlockSize() / chain.EntrySize(), shard);
+  chain >> boost::ref(counter) >> stream >> util::stream::kRecycle;
+  for (; stream; ++stream) {
+    out[std::vector<WordIndex>(stream->begin(), stream->end())] += stream->Count();
+  }
+  BOOST_CHECK_EQUAL(11, type_count);
+}
+
+BOOST_AUTO_TEST_CASE(Sharded) {
+  const char input[] = "looking on a little more loin\non a little more loin\non foo little more loin\nbar\n\n";
+  CountMap all;
+  CountShard(input, sizeof(input) - 1, Shard(), all);
+
+  CountMap merged;
+  for (unsigned int i = 0; i < 3; ++i) {
+    CountMap piece;
+    CountShard(input, sizeof(input) - 1, Shard(i, 3), piece);
+    for (CountMap::const_iterator j = piece.begin(); j != piece.end(); ++j) {
+      // Shards are disjoint.
+      BOOST_CHECK(merged.insert(*j).second);
+    }
+  }
+  BOOST_CHECK(all == merged);
+}
+
 }}} // namespaces
@@ -4,6 +4,8 @@
 #include "util/usage.hh"
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <boost/program_options.hpp>
 #include <boost/version.hpp>
@@ -32,6 +34,9 @@ int main(int argc, char *argv[]) {
     namespace po = boost::program_options;
     po::options_description options("Language model building options");
     lm::builder::PipelineConfig pipeline;
+    std::vector<std::string> merge_shards;
+    lm::builder::BinaryConfig &binary = pipeline.binary;
+    unsigned int quantize_bits, backoff_bits, bhiksha_bits;
 
     options.add_options()
       ("order,o", po::value<std::size_t>(&pipeline.order)
@@ -47,7 +52,15 @@ int main(int argc, char *argv[]) {
       ("vocab_estimate", po::value<lm::WordIndex>(&pipeline.vocab_estimate)->default_value(1000000), "Assume this vocabulary size for purposes of calculating memory in step 1 (corpus count) and pre-sizing the hash table")
       ("block_count", po::value<std::size_t>(&pipeline.block_count)->default_value(2), "Block count (per order)")
       ("vocab_file", po::value<std::string>(&pipeline.vocab_file)->default_value(""), "Location to write vocabulary file")
-      ("verbose_header", po::bool_switch(&pipeline.verbose_header), "Add a verbose header to the ARPA file that includes information such as token count, smoothing type, etc.");
+      ("verbose_header", po::bool_switch(&pipeline.verbose_header), "Add a verbose header to the ARPA file that includes information such as token count, smoothing type, etc.")
+      ("shard_count", po::value<unsigned int>(&pipeline.shard.count)->default_value(1), "Split counting into this many shards by hash of context.  With more than one, only count shard --shard_index and write its counts to stdout instead of an ARPA file")
+      ("shard_index", po::value<unsigned int>(&pipeline.shard.index)->default_value(0), "Which shard to count, from 0")
+      ("merge_shards", po::value<std::vector<std::string> >(&merge_shards)->multitoken(), "Instead of reading a corpus from stdin, merge the counts written by each shard and finish building the model")
+      ("binary", po::value<std::string>(&binary.file), "Write a KenLM binary file here instead of an ARPA file to stdout")
+      ("binary_type", po::value<std::string>(&binary.type)->default_value("probing"), "Binary data structure: probing or trie")
+      ("quantize", po::value<unsigned int>(&quantize_bits), "Trie: quantize probabilities to this many bits")
+      ("backoff_bits", po::value<unsigned int>(&backoff_bits), "Trie: quantize backoffs to this many bits (default: --quantize)")
+      ("bhiksha", po::value<unsigned int>(&bhiksha_bits), "Trie: compress pointers with an array of offsets encoding at most this many bits");
     if (argc == 1) {
       std::cerr << 
         "Builds unpruned language models with modified Kneser-Ney smoothing.\n\n"
@@ -65,7 +78,13 @@ int main(int argc, char *argv[]) {
         "setting the temporary file location (-T) and sorting memory (-S) is recommended.\n\n"
         "Memory sizes are specified like GNU sort: a number followed by a unit character.\n"
         "Valid units are \% for percentage of memory (supported platforms only) and (in\n"
-        "increasing powers of 1024): b, K, M, G, T, P, E, Z, Y.  Default is K (*1024).\n\n";
+        "increasing powers of 1024): b, K, M, G, T, P, E, Z, Y.  Default is K (*1024).\n\n"
+        "To count a large corpus in pieces, run once per shard with the same corpus:\n"
+        "  lmplz -o 5 --shard_count 4 --shard_index 0 <text >shard0\n"
+        "then build the model from all of them:\n"
+        "  lmplz -o 5 --merge_shards shard0 shard1 shard2 shard3 >text.arpa\n\n"
+        "With --binary, the model is built from the final n-grams and written as a\n"
+        "KenLM binary file, the same as build_binary would write, without ARPA text.\n\n";
       std::cerr << options << std::endl;
       return 1;
     }
@@ -83,6 +102,25 @@ int main(int argc, char *argv[]) {
 
     util::NormalizeTempPrefix(pipeline.sort.temp_prefix);
 
+    if ((vm.count("quantize") && quantize_bits > 25) || (vm.count("backoff_bits") && backoff_bits > 25) || (vm.count("bhiksha") && bhiksha_bits > 255)) {
+      std::cerr << "Quantization is limited to 25 bits and --bhiksha to 255" << std::endl;
+      return 1;
+    }
+    if (vm.count("quantize")) {
+      binary.quantize = true;
+      binary.model.prob_bits = quantize_bits;
+      binary.model.backoff_bits = vm.count("backoff_bits") ? backoff_bits : quantize_bits;
+    } else if (vm.count("backoff_bits")) {
+      std::cerr << "--backoff_bits requires --quantize" << std::endl;
+      return 1;
+    }
+    if (vm.count("bhiksha")) {
+      binary.bhiksha = true;
+      binary.model.pointer_bhiksha_bits = bhiksha_bits;
+    }
+    // The pipeline reports its own progress.
+    binary.model.show_progress = false;
+
     lm::builder::InitialProbabilitiesConfig &initial = pipeline.initial_probs;
     // TODO: evaluate options for these.  
     initial.adder_in.total_memory = 32768;
@@ -91,9 +129,16 @@ int main(int argc, char *argv[]) {
     initial.adder_out.block_count = 2;
     pipeline.read_backoffs = initial.adder_out;
 
-    // Read from stdin
     try {
-      lm::builder::Pipeline(pipeline, 0, 1);
+      if (pipeline.shard.count > 1 && merge_shards.empty()) {
+        // Read from stdin
+        lm::builder::CountShard(pipeline, 0, 1);
+      } else if (!merge_shards.empty()) {
+        lm::builder::Pipeline(pipeline, merge_shards, 1);
+      } else {
+        // Read from stdin
+        lm::builder::Pipeline(pipeline, 0, 1);
+      }
     } catch (const util::MallocException &e) {
       std::cerr << e.what() << std::endl;
       std::cerr << "Try rerunning with a more conservative -S setting than " << vm["memory"].as<std::string>() << std::endl;
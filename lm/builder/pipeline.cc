@@ -1,22 +1,27 @@
 #include "lm/builder/pipeline.hh"
 
 #include "lm/builder/adjust_counts.hh"
+#include "lm/builder/binary.hh"
 #include "lm/builder/corpus_count.hh"
 #include "lm/builder/initial_probabilities.hh"
 #include "lm/builder/interpolate.hh"
 #include "lm/builder/print.hh"
+#include "lm/builder/shard.hh"
 #include "lm/builder/sort.hh"
 
 #include "lm/sizes.hh"
 
 #include "util/exception.hh"
 #include "util/file.hh"
+#include "util/scoped.hh"
 #include "util/stream/io.hh"
 
 #include <algorithm>
 #include <iostream>
 #include <vector>
 
+#include <boost/scoped_array.hpp>
+
 namespace lm { namespace builder {
 
 namespace {
@@ -203,7 +208,9 @@ class Master {
     FixedArray<util::stream::FileBuffer> files_;
 };
 
-void CountText(int text_file /* input */, int vocab_file /* output */, Master &master, uint64_t &token_count, std::string &text_file_name) {
+// If shard_out is not -1, the sorted counts are written there as a shard
+// file instead of being prepared for adjusted counts.
+void CountText(int text_file /* input */, int vocab_file /* output */, Master &master, uint64_t &token_count, std::string &text_file_name, int shard_out = -1) {
   const PipelineConfig &config = master.Config();
   std::cerr << "=== 1/5 Counting and sorting n-grams ===" << std::endl;
 
@@ -221,15 +228,52 @@ void CountText(int text_file /* input */, int vocab_file /* output */, Master &m
   WordIndex type_count = config.vocab_estimate;
   util::FilePiece text(text_file, NULL, &std::cerr);
   text_file_name = text.FileName();
-  CorpusCount counter(text, vocab_file, token_count, type_count, chain.BlockSize() / chain.EntrySize());
+  CorpusCount counter(text, vocab_file, token_count, type_count, chain.BlockSize() / chain.EntrySize(), config.shard);
   chain >> boost::ref(counter);
 
   util::stream::Sort<SuffixOrder, AddCombiner> sorter(chain, config.sort, SuffixOrder(config.order), AddCombiner());
   chain.Wait(true);
+  if (shard_out != -1) {
+    std::cerr << "=== Writing counts for shard " << config.shard.index << " of " << config.shard.count << " ===" << std::endl;
+    util::scoped_fd sorted(sorter.StealCompleted());
+    WriteShard(config.order, token_count, type_count, vocab_file, sorted.get(), shard_out);
+    return;
+  }
   std::cerr << "=== 2/5 Calculating and sorting adjusted counts ===" << std::endl;
   master.InitForAdjust(sorter, type_count);
 }
 
+// Each shard file is sorted, but they have to be merged.  Since the shards are
+// disjoint, AddCombiner never fires across shards; it is only there to match
+// the sort done by CountText.
+void CountShards(const std::vector<std::string> &shard_files, int vocab_file /* output */, Master &master, uint64_t &token_count) {
+  const PipelineConfig &config = master.Config();
+  std::cerr << "=== 1/5 Merging counts from " << shard_files.size() << " shards ===" << std::endl;
+  UTIL_THROW_IF(shard_files.empty(), util::Exception, "No shard files to merge.");
+
+  boost::scoped_array<util::scoped_fd> owners(new util::scoped_fd[shard_files.size()]);
+  std::vector<int> fds;
+  uint64_t type_count = 0;
+  for (std::size_t i = 0; i < shard_files.size(); ++i) {
+    owners[i].reset(util::OpenReadOrThrow(shard_files[i].c_str()));
+    fds.push_back(owners[i].get());
+    ShardHeader header(ReadShardHeader(fds.back(), i ? -1 : vocab_file));
+    UTIL_THROW_IF(header.order != config.order, ShardFormatException, "Shard " << shard_files[i] << " has order " << header.order << " but order " << config.order << " was requested.");
+    if (!i) {
+      token_count = header.token_count;
+      type_count = header.type_count;
+    }
+    UTIL_THROW_IF(header.token_count != token_count || header.type_count != type_count, ShardFormatException, "Shard " << shard_files[i] << " was counted from a different corpus than " << shard_files[0] << ".");
+  }
+
+  util::stream::Chain chain(util::stream::ChainConfig(NGram::TotalSize(config.order), config.block_count, config.TotalMemory()));
+  chain >> ReadShards(fds);
+  util::stream::Sort<SuffixOrder, AddCombiner> sorter(chain, config.sort, SuffixOrder(config.order), AddCombiner());
+  chain.Wait(true);
+  std::cerr << "=== 2/5 Calculating and sorting adjusted counts ===" << std::endl;
+  master.InitForAdjust(sorter, static_cast<WordIndex>(type_count));
+}
+
 void InitialProbabilities(const std::vector<uint64_t> &counts, const std::vector<Discount> &discounts, Master &master, Sorts<SuffixOrder> &primary, FixedArray<util::stream::FileBuffer> &gammas) {
   const PipelineConfig &config = master.Config();
   Chains second(config.order);
@@ -273,10 +317,8 @@ void InterpolateProbabilities(const std::vector<uint64_t> &counts, Master &maste
   master.BufferFinal(counts);
 }
 
-} // namespace
-
-void Pipeline(PipelineConfig config, int text_file, int out_arpa) {
-  // Some fail-fast sanity checks.
+// Some fail-fast sanity checks.
+void CheckConfig(PipelineConfig &config) {
   if (config.sort.buffer_size * 4 > config.TotalMemory()) {
     config.sort.buffer_size = config.TotalMemory() / 4;
     std::cerr << "Warning: changing sort block size to " << config.sort.buffer_size << " bytes due to low total memory." << std::endl;
@@ -288,17 +330,12 @@ void Pipeline(PipelineConfig config, int text_file, int out_arpa) {
   UTIL_THROW_IF(config.sort.buffer_size < config.minimum_block, util::Exception, "Sort block size " << config.sort.buffer_size << " is below the minimum block size " << config.minimum_block << ".");
   UTIL_THROW_IF(config.TotalMemory() < config.minimum_block * config.order * config.block_count, util::Exception,
       "Not enough memory to fit " << (config.order * config.block_count) << " blocks with minimum size " << config.minimum_block << ".  Increase memory to " << (config.minimum_block * config.order * config.block_count) << " bytes or decrease the minimum block size.");
+  if (!config.binary.file.empty()) CheckBinaryConfig(config.binary);
+}
 
-  UTIL_TIMER("(%w s) Total wall time elapsed\n");
-  Master master(config);
-
-  util::scoped_fd vocab_file(config.vocab_file.empty() ? 
-      util::MakeTemp(config.TempPrefix()) : 
-      util::CreateOrThrow(config.vocab_file.c_str()));
-  uint64_t token_count;
-  std::string text_file_name;
-  CountText(text_file, vocab_file.get(), master, token_count, text_file_name);
-
+// Everything after counting.
+void Estimate(Master &master, int vocab_file, uint64_t token_count, const std::string &text_file_name, int out_arpa) {
+  const PipelineConfig &config = master.Config();
   std::vector<uint64_t> counts;
   std::vector<Discount> discounts;
   master >> AdjustCounts(counts, discounts);
@@ -310,12 +347,65 @@ void Pipeline(PipelineConfig config, int text_file, int out_arpa) {
     InterpolateProbabilities(counts, master, primary, gammas);
   }
 
-  std::cerr << "=== 5/5 Writing ARPA model ===" << std::endl;
-  VocabReconstitute vocab(vocab_file.get());
+  VocabReconstitute vocab(vocab_file);
   UTIL_THROW_IF(vocab.Size() != counts[0], util::Exception, "Vocab words don't match up.  Is there a null byte in the input?");
-  HeaderInfo header_info(text_file_name, token_count);
-  master >> PrintARPA(vocab, counts, (config.verbose_header ? &header_info : NULL), out_arpa) >> util::stream::kRecycle;
+  if (config.binary.file.empty()) {
+    std::cerr << "=== 5/5 Writing ARPA model ===" << std::endl;
+    HeaderInfo header_info(text_file_name, token_count);
+    master >> PrintARPA(vocab, counts, (config.verbose_header ? &header_info : NULL), out_arpa) >> util::stream::kRecycle;
+  } else {
+    std::cerr << "=== 5/5 Writing binary model ===" << std::endl;
+    master >> WriteBinary(vocab, counts, config.binary, config.TempPrefix()) >> util::stream::kRecycle;
+  }
   master.MutableChains().Wait(true);
 }
 
+int OpenVocab(const PipelineConfig &config) {
+  return config.vocab_file.empty() ? 
+      util::MakeTemp(config.TempPrefix()) : 
+      util::CreateOrThrow(config.vocab_file.c_str());
+}
+
+} // namespace
+
+void Pipeline(PipelineConfig config, int text_file, int out_arpa) {
+  CheckConfig(config);
+
+  UTIL_TIMER("(%w s) Total wall time elapsed\n");
+  Master master(config);
+
+  util::scoped_fd vocab_file(OpenVocab(config));
+  uint64_t token_count;
+  std::string text_file_name;
+  CountText(text_file, vocab_file.get(), master, token_count, text_file_name);
+
+  Estimate(master, vocab_file.get(), token_count, text_file_name, out_arpa);
+}
+
+void CountShard(PipelineConfig config, int text_file, int out_shard) {
+  CheckConfig(config);
+  UTIL_THROW_IF(config.shard.index >= config.shard.count, util::Exception, "Shard index " << config.shard.index << " is not below the shard count " << config.shard.count << ".");
+
+  UTIL_TIMER("(%w s) Total wall time elapsed\n");
+  Master master(config);
+
+  util::scoped_fd vocab_file(OpenVocab(config));
+  uint64_t token_count;
+  std::string text_file_name;
+  CountText(text_file, vocab_file.get(), master, token_count, text_file_name, out_shard);
+}
+
+void Pipeline(PipelineConfig config, const std::vector<std::string> &shard_files, int out_arpa) {
+  CheckConfig(config);
+
+  UTIL_TIMER("(%w s) Total wall time elapsed\n");
+  Master master(config);
+
+  util::scoped_fd vocab_file(OpenVocab(config));
+  uint64_t token_count;
+  CountShards(shard_files, vocab_file.get(), master, token_count);
+
+  Estimate(master, vocab_file.get(), token_count, shard_files.front(), out_arpa);
+}
+
 }} // namespaces
@@ -1,13 +1,16 @@
 #ifndef LM_BUILDER_PIPELINE__
 #define LM_BUILDER_PIPELINE__
 
+#include "lm/builder/binary.hh"
 #include "lm/builder/initial_probabilities.hh"
 #include "lm/builder/header_info.hh"
+#include "lm/builder/shard.hh"
 #include "lm/word_index.hh"
 #include "util/stream/config.hh"
 #include "util/file_piece.hh"
 
 #include <string>
+#include <vector>
 #include <cstddef>
 
 namespace lm { namespace builder {
@@ -30,6 +33,12 @@ struct PipelineConfig {
   // Number of blocks to use.  This will be overridden to 1 if everything fits.
   std::size_t block_count;
 
+  // Which part of the n-gram space CountShard counts.
+  Shard shard;
+
+  // If binary.file is set, the model is written there instead of out_arpa.
+  BinaryConfig binary;
+
   const std::string &TempPrefix() const { return sort.temp_prefix; }
   std::size_t TotalMemory() const { return sort.total_memory; }
 };
@@ -37,5 +46,14 @@ struct PipelineConfig {
 // Takes ownership of text_file.
 void Pipeline(PipelineConfig config, int text_file, int out_arpa);
 
+// Count only the n-grams in config.shard and write them to out_shard in the
+// format described in lm/builder/shard.hh.  Shards can be counted by separate
+// processes, each in its own memory.  Takes ownership of text_file.
+void CountShard(PipelineConfig config, int text_file, int out_shard);
+
+// Finish estimating a model from the files written by CountShard, one for
+// each shard.
+void Pipeline(PipelineConfig config, const std::vector<std::string> &shard_files, int out_arpa);
+
 }} // namespaces
 #endif // LM_BUILDER_PIPELINE__
@@ -0,0 +1,85 @@
+#include "lm/builder/shard.hh"
+
+#include "util/file.hh"
+#include "util/scoped.hh"
+#include "util/stream/chain.hh"
+
+#include <algorithm>
+#include <limits>
+
+#include <string.h>
+
+namespace lm { namespace builder {
+
+namespace {
+const char kMagic[8] = {'l', 'm', 's', 'h', 'a', 'r', 'd', '1'};
+
+// Copy the rest of from to to.
+void CopyRest(int from, int to, uint64_t limit) {
+  const std::size_t kBuffer = 1 << 20;
+  util::scoped_malloc buffer(util::MallocOrThrow(kBuffer));
+  while (limit) {
+    std::size_t got = util::ReadOrEOF(from, buffer.get(), static_cast<std::size_t>(std::min<uint64_t>(kBuffer, limit)));
+    if (!got) break;
+    util::WriteOrThrow(to, buffer.get(), got);
+    limit -= got;
+  }
+}
+} // namespace
+
+ShardFormatException::ShardFormatException() throw() {}
+ShardFormatException::~ShardFormatException() throw() {}
+
+void WriteShard(uint64_t order, uint64_t token_count, uint64_t type_count, int vocab, int ngrams, int out) {
+  ShardHeader header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.order = order;
+  header.token_count = token_count;
+  header.type_count = type_count;
+  header.vocab_bytes = util::SizeOrThrow(vocab);
+  util::WriteOrThrow(out, &header, sizeof(ShardHeader));
+  util::SeekOrThrow(vocab, 0);
+  CopyRest(vocab, out, header.vocab_bytes);
+  util::SeekOrThrow(ngrams, 0);
+  CopyRest(ngrams, out, std::numeric_limits<uint64_t>::max());
+}
+
+ShardHeader ReadShardHeader(int fd, int vocab_out) {
+  ShardHeader header;
+  util::ReadOrThrow(fd, &header, sizeof(ShardHeader));
+  UTIL_THROW_IF(memcmp(header.magic, kMagic, sizeof(kMagic)), ShardFormatException, "Not a shard file written by lmplz --shard_count.");
+  if (vocab_out == -1) {
+    util::AdvanceOrThrow(fd, header.vocab_bytes);
+  } else {
+    CopyRest(fd, vocab_out, header.vocab_bytes);
+  }
+  return header;
+}
+
+void ReadShards::Run(const util::stream::ChainPosition &position) {
+  const std::size_t block_size = position.GetChain().BlockSize();
+  const std::size_t entry_size = position.GetChain().EntrySize();
+  util::stream::Link link(position);
+  std::size_t filled = 0;
+  for (std::vector<int>::const_iterator fd = fds_.begin(); fd != fds_.end(); ++fd) {
+    while (true) {
+      std::size_t got = util::ReadOrEOF(*fd, static_cast<uint8_t*>(link->Get()) + filled, block_size - filled);
+      filled += got;
+      if (filled == block_size) {
+        link->SetValidSize(block_size);
+        ++link;
+        filled = 0;
+      } else {
+        break;
+      }
+    }
+    UTIL_THROW_IF(filled % entry_size, ShardFormatException, "Shard file ended with a partial n-gram.");
+  }
+  if (filled) {
+    link->SetValidSize(filled);
+    ++link;
+  }
+  link.Poison();
+}
+
+}} // namespaces
@@ -0,0 +1,74 @@
+#ifndef LM_BUILDER_SHARD__
+#define LM_BUILDER_SHARD__
+
+#include "lm/word_index.hh"
+#include "util/exception.hh"
+#include "util/murmur_hash.hh"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace util { namespace stream { class ChainPosition; } }
+
+namespace lm { namespace builder {
+
+// Splits the n-gram space into count pieces by a hash of each n-gram's
+// context (or of the word itself for unigrams).  Every shard reads the whole
+// corpus, so vocabulary ids and token counts agree across shards.
+struct Shard {
+  Shard() : index(0), count(1) {}
+  Shard(unsigned int index_in, unsigned int count_in) : index(index_in), count(count_in) {}
+
+  bool Keep(const WordIndex *begin, std::size_t order) const {
+    if (count == 1) return true;
+    std::size_t context = (order > 1) ? (order - 1) : 1;
+    return util::MurmurHashNative(begin, context * sizeof(WordIndex)) % count == index;
+  }
+
+  unsigned int index;
+  unsigned int count;
+};
+
+class ShardFormatException : public util::Exception {
+  public:
+    ShardFormatException() throw();
+    ~ShardFormatException() throw();
+};
+
+/* A shard file holds the counts from one shard:
+ *   ShardHeader
+ *   vocabulary: vocab_bytes of null-delimited words in index order
+ *   unique N-grams with raw counts, sorted in suffix order
+ */
+struct ShardHeader {
+  char magic[8];
+  uint64_t order;
+  uint64_t token_count;
+  uint64_t type_count;
+  uint64_t vocab_bytes;
+};
+
+// Write a shard file to out.  vocab and ngrams are read from the beginning.
+void WriteShard(uint64_t order, uint64_t token_count, uint64_t type_count, int vocab, int ngrams, int out);
+
+// Read the header and vocabulary of a shard file, leaving fd at the N-grams.
+// The vocabulary is copied to vocab_out unless it is -1.
+ShardHeader ReadShardHeader(int fd, int vocab_out);
+
+// Streams the N-grams of several shard files, each already positioned by
+// ReadShardHeader, into one chain.  The result is not sorted across shards.
+class ReadShards {
+  public:
+    explicit ReadShards(const std::vector<int> &fds) : fds_(fds) {}
+
+    void Run(const util::stream::ChainPosition &position);
+
+  private:
+    std::vector<int> fds_;
+};
+
+}} // namespaces
+#endif // LM_BUILDER_SHARD__
@@ -6,6 +6,7 @@
 #endif
 #include "lm/filter/vocab.hh"
 #include "lm/filter/wrapper.hh"
+#include "util/file.hh"
 #include "util/file_piece.hh"
 
 #include <boost/ptr_container/ptr_vector.hpp>
@@ -14,13 +15,14 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <string>
 
 namespace lm {
 namespace {
 
 void DisplayHelp(const char *name) {
   std::cerr
-    << "Usage: " << name << " mode [context] [phrase] [raw|arpa] [threads:m] [batch_size:m] (vocab|model):input_file output_file\n\n"
+    << "Usage: " << name << " mode [context] [phrase] [raw|arpa] [threads:m] [batch_size:m] [temp:prefix] [postings:file] (vocab|model):input_file output_file\n\n"
     "copy mode just copies, but makes the format nicer for e.g. irstlm's broken\n"
     "    parser.\n"
     "single mode treats the entire input as a single sentence.\n"
@@ -38,6 +40,12 @@ void DisplayHelp(const char *name) {
     "raw means space-separated tokens, optionally followed by a tab and arbitrary\n"
     "    text.  This is useful for ngram count files.\n"
     "arpa means the ARPA file format for n-gram language models.\n\n"
+    "temp:prefix is where multiple and union mode spill sentence vocabularies while\n"
+    "    indexing them (default: /tmp/).\n"
+    "postings:file saves the index of sentence vocabularies that multiple and union\n"
+    "    mode build to file.  If file exists and was built from the same sentences,\n"
+    "    it is mapped instead of indexing them again, so filter processes over the\n"
+    "    same sentences share it.  Otherwise it is rebuilt.\n\n"
 #ifndef NTHREAD
     "threads:m sets m threads (default: conccurrency detected by boost)\n"
     "batch_size:m sets the batch size for threading.  Expect memory usage from this\n"
@@ -64,7 +72,8 @@ struct Config {
 #endif
   phrase(false),
   context(false),
-  format(FORMAT_ARPA)
+  format(FORMAT_ARPA),
+  temp_prefix("/tmp/")
   {
 #ifndef NTHREAD
     if (!threads) threads = 1;
@@ -79,8 +88,17 @@ struct Config {
   bool context;
   FilterMode mode;
   Format format;
+  std::string temp_prefix;
+  std::string postings;
 };
 
+// Index the sentence vocabularies, or map them if config.postings was saved
+// from the same sentences before.
+unsigned int ReadPostings(const Config &config, std::istream &in_vocab, vocab::Postings &out) {
+  if (config.postings.empty()) return vocab::ReadMultiple(in_vocab, out, config.temp_prefix);
+  return vocab::LoadOrReadMultiple(in_vocab, out, config.temp_prefix, config.postings);
+}
+
 template <class Format, class Filter, class OutputBuffer, class Output> void RunThreadedFilter(const Config &config, util::FilePiece &in_lm, Filter &filter, Output &output) {
 #ifndef NTHREAD
   if (config.threads == 1) {
@@ -118,8 +136,8 @@ template <class Format> void DispatchFilterModes(const Config &config, std::istr
       RunContextFilter<Format, Filter, MultipleOutputBuffer, typename Format::Multiple>(config, in_lm, Filter(substrings), out);
     } else {
       typedef vocab::Multiple Filter;
-      boost::unordered_map<std::string, std::vector<unsigned int> > words;
-      typename Format::Multiple out(out_name, vocab::ReadMultiple(in_vocab, words));
+      vocab::Multiple::Words words;
+      typename Format::Multiple out(out_name, ReadPostings(config, in_vocab, words));
       RunContextFilter<Format, Filter, MultipleOutputBuffer, typename Format::Multiple>(config, in_lm, Filter(words), out);
     }
     return;
@@ -146,7 +164,7 @@ template <class Format> void DispatchFilterModes(const Config &config, std::istr
       DispatchBinaryFilter<Format, phrase::Union>(config, in_lm, phrase::Union(substrings), out);
     } else {
       vocab::Union::Words words;
-      vocab::ReadMultiple(in_vocab, words);
+      ReadPostings(config, in_vocab, words);
       DispatchBinaryFilter<Format, vocab::Union>(config, in_lm, vocab::Union(words), out);
     }
     return;
@@ -183,6 +201,11 @@ int main(int argc, char *argv[]) {
       config.format = lm::FORMAT_ARPA;
     } else if (!std::strcmp(str, "raw")) {
       config.format = lm::FORMAT_COUNT;
+    } else if (!std::strncmp(str, "temp:", 5)) {
+      config.temp_prefix = str + 5;
+      util::NormalizeTempPrefix(config.temp_prefix);
+    } else if (!std::strncmp(str, "postings:", 9)) {
+      config.postings = str + 9;
 #ifndef NTHREAD
     } else if (!std::strncmp(str, "threads:", 8)) {
       config.threads = boost::lexical_cast<size_t>(str + 8);
@@ -1,10 +1,24 @@
 #include "lm/filter/vocab.hh"
 
+#include "util/exception.hh"
+#include "util/file.hh"
+
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <istream>
 #include <iostream>
+#include <limits>
 
 #include <ctype.h>
 #include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 namespace lm {
 namespace vocab {
@@ -18,6 +32,22 @@ void ReadSingle(std::istream &in, boost::unordered_set<std::string> &out) {
 }
 
 namespace {
+// Entries of the spill file buffered in memory.
+const std::size_t kSpillBuffer = 1 << 20;
+
+const char kMagic[16] = "lm postings 2\n";
+const float kMultiplier = 1.5;
+
+struct Header {
+  char magic[sizeof(kMagic)];
+  uint64_t words, postings, table_size;
+  Fingerprint fingerprint;
+};
+
+uint64_t BlockSize(const Header &header) {
+  return sizeof(Header) + header.table_size + (header.words + 1 + header.postings) * sizeof(unsigned int);
+}
+
 bool IsLineEnd(std::istream &in) {
   int got;
   do {
@@ -28,26 +58,254 @@ bool IsLineEnd(std::istream &in) {
   in.unget();
   return false;
 }
+
+// Hashes words and sentence ends in the order they are read.
+class FingerprintBuilder {
+  public:
+    FingerprintBuilder() {
+      value_.sentences = value_.words = value_.hash = 0;
+    }
+
+    void Word(const std::string &word) {
+      ++value_.words;
+      value_.hash = util::MurmurHashNative(word.data(), word.size(), value_.hash);
+    }
+
+    void EndSentence() {
+      ++value_.sentences;
+      value_.hash = util::MurmurHashNative(&value_.sentences, sizeof(value_.sentences), value_.hash);
+    }
+
+    const Fingerprint &Get() const { return value_; }
+
+  private:
+    Fingerprint value_;
+};
+
+// A named temporary file, removed when this goes out of scope unless kept.
+class TempFile : boost::noncopyable {
+  public:
+    explicit TempFile(const std::string &base) {
+      std::string name(base);
+      name += "XXXXXX";
+      name.push_back(0);
+      util::scoped_fd fd(mkstemp(&name[0]));
+      UTIL_THROW_IF(fd.get() == -1, util::ErrnoException, "while making a temporary based on " << base);
+      name_ = name.c_str();
+    }
+
+    ~TempFile() {
+      if (!name_.empty()) unlink(name_.c_str());
+    }
+
+    const std::string &Name() const { return name_; }
+
+    void Keep() { name_.clear(); }
+
+  private:
+    std::string name_;
+};
+
+unsigned int Rebuild(std::istream &in, Postings &out, const std::string &temp_prefix, const std::string &file) {
+  std::cerr << file << " indexes other sentence vocabularies, so it is being rebuilt." << std::endl;
+  unsigned int sentences = ReadMultiple(in, out, temp_prefix);
+  out.Save(file.c_str());
+  return sentences;
+}
 }// namespace
 
+Fingerprint ReadFingerprint(std::istream &in, std::ostream *copy) {
+  in.exceptions(std::istream::badbit);
+  FingerprintBuilder builder;
+  bool in_sentence = false;
+  std::string word;
+  while (in >> word) {
+    builder.Word(word);
+    if (copy) {
+      if (in_sentence) *copy << ' ';
+      *copy << word;
+    }
+    in_sentence = true;
+    if (IsLineEnd(in)) {
+      builder.EndSentence();
+      if (copy) *copy << '\n';
+      in_sentence = false;
+    }
+  }
+  if (in_sentence) {
+    builder.EndSentence();
+    if (copy) *copy << '\n';
+  }
+  return builder.Get();
+}
+
+const uint64_t Postings::kInvalidKey;
+
+// Writes a temporary file and renames it, so that processes which have the old
+// index mapped keep reading it intact.
+void Postings::Save(const char *file) const {
+  Header header;
+  memcpy(&header, memory_.begin(), sizeof(header));
+  TempFile temp(std::string(file) + ".");
+  {
+    util::scoped_fd fd(util::CreateOrThrow(temp.Name().c_str()));
+    util::WriteOrThrow(fd.get(), memory_.begin(), BlockSize(header));
+  }
+  UTIL_THROW_IF(std::rename(temp.Name().c_str(), file), util::ErrnoException, "while renaming " << temp.Name() << " to " << file);
+  temp.Keep();
+}
+
+bool Postings::Load(const char *file) {
+  util::scoped_fd fd(open(file, O_RDONLY));
+  if (fd.get() == -1) {
+    UTIL_THROW_IF(errno != ENOENT, util::ErrnoException, "while opening " << file);
+    return false;
+  }
+  Header header;
+  UTIL_THROW_IF(util::ReadOrEOF(fd.get(), &header, sizeof(header)) != sizeof(header) || memcmp(header.magic, kMagic, sizeof(kMagic)),
+      util::Exception, file << " is not an index of sentence vocabularies");
+  uint64_t size = util::SizeOrThrow(fd.get());
+  UTIL_THROW_IF(size < BlockSize(header), util::Exception, "Truncated index of sentence vocabularies " << file);
+  util::MapRead(util::LAZY, fd.get(), 0, size, memory_);
+  Attach(false);
+  return true;
+}
+
+void Postings::Allocate(uint64_t words, uint64_t postings, const Fingerprint &fingerprint) {
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.words = words;
+  header.postings = postings;
+  header.fingerprint = fingerprint;
+  header.table_size = Table::Size(words, kMultiplier);
+  util::MapAnonymous(BlockSize(header), memory_);
+  memcpy(memory_.get(), &header, sizeof(header));
+  Attach(true);
+}
+
+void Postings::Attach(bool clear) {
+  Header header;
+  memcpy(&header, memory_.begin(), sizeof(header));
+  uint8_t *base = static_cast<uint8_t*>(memory_.get()) + sizeof(header);
+  table_ = Table(base, header.table_size, kInvalidKey);
+  if (clear) table_.Clear();
+  offsets_ = reinterpret_cast<unsigned int*>(base + header.table_size);
+  sentences_ = offsets_ + header.words + 1;
+  fingerprint_ = header.fingerprint;
+}
+
 // Read space separated words in enter separated lines.  These lines can be
 // very long, so don't read an entire line at a time.  
-unsigned int ReadMultiple(std::istream &in, boost::unordered_map<std::string, std::vector<unsigned int> > &out) {
+unsigned int ReadMultiple(std::istream &in, Postings &out, const std::string &temp_prefix) {
   in.exceptions(std::istream::badbit);
+  // Each sentence's distinct words as indices into counts, with kSentenceEnd
+  // after each sentence.  This is as big as the postings, so it goes to disk
+  // instead of being held in memory alongside them.
+  const unsigned int kSentenceEnd = std::numeric_limits<unsigned int>::max();
+  util::scoped_fd spill(util::MakeTemp(temp_prefix));
+  std::vector<unsigned int> buffer;
+  buffer.reserve(kSpillBuffer);
+  // Per word: how many sentences have it and the last sentence that did.
+  std::vector<unsigned int> counts, last;
+  // Word hash to index into counts.
+  boost::unordered_map<uint64_t, unsigned int> ids;
+  FingerprintBuilder fingerprint;
   unsigned int sentence = 0;
   bool used_id = false;
   std::string word;
   while (in >> word) {
+    fingerprint.Word(word);
     used_id = true;
-    std::vector<unsigned int> &posting = out[word];
-    if (posting.empty() || (posting.back() != sentence))
-      posting.push_back(sentence);
+    std::pair<boost::unordered_map<uint64_t, unsigned int>::iterator, bool> found(ids.insert(std::make_pair(Postings::Key(word), static_cast<unsigned int>(counts.size()))));
+    unsigned int id = found.first->second;
+    if (found.second) {
+      counts.push_back(0);
+      last.push_back(0);
+    }
+    if (!counts[id] || last[id] != sentence) {
+      ++counts[id];
+      last[id] = sentence;
+      buffer.push_back(id);
+    }
     if (IsLineEnd(in)) {
+      fingerprint.EndSentence();
+      buffer.push_back(kSentenceEnd);
       ++sentence;
       used_id = false;
     }
+    if (buffer.size() >= kSpillBuffer - 1) {
+      util::WriteOrThrow(spill.get(), &buffer[0], buffer.size() * sizeof(unsigned int));
+      buffer.clear();
+    }
+  }
+  if (!buffer.empty()) util::WriteOrThrow(spill.get(), &buffer[0], buffer.size() * sizeof(unsigned int));
+  if (used_id) fingerprint.EndSentence();
+  std::vector<unsigned int>().swap(last);
+
+  uint64_t postings = 0;
+  for (std::size_t i = 0; i < counts.size(); ++i) postings += counts[i];
+  UTIL_THROW_IF(postings > std::numeric_limits<unsigned int>::max(), util::Exception, "Too many words in sentence vocabularies: " << postings);
+  out.Allocate(counts.size(), postings, fingerprint.Get());
+  for (boost::unordered_map<uint64_t, unsigned int>::const_iterator i = ids.begin(); i != ids.end(); ++i) {
+    Postings::Entry entry;
+    entry.key = i->first;
+    entry.index = i->second;
+    out.table_.Insert(entry);
+  }
+  boost::unordered_map<uint64_t, unsigned int>().swap(ids);
+
+  // Counting sort by word.  Sentences are read back in order, so each word's
+  // list comes out sorted.
+  out.offsets_[0] = 0;
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    out.offsets_[i + 1] = out.offsets_[i] + counts[i];
+  }
+  std::copy(out.offsets_, out.offsets_ + counts.size(), counts.begin());
+  util::SeekOrThrow(spill.get(), 0);
+  buffer.resize(kSpillBuffer);
+  unsigned int current = 0;
+  std::size_t got;
+  while ((got = util::ReadOrEOF(spill.get(), &buffer[0], kSpillBuffer * sizeof(unsigned int)))) {
+    // Writes were whole entries and a read only falls short at the end.
+    UTIL_THROW_IF(got % sizeof(unsigned int), util::Exception, "Partial entry in the sentence vocabulary spill file");
+    for (const unsigned int *i = &buffer[0]; i != &buffer[0] + got / sizeof(unsigned int); ++i) {
+      if (*i == kSentenceEnd) {
+        ++current;
+      } else {
+        out.sentences_[counts[*i]++] = current;
+      }
+    }
+  }
+  return out.SentenceCount();
+}
+
+unsigned int LoadOrReadMultiple(std::istream &in, Postings &out, const std::string &temp_prefix, const std::string &file) {
+  if (!out.Load(file.c_str())) {
+    unsigned int sentences = ReadMultiple(in, out, temp_prefix);
+    out.Save(file.c_str());
+    return sentences;
+  }
+  std::streampos start = in.tellg();
+  if (start != std::streampos(-1)) {
+    if (ReadFingerprint(in, NULL) == out.GetFingerprint()) return out.SentenceCount();
+    in.clear();
+    in.seekg(start);
+    UTIL_THROW_IF(!in, util::Exception, "Failed to seek back to the start of the sentence vocabularies");
+    return Rebuild(in, out, temp_prefix, file);
+  }
+  // A pipe: keep a copy to index if the fingerprint differs.
+  TempFile copy(temp_prefix);
+  {
+    std::ofstream to(copy.Name().c_str());
+    Fingerprint fingerprint(ReadFingerprint(in, &to));
+    to.close();
+    UTIL_THROW_IF(!to, util::ErrnoException, "while copying sentence vocabularies to " << copy.Name());
+    if (fingerprint == out.GetFingerprint()) return out.SentenceCount();
   }
-  return sentence + used_id;
+  std::ifstream from(copy.Name().c_str());
+  UTIL_THROW_IF(!from, util::ErrnoException, "while opening " << copy.Name());
+  return Rebuild(from, out, temp_prefix, file);
 }
 
 } // namespace vocab
@@ -3,26 +3,132 @@
 
 // Vocabulary-based filters for language models.
 
+#include "util/mmap.hh"
 #include "util/multi_intersection.hh"
+#include "util/murmur_hash.hh"
+#include "util/probing_hash_table.hh"
 #include "util/string_piece.hh"
 #include "util/string_piece_hash.hh"
 #include "util/tokenize_piece.hh"
 
 #include <boost/noncopyable.hpp>
 #include <boost/range/iterator_range.hpp>
-#include <boost/unordered/unordered_map.hpp>
 #include <boost/unordered/unordered_set.hpp>
 
+#include <iosfwd>
 #include <string>
 #include <vector>
 
+#include <stdint.h>
+
 namespace lm {
 namespace vocab {
 
 void ReadSingle(std::istream &in, boost::unordered_set<std::string> &out);
 
+/* Identifies the sentence vocabularies an index was built from, so that a
+ * saved index is not used to filter against other sentences: the number of
+ * sentences and words and a hash of the words and where sentences end.
+ */
+struct Fingerprint {
+  uint64_t sentences, words, hash;
+
+  bool operator==(const Fingerprint &other) const {
+    return sentences == other.sentences && words == other.words && hash == other.hash;
+  }
+  bool operator!=(const Fingerprint &other) const { return !(*this == other); }
+};
+
+// Read sentence vocabularies as ReadMultiple does, without indexing them.  If
+// copy is not NULL, write them to it one sentence per line.
+Fingerprint ReadFingerprint(std::istream &in, std::ostream *copy);
+
+/* For each word, the sentences whose vocabulary contains it, in increasing
+ * order.  Words are keyed by hash like phrase::Substrings, so a collision makes
+ * the filter slightly more permissive.  The sentence lists share one array
+ * instead of having a vector each: with millions of sentences, most words are
+ * rare and per-word allocations and strings would dominate memory.
+ *
+ * The hash table, offsets and sentence lists are one block of memory.  Save
+ * writes it as it is and Load maps it, so processes filtering against the same
+ * sentences share its pages instead of each indexing them.  The block starts
+ * with the Fingerprint of the sentences, which LoadOrReadMultiple checks.
+ */
+class Postings : boost::noncopyable {
+  public:
+    typedef boost::iterator_range<const unsigned int*> Range;
+
+    Postings() : offsets_(NULL), sentences_(NULL) {
+      fingerprint_.sentences = fingerprint_.words = fingerprint_.hash = 0;
+    }
+
+    // Sentences with word.  Returns false if no sentence has it.
+    bool Find(const StringPiece &word, Range &out) const {
+      Table::ConstIterator i;
+      if (!table_.Find(Key(word), i)) return false;
+      out = Range(sentences_ + offsets_[i->index], sentences_ + offsets_[i->index + 1]);
+      return true;
+    }
+
+    // Number of sentence vocabularies indexed.
+    unsigned int SentenceCount() const { return fingerprint_.sentences; }
+
+    const Fingerprint &GetFingerprint() const { return fingerprint_; }
+
+    // Write the index for Load.
+    void Save(const char *file) const;
+
+    // Map an index written by Save.  Returns false if file does not exist and
+    // throws if it is not an index.
+    bool Load(const char *file);
+
+  private:
+    friend unsigned int ReadMultiple(std::istream &in, Postings &out, const std::string &temp_prefix);
+
+    struct Entry {
+      typedef uint64_t Key;
+      uint64_t key;
+      // Into offsets_.
+      uint64_t index;
+
+      uint64_t GetKey() const { return key; }
+      void SetKey(uint64_t to) { key = to; }
+    };
+    typedef util::ProbingHashTable<Entry, util::IdentityHash> Table;
+
+    static const uint64_t kInvalidKey = static_cast<uint64_t>(-1);
+
+    static uint64_t Key(const StringPiece &word) {
+      uint64_t hash = util::MurmurHashNative(word.data(), word.size());
+      return hash == kInvalidKey ? 0 : hash;
+    }
+
+    // Lays out memory_ for this many words and postings.  The table is empty.
+    void Allocate(uint64_t words, uint64_t postings, const Fingerprint &fingerprint);
+
+    // Points table_, offsets_ and sentences_ into memory_.
+    void Attach(bool clear);
+
+    util::scoped_memory memory_;
+
+    Table table_;
+
+    // Word i's sentences are [offsets_[i], offsets_[i+1]) in sentences_.
+    unsigned int *offsets_;
+    unsigned int *sentences_;
+
+    Fingerprint fingerprint_;
+};
+
 // Read one sentence vocabulary per line.  Return the number of sentences.
-unsigned int ReadMultiple(std::istream &in, boost::unordered_map<std::string, std::vector<unsigned int> > &out);
+// The words of each sentence are spilled to an unlinked file in temp_prefix.
+unsigned int ReadMultiple(std::istream &in, Postings &out, const std::string &temp_prefix);
+
+// Map the index saved in file if it was built from the sentence vocabularies
+// in, else index them with ReadMultiple and save the index to file.  Either way
+// in is read to the end.  If in cannot seek, it is copied to a file in
+// temp_prefix in case it has to be read again.
+unsigned int LoadOrReadMultiple(std::istream &in, Postings &out, const std::string &temp_prefix, const std::string &file);
 
 /* Is this a special tag like <s> or <UNK>?  This actually includes anything
  * surrounded with < and >, which most tokenizers separate for real words, so
@@ -54,18 +160,18 @@ class Single {
 
 class Union {
   public:
-    typedef boost::unordered_map<std::string, std::vector<unsigned int> > Words;
+    typedef Postings Words;
 
     explicit Union(const Words &vocabs) : vocabs_(vocabs) {}
 
     template <class Iterator> bool PassNGram(const Iterator &begin, const Iterator &end) {
       sets_.clear();
 
+      Postings::Range found;
       for (Iterator i(begin); i != end; ++i) {
         if (IsTag(*i)) continue;
-        Words::const_iterator found(FindStringPiece(vocabs_, *i));
-        if (vocabs_.end() == found) return false;
-        sets_.push_back(boost::iterator_range<const unsigned int*>(&*found->second.begin(), &*found->second.end()));
+        if (!vocabs_.Find(*i, found)) return false;
+        sets_.push_back(found);
       }
       return (sets_.empty() || util::FirstIntersection(sets_));
     }
@@ -73,12 +179,12 @@ class Union {
   private:
     const Words &vocabs_;
 
-    std::vector<boost::iterator_range<const unsigned int*> > sets_;
+    std::vector<Postings::Range> sets_;
 };
 
 class Multiple {
   public:
-    typedef boost::unordered_map<std::string, std::vector<unsigned int> > Words;
+    typedef Postings Words;
 
     Multiple(const Words &vocabs) : vocabs_(vocabs) {}
 
@@ -100,11 +206,11 @@ class Multiple {
   public:
     template <class Iterator, class Output> void AddNGram(const Iterator &begin, const Iterator &end, const StringPiece &line, Output &output) {
       sets_.clear();
+      Postings::Range found;
       for (Iterator i(begin); i != end; ++i) {
         if (IsTag(*i)) continue;
-        Words::const_iterator found(FindStringPiece(vocabs_, *i));
-        if (vocabs_.end() == found) return;
-        sets_.push_back(boost::iterator_range<const unsigned int*>(&*found->second.begin(), &*found->second.end()));
+        if (!vocabs_.Find(*i, found)) return;
+        sets_.push_back(found);
       }
       if (sets_.empty()) {
         output.AddNGram(line);
@@ -124,7 +230,7 @@ class Multiple {
   private:
     const Words &vocabs_;
 
-    std::vector<boost::iterator_range<const unsigned int*> > sets_;
+    std::vector<Postings::Range> sets_;
 };
 
 } // namespace vocab
@@ -0,0 +1,224 @@
+#include "lm/filter/vocab.hh"
+
+#include "util/tokenize_piece.hh"
+
+#include <cstdlib>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#define BOOST_TEST_MODULE VocabFilterTest
+#include <boost/test/unit_test.hpp>
+
+namespace lm {
+namespace vocab {
+namespace {
+
+// Three sentences: {a, b}, {b, c} and {c, d}.
+const char kSentences[] = "a b a\nb  c\t\nc d";
+
+class TempDir {
+  public:
+    TempDir() {
+      char pattern[] = "/tmp/vocab_test.XXXXXX";
+      BOOST_REQUIRE(mkdtemp(pattern));
+      path_ = pattern;
+    }
+
+    ~TempDir() {
+      std::system(("rm -rf " + path_).c_str());
+    }
+
+    std::string File(const char *name) const { return path_ + "/" + name; }
+
+  private:
+    std::string path_;
+};
+
+// Like a pipe: can be read once and not seeked.
+class OnceBuf : public std::streambuf {
+  public:
+    explicit OnceBuf(const std::string &text) : text_(text) {
+      setg(&text_[0], &text_[0], &text_[0] + text_.size());
+    }
+
+  private:
+    std::string text_;
+};
+
+std::vector<unsigned int> Sentences(const Postings &postings, const char *word) {
+  Postings::Range found;
+  if (!postings.Find(word, found)) return std::vector<unsigned int>();
+  return std::vector<unsigned int>(found.begin(), found.end());
+}
+
+void CheckSentences(const Postings &postings, const char *word, unsigned int first, unsigned int second) {
+  std::vector<unsigned int> found(Sentences(postings, word));
+  BOOST_REQUIRE_EQUAL(2U, found.size());
+  BOOST_CHECK_EQUAL(first, found[0]);
+  BOOST_CHECK_EQUAL(second, found[1]);
+}
+
+// Checks postings of kSentences.
+void CheckIndex(const Postings &postings) {
+  BOOST_CHECK_EQUAL(3U, postings.SentenceCount());
+  std::vector<unsigned int> a(Sentences(postings, "a"));
+  BOOST_REQUIRE_EQUAL(1U, a.size());
+  BOOST_CHECK_EQUAL(0U, a[0]);
+  CheckSentences(postings, "b", 0, 1);
+  CheckSentences(postings, "c", 1, 2);
+  BOOST_CHECK(Sentences(postings, "e").empty());
+}
+
+unsigned int Index(const std::string &sentences, Postings &postings) {
+  std::istringstream in(sentences);
+  return ReadMultiple(in, postings, "/tmp/");
+}
+
+ino_t Inode(const std::string &file) {
+  struct stat sb;
+  BOOST_REQUIRE(!stat(file.c_str(), &sb));
+  return sb.st_ino;
+}
+
+bool Passes(Union &filter, const char *ngram) {
+  return filter.PassNGram(util::TokenIter<util::SingleCharacter, true>(ngram, ' '), util::TokenIter<util::SingleCharacter, true>::end());
+}
+
+// Records what Multiple sends to each sentence.
+struct RecordOutput {
+  void SingleAddNGram(unsigned int index, const StringPiece &line) {
+    sentences.push_back(index);
+    lines.push_back(line.as_string());
+  }
+  void AddNGram(const StringPiece &line) {
+    all.push_back(line.as_string());
+  }
+
+  std::vector<unsigned int> sentences;
+  std::vector<std::string> lines, all;
+};
+
+BOOST_AUTO_TEST_CASE(ReadMultipleIndexes) {
+  Postings postings;
+  BOOST_CHECK_EQUAL(3U, Index(kSentences, postings));
+  CheckIndex(postings);
+}
+
+BOOST_AUTO_TEST_CASE(UnionFilter) {
+  Postings postings;
+  Index(kSentences, postings);
+  Union filter(postings);
+  BOOST_CHECK(Passes(filter, "a b"));
+  BOOST_CHECK(Passes(filter, "<s> c d </s>"));
+  BOOST_CHECK(Passes(filter, "<s>"));
+  BOOST_CHECK(!Passes(filter, "a c"));
+  BOOST_CHECK(!Passes(filter, "a e"));
+}
+
+BOOST_AUTO_TEST_CASE(MultipleFilter) {
+  Postings postings;
+  Index(kSentences, postings);
+  Multiple filter(postings);
+  RecordOutput out;
+  filter.AddNGram(StringPiece("b"), StringPiece("-1\tb"), out);
+  filter.AddNGram(StringPiece("c d"), StringPiece("-2\tc d"), out);
+  filter.AddNGram(StringPiece("a d"), StringPiece("-3\ta d"), out);
+  filter.AddNGram(StringPiece("</s>"), StringPiece("-4\t</s>"), out);
+  BOOST_REQUIRE_EQUAL(3U, out.sentences.size());
+  BOOST_CHECK_EQUAL(0U, out.sentences[0]);
+  BOOST_CHECK_EQUAL(1U, out.sentences[1]);
+  BOOST_CHECK_EQUAL(2U, out.sentences[2]);
+  BOOST_CHECK_EQUAL("-1\tb", out.lines[1]);
+  BOOST_CHECK_EQUAL("-2\tc d", out.lines[2]);
+  BOOST_REQUIRE_EQUAL(1U, out.all.size());
+  BOOST_CHECK_EQUAL("-4\t</s>", out.all[0]);
+}
+
+BOOST_AUTO_TEST_CASE(SaveLoad) {
+  TempDir dir;
+  Postings built;
+  Index(kSentences, built);
+  built.Save(dir.File("postings").c_str());
+
+  Postings loaded;
+  BOOST_CHECK(!loaded.Load(dir.File("missing").c_str()));
+  BOOST_REQUIRE(loaded.Load(dir.File("postings").c_str()));
+  CheckIndex(loaded);
+  BOOST_CHECK(loaded.GetFingerprint() == built.GetFingerprint());
+}
+
+BOOST_AUTO_TEST_CASE(FingerprintFollowsWords) {
+  Postings postings;
+  Index(kSentences, postings);
+  // Spacing does not matter, words and sentence ends do.
+  std::istringstream same("a b a \n\n b c\nc   d\n");
+  BOOST_CHECK(ReadFingerprint(same, NULL) == postings.GetFingerprint());
+  std::istringstream split("a b a b\nc\nc d");
+  BOOST_CHECK(ReadFingerprint(split, NULL) != postings.GetFingerprint());
+  std::istringstream other("a b a\nb c\nc e");
+  BOOST_CHECK(ReadFingerprint(other, NULL) != postings.GetFingerprint());
+
+  // The copy reads back the same.
+  std::istringstream in(kSentences);
+  std::ostringstream copy;
+  ReadFingerprint(in, &copy);
+  BOOST_CHECK_EQUAL("a b a\nb c\nc d\n", copy.str());
+}
+
+BOOST_AUTO_TEST_CASE(LoadOrReadChecksFingerprint) {
+  TempDir dir;
+  const std::string file(dir.File("postings"));
+  {
+    Postings postings;
+    std::istringstream in(kSentences);
+    BOOST_CHECK_EQUAL(3U, LoadOrReadMultiple(in, postings, "/tmp/", file));
+    CheckIndex(postings);
+  }
+  ino_t saved = Inode(file);
+  {
+    // The same sentences map the saved index.
+    Postings postings;
+    std::istringstream in(kSentences);
+    BOOST_CHECK_EQUAL(3U, LoadOrReadMultiple(in, postings, "/tmp/", file));
+    CheckIndex(postings);
+    BOOST_CHECK_EQUAL(saved, Inode(file));
+  }
+  {
+    // Other sentences rebuild it.
+    Postings postings;
+    std::istringstream in("a b e\nb\n");
+    BOOST_CHECK_EQUAL(2U, LoadOrReadMultiple(in, postings, "/tmp/", file));
+    CheckSentences(postings, "b", 0, 1);
+    BOOST_CHECK_EQUAL(1U, Sentences(postings, "e").size());
+    BOOST_CHECK(Sentences(postings, "c").empty());
+    BOOST_CHECK(saved != Inode(file));
+    saved = Inode(file);
+  }
+  {
+    // A stream that cannot seek back is copied, and the copy indexed.
+    Postings postings;
+    OnceBuf buf(kSentences);
+    std::istream in(&buf);
+    BOOST_CHECK_EQUAL(3U, LoadOrReadMultiple(in, postings, dir.File("copy"), file));
+    CheckIndex(postings);
+    BOOST_CHECK(saved != Inode(file));
+    saved = Inode(file);
+  }
+  {
+    Postings postings;
+    OnceBuf buf(kSentences);
+    std::istream in(&buf);
+    BOOST_CHECK_EQUAL(3U, LoadOrReadMultiple(in, postings, dir.File("copy"), file));
+    CheckIndex(postings);
+    BOOST_CHECK_EQUAL(saved, Inode(file));
+  }
+}
+
+} // namespace
+} // namespace vocab
+} // namespace lm
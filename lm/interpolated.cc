@@ -0,0 +1,197 @@
+#include "lm/interpolated.hh"
+
+#include "lm/binary_format.hh"
+#include "lm/enumerate_vocab.hh"
+#include "lm/lm_exception.hh"
+#include "lm/model.hh"
+#include "util/string_piece_hash.hh"
+
+#include <algorithm>
+
+#include <math.h>
+
+namespace lm {
+namespace ngram {
+namespace detail {
+
+// One of the models, whatever its type.
+class InterpolatedPart {
+  public:
+    virtual ~InterpolatedPart() {}
+
+    virtual FullScoreReturn FullScore(const State &in_state, const WordIndex new_word, State &out_state) const = 0;
+
+    virtual FullScoreReturn FullScoreForgotState(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word, State &out_state) const = 0;
+
+    virtual const State &BeginSentenceState() const = 0;
+
+    virtual const State &NullContextState() const = 0;
+
+    virtual unsigned char Order() const = 0;
+};
+
+// Records where each word of one model went in the merged vocabulary.
+class InterpolatedCollector : public EnumerateVocab {
+  public:
+    InterpolatedCollector(InterpolatedVocabulary &vocab, std::size_t model) : vocab_(vocab), model_(model) {}
+
+    void Add(WordIndex index, const StringPiece &str) {
+      vocab_.Add(model_, index, str);
+    }
+
+  private:
+    InterpolatedVocabulary &vocab_;
+    const std::size_t model_;
+};
+
+} // namespace detail
+
+namespace {
+
+template <class Model> class Part : public detail::InterpolatedPart {
+  public:
+    Part(const char *file, const Config &config) : model_(file, config) {}
+
+    FullScoreReturn FullScore(const State &in_state, const WordIndex new_word, State &out_state) const {
+      return model_.FullScore(in_state, new_word, out_state);
+    }
+
+    FullScoreReturn FullScoreForgotState(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word, State &out_state) const {
+      return model_.FullScoreForgotState(context_rbegin, context_rend, new_word, out_state);
+    }
+
+    const State &BeginSentenceState() const { return model_.BeginSentenceState(); }
+
+    const State &NullContextState() const { return model_.NullContextState(); }
+
+    unsigned char Order() const { return model_.Order(); }
+
+  private:
+    Model model_;
+};
+
+detail::InterpolatedPart *LoadPart(const char *file, const Config &config) {
+  ModelType model_type;
+  if (!RecognizeBinary(file, model_type)) return new Part<ProbingModel>(file, config);
+  switch (model_type) {
+    case PROBING:
+      return new Part<ProbingModel>(file, config);
+    case REST_PROBING:
+      return new Part<RestProbingModel>(file, config);
+    case TRIE:
+      return new Part<TrieModel>(file, config);
+    case QUANT_TRIE:
+      return new Part<QuantTrieModel>(file, config);
+    case ARRAY_TRIE:
+      return new Part<ArrayTrieModel>(file, config);
+    case QUANT_ARRAY_TRIE:
+      return new Part<QuantArrayTrieModel>(file, config);
+    default:
+      UTIL_THROW(FormatLoadException, "Unrecognized kenlm model type " << model_type << " in " << file);
+  }
+}
+
+} // namespace
+
+WordIndex InterpolatedVocabulary::Index(const StringPiece &str) const {
+  Map::const_iterator i(FindStringPiece(map_, str));
+  return (i == map_.end()) ? 0 : i->second;
+}
+
+void InterpolatedVocabulary::Add(std::size_t model, WordIndex index, const StringPiece &str) {
+  std::pair<Map::iterator, bool> ret(map_.insert(std::make_pair(std::string(str.data(), str.size()), static_cast<WordIndex>(strings_.size()))));
+  if (ret.second) {
+    strings_.push_back(ret.first->first);
+    parts_.resize(parts_.size() + models_, 0);
+  }
+  parts_[ret.first->second * models_ + model] = index;
+}
+
+InterpolatedModel::InterpolatedModel(const std::vector<std::string> &files, const std::vector<float> &weights, Method method, const Config &config)
+  : weights_(weights), method_(method) {
+  UTIL_THROW_IF(files.empty(), ConfigException, "No models to interpolate.");
+  UTIL_THROW_IF(files.size() > kMaxInterpolated, ConfigException, "Interpolating " << files.size() << " models but at most " << kMaxInterpolated << " are supported.  Change kMaxInterpolated in lm/interpolated.hh.");
+  UTIL_THROW_IF(files.size() != weights.size(), ConfigException, "There are " << files.size() << " models but " << weights.size() << " weights.");
+
+  vocab_.models_ = files.size();
+  // <unk> is 0 in every model.
+  vocab_.Add(0, 0, "<unk>");
+
+  InterpolatedState begin_sentence, null_context;
+  begin_sentence.count = null_context.count = static_cast<unsigned char>(files.size());
+  unsigned char order = 0;
+  try {
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      detail::InterpolatedCollector collector(vocab_, i);
+      Config part_config(config);
+      part_config.enumerate_vocab = &collector;
+      parts_.push_back(LoadPart(files[i].c_str(), part_config));
+      begin_sentence.sub[i] = parts_.back()->BeginSentenceState();
+      null_context.sub[i] = parts_.back()->NullContextState();
+      order = std::max(order, parts_.back()->Order());
+    }
+  } catch (...) {
+    for (std::vector<detail::InterpolatedPart*>::iterator i = parts_.begin(); i != parts_.end(); ++i) delete *i;
+    throw;
+  }
+
+  vocab_.SetSpecial(vocab_.Index("<s>"), vocab_.Index("</s>"), 0);
+  if (config.enumerate_vocab) {
+    for (WordIndex i = 0; i < vocab_.Bound(); ++i) {
+      config.enumerate_vocab->Add(i, vocab_.strings_[i]);
+    }
+  }
+  P::Init(begin_sentence, null_context, vocab_, order);
+}
+
+InterpolatedModel::~InterpolatedModel() {
+  for (std::vector<detail::InterpolatedPart*>::iterator i = parts_.begin(); i != parts_.end(); ++i) delete *i;
+}
+
+FullScoreReturn InterpolatedModel::FullScore(const State &in_state, const WordIndex new_word, State &out_state) const {
+  FullScoreReturn parts[kMaxInterpolated];
+  out_state.count = in_state.count;
+  for (std::size_t i = 0; i < parts_.size(); ++i) {
+    parts[i] = parts_[i]->FullScore(in_state.sub[i], vocab_.Part(new_word, i), out_state.sub[i]);
+  }
+  return Combine(parts);
+}
+
+FullScoreReturn InterpolatedModel::FullScoreForgotState(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word, State &out_state) const {
+  context_rend = std::min(context_rend, context_rbegin + P::Order() - 1);
+  FullScoreReturn parts[kMaxInterpolated];
+  WordIndex context[KENLM_MAX_ORDER];
+  out_state.count = static_cast<unsigned char>(parts_.size());
+  for (std::size_t i = 0; i < parts_.size(); ++i) {
+    WordIndex *out = context;
+    for (const WordIndex *c = context_rbegin; c != context_rend; ++c, ++out) {
+      *out = vocab_.Part(*c, i);
+    }
+    parts[i] = parts_[i]->FullScoreForgotState(context, out, vocab_.Part(new_word, i), out_state.sub[i]);
+  }
+  return Combine(parts);
+}
+
+FullScoreReturn InterpolatedModel::Combine(const FullScoreReturn *parts) const {
+  FullScoreReturn ret;
+  ret.prob = 0.0;
+  ret.ngram_length = 0;
+  ret.independent_left = true;
+  ret.extend_left = 0;
+  ret.rest = 0.0;
+  for (std::size_t i = 0; i < parts_.size(); ++i) {
+    if (method_ == LINEAR) {
+      ret.prob += weights_[i] * powf(10.0, parts[i].prob);
+    } else {
+      ret.prob += weights_[i] * parts[i].prob;
+    }
+    ret.ngram_length = std::max(ret.ngram_length, parts[i].ngram_length);
+    ret.independent_left = ret.independent_left && parts[i].independent_left;
+  }
+  if (method_ == LINEAR) ret.prob = log10f(ret.prob);
+  ret.rest = ret.prob;
+  return ret;
+}
+
+} // namespace ngram
+} // namespace lm
@@ -0,0 +1,147 @@
+#ifndef LM_INTERPOLATED__
+#define LM_INTERPOLATED__
+
+/* Query several models as one.  The vocabularies are merged into one mapping
+ * and the state holds every model's state, so a decoder sees a single feature
+ * with a single state to compare.
+ */
+
+#include "lm/config.hh"
+#include "lm/facade.hh"
+#include "lm/return.hh"
+#include "lm/state.hh"
+#include "lm/virtual_interface.hh"
+#include "lm/word_index.hh"
+#include "util/string_piece.hh"
+
+#include <boost/unordered_map.hpp>
+
+#include <string>
+#include <vector>
+
+namespace lm {
+namespace ngram {
+
+// Most models that can be interpolated.  This bounds sizeof(InterpolatedState).
+const std::size_t kMaxInterpolated = 4;
+
+// The state of each model, in the order the models were given.
+class InterpolatedState {
+  public:
+    bool operator==(const InterpolatedState &other) const {
+      if (count != other.count) return false;
+      for (unsigned char i = 0; i < count; ++i) {
+        if (!(sub[i] == other.sub[i])) return false;
+      }
+      return true;
+    }
+
+    // Three way comparison function.
+    int Compare(const InterpolatedState &other) const {
+      if (count != other.count) return count < other.count ? -1 : 1;
+      for (unsigned char i = 0; i < count; ++i) {
+        int ret = sub[i].Compare(other.sub[i]);
+        if (ret) return ret;
+      }
+      return 0;
+    }
+
+    bool operator<(const InterpolatedState &other) const {
+      return Compare(other) < 0;
+    }
+
+    State sub[kMaxInterpolated];
+    unsigned char count;
+};
+
+inline uint64_t hash_value(const InterpolatedState &state) {
+  uint64_t ret = 0;
+  for (unsigned char i = 0; i < state.count; ++i) {
+    ret = hash_value(state.sub[i], ret);
+  }
+  return ret;
+}
+
+namespace detail {
+class InterpolatedPart;
+class InterpolatedCollector;
+} // namespace detail
+
+/* Every word in any of the models.  Index 0 is <unk>.  Each index maps to the
+ * word's index in each model, which is 0 if that model does not have it.
+ */
+class InterpolatedVocabulary : public base::Vocabulary {
+  public:
+    InterpolatedVocabulary() : models_(0) {}
+
+    WordIndex Index(const StringPiece &str) const;
+
+    // Vocab words are [0, Bound()).
+    WordIndex Bound() const { return static_cast<WordIndex>(strings_.size()); }
+
+    // The index of word in model.
+    WordIndex Part(WordIndex word, std::size_t model) const {
+      return parts_[word * models_ + model];
+    }
+
+  private:
+    friend class InterpolatedModel;
+    friend class detail::InterpolatedCollector;
+
+    // Called while loading: str is index in model.
+    void Add(std::size_t model, WordIndex index, const StringPiece &str);
+
+    typedef boost::unordered_map<std::string, WordIndex> Map;
+    Map map_;
+
+    std::vector<std::string> strings_;
+
+    std::vector<WordIndex> parts_;
+
+    std::size_t models_;
+};
+
+/* Interpolates models of any type.  Each is loaded with the same Config,
+ * except that config.enumerate_vocab sees the merged vocabulary once all the
+ * models are loaded.
+ *
+ * LINEAR: log10(sum_i weight_i * 10^{p_i}).  The weights should sum to 1.
+ * LOG_LINEAR: sum_i weight_i * p_i.  This is not normalized.
+ */
+class InterpolatedModel : public base::ModelFacade<InterpolatedModel, InterpolatedState, InterpolatedVocabulary> {
+  private:
+    typedef base::ModelFacade<InterpolatedModel, InterpolatedState, InterpolatedVocabulary> P;
+
+  public:
+    enum Method { LINEAR, LOG_LINEAR };
+
+    InterpolatedModel(const std::vector<std::string> &files, const std::vector<float> &weights, Method method = LINEAR, const Config &config = Config());
+
+    ~InterpolatedModel();
+
+    std::size_t ModelCount() const { return parts_.size(); }
+
+    /* ngram_length is the longest of any model and independent_left is true
+     * only if it is for every model.  extend_left and rest are not useful.
+     */
+    FullScoreReturn FullScore(const State &in_state, const WordIndex new_word, State &out_state) const;
+
+    // Like Model::FullScoreForgotState with context in merged indices.
+    FullScoreReturn FullScoreForgotState(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word, State &out_state) const;
+
+  private:
+    FullScoreReturn Combine(const FullScoreReturn *parts) const;
+
+    std::vector<detail::InterpolatedPart*> parts_;
+
+    std::vector<float> weights_;
+
+    Method method_;
+
+    InterpolatedVocabulary vocab_;
+};
+
+} // namespace ngram
+} // namespace lm
+
+#endif // LM_INTERPOLATED__
@@ -0,0 +1,116 @@
+#include "lm/interpolated.hh"
+#include "lm/model.hh"
+
+#include <math.h>
+#include <string.h>
+
+#define BOOST_TEST_MODULE InterpolatedTest
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+// Apparently some Boost versions use templates and are pretty strict about types matching.
+#define SLOPPY_CHECK_CLOSE(ref, value, tol) BOOST_CHECK_CLOSE(static_cast<double>(ref), static_cast<double>(value), static_cast<double>(tol));
+
+namespace lm {
+namespace ngram {
+namespace {
+
+// Stupid bjam reverses the command line arguments randomly.
+const char *TestLocation() {
+  if (boost::unit_test::framework::master_test_suite().argc < 3) {
+    return "test.arpa";
+  }
+  char **argv = boost::unit_test::framework::master_test_suite().argv;
+  return argv[strstr(argv[1], "nounk") ? 2 : 1];
+}
+const char *TestNoUnkLocation() {
+  if (boost::unit_test::framework::master_test_suite().argc < 3) {
+    return "test_nounk.arpa";
+  }
+  char **argv = boost::unit_test::framework::master_test_suite().argv;
+  return argv[strstr(argv[1], "nounk") ? 1 : 2];
+}
+
+const char *kSentence[] = {"looking", "on", "a", "little", "more", "loin", "this_is_not_found", "more", ".", "</s>"};
+
+// Score kSentence with the interpolated model and with each model separately.
+void Compare(const std::vector<std::string> &files, const std::vector<float> &weights, InterpolatedModel::Method method) {
+  InterpolatedModel merged(files, weights, method);
+  ProbingModel first(files[0].c_str()), second(files[1].c_str());
+
+  InterpolatedState state(merged.BeginSentenceState()), out;
+  State first_state(first.BeginSentenceState()), second_state(second.BeginSentenceState()), first_out, second_out;
+  // Context in merged indices, most recent first, for FullScoreForgotState.
+  std::vector<WordIndex> history(1, merged.GetVocabulary().BeginSentence());
+  for (const char **word = kSentence; word != kSentence + sizeof(kSentence) / sizeof(const char*); ++word) {
+    WordIndex index = merged.GetVocabulary().Index(*word);
+    FullScoreReturn ret(merged.FullScore(state, index, out));
+
+    FullScoreReturn first_ret(first.FullScore(first_state, first.GetVocabulary().Index(*word), first_out));
+    FullScoreReturn second_ret(second.FullScore(second_state, second.GetVocabulary().Index(*word), second_out));
+    float expected = (method == InterpolatedModel::LINEAR) ?
+      log10(weights[0] * pow(10.0, first_ret.prob) + weights[1] * pow(10.0, second_ret.prob)) :
+      weights[0] * first_ret.prob + weights[1] * second_ret.prob;
+    SLOPPY_CHECK_CLOSE(expected, ret.prob, 0.001);
+    BOOST_CHECK_EQUAL(static_cast<unsigned int>(std::max(first_ret.ngram_length, second_ret.ngram_length)), static_cast<unsigned int>(ret.ngram_length));
+    BOOST_CHECK(first_out == out.sub[0]);
+    BOOST_CHECK(second_out == out.sub[1]);
+
+    InterpolatedState forgot;
+    FullScoreReturn forgot_ret(merged.FullScoreForgotState(&history[0], &history[0] + history.size(), index, forgot));
+    SLOPPY_CHECK_CLOSE(ret.prob, forgot_ret.prob, 0.001);
+    BOOST_CHECK_EQUAL(static_cast<unsigned int>(ret.ngram_length), static_cast<unsigned int>(forgot_ret.ngram_length));
+
+    history.insert(history.begin(), index);
+    state = out;
+    first_state = first_out;
+    second_state = second_out;
+  }
+}
+
+std::vector<std::string> Files(const char *first, const char *second) {
+  std::vector<std::string> ret;
+  ret.push_back(first);
+  ret.push_back(second);
+  return ret;
+}
+
+std::vector<float> Weights(float first, float second) {
+  std::vector<float> ret;
+  ret.push_back(first);
+  ret.push_back(second);
+  return ret;
+}
+
+BOOST_AUTO_TEST_CASE(Vocabulary) {
+  InterpolatedModel merged(Files(TestLocation(), TestNoUnkLocation()), Weights(0.5, 0.5));
+  ProbingModel unk(TestLocation()), nounk(TestNoUnkLocation());
+  const InterpolatedVocabulary &vocab = merged.GetVocabulary();
+  BOOST_CHECK_EQUAL(2, merged.ModelCount());
+  BOOST_CHECK_EQUAL(5, merged.Order());
+  // Both have the same words, and <unk> is implicit in test_nounk.arpa.
+  BOOST_CHECK_EQUAL(unk.GetVocabulary().Bound(), vocab.Bound());
+  BOOST_CHECK_EQUAL(0, vocab.Index("this_is_not_found"));
+  BOOST_CHECK_EQUAL(0, vocab.Part(0, 1));
+  WordIndex loin = vocab.Index("loin");
+  BOOST_CHECK_EQUAL(unk.GetVocabulary().Index("loin"), vocab.Part(loin, 0));
+  BOOST_CHECK_EQUAL(nounk.GetVocabulary().Index("loin"), vocab.Part(loin, 1));
+  BOOST_CHECK_EQUAL(vocab.Index("<s>"), vocab.BeginSentence());
+  BOOST_CHECK_EQUAL(vocab.Index("</s>"), vocab.EndSentence());
+}
+
+BOOST_AUTO_TEST_CASE(Same) {
+  Compare(Files(TestLocation(), TestLocation()), Weights(0.3, 0.7), InterpolatedModel::LINEAR);
+}
+
+BOOST_AUTO_TEST_CASE(Linear) {
+  Compare(Files(TestLocation(), TestNoUnkLocation()), Weights(0.4, 0.6), InterpolatedModel::LINEAR);
+}
+
+BOOST_AUTO_TEST_CASE(LogLinear) {
+  Compare(Files(TestLocation(), TestNoUnkLocation()), Weights(0.8, 0.5), InterpolatedModel::LOG_LINEAR);
+}
+
+} // namespace
+} // namespace ngram
+} // namespace lm
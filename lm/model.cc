@@ -2,6 +2,7 @@
 
 #include "lm/blank.hh"
 #include "lm/lm_exception.hh"
+#include "lm/ngram_source.hh"
 #include "lm/search_hashed.hh"
 #include "lm/search_trie.hh"
 #include "lm/read_arpa.hh"
@@ -36,7 +37,17 @@ template <class Search, class VocabularyT> void GenericModel<Search, VocabularyT
 
 template <class Search, class VocabularyT> GenericModel<Search, VocabularyT>::GenericModel(const char *file, const Config &config) {
   LoadLM(file, config, *this);
+  InitStates();
+}
+
+template <class Search, class VocabularyT> GenericModel<Search, VocabularyT>::GenericModel(NGramSource &source, const Config &config) {
+  std::vector<uint64_t> counts;
+  source.ReadCounts(counts);
+  InitializeFromInput(NULL, source, counts, config);
+  InitStates();
+}
 
+template <class Search, class VocabularyT> void GenericModel<Search, VocabularyT>::InitStates() {
   // g++ prints warnings unless these are fully initialized.
   State begin_sentence = State();
   begin_sentence.length = 1;
@@ -75,37 +86,41 @@ template <class Search, class VocabularyT> void GenericModel<Search, VocabularyT
     std::vector<uint64_t> counts;
     // File counts do not include pruned trigrams that extend to quadgrams etc.   These will be fixed by search_.
     ReadARPACounts(f, counts);
-    CheckCounts(counts);
-    if (counts.size() < 2) UTIL_THROW(FormatLoadException, "This ngram implementation assumes at least a bigram model.");
-    if (config.probing_multiplier <= 1.0) UTIL_THROW(ConfigException, "probing multiplier must be > 1.0");
-
-    std::size_t vocab_size = util::CheckOverflow(VocabularyT::Size(counts[0], config));
-    // Setup the binary file for writing the vocab lookup table.  The search_ is responsible for growing the binary file to its needs.
-    vocab_.SetupMemory(SetupJustVocab(config, counts.size(), vocab_size, backing_), vocab_size, counts[0], config);
-
-    if (config.write_mmap) {
-      WriteWordsWrapper wrap(config.enumerate_vocab);
-      vocab_.ConfigureEnumerate(&wrap, counts[0]);
-      search_.InitializeFromARPA(file, f, counts, config, vocab_, backing_);
-      wrap.Write(backing_.file.get(), backing_.vocab.size() + vocab_.UnkCountChangePadding() + Search::Size(counts, config));
-    } else {
-      vocab_.ConfigureEnumerate(config.enumerate_vocab, counts[0]);
-      search_.InitializeFromARPA(file, f, counts, config, vocab_, backing_);
-    }
-
-    if (!vocab_.SawUnk()) {
-      assert(config.unknown_missing != THROW_UP);
-      // Default probabilities for unknown.
-      search_.UnknownUnigram().backoff = 0.0;
-      search_.UnknownUnigram().prob = config.unknown_missing_logprob;
-    }
-    FinishFile(config, kModelType, kVersion, counts, vocab_.UnkCountChangePadding(), backing_);
+    InitializeFromInput(file, f, counts, config);
   } catch (util::Exception &e) {
     e << " Byte: " << f.Offset();
     throw;
   }
 }
 
+template <class Search, class VocabularyT> template <class Input> void GenericModel<Search, VocabularyT>::InitializeFromInput(const char *file, Input &f, std::vector<uint64_t> &counts, const Config &config) {
+  CheckCounts(counts);
+  if (counts.size() < 2) UTIL_THROW(FormatLoadException, "This ngram implementation assumes at least a bigram model.");
+  if (config.probing_multiplier <= 1.0) UTIL_THROW(ConfigException, "probing multiplier must be > 1.0");
+
+  std::size_t vocab_size = util::CheckOverflow(VocabularyT::Size(counts[0], config));
+  // Setup the binary file for writing the vocab lookup table.  The search_ is responsible for growing the binary file to its needs.
+  vocab_.SetupMemory(SetupJustVocab(config, counts.size(), vocab_size, backing_), vocab_size, counts[0], config);
+
+  if (config.write_mmap) {
+    WriteWordsWrapper wrap(config.enumerate_vocab);
+    vocab_.ConfigureEnumerate(&wrap, counts[0]);
+    search_.Initialize(file, f, counts, config, vocab_, backing_);
+    wrap.Write(backing_.file.get(), backing_.vocab.size() + vocab_.UnkCountChangePadding() + Search::Size(counts, config));
+  } else {
+    vocab_.ConfigureEnumerate(config.enumerate_vocab, counts[0]);
+    search_.Initialize(file, f, counts, config, vocab_, backing_);
+  }
+
+  if (!vocab_.SawUnk()) {
+    assert(config.unknown_missing != THROW_UP);
+    // Default probabilities for unknown.
+    search_.UnknownUnigram().backoff = 0.0;
+    search_.UnknownUnigram().prob = config.unknown_missing_logprob;
+  }
+  FinishFile(config, kModelType, kVersion, counts, vocab_.UnkCountChangePadding(), backing_);
+}
+
 template <class Search, class VocabularyT> void GenericModel<Search, VocabularyT>::UpdateConfigFromBinary(int fd, const std::vector<uint64_t> &counts, Config &config) {
   util::AdvanceOrThrow(fd, VocabularyT::Size(counts[0], config));
   Search::UpdateConfigFromBinary(fd, counts, config);
@@ -146,6 +161,27 @@ template <class Search, class VocabularyT> FullScoreReturn GenericModel<Search,
   return ret;
 }
 
+template <class Search, class VocabularyT> float GenericModel<Search, VocabularyT>::FullScorePhrase(const State &in_state, const WordIndex *begin, const WordIndex *end, State &out_state) const {
+  if (begin == end) {
+    out_state = in_state;
+    return 0.0;
+  }
+  search_.Prefetch(*begin, in_state.length ? in_state.words : NULL);
+  for (const WordIndex *i = begin + 1; i < end; ++i) {
+    search_.Prefetch(*i, i - 1);
+  }
+
+  float ret = 0.0;
+  State states[2];
+  const State *from = &in_state;
+  for (const WordIndex *i = begin; i < end; ++i) {
+    State &to = (i + 1 == end) ? out_state : states[(i - begin) % 2];
+    ret += FullScore(*from, *i, to).prob;
+    from = &to;
+  }
+  return ret;
+}
+
 template <class Search, class VocabularyT> void GenericModel<Search, VocabularyT>::GetState(const WordIndex *context_rbegin, const WordIndex *context_rend, State &out_state) const {
   // Generate a state from context.
   context_rend = std::min(context_rend, context_rbegin + P::Order() - 1);
@@ -23,6 +23,7 @@
 namespace util { class FilePiece; }
 
 namespace lm {
+class NGramSource;
 namespace ngram {
 namespace detail {
 
@@ -51,6 +52,11 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
      */
     explicit GenericModel(const char *file, const Config &config = Config());
 
+    /* Build the model from n-grams that are not ARPA text, such as lmplz's.
+     * As with ARPA files, set config.write_mmap to save a binary file.  
+     */
+    GenericModel(NGramSource &source, const Config &config = Config());
+
     /* Score p(new_word | in_state) and incorporate new_word into out_state.
      * Note that in_state and out_state must be different references:
      * &in_state != &out_state.  
@@ -66,6 +72,14 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
      */
     FullScoreReturn FullScoreForgotState(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word, State &out_state) const;
 
+    /* Score the words [begin, end) in order, starting from in_state, and
+     * return the sum of their log10 probabilities.  This is the same as
+     * calling FullScore on each word in turn, but the lookups for every word
+     * are started before the first is scored so their cache misses overlap.
+     * out_state must not be in_state.  
+     */
+    float FullScorePhrase(const State &in_state, const WordIndex *begin, const WordIndex *end, State &out_state) const;
+
     /* Get the state for a context.  Don't use this if you can avoid it.  Use
      * BeginSentenceState or EmptyContextState and extend from those.  If
      * you're only going to use this state to call FullScore once, use
@@ -106,6 +120,9 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
   private:
     friend void lm::ngram::LoadLM<>(const char *file, const Config &config, GenericModel<Search, VocabularyT> &to);
 
+    // Sets up the begin sentence and null context states after loading.
+    void InitStates();
+
     static void UpdateConfigFromBinary(int fd, const std::vector<uint64_t> &counts, Config &config);
 
     FullScoreReturn ScoreExceptBackoff(const WordIndex *const context_rbegin, const WordIndex *const context_rend, const WordIndex new_word, State &out_state) const;
@@ -120,6 +137,9 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
 
     void InitializeFromARPA(const char *file, const Config &config);
 
+    // Builds from ARPA text once the counts are read, or from an NGramSource.
+    template <class Input> void InitializeFromInput(const char *file, Input &f, std::vector<uint64_t> &counts, const Config &config);
+
     float InternalUnRest(const uint64_t *pointers_begin, const uint64_t *pointers_end, unsigned char first_length) const;
 
     Backing &MutableBacking() { return backing_; }
@@ -140,6 +160,7 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
 class name : public from {\
   public:\
     name(const char *file, const Config &config = Config()) : from(file, config) {}\
+    name(NGramSource &source, const Config &config = Config()) : from(source, config) {}\
 };
 
 LM_NAME_MODEL(ProbingModel, detail::GenericModel<detail::HashedSearch<BackoffValue> LM_COMMA() ProbingVocabulary>);
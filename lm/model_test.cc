@@ -286,6 +286,27 @@ template <class M> void NoUnkCheck(const M &model) {
   SLOPPY_CHECK_CLOSE(-100.0, ret.prob, 0.001);
 }
 
+template <class M> void Phrase(const M &model) {
+  const char *words[] = {"looking", "on", "a", "little", "more", "loin", "not_found", "</s>"};
+  std::vector<WordIndex> ids;
+  for (std::size_t i = 0; i < sizeof(words) / sizeof(const char*); ++i) {
+    ids.push_back(model.GetVocabulary().Index(words[i]));
+  }
+  State state(model.BeginSentenceState()), out;
+  float expected = 0.0;
+  for (std::size_t i = 0; i < ids.size(); ++i) {
+    expected += model.FullScore(state, ids[i], out).prob;
+    state = out;
+  }
+  State phrase_state;
+  SLOPPY_CHECK_CLOSE(expected, model.FullScorePhrase(model.BeginSentenceState(), &ids[0], &ids[0] + ids.size(), phrase_state), 0.001);
+  BOOST_CHECK(state == phrase_state);
+
+  phrase_state = model.NullContextState();
+  SLOPPY_CHECK_CLOSE(0.0, model.FullScorePhrase(model.BeginSentenceState(), &ids[0], &ids[0], phrase_state), 0.001);
+  BOOST_CHECK(model.BeginSentenceState() == phrase_state);
+}
+
 template <class M> void Everything(const M &m) {
   Starters(m);
   Continuation(m);
@@ -294,6 +315,7 @@ template <class M> void Everything(const M &m) {
   MinimalState(m);
   ExtendLeftTest(m);
   Stateless(m);
+  Phrase(m);
 }
 
 class ExpectEnumerateVocab : public EnumerateVocab {
@@ -0,0 +1,32 @@
+#include "lm/ngram_source.hh"
+
+#include "lm/blank.hh"
+
+#include <cmath>
+
+#ifdef WIN32
+#include <float.h>
+#endif
+
+namespace lm {
+
+NGramSource::~NGramSource() {}
+
+namespace detail {
+
+float SourceBackoff(float backoff) {
+  // Negative zero means no (n+1)-gram has this n-gram as context.  The data
+  // structure sets positive zero where one does, as it does for ARPA files.
+  if (backoff == ngram::kExtensionBackoff) return ngram::kNoExtensionBackoff;
+#ifdef WIN32
+  int float_class = _fpclass(backoff);
+  UTIL_THROW_IF(float_class == _FPCLASS_SNAN || float_class == _FPCLASS_QNAN || float_class == _FPCLASS_NINF || float_class == _FPCLASS_PINF, FormatLoadException, "Bad backoff " << backoff);
+#else
+  int float_class = std::fpclassify(backoff);
+  UTIL_THROW_IF(float_class == FP_NAN || float_class == FP_INFINITE, FormatLoadException, "Bad backoff " << backoff);
+#endif
+  return backoff;
+}
+
+} // namespace detail
+} // namespace lm
@@ -0,0 +1,121 @@
+#ifndef LM_NGRAM_SOURCE__
+#define LM_NGRAM_SOURCE__
+
+#include "lm/lm_exception.hh"
+#include "lm/read_arpa.hh"
+#include "lm/weights.hh"
+#include "lm/word_index.hh"
+#include "util/string_piece.hh"
+
+#include <cstddef>
+#include <vector>
+
+#include <stdint.h>
+
+namespace lm {
+
+/* N-grams that come from somewhere other than ARPA text, such as the streams
+ * lmplz would otherwise print.  A model built from a source is the same as
+ * one built from the ARPA file it stands for.  The loaders read it like an
+ * ARPA file: the counts, then each order in turn starting with unigrams.
+ * Words are the source's own ids, which must be below the unigram count.
+ */
+class NGramSource {
+  public:
+    virtual ~NGramSource();
+
+    // Number of n-grams of each order, unigrams first.
+    virtual void ReadCounts(std::vector<uint64_t> &counts) = 0;
+
+    // Start reading the n-grams of order n.
+    virtual void BeginOrder(unsigned int n) = 0;
+
+    // The next n-gram of the current order: its words in the usual order, its
+    // log10 probability, and its backoff, which is zero if it has none.  The
+    // words stay valid until the next call.
+    virtual const WordIndex *Next(float &prob, float &backoff) = 0;
+
+    // Called after the last n-gram of the last order.
+    virtual void End() = 0;
+
+    virtual StringPiece Word(WordIndex id) const = 0;
+
+    // Model vocabulary id of each source id.  Set by Read1Grams.
+    const std::vector<WordIndex> &ModelIds() const { return model_ids_; }
+    std::vector<WordIndex> &MutableModelIds() { return model_ids_; }
+
+  private:
+    std::vector<WordIndex> model_ids_;
+};
+
+// These match the ARPA readers in lm/read_arpa.hh so the loaders can take
+// either.
+
+inline void ReadNGramHeader(NGramSource &in, unsigned int length) {
+  in.BeginOrder(length);
+}
+
+inline void ReadEnd(NGramSource &in) {
+  in.End();
+}
+
+namespace detail {
+
+inline float SourceProb(float prob, PositiveProbWarn &warn) {
+  if (prob > 0.0) {
+    warn.Warn(prob);
+    return 0.0;
+  }
+  return prob;
+}
+
+// As ReadBackoff does for text: zero becomes kNoExtensionBackoff.
+float SourceBackoff(float backoff);
+
+inline void SetSourceBackoff(float backoff, Prob &/*weights*/) {
+  UTIL_THROW_IF(backoff != 0.0, FormatLoadException, "Non-zero backoff " << backoff << " provided for an n-gram that should have no backoff");
+}
+inline void SetSourceBackoff(float backoff, ProbBackoff &weights) {
+  weights.backoff = SourceBackoff(backoff);
+}
+inline void SetSourceBackoff(float backoff, RestWeights &weights) {
+  weights.backoff = SourceBackoff(backoff);
+}
+
+} // namespace detail
+
+template <class Voc, class Weights> void Read1Grams(NGramSource &f, std::size_t count, Voc &vocab, Weights *unigrams, PositiveProbWarn &warn) {
+  f.BeginOrder(1);
+  float backoff;
+  for (std::size_t i = 0; i < count; ++i) {
+    float prob;
+    const WordIndex id = *f.Next(prob, backoff);
+    UTIL_THROW_IF(id >= count, FormatLoadException, "Unigram id " << id << " is not below the unigram count " << count);
+    Weights &value = unigrams[vocab.Insert(f.Word(id))];
+    value.prob = detail::SourceProb(prob, warn);
+    detail::SetSourceBackoff(backoff, value);
+  }
+  vocab.FinishedLoading(unigrams);
+  // Only now are the ids final: SortedVocabulary sorts when it finishes.
+  std::vector<WordIndex> &ids = f.MutableModelIds();
+  ids.resize(count);
+  for (WordIndex id = 0; id < count; ++id) {
+    ids[id] = vocab.Index(f.Word(id));
+  }
+}
+
+template <class Voc, class Weights> void ReadNGram(NGramSource &f, const unsigned char n, const Voc &/*vocab*/, WordIndex *const reverse_indices, Weights &weights, PositiveProbWarn &warn) {
+  float backoff;
+  const WordIndex *word = f.Next(weights.prob, backoff);
+  weights.prob = detail::SourceProb(weights.prob, warn);
+  const std::vector<WordIndex> &ids = f.ModelIds();
+  for (WordIndex *vocab_out = reverse_indices + n - 1; vocab_out >= reverse_indices; --vocab_out, ++word) {
+    UTIL_THROW_IF(*word >= ids.size(), FormatLoadException, "Word id " << *word << " in a " << static_cast<unsigned int>(n) << "-gram is not a unigram");
+    *vocab_out = ids[*word];
+  }
+  detail::SetSourceBackoff(backoff, weights);
+}
+
+} // namespace lm
+
+#endif // LM_NGRAM_SOURCE__
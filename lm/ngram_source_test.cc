@@ -0,0 +1,180 @@
+#include "lm/ngram_source.hh"
+
+#include "lm/model.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+#define BOOST_TEST_MODULE NGramSourceTest
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+namespace lm {
+namespace {
+
+const char kARPA[] =
+  "\n\\data\\\n"
+  "ngram 1=5\n"
+  "ngram 2=4\n"
+  "ngram 3=2\n"
+  "\n\\1-grams:\n"
+  "-1\t<unk>\t0\n"
+  "-99\t<s>\t-0.5\n"
+  "-1.5\t</s>\n"
+  "-0.7\ta\t-0.3\n"
+  "-0.9\tb\t-0.2\n"
+  "\n\\2-grams:\n"
+  "-0.4\t<s> a\t-0.1\n"
+  "-0.6\ta b\t-0.2\n"
+  "-0.3\tb </s>\n"
+  "-0.8\ta </s>\n"
+  "\n\\3-grams:\n"
+  "-0.2\t<s> a b\n"
+  "-0.1\ta b </s>\n"
+  "\n\\end\\\n";
+
+const char *const kWords[] = {"<unk>", "<s>", "</s>", "a", "b"};
+
+struct Entry {
+  WordIndex words[3];
+  float prob, backoff;
+};
+
+// kARPA in the same order, with ids into kWords.
+const Entry kUnigrams[] = {
+  {{0}, -1.0, 0.0}, {{1}, -99.0, -0.5}, {{2}, -1.5, 0.0}, {{3}, -0.7, -0.3}, {{4}, -0.9, -0.2}};
+const Entry kBigrams[] = {
+  {{1, 3}, -0.4, -0.1}, {{3, 4}, -0.6, -0.2}, {{4, 2}, -0.3, 0.0}, {{3, 2}, -0.8, 0.0}};
+const Entry kTrigrams[] = {
+  {{1, 3, 4}, -0.2, 0.0}, {{3, 4, 2}, -0.1, 0.0}};
+
+class VectorSource : public NGramSource {
+  public:
+    VectorSource() : order_(0), index_(0) {
+      orders_.push_back(std::vector<Entry>(kUnigrams, kUnigrams + 5));
+      orders_.push_back(std::vector<Entry>(kBigrams, kBigrams + 4));
+      orders_.push_back(std::vector<Entry>(kTrigrams, kTrigrams + 2));
+    }
+
+    std::vector<std::vector<Entry> > &Orders() { return orders_; }
+
+    void ReadCounts(std::vector<uint64_t> &counts) {
+      counts.clear();
+      for (std::size_t i = 0; i < orders_.size(); ++i) counts.push_back(orders_[i].size());
+    }
+
+    void BeginOrder(unsigned int n) {
+      BOOST_REQUIRE_EQUAL(order_ + 1, n);
+      order_ = n;
+      index_ = 0;
+    }
+
+    const WordIndex *Next(float &prob, float &backoff) {
+      const Entry &entry = orders_[order_ - 1].at(index_++);
+      prob = entry.prob;
+      backoff = entry.backoff;
+      return entry.words;
+    }
+
+    void End() {
+      BOOST_CHECK_EQUAL(orders_.size(), order_);
+    }
+
+    StringPiece Word(WordIndex id) const { return kWords[id]; }
+
+  private:
+    std::vector<std::vector<Entry> > orders_;
+    unsigned int order_;
+    std::size_t index_;
+};
+
+class TempDir {
+  public:
+    TempDir() {
+      char pattern[] = "/tmp/ngram_source_test.XXXXXX";
+      BOOST_REQUIRE(mkdtemp(pattern));
+      path_ = pattern;
+    }
+
+    ~TempDir() {
+      std::system(("rm -rf " + path_).c_str());
+    }
+
+    std::string File(const char *name) const { return path_ + "/" + name; }
+
+  private:
+    std::string path_;
+};
+
+std::string Contents(const std::string &file) {
+  std::ifstream in(file.c_str(), std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+ngram::Config Quiet() {
+  ngram::Config config;
+  config.messages = NULL;
+  return config;
+}
+
+// The binary file built from the source matches the one built from kARPA.
+template <class Model> void MatchesARPA() {
+  TempDir dir;
+  const std::string arpa(dir.File("test.arpa")), from_arpa(dir.File("arpa.bin")), from_source(dir.File("source.bin")), temp(dir.File(""));
+  {
+    std::ofstream out(arpa.c_str());
+    out << kARPA;
+  }
+  ngram::Config config(Quiet());
+  config.temporary_directory_prefix = temp.c_str();
+  {
+    config.write_mmap = from_arpa.c_str();
+    Model model(arpa.c_str(), config);
+  }
+  {
+    config.write_mmap = from_source.c_str();
+    VectorSource source;
+    Model model(source, config);
+    ngram::State out;
+    FullScoreReturn ret(model.FullScore(model.BeginSentenceState(), model.GetVocabulary().Index("a"), out));
+    BOOST_CHECK_CLOSE(-0.4, ret.prob, 0.001);
+    BOOST_CHECK_EQUAL(2, ret.ngram_length);
+    ngram::State in(out);
+    ret = model.FullScore(in, model.GetVocabulary().Index("b"), out);
+    BOOST_CHECK_CLOSE(-0.2, ret.prob, 0.001);
+    BOOST_CHECK_EQUAL(3, ret.ngram_length);
+  }
+  std::string expected(Contents(from_arpa));
+  BOOST_REQUIRE(!expected.empty());
+  BOOST_CHECK(expected == Contents(from_source));
+}
+
+BOOST_AUTO_TEST_CASE(Probing) {
+  MatchesARPA<ngram::ProbingModel>();
+}
+BOOST_AUTO_TEST_CASE(Trie) {
+  MatchesARPA<ngram::TrieModel>();
+}
+BOOST_AUTO_TEST_CASE(QuantArrayTrie) {
+  MatchesARPA<ngram::QuantArrayTrieModel>();
+}
+
+BOOST_AUTO_TEST_CASE(BadWordId) {
+  VectorSource source;
+  source.Orders()[1][2].words[0] = 5;
+  BOOST_CHECK_THROW(ngram::ProbingModel(source, Quiet()), FormatLoadException);
+}
+
+BOOST_AUTO_TEST_CASE(BackoffWithoutContext) {
+  VectorSource source;
+  source.Orders()[2][0].backoff = -0.1;
+  BOOST_CHECK_THROW(ngram::TrieModel(source, Quiet()), FormatLoadException);
+}
+
+} // namespace
+} // namespace lm
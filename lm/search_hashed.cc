@@ -4,6 +4,7 @@
 #include "lm/blank.hh"
 #include "lm/lm_exception.hh"
 #include "lm/model.hh"
+#include "lm/ngram_source.hh"
 #include "lm/read_arpa.hh"
 #include "lm/value.hh"
 #include "lm/vocab.hh"
@@ -156,8 +157,8 @@ template <class Build> void MarkLower(
   }
 }
 
-template <class Build, class Activate, class Store> void ReadNGrams(
-    util::FilePiece &f,
+template <class Input, class Build, class Activate, class Store> void ReadNGrams(
+    Input &f,
     const unsigned int n,
     const size_t count,
     const ProbingVocabulary &vocab,
@@ -219,7 +220,15 @@ template <class Value> uint8_t *HashedSearch<Value>::SetupMemory(uint8_t *start,
   return start;
 }
 
-template <class Value> void HashedSearch<Value>::InitializeFromARPA(const char * /*file*/, util::FilePiece &f, const std::vector<uint64_t> &counts, const Config &config, ProbingVocabulary &vocab, Backing &backing) {
+template <class Value> void HashedSearch<Value>::Initialize(const char * /*file*/, util::FilePiece &f, const std::vector<uint64_t> &counts, const Config &config, ProbingVocabulary &vocab, Backing &backing) {
+  InitializeFrom(f, counts, config, vocab, backing);
+}
+
+template <class Value> void HashedSearch<Value>::Initialize(const char * /*file*/, NGramSource &f, const std::vector<uint64_t> &counts, const Config &config, ProbingVocabulary &vocab, Backing &backing) {
+  InitializeFrom(f, counts, config, vocab, backing);
+}
+
+template <class Value> template <class Input> void HashedSearch<Value>::InitializeFrom(Input &f, const std::vector<uint64_t> &counts, const Config &config, ProbingVocabulary &vocab, Backing &backing) {
   // TODO: fix sorted.
   SetupMemory(GrowForSearch(config, vocab.UnkCountChangePadding(), Size(counts, config), backing), counts, config);
 
@@ -229,12 +238,12 @@ template <class Value> void HashedSearch<Value>::InitializeFromARPA(const char *
   DispatchBuild(f, counts, config, vocab, warn);
 }
 
-template <> void HashedSearch<BackoffValue>::DispatchBuild(util::FilePiece &f, const std::vector<uint64_t> &counts, const Config &config, const ProbingVocabulary &vocab, PositiveProbWarn &warn) {
+template <> template <class Input> void HashedSearch<BackoffValue>::DispatchBuild(Input &f, const std::vector<uint64_t> &counts, const Config &config, const ProbingVocabulary &vocab, PositiveProbWarn &warn) {
   NoRestBuild build;
   ApplyBuild(f, counts, vocab, warn, build);
 }
 
-template <> void HashedSearch<RestValue>::DispatchBuild(util::FilePiece &f, const std::vector<uint64_t> &counts, const Config &config, const ProbingVocabulary &vocab, PositiveProbWarn &warn) {
+template <> template <class Input> void HashedSearch<RestValue>::DispatchBuild(Input &f, const std::vector<uint64_t> &counts, const Config &config, const ProbingVocabulary &vocab, PositiveProbWarn &warn) {
   switch (config.rest_function) {
     case Config::REST_MAX:
       {
@@ -251,25 +260,25 @@ template <> void HashedSearch<RestValue>::DispatchBuild(util::FilePiece &f, cons
   }
 }
 
-template <class Value> template <class Build> void HashedSearch<Value>::ApplyBuild(util::FilePiece &f, const std::vector<uint64_t> &counts, const ProbingVocabulary &vocab, PositiveProbWarn &warn, const Build &build) {
+template <class Value> template <class Input, class Build> void HashedSearch<Value>::ApplyBuild(Input &f, const std::vector<uint64_t> &counts, const ProbingVocabulary &vocab, PositiveProbWarn &warn, const Build &build) {
   for (WordIndex i = 0; i < counts[0]; ++i) {
     build.SetRest(&i, (unsigned int)1, unigram_.Raw()[i]);
   }
 
   try {
     if (counts.size() > 2) {
-      ReadNGrams<Build, ActivateUnigram<typename Value::Weights>, Middle>(
+      ReadNGrams<Input, Build, ActivateUnigram<typename Value::Weights>, Middle>(
           f, 2, counts[1], vocab, build, unigram_.Raw(), middle_, ActivateUnigram<typename Value::Weights>(unigram_.Raw()), middle_[0], warn);
     }
     for (unsigned int n = 3; n < counts.size(); ++n) {
-      ReadNGrams<Build, ActivateLowerMiddle<Middle>, Middle>(
+      ReadNGrams<Input, Build, ActivateLowerMiddle<Middle>, Middle>(
           f, n, counts[n-1], vocab, build, unigram_.Raw(), middle_, ActivateLowerMiddle<Middle>(middle_[n-3]), middle_[n-2], warn);
     }
     if (counts.size() > 2) {
-      ReadNGrams<Build, ActivateLowerMiddle<Middle>, Longest>(
+      ReadNGrams<Input, Build, ActivateLowerMiddle<Middle>, Longest>(
           f, counts.size(), counts[counts.size() - 1], vocab, build, unigram_.Raw(), middle_, ActivateLowerMiddle<Middle>(middle_.back()), longest_, warn);
     } else {
-      ReadNGrams<Build, ActivateUnigram<typename Value::Weights>, Longest>(
+      ReadNGrams<Input, Build, ActivateUnigram<typename Value::Weights>, Longest>(
           f, counts.size(), counts[counts.size() - 1], vocab, build, unigram_.Raw(), middle_, ActivateUnigram<typename Value::Weights>(unigram_.Raw()), longest_, warn);
     }
   } catch (util::ProbingSizeException &e) {
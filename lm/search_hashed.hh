@@ -8,6 +8,7 @@
 #include "lm/weights.hh"
 
 #include "util/bit_packing.hh"
+#include "util/prefetch.hh"
 #include "util/probing_hash_table.hh"
 
 #include <algorithm>
@@ -17,6 +18,7 @@
 namespace util { class FilePiece; }
 
 namespace lm {
+class NGramSource;
 namespace ngram {
 struct Backing;
 class ProbingVocabulary;
@@ -84,7 +86,9 @@ template <class Value> class HashedSearch {
 
     uint8_t *SetupMemory(uint8_t *start, const std::vector<uint64_t> &counts, const Config &config);
 
-    void InitializeFromARPA(const char *file, util::FilePiece &f, const std::vector<uint64_t> &counts, const Config &config, ProbingVocabulary &vocab, Backing &backing);
+    // Read the n-grams from ARPA text or from a source.  
+    void Initialize(const char *file, util::FilePiece &f, const std::vector<uint64_t> &counts, const Config &config, ProbingVocabulary &vocab, Backing &backing);
+    void Initialize(const char *file, NGramSource &f, const std::vector<uint64_t> &counts, const Config &config, ProbingVocabulary &vocab, Backing &backing);
 
     void LoadedBinary();
 
@@ -102,6 +106,19 @@ template <class Value> class HashedSearch {
       return ret;
     }
 
+    // Start loading what scoring word after previous will read first: its
+    // unigram and, if previous is not NULL, the bigram bucket.
+    void Prefetch(WordIndex word, const WordIndex *previous) const {
+      unigram_.Prefetch(word);
+      if (!previous) return;
+      const Node bigram = CombineWordHash(static_cast<Node>(word), *previous);
+      if (middle_.empty()) {
+        longest_.Prefetch(bigram);
+      } else {
+        middle_[0].Prefetch(bigram);
+      }
+    }
+
 #pragma GCC diagnostic ignored "-Wuninitialized"
     MiddlePointer Unpack(uint64_t extend_pointer, unsigned char extend_length, Node &node) const {
       node = extend_pointer;
@@ -144,10 +161,12 @@ template <class Value> class HashedSearch {
     }
 
   private:
+    template <class Input> void InitializeFrom(Input &f, const std::vector<uint64_t> &counts, const Config &config, ProbingVocabulary &vocab, Backing &backing);
+
     // Interpret config's rest cost build policy and pass the right template argument to ApplyBuild.  
-    void DispatchBuild(util::FilePiece &f, const std::vector<uint64_t> &counts, const Config &config, const ProbingVocabulary &vocab, PositiveProbWarn &warn);
+    template <class Input> void DispatchBuild(Input &f, const std::vector<uint64_t> &counts, const Config &config, const ProbingVocabulary &vocab, PositiveProbWarn &warn);
 
-    template <class Build> void ApplyBuild(util::FilePiece &f, const std::vector<uint64_t> &counts, const ProbingVocabulary &vocab, PositiveProbWarn &warn, const Build &build);
+    template <class Input, class Build> void ApplyBuild(Input &f, const std::vector<uint64_t> &counts, const ProbingVocabulary &vocab, PositiveProbWarn &warn, const Build &build);
 
     class Unigram {
       public:
@@ -171,6 +190,10 @@ template <class Value> class HashedSearch {
           return unigram_[index];
         }
 
+        void Prefetch(WordIndex index) const {
+          util::Prefetch(unigram_ + index);
+        }
+
         typename Value::Weights &Unknown() { return unigram_[0]; }
 
         void LoadedBinary() {}
@@ -426,8 +426,9 @@ void SanityCheckCounts(const std::vector<uint64_t> &initial, const std::vector<u
   }
 }
 
-template <class Quant> void TrainQuantizer(uint8_t order, uint64_t count, const std::vector<float> &additional, RecordReader &reader, util::ErsatzProgress &progress, Quant &quant) {
-  std::vector<float> probs(additional), backoffs;
+void ReadQuantizerValues(uint8_t order, uint64_t count, const std::vector<float> &additional, RecordReader &reader, util::ErsatzProgress &progress, std::vector<float> &probs, std::vector<float> &backoffs) {
+  probs = additional;
+  backoffs.clear();
   probs.reserve(count + additional.size());
   backoffs.reserve(count);
   for (reader.Rewind(); reader; ++reader) {
@@ -436,20 +437,40 @@ template <class Quant> void TrainQuantizer(uint8_t order, uint64_t count, const
     if (weights.backoff != 0.0) backoffs.push_back(weights.backoff);
     ++progress;
   }
-  quant.Train(order, probs, backoffs);
 }
 
-template <class Quant> void TrainProbQuantizer(uint8_t order, uint64_t count, RecordReader &reader, util::ErsatzProgress &progress, Quant &quant) {
-  std::vector<float> probs, backoffs;
+void ReadProbQuantizerValues(uint8_t order, uint64_t count, RecordReader &reader, util::ErsatzProgress &progress, std::vector<float> &probs) {
+  probs.clear();
   probs.reserve(count);
   for (reader.Rewind(); reader; ++reader) {
     const Prob &weights = *reinterpret_cast<const Prob*>(reinterpret_cast<const uint8_t*>(reader.Data()) + sizeof(WordIndex) * order);
     probs.push_back(weights.prob);
     ++progress;
   }
-  quant.TrainProb(order, probs);
 }
 
+// Trains one order's bins.  Orders use separate tables, so this can run while
+// the next order's values are read.
+template <class Quant> class TrainOrder {
+  public:
+    TrainOrder(Quant &quant, uint8_t order, bool longest, std::vector<float> &probs, std::vector<float> &backoffs)
+      : quant_(&quant), order_(order), longest_(longest), probs_(&probs), backoffs_(&backoffs) {}
+
+    void operator()() const {
+      if (longest_) {
+        quant_->TrainProb(order_, *probs_);
+      } else {
+        quant_->Train(order_, *probs_, *backoffs_);
+      }
+    }
+
+  private:
+    Quant *quant_;
+    uint8_t order_;
+    bool longest_;
+    std::vector<float> *probs_, *backoffs_;
+};
+
 void PopulateUnigramWeights(FILE *file, WordIndex unigram_count, RecordReader &contexts, UnigramValue *unigrams) {
   // Fill unigram probabilities.
   try {
@@ -506,10 +527,18 @@ template <class Quant, class Bhiksha> void BuildTrie(SortedFiles &files, std::ve
   if (Quant::kTrain) {
     util::ErsatzProgress progress(std::accumulate(counts.begin() + 1, counts.end(), 0),
                                   config.ProgressMessages(), "Quantizing");
+    // Two sets of values: one being trained and one being read.  Start waits
+    // for the previous order, so a set is free again when it is read into.
+    std::vector<float> probs[2], backoffs[2];
+    Background training;
     for (unsigned char i = 2; i < counts.size(); ++i) {
-      TrainQuantizer(i, counts[i-1], sri.Values(i), inputs[i-2], progress, quant);
+      ReadQuantizerValues(i, counts[i-1], sri.Values(i), inputs[i-2], progress, probs[i % 2], backoffs[i % 2]);
+      training.Start(TrainOrder<Quant>(quant, i, false, probs[i % 2], backoffs[i % 2]));
     }
-    TrainProbQuantizer(counts.size(), counts.back(), inputs[counts.size() - 2], progress, quant);
+    const unsigned char longest = counts.size();
+    ReadProbQuantizerValues(longest, counts.back(), inputs[longest - 2], progress, probs[longest % 2]);
+    training.Start(TrainOrder<Quant>(quant, longest, true, probs[longest % 2], backoffs[longest % 2]));
+    training.Wait();
     quant.FinishedLoading(config);
   }
 
@@ -587,14 +616,24 @@ template <class Quant, class Bhiksha> void TrieSearch<Quant, Bhiksha>::LoadedBin
   longest_.LoadedBinary();
 }
 
-template <class Quant, class Bhiksha> void TrieSearch<Quant, Bhiksha>::InitializeFromARPA(const char *file, util::FilePiece &f, std::vector<uint64_t> &counts, const Config &config, SortedVocabulary &vocab, Backing &backing) {
+template <class Quant, class Bhiksha> void TrieSearch<Quant, Bhiksha>::Initialize(const char *file, util::FilePiece &f, std::vector<uint64_t> &counts, const Config &config, SortedVocabulary &vocab, Backing &backing) {
+  InitializeFrom(file, f, counts, config, vocab, backing);
+}
+
+template <class Quant, class Bhiksha> void TrieSearch<Quant, Bhiksha>::Initialize(const char *file, NGramSource &f, std::vector<uint64_t> &counts, const Config &config, SortedVocabulary &vocab, Backing &backing) {
+  InitializeFrom(file, f, counts, config, vocab, backing);
+}
+
+template <class Quant, class Bhiksha> template <class Input> void TrieSearch<Quant, Bhiksha>::InitializeFrom(const char *file, Input &f, std::vector<uint64_t> &counts, const Config &config, SortedVocabulary &vocab, Backing &backing) {
   std::string temporary_prefix;
   if (config.temporary_directory_prefix) {
     temporary_prefix = config.temporary_directory_prefix;
   } else if (config.write_mmap) {
     temporary_prefix = config.write_mmap;
-  } else {
+  } else if (file) {
     temporary_prefix = file;
+  } else {
+    temporary_prefix = "/tmp/";
   }
   // At least 1MB sorting memory.
   SortedFiles sorted(config, f, counts, std::max<size_t>(config.building_memory, 1048576), temporary_prefix, vocab);
@@ -15,6 +15,7 @@
 #include <assert.h>
 
 namespace lm {
+class NGramSource;
 namespace ngram {
 struct Backing;
 class SortedVocabulary;
@@ -60,7 +61,10 @@ template <class Quant, class Bhiksha> class TrieSearch {
 
     void LoadedBinary();
 
-    void InitializeFromARPA(const char *file, util::FilePiece &f, std::vector<uint64_t> &counts, const Config &config, SortedVocabulary &vocab, Backing &backing);
+    // Read the n-grams from ARPA text or from a source, sorting them on disk
+    // to build the trie.  
+    void Initialize(const char *file, util::FilePiece &f, std::vector<uint64_t> &counts, const Config &config, SortedVocabulary &vocab, Backing &backing);
+    void Initialize(const char *file, NGramSource &f, std::vector<uint64_t> &counts, const Config &config, SortedVocabulary &vocab, Backing &backing);
 
     unsigned char Order() const {
       return middle_end_ - middle_begin_ + 2;
@@ -75,6 +79,12 @@ template <class Quant, class Bhiksha> class TrieSearch {
       return ret;
     }
 
+    // Start loading the unigram entry that scoring word reads first.  Where its
+    // children are is not known until that entry arrives.
+    void Prefetch(WordIndex word, const WordIndex * /*previous*/) const {
+      unigram_.Prefetch(word);
+    }
+
     MiddlePointer Unpack(uint64_t extend_pointer, unsigned char extend_length, Node &node) const {
       return MiddlePointer(quant_, extend_length - 2, middle_begin_[extend_length - 2].ReadEntry(extend_pointer, node));
     }
@@ -103,6 +113,8 @@ template <class Quant, class Bhiksha> class TrieSearch {
   private:
     friend void BuildTrie<Quant, Bhiksha>(SortedFiles &files, std::vector<uint64_t> &counts, const Config &config, TrieSearch<Quant, Bhiksha> &out, Quant &quant, const SortedVocabulary &vocab, Backing &backing);
 
+    template <class Input> void InitializeFrom(const char *file, Input &f, std::vector<uint64_t> &counts, const Config &config, SortedVocabulary &vocab, Backing &backing);
+
     // Middles are managed manually so we can delay construction and they don't have to be copyable.  
     void FreeMiddles() {
       for (const Middle *i = middle_begin_; i != middle_end_; ++i) {
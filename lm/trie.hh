@@ -4,6 +4,7 @@
 #include "lm/weights.hh"
 #include "lm/word_index.hh"
 #include "util/bit_packing.hh"
+#include "util/prefetch.hh"
 
 #include <cstddef>
 
@@ -64,6 +65,10 @@ class Unigram {
     
     void LoadedBinary() {}
 
+    void Prefetch(WordIndex word) const {
+      util::Prefetch(unigram_ + word);
+    }
+
     UnigramPointer Find(WordIndex word, NodeRange &next) const {
       UnigramValue *val = unigram_ + word;
       next.begin = val->next;
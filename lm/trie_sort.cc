@@ -2,6 +2,7 @@
 
 #include "lm/config.hh"
 #include "lm/lm_exception.hh"
+#include "lm/ngram_source.hh"
 #include "lm/read_arpa.hh"
 #include "lm/vocab.hh"
 #include "lm/weights.hh"
@@ -139,6 +140,88 @@ template <class Combine> FILE *MergeSortedFiles(FILE *first_file, FILE *second_f
   return out_file.release();
 }
 
+class Closer {
+  public:
+    explicit Closer(std::deque<FILE*> &files) : files_(files) {}
+
+    ~Closer() {
+      for (std::deque<FILE*>::iterator i = files_.begin(); i != files_.end(); ++i) {
+        util::scoped_FILE deleter(*i);
+      }
+    }
+
+    void PopFront() {
+      util::scoped_FILE deleter(files_.front());
+      files_.pop_front();
+    }
+  private:
+    std::deque<FILE*> &files_;
+};
+
+// Sorts a batch of n-grams in place then writes it and its contexts.  
+class SortBatch {
+  public:
+    SortBatch(uint8_t *begin, uint8_t *end, const std::string &file_prefix, std::size_t entry_size, unsigned char order, util::scoped_FILE &full, util::scoped_FILE &context)
+      : begin_(begin), end_(end), file_prefix_(file_prefix), entry_size_(entry_size), order_(order), full_(&full), context_(&context) {}
+
+    void operator()() const {
+      // Sort full records by full n-gram.  
+      util::SizedProxy proxy_begin(begin_, entry_size_), proxy_end(end_, entry_size_);
+      // parallel_sort uses too much RAM.  TODO: figure out why windows sort doesn't like my proxies.  
+#if defined(_WIN32) || defined(_WIN64)
+      std::stable_sort
+#else
+      std::sort
+#endif
+          (NGramIter(proxy_begin), NGramIter(proxy_end), util::SizedCompare<EntryCompare>(EntryCompare(order_)));
+      full_->reset(DiskFlush(begin_, end_, file_prefix_));
+      context_->reset(WriteContextFile(begin_, end_, file_prefix_, entry_size_, order_));
+    }
+
+  private:
+    uint8_t *begin_, *end_;
+    std::string file_prefix_;
+    std::size_t entry_size_;
+    unsigned char order_;
+    util::scoped_FILE *full_, *context_;
+};
+
+// Merges the sorted batches of one order.  Closes the batch files when run.  
+class MergeOrder {
+  public:
+    MergeOrder(const std::deque<FILE*> &files, const std::deque<FILE*> &contexts, const std::string &file_prefix, std::size_t weights_size, unsigned char order, util::scoped_FILE &full, util::scoped_FILE &context)
+      : files_(files), contexts_(contexts), file_prefix_(file_prefix), weights_size_(weights_size), order_(order), full_(&full), context_(&context) {}
+
+    void operator()() const {
+      std::deque<FILE*> files(files_), contexts(contexts_);
+      Closer files_closer(files), contexts_closer(contexts);
+
+      while (files.size() > 1) {
+        files.push_back(MergeSortedFiles(files[0], files[1], file_prefix_, weights_size_, order_, ThrowCombine()));
+        files_closer.PopFront();
+        files_closer.PopFront();
+        contexts.push_back(MergeSortedFiles(contexts[0], contexts[1], file_prefix_, 0, order_ - 1, FirstCombine()));
+        contexts_closer.PopFront();
+        contexts_closer.PopFront();
+      }
+
+      if (!files.empty()) {
+        // Steal from closers.
+        full_->reset(files.front());
+        files.pop_front();
+        context_->reset(contexts.front());
+        contexts.pop_front();
+      }
+    }
+
+  private:
+    std::deque<FILE*> files_, contexts_;
+    std::string file_prefix_;
+    std::size_t weights_size_;
+    unsigned char order_;
+    util::scoped_FILE *full_, *context_;
+};
+
 } // namespace
 
 void RecordReader::Init(FILE *file, std::size_t entry_size) {
@@ -176,7 +259,7 @@ void RecordReader::Rewind() {
   }
 }
 
-SortedFiles::SortedFiles(const Config &config, util::FilePiece &f, std::vector<uint64_t> &counts, size_t buffer, const std::string &file_prefix, SortedVocabulary &vocab) {
+template <class Input> SortedFiles::SortedFiles(const Config &config, Input &f, std::vector<uint64_t> &counts, size_t buffer, const std::string &file_prefix, SortedVocabulary &vocab) {
   PositiveProbWarn warn(config.positive_log_probability);
   unigram_.reset(util::MakeTemp(file_prefix));
   {
@@ -200,46 +283,43 @@ SortedFiles::SortedFiles(const Config &config, util::FilePiece &f, std::vector<u
   mem.reset(malloc(buffer));
   if (!mem.get()) UTIL_THROW(util::ErrnoException, "malloc failed for sort buffer size " << buffer);
 
+  // Each order is merged while later orders are read.  These wait for their
+  // threads when destroyed, which happens before full_ and context_ go away.
+  Background merges[KENLM_MAX_ORDER - 1];
   for (unsigned char order = 2; order <= counts.size(); ++order) {
-    ConvertToSorted(f, vocab, counts, file_prefix, order, warn, mem.get(), buffer);
+    ConvertToSorted(f, vocab, counts, file_prefix, order, warn, mem.get(), buffer, merges[order - 2]);
   }
   ReadEnd(f);
+  for (unsigned char order = 2; order <= counts.size(); ++order) {
+    merges[order - 2].Wait();
+  }
 }
 
-namespace {
-class Closer {
-  public:
-    explicit Closer(std::deque<FILE*> &files) : files_(files) {}
-
-    ~Closer() {
-      for (std::deque<FILE*>::iterator i = files_.begin(); i != files_.end(); ++i) {
-        util::scoped_FILE deleter(*i);
-      }
-    }
-
-    void PopFront() {
-      util::scoped_FILE deleter(files_.front());
-      files_.pop_front();
-    }
-  private:
-    std::deque<FILE*> &files_;
-};
-} // namespace
-
-void SortedFiles::ConvertToSorted(util::FilePiece &f, const SortedVocabulary &vocab, const std::vector<uint64_t> &counts, const std::string &file_prefix, unsigned char order, PositiveProbWarn &warn, void *mem, std::size_t mem_size) {
+template <class Input> void SortedFiles::ConvertToSorted(Input &f, const SortedVocabulary &vocab, const std::vector<uint64_t> &counts, const std::string &file_prefix, unsigned char order, PositiveProbWarn &warn, void *mem, std::size_t mem_size, Background &merge) {
   ReadNGramHeader(f, order);
   const size_t count = counts[order - 1];
   // Size of weights.  Does it include backoff?  
   const size_t words_size = sizeof(WordIndex) * order;
   const size_t weights_size = sizeof(float) + ((order == counts.size()) ? 0 : sizeof(float));
   const size_t entry_size = words_size + weights_size;
-  const size_t batch_size = std::min(count, mem_size / entry_size);
-  uint8_t *const begin = reinterpret_cast<uint8_t*>(mem);
+  // With threads, a batch is sorted in one half of memory while the next is
+  // read into the other half.  
+#ifdef WITH_THREADS
+  const size_t halves = (mem_size / entry_size >= 2) ? 2 : 1;
+#else
+  const size_t halves = 1;
+#endif
+  const size_t batch_size = std::min(count, mem_size / halves / entry_size);
 
   std::deque<FILE*> files, contexts;
   Closer files_closer(files), contexts_closer(contexts);
 
+  // Declared before sorter, which writes to them until it is joined.
+  util::scoped_FILE sorted_full, sorted_context;
+  Background sorter;
+
   for (std::size_t batch = 0, done = 0; done < count; ++batch) {
+    uint8_t *const begin = reinterpret_cast<uint8_t*>(mem) + (batch % halves) * batch_size * entry_size;
     uint8_t *out = begin;
     uint8_t *out_end = out + std::min(count - done, batch_size) * entry_size;
     if (order == counts.size()) {
@@ -251,41 +331,32 @@ void SortedFiles::ConvertToSorted(util::FilePiece &f, const SortedVocabulary &vo
         ReadNGram(f, order, vocab, reinterpret_cast<WordIndex*>(out), *reinterpret_cast<ProbBackoff*>(out + words_size), warn);
       }
     }
-    // Sort full records by full n-gram.  
-    util::SizedProxy proxy_begin(begin, entry_size), proxy_end(out_end, entry_size);
-    // parallel_sort uses too much RAM.  TODO: figure out why windows sort doesn't like my proxies.  
-#if defined(_WIN32) || defined(_WIN64)
-    std::stable_sort
-#else
-    std::sort
-#endif
-        (NGramIter(proxy_begin), NGramIter(proxy_end), util::SizedCompare<EntryCompare>(EntryCompare(order)));
-    files.push_back(DiskFlush(begin, out_end, file_prefix));
-    contexts.push_back(WriteContextFile(begin, out_end, file_prefix, entry_size, order));
+    sorter.Wait();
+    if (sorted_full.get()) {
+      files.push_back(sorted_full.release());
+      contexts.push_back(sorted_context.release());
+    }
+    sorter.Start(SortBatch(begin, out_end, file_prefix, entry_size, order, sorted_full, sorted_context));
 
     done += (out_end - begin) / entry_size;
   }
-
-  // All individual files created.  Merge them.  
-
-  while (files.size() > 1) {
-    files.push_back(MergeSortedFiles(files[0], files[1], file_prefix, weights_size, order, ThrowCombine()));
-    files_closer.PopFront();
-    files_closer.PopFront();
-    contexts.push_back(MergeSortedFiles(contexts[0], contexts[1], file_prefix, 0, order - 1, FirstCombine()));
-    contexts_closer.PopFront();
-    contexts_closer.PopFront();
+  sorter.Wait();
+  if (sorted_full.get()) {
+    files.push_back(sorted_full.release());
+    contexts.push_back(sorted_context.release());
   }
 
-  if (!files.empty()) {
-    // Steal from closers.
-    full_[order - 2].reset(files.front());
-    files.pop_front();
-    context_[order - 2].reset(contexts.front());
-    contexts.pop_front();
-  }
+  // All individual files created.  Merge them.  
+  MergeOrder merge_order(files, contexts, file_prefix, weights_size, order, full_[order - 2], context_[order - 2]);
+  // merge_order owns the files now.
+  files.clear();
+  contexts.clear();
+  merge.Start(merge_order);
 }
 
+template SortedFiles::SortedFiles(const Config &config, util::FilePiece &f, std::vector<uint64_t> &counts, std::size_t buffer, const std::string &file_prefix, SortedVocabulary &vocab);
+template SortedFiles::SortedFiles(const Config &config, NGramSource &f, std::vector<uint64_t> &counts, std::size_t buffer, const std::string &file_prefix, SortedVocabulary &vocab);
+
 } // namespace trie
 } // namespace ngram
 } // namespace lm
@@ -3,13 +3,21 @@
 #ifndef LM_TRIE_SORT__
 #define LM_TRIE_SORT__
 
+#include "lm/lm_exception.hh"
 #include "lm/max_order.hh"
 #include "lm/word_index.hh"
 
 #include "util/file.hh"
 #include "util/scoped.hh"
 
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
 #include <cstddef>
+#include <exception>
 #include <functional>
 #include <string>
 #include <vector>
@@ -21,6 +29,7 @@ class FilePiece;
 } // namespace util
 
 namespace lm {
+class NGramSource;
 class PositiveProbWarn;
 namespace ngram {
 class SortedVocabulary;
@@ -82,10 +91,71 @@ class RecordReader {
     std::size_t entry_size_;
 };
 
+// Runs one piece of trie building (sorting, merging, training) alongside
+// the caller.  Wait rethrows anything the work threw.  Without threads, Start
+// just does the work.  
+class Background {
+  public:
+    Background() : failed_(false), format_(false) {}
+
+    ~Background() {
+#ifdef WITH_THREADS
+      if (thread_.get()) thread_->join();
+#endif
+    }
+
+    template <class Work> void Start(const Work &work) {
+      Wait();
+#ifdef WITH_THREADS
+      thread_.reset(new boost::thread(boost::bind(&Background::Call<Work>, this, work)));
+#else
+      work();
+#endif
+    }
+
+    void Wait() {
+#ifdef WITH_THREADS
+      if (thread_.get()) {
+        thread_->join();
+        thread_.reset();
+      }
+#endif
+      if (failed_) {
+        failed_ = false;
+        if (format_) UTIL_THROW(FormatLoadException, message_);
+        UTIL_THROW(util::Exception, message_);
+      }
+    }
+
+  private:
+#ifdef WITH_THREADS
+    template <class Work> void Call(const Work &work) {
+      try {
+        work();
+      } catch (const FormatLoadException &e) {
+        Fail(true, e.what());
+      } catch (const std::exception &e) {
+        Fail(false, e.what());
+      }
+    }
+
+    void Fail(bool format, const char *message) {
+      failed_ = true;
+      format_ = format;
+      message_ = message;
+    }
+
+    boost::scoped_ptr<boost::thread> thread_;
+#endif
+
+    bool failed_, format_;
+    std::string message_;
+};
+
 class SortedFiles {
   public:
-    // Build from ARPA
-    SortedFiles(const Config &config, util::FilePiece &f, std::vector<uint64_t> &counts, std::size_t buffer, const std::string &file_prefix, SortedVocabulary &vocab);
+    // Build from ARPA text (util::FilePiece) or an NGramSource.  
+    template <class Input> SortedFiles(const Config &config, Input &f, std::vector<uint64_t> &counts, std::size_t buffer, const std::string &file_prefix, SortedVocabulary &vocab);
 
     int StealUnigram() {
       return unigram_.release();
@@ -100,7 +170,7 @@ class SortedFiles {
     }
 
   private:
-    void ConvertToSorted(util::FilePiece &f, const SortedVocabulary &vocab, const std::vector<uint64_t> &counts, const std::string &prefix, unsigned char order, PositiveProbWarn &warn, void *mem, std::size_t mem_size);
+    template <class Input> void ConvertToSorted(Input &f, const SortedVocabulary &vocab, const std::vector<uint64_t> &counts, const std::string &prefix, unsigned char order, PositiveProbWarn &warn, void *mem, std::size_t mem_size, Background &merge);
     
     util::scoped_fd unigram_;
 
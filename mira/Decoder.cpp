@@ -103,7 +103,7 @@ namespace Mira {
                               string filename)
   {
   	StaticData &staticData = StaticData::InstanceNonConst();
-  	bool chartDecoding = (staticData.GetSearchAlgorithm() == ChartDecoding);
+  	bool chartDecoding = staticData.IsChart();
   	initialize(staticData, source, sentenceid, bleuObjectiveWeight, bleuScoreWeight, avgRefLength, chartDecoding);
     const TranslationSystem& system = staticData.GetTranslationSystem(TranslationSystem::DEFAULT);
 
@@ -268,7 +268,7 @@ namespace Mira {
   														size_t nBestSize, float bleuObjectiveWeight, float bleuScoreWeight,
   														bool distinctNbest, bool avgRefLength, string filename, ofstream& streamOut) {
   	StaticData &staticData = StaticData::InstanceNonConst();
-  	bool chartDecoding = (staticData.GetSearchAlgorithm() == ChartDecoding);
+  	bool chartDecoding = staticData.IsChart();
   	initialize(staticData, source, sentenceid, bleuObjectiveWeight, bleuScoreWeight, avgRefLength, chartDecoding);
     const TranslationSystem& system = staticData.GetTranslationSystem(TranslationSystem::DEFAULT);
 
@@ -23,8 +23,7 @@ int BleuScoreState::Compare(const FFState& o) const
       return 0;
 
     const StaticData &staticData = StaticData::Instance();
-    SearchAlgorithm searchAlgorithm = staticData.GetSearchAlgorithm();
-    bool chartDecoding = (searchAlgorithm == ChartDecoding);
+    bool chartDecoding = staticData.IsChart();
     if (chartDecoding) 
       return 0;
 
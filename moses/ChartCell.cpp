@@ -24,6 +24,7 @@
 #include "ChartCellCollection.h"
 #include "RuleCubeQueue.h"
 #include "RuleCube.h"
+#include "RuleCubeGrowingQueue.h"
 #include "WordsRange.h"
 #include "Util.h"
 #include "StaticData.h"
@@ -86,6 +87,11 @@ void ChartCell::ProcessSentence(const ChartTranslationOptionList &transOptList
 {
   const StaticData &staticData = StaticData::Instance();
 
+  if (staticData.GetSearchAlgorithm() == ChartCubeGrowing) {
+    ProcessSentenceCubeGrowing(transOptList, allChartCells);
+    return;
+  }
+
   // priority queue for applicable rules with selected hypotheses
   RuleCubeQueue queue(m_manager);
 
@@ -105,6 +111,40 @@ void ChartCell::ProcessSentence(const ChartTranslationOptionList &transOptList
   }
 }
 
+/** Decoding at span level using a single queue for all rules of the cell
+ *  (search-algorithm 6).  Popping stops at the pop limit or once the best
+ *  queued item falls outside the cube growing beam.
+ */
+void ChartCell::ProcessSentenceCubeGrowing(const ChartTranslationOptionList &transOptList
+                                           , const ChartCellCollection &allChartCells)
+{
+  const StaticData &staticData = StaticData::Instance();
+
+  RuleCubeGrowingQueue queue(allChartCells, m_manager);
+  for (size_t i = 0; i < transOptList.GetSize(); ++i) {
+    queue.Add(transOptList.Get(i));
+  }
+
+  const size_t popLimit = staticData.GetCubePruningPopLimit();
+  const float beamWidth = staticData.GetCubeGrowingBeamWidth();
+  float bestScore = -std::numeric_limits<float>::infinity();
+  for (size_t numPops = 0; numPops < popLimit && !queue.IsEmpty(); ++numPops)
+  {
+    const float topScore = queue.GetTopScore();
+    if (topScore < bestScore + beamWidth) {
+      break;
+    }
+    bestScore = std::max(bestScore, topScore);
+    ChartHypothesis *hypo = queue.Pop();
+    AddHypothesis(hypo);
+  }
+
+  m_manager.GetSentenceStats().AddCellSearch(
+    CellSearchInfo(m_coverage.GetStartPos(), m_coverage.GetEndPos(),
+                   queue.GetNumPops(), queue.GetNumPushes(),
+                   queue.GetNumDuplicates()));
+}
+
 //! call SortHypotheses() in each hypo collection in this cell
 void ChartCell::SortHypotheses()
 {
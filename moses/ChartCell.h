@@ -83,6 +83,9 @@ protected:
   bool m_nBestIsEnabled; /**< flag to determine whether to keep track of old arcs */
   ChartManager &m_manager;
 
+  void ProcessSentenceCubeGrowing(const ChartTranslationOptionList &transOptList
+                                  ,const ChartCellCollection &allChartCells);
+
 public:
   ChartCell(size_t startPos, size_t endPos, ChartManager &manager);
   ~ChartCell();
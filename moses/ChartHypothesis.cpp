@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <vector>
+#include <boost/functional/hash.hpp>
 #include "ChartHypothesis.h"
 #include "RuleCubeItem.h"
 #include "ChartCell.h"
@@ -142,6 +143,17 @@ int ChartHypothesis::RecombineCompare(const ChartHypothesis &compare) const
   return 0;
 }
 
+/** hash of the feature function states, consistent with RecombineCompare()
+ */
+std::size_t ChartHypothesis::RecombineHash() const
+{
+  std::size_t seed = 0;
+  for (unsigned i = 0; i < m_ffStates.size(); ++i) {
+    boost::hash_combine(seed, m_ffStates[i] ? m_ffStates[i]->Hash() : 0);
+  }
+  return seed;
+}
+
 /** calculate total score
   * @todo this should be in ScoreBreakdown
  */
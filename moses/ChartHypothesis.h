@@ -125,6 +125,7 @@ public:
   Phrase GetOutputPhrase() const;
 
 	int RecombineCompare(const ChartHypothesis &compare) const;
+  std::size_t RecombineHash() const;
 
   void CalcScore();
 
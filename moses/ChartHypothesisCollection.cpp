@@ -238,7 +238,7 @@ void ChartHypothesisCollection::PruneToSize(ChartManager &manager)
 
       // sort hypos
       std::copy(m_hypos.begin(), m_hypos.end(), std::inserter(hyposOrdered, hyposOrdered.end()));
-      std::sort(hyposOrdered.begin(), hyposOrdered.end(), ChartHypothesisScoreOrderer());
+      std::sort(hyposOrdered.begin(), hyposOrdered.end(), ChartHypothesisScoreStateOrderer());
 
       //keep only |size|. delete the rest
       std::vector<ChartHypothesis*>::iterator iter;
@@ -262,7 +262,7 @@ void ChartHypothesisCollection::SortHypotheses()
     // put into vec
     m_hyposOrdered.reserve(m_hypos.size());
     std::copy(m_hypos.begin(), m_hypos.end(), back_inserter(m_hyposOrdered));
-    std::sort(m_hyposOrdered.begin(), m_hyposOrdered.end(), ChartHypothesisScoreOrderer());
+    std::sort(m_hyposOrdered.begin(), m_hyposOrdered.end(), ChartHypothesisScoreStateOrderer());
   }
 }
 
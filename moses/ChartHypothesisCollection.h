@@ -20,7 +20,7 @@
  ***********************************************************************/
 #pragma once
 
-#include <set>
+#include <boost/unordered_set.hpp>
 #include "ChartHypothesis.h"
 #include "RuleCube.h"
 
@@ -37,10 +37,33 @@ public:
   }
 };
 
+/** functor to compare (chart) hypotheses by descending score, breaking ties
+ *  by feature function states so the order doesn't depend on the container.
+ */
+class ChartHypothesisScoreStateOrderer
+{
+public:
+  bool operator()(const ChartHypothesis* hypoA, const ChartHypothesis* hypoB) const {
+    if (hypoA->GetTotalScore() != hypoB->GetTotalScore()) {
+      return hypoA->GetTotalScore() > hypoB->GetTotalScore();
+    }
+    return hypoA->RecombineCompare(*hypoB) < 0;
+  }
+};
+
+//! functor to hash (chart) hypotheses by feature function states.
+class ChartHypothesisRecombinationHasher
+{
+public:
+  size_t operator()(const ChartHypothesis* hypo) const {
+    return hypo->RecombineHash();
+  }
+};
+
 /** functor to compare (chart) hypotheses by feature function states.
  *  If 2 hypos are equal, according to this functor, then they can be recombined.
  */
-class ChartHypothesisRecombinationOrderer
+class ChartHypothesisRecombinationEqualityPred
 {
 public:
   bool operator()(const ChartHypothesis* hypoA, const ChartHypothesis* hypoB) const {
@@ -52,11 +75,7 @@ public:
     // shouldn't be mixing hypos with different lhs
     CHECK(hypoA->GetTargetLHS() == hypoB->GetTargetLHS());
 
-    int ret = hypoA->RecombineCompare(*hypoB);
-    if (ret != 0)
-      return (ret < 0);
-
-    return false;
+    return hypoA->RecombineCompare(*hypoB) == 0;
   }
 };
 
@@ -68,7 +87,9 @@ class ChartHypothesisCollection
   friend std::ostream& operator<<(std::ostream&, const ChartHypothesisCollection&);
 
 protected:
-  typedef std::set<ChartHypothesis*, ChartHypothesisRecombinationOrderer> HCType;
+  typedef boost::unordered_set<ChartHypothesis*,
+                               ChartHypothesisRecombinationHasher,
+                               ChartHypothesisRecombinationEqualityPred> HCType;
   HCType m_hypos;
   HypoList m_hyposOrdered;
 
@@ -0,0 +1,249 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2013 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "ChartKBestExtractor.h"
+
+#include "Util.h"
+
+#include <boost/functional/hash.hpp>
+
+#include <set>
+
+namespace Moses
+{
+
+ChartKBestExtractor::Derivation::Derivation(const ChartHypothesis *e,
+                                            const std::vector<Vertex*> &t)
+  : edge(e)
+  , tail(t)
+  , backPointers(t.size(), 0)
+  , score(edge ? edge->GetTotalScore() : 0.0f)
+{
+  // The hypothesis' score already includes its previous hypotheses, which
+  // are normally (but not always, given ties) the best sub-derivations.
+  subderivations.reserve(tail.size());
+  for (std::size_t i = 0; i < tail.size(); ++i) {
+    subderivations.push_back(tail[i]->kBestList[0]);
+    score += subderivations[i]->score;
+    if (edge) {
+      score -= edge->GetPrevHypo(i)->GetTotalScore();
+    }
+  }
+}
+
+ChartKBestExtractor::Derivation::Derivation(const Derivation &d, std::size_t i)
+  : edge(d.edge)
+  , tail(d.tail)
+  , backPointers(d.backPointers)
+  , subderivations(d.subderivations)
+  , score(d.score)
+{
+  std::size_t index = ++backPointers[i];
+  score -= subderivations[i]->score;
+  subderivations[i] = tail[i]->kBestList[index];
+  score += subderivations[i]->score;
+}
+
+std::size_t ChartKBestExtractor::DerivationHasher::operator()(
+  const DerivationPtr &d) const
+{
+  std::size_t seed = 0;
+  boost::hash_combine(seed, d->edge);
+  boost::hash_combine(seed, d->tail);
+  boost::hash_combine(seed, d->backPointers);
+  return seed;
+}
+
+bool ChartKBestExtractor::DerivationEqualityPred::operator()(
+  const DerivationPtr &d1, const DerivationPtr &d2) const
+{
+  return d1->edge == d2->edge &&
+         d1->tail == d2->tail &&
+         d1->backPointers == d2->backPointers;
+}
+
+ChartKBestExtractor::~ChartKBestExtractor()
+{
+  RemoveAllInColl(m_vertices);
+}
+
+void ChartKBestExtractor::Extract(
+  const std::vector<const ChartHypothesis*> &topHypos, std::size_t k,
+  bool onlyDistinct, std::size_t popLimit,
+  std::vector<DerivationPtr> &kBestList)
+{
+  kBestList.clear();
+  if (topHypos.empty() || k == 0) {
+    return;
+  }
+
+  // The top cell can hold several winning hypotheses (one per LHS and
+  // state), so create a virtual root with one unary hyperarc to each.
+  Vertex *root = new Vertex(NULL);
+  m_vertices.push_back(root);
+  for (std::vector<const ChartHypothesis*>::const_iterator p = topHypos.begin();
+       p != topHypos.end(); ++p) {
+    Vertex *vertex = FindOrCreateVertex(**p);
+    LazyKthBest(*vertex, 1);
+    AddCandidate(*root, NULL, std::vector<Vertex*>(1, vertex));
+  }
+  root->visited = true;
+
+  // Reveal derivations one at a time so that, if only distinct translations
+  // are wanted, we can stop as soon as there are enough of them.
+  std::set<Phrase> distinctHyps;
+  for (std::size_t i = 0; kBestList.size() < k && i < popLimit; ++i) {
+    LazyKthBest(*root, i+1);
+    if (root->kBestList.size() <= i) {
+      break;
+    }
+    const DerivationPtr &d = root->kBestList[i];
+    if (!onlyDistinct || distinctHyps.insert(GetOutputPhrase(*d)).second) {
+      kBestList.push_back(d);
+    }
+  }
+}
+
+const ChartKBestExtractor::Derivation &ChartKBestExtractor::GetTopDerivation(
+  const Derivation &d)
+{
+  return d.edge ? d : *d.subderivations[0];
+}
+
+Phrase ChartKBestExtractor::GetOutputPhrase(const Derivation &d)
+{
+  Phrase ret(ARRAY_SIZE_INCR);
+  CreateOutputPhrase(GetTopDerivation(d), ret);
+  return ret;
+}
+
+// exactly like ChartHypothesis::CreateOutputPhrase, but using the
+// sub-derivations instead of the previous hypotheses
+void ChartKBestExtractor::CreateOutputPhrase(const Derivation &d, Phrase &out)
+{
+  const Phrase &currTargetPhrase = d.edge->GetCurrTargetPhrase();
+  const AlignmentInfo::NonTermIndexMap &nonTermIndexMap =
+    d.edge->GetCurrTargetPhrase().GetAlignNonTerm().GetNonTermIndexMap();
+  for (size_t pos = 0; pos < currTargetPhrase.GetSize(); ++pos) {
+    const Word &word = currTargetPhrase.GetWord(pos);
+    if (word.IsNonTerminal()) {
+      size_t nonTermInd = nonTermIndexMap[pos];
+      CreateOutputPhrase(*d.subderivations[nonTermInd], out);
+    } else {
+      out.AddWord(word);
+    }
+  }
+}
+
+// The hypothesis' breakdown covers its best sub-derivations, so swap in the
+// breakdowns of the sub-derivations that were actually chosen.
+ScoreComponentCollection ChartKBestExtractor::GetScoreBreakdown(
+  const Derivation &d)
+{
+  const Derivation &top = GetTopDerivation(d);
+  ScoreComponentCollection ret = top.edge->GetScoreBreakdown();
+  for (std::size_t i = 0; i < top.subderivations.size(); ++i) {
+    ret.PlusEquals(GetScoreBreakdown(*top.subderivations[i]));
+    ret.MinusEquals(top.edge->GetPrevHypo(i)->GetScoreBreakdown());
+  }
+  return ret;
+}
+
+ChartKBestExtractor::Vertex *ChartKBestExtractor::FindOrCreateVertex(
+  const ChartHypothesis &hypo)
+{
+  std::pair<VertexMap::iterator, bool> p =
+    m_vertexMap.insert(std::make_pair(&hypo, static_cast<Vertex*>(NULL)));
+  if (p.second) {
+    p.first->second = new Vertex(&hypo);
+    m_vertices.push_back(p.first->second);
+  }
+  return p.first->second;
+}
+
+// Push the best derivation of every incoming hyperarc: the winning hypothesis
+// itself plus everything recombined into it.
+void ChartKBestExtractor::GetCandidates(Vertex &v)
+{
+  const ChartHypothesis &winner = *v.hypo;
+  std::vector<const ChartHypothesis*> edges(1, &winner);
+  const ChartArcList *arcList = winner.GetArcList();
+  if (arcList) {
+    edges.insert(edges.end(), arcList->begin(), arcList->end());
+  }
+
+  for (std::vector<const ChartHypothesis*>::const_iterator p = edges.begin();
+       p != edges.end(); ++p) {
+    const ChartHypothesis &edge = **p;
+    const std::vector<const ChartHypothesis*> &prevHypos = edge.GetPrevHypos();
+    std::vector<Vertex*> tail;
+    tail.reserve(prevHypos.size());
+    for (std::size_t i = 0; i < prevHypos.size(); ++i) {
+      Vertex *child = FindOrCreateVertex(*prevHypos[i]);
+      LazyKthBest(*child, 1);
+      tail.push_back(child);
+    }
+    AddCandidate(v, &edge, tail);
+  }
+}
+
+void ChartKBestExtractor::AddCandidate(Vertex &v, const ChartHypothesis *edge,
+                                       const std::vector<Vertex*> &tail)
+{
+  DerivationPtr d(new Derivation(edge, tail));
+  if (v.seen.insert(d).second) {
+    v.candidates.push(d);
+  }
+}
+
+void ChartKBestExtractor::LazyKthBest(Vertex &v, std::size_t k)
+{
+  if (!v.visited) {
+    GetCandidates(v);
+    v.visited = true;
+  }
+  while (v.kBestList.size() < k) {
+    if (!v.kBestList.empty()) {
+      // Add the successors of the last derivation to the candidates.
+      LazyNext(v, *v.kBestList.back());
+    }
+    if (v.candidates.empty()) {
+      break;
+    }
+    v.kBestList.push_back(v.candidates.top());
+    v.candidates.pop();
+  }
+}
+
+void ChartKBestExtractor::LazyNext(Vertex &v, const Derivation &d)
+{
+  for (std::size_t i = 0; i < d.tail.size(); ++i) {
+    Vertex &child = *d.tail[i];
+    std::size_t index = d.backPointers[i] + 1;
+    LazyKthBest(child, index+1);
+    if (index < child.kBestList.size()) {
+      DerivationPtr next(new Derivation(d, i));
+      if (v.seen.insert(next).second) {
+        v.candidates.push(next);
+      }
+    }
+  }
+}
+
+}  // namespace Moses
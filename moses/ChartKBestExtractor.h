@@ -0,0 +1,141 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2013 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include "ChartHypothesis.h"
+#include "Phrase.h"
+#include "ScoreComponentCollection.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include <queue>
+#include <vector>
+
+namespace Moses
+{
+
+/** Lazy k-best extraction from the chart decoder's hypergraph, following
+ * algorithm 3 of Huang and Chiang (2005), "Better k-best Parsing".
+ *
+ * A vertex is a winning ChartHypothesis.  Its incoming hyperarcs are the
+ * winner itself and the hypotheses in its arc list; their tails are the
+ * winners pointed to by GetPrevHypos().  A derivation is a hyperarc plus,
+ * for each tail vertex, an index into that vertex's k-best list, so
+ * derivations share their sub-derivations instead of copying them.
+ */
+class ChartKBestExtractor
+{
+ public:
+  struct Vertex;
+
+  struct Derivation {
+    // The best derivation that uses hyperarc (NULL for the virtual root).
+    Derivation(const ChartHypothesis *, const std::vector<Vertex*> &);
+    // The successor of a derivation along tail position i.
+    Derivation(const Derivation &, std::size_t i);
+
+    const ChartHypothesis *edge;
+    std::vector<Vertex*> tail;
+    std::vector<std::size_t> backPointers;
+    std::vector<boost::shared_ptr<Derivation> > subderivations;
+    float score;
+  };
+
+  typedef boost::shared_ptr<Derivation> DerivationPtr;
+
+  ChartKBestExtractor() {}
+  ~ChartKBestExtractor();
+
+  /** Find the top k derivations rooted at any of topHypos, which are the
+   * winning hypotheses of the top cell.  Derivations are revealed lazily
+   * and, if onlyDistinct, only the first one with each output string is
+   * kept.  At most popLimit derivations are considered.
+   */
+  void Extract(const std::vector<const ChartHypothesis*> &topHypos,
+               std::size_t k, bool onlyDistinct, std::size_t popLimit,
+               std::vector<DerivationPtr> &kBestList);
+
+  //! the hypothesis at the root of a derivation returned by Extract
+  static const Derivation &GetTopDerivation(const Derivation &);
+
+  static Phrase GetOutputPhrase(const Derivation &);
+
+  static ScoreComponentCollection GetScoreBreakdown(const Derivation &);
+
+ private:
+  class DerivationOrderer
+  {
+   public:
+    bool operator()(const DerivationPtr &d1, const DerivationPtr &d2) const {
+      return d1->score < d2->score;
+    }
+  };
+
+  class DerivationHasher
+  {
+   public:
+    std::size_t operator()(const DerivationPtr &) const;
+  };
+
+  class DerivationEqualityPred
+  {
+   public:
+    bool operator()(const DerivationPtr &, const DerivationPtr &) const;
+  };
+
+ public:
+  struct Vertex {
+    typedef std::priority_queue<DerivationPtr, std::vector<DerivationPtr>,
+                                DerivationOrderer> CandidateQueue;
+
+    typedef boost::unordered_set<DerivationPtr, DerivationHasher,
+                                 DerivationEqualityPred> DerivationSet;
+
+    Vertex(const ChartHypothesis *h) : hypo(h), visited(false) {}
+
+    const ChartHypothesis *hypo;  // NULL for the virtual root
+    std::vector<DerivationPtr> kBestList;
+    CandidateQueue candidates;
+    DerivationSet seen;
+    bool visited;
+  };
+
+ private:
+  typedef boost::unordered_map<const ChartHypothesis*, Vertex*> VertexMap;
+
+  ChartKBestExtractor(const ChartKBestExtractor &);  // Not implemented
+  ChartKBestExtractor &operator=(const ChartKBestExtractor &);  // Not implemented
+
+  Vertex *FindOrCreateVertex(const ChartHypothesis &);
+  void GetCandidates(Vertex &);
+  void AddCandidate(Vertex &, const ChartHypothesis *,
+                    const std::vector<Vertex*> &);
+  void LazyKthBest(Vertex &, std::size_t);
+  void LazyNext(Vertex &, const Derivation &);
+
+  static void CreateOutputPhrase(const Derivation &, Phrase &);
+
+  VertexMap m_vertexMap;
+  std::vector<Vertex*> m_vertices;
+};
+
+}  // namespace Moses
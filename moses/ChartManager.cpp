@@ -24,7 +24,7 @@
 #include "ChartCell.h"
 #include "ChartHypothesis.h"
 #include "ChartTranslationOptions.h"
-#include "ChartTrellisDetourQueue.h"
+#include "ChartKBestExtractor.h"
 #include "ChartTrellisNode.h"
 #include "ChartTrellisPath.h"
 #include "ChartTrellisPathList.h"
@@ -121,6 +121,12 @@ void ChartManager::ProcessSentence()
       cerr << endl;
     }
   }
+
+  if (StaticData::Instance().GetSearchAlgorithm() == ChartCubeGrowing) {
+    IFVERBOSE(2) {
+      OutputCellSearchInfos(cerr, GetSentenceStats());
+    }
+  }
 }
 
 /** add specific translation options and hypotheses according to the XML override translation scheme.
@@ -182,22 +188,23 @@ void ChartManager::CalcNBest(size_t count, ChartTrellisPathList &ret,bool onlyDi
     // no hypothesis
     return;
   }
-  boost::shared_ptr<ChartTrellisPath> basePath(new ChartTrellisPath(*hypo));
 
   // Add it to the n-best list.
   if (count == 1) {
-	ret.Add(basePath);
+    boost::shared_ptr<ChartTrellisPath> basePath(new ChartTrellisPath(*hypo));
+    ret.Add(basePath);
     return;
   }
 
-  // Set a limit on the number of detours to pop.  If the n-best list is
-  // restricted to distinct translations then this limit should be bigger
-  // than n.  The n-best factor determines how much bigger the limit should be.
+  // Set a limit on the number of derivations to consider.  If the n-best
+  // list is restricted to distinct translations then this limit should be
+  // bigger than n.  The n-best factor determines how much bigger the limit
+  // should be.
   const StaticData &staticData = StaticData::Instance();
   const size_t nBestFactor = staticData.GetNBestFactor();
   size_t popLimit;
   if (!onlyDistinct) {
-    popLimit = count-1;
+    popLimit = count;
   } else if (nBestFactor == 0) {
     // 0 = 'unlimited.'  This actually sets a large-ish limit in case too many
     // translations are identical.
@@ -206,54 +213,20 @@ void ChartManager::CalcNBest(size_t count, ChartTrellisPathList &ret,bool onlyDi
     popLimit = count * nBestFactor;
   }
 
-  // Create an empty priority queue of detour objects.  It is bounded to
-  // contain no more than popLimit items.
-  ChartTrellisDetourQueue contenders(popLimit);
-
   // Get all complete translations
   const HypoList *topHypos = lastCell.GetAllSortedHypotheses();
-  
-  // Create a ChartTrellisDetour for each complete translation and add it to the queue
-  HypoList::const_iterator iter;
-  for (iter = topHypos->begin(); iter != topHypos->end(); ++iter) {
-	  const ChartHypothesis &hypo = **iter;
-	  boost::shared_ptr<ChartTrellisPath> basePath(new ChartTrellisPath(hypo));
-	  ChartTrellisDetour *detour = new ChartTrellisDetour(basePath, basePath->GetFinalNode(), hypo);
-	  contenders.Push(detour);
-  }
- 	
+
+  // Extract the k-best derivations lazily from the hypergraph.
+  ChartKBestExtractor extractor;
+  std::vector<ChartKBestExtractor::DerivationPtr> kBestList;
+  extractor.Extract(*topHypos, count, onlyDistinct, popLimit, kBestList);
+
   delete topHypos;
 
-  // Record the output phrase if distinct translations are required.
-  set<Phrase> distinctHyps;
-  
-  // MAIN loop
-  for (size_t i = 0; ret.GetSize() < count && !contenders.Empty() && i < popLimit; ++i) {
-    // Get the best detour from the queue.
-    std::auto_ptr<const ChartTrellisDetour> detour(contenders.Pop());
-    CHECK(detour.get());
-
-    // Create a full base path from the chosen detour.
-    //basePath.reset(new ChartTrellisPath(*detour));
-    boost::shared_ptr<ChartTrellisPath> path(new ChartTrellisPath(*detour));
-    
-    // Generate new detours from this base path and add them to the queue of
-    // contenders.  The new detours deviate from the base path by a single
-    // replacement along the previous detour sub-path.
-    CHECK(path->GetDeviationPoint());
-    CreateDeviantPaths(path, *(path->GetDeviationPoint()), contenders);
-
-    // If the n-best list is allowed to contain duplicate translations (at the
-    // surface level) then add the new path unconditionally, otherwise check
-    // whether the translation has seen before.
-    if (!onlyDistinct) {
-      ret.Add(path);
-    } else {
-      Phrase tgtPhrase = path->GetOutputPhrase();
-      if (distinctHyps.insert(tgtPhrase).second) {
-        ret.Add(path);
-      }
-    }
+  for (std::vector<ChartKBestExtractor::DerivationPtr>::const_iterator
+       p = kBestList.begin(); p != kBestList.end(); ++p) {
+    boost::shared_ptr<ChartTrellisPath> path(new ChartTrellisPath(**p));
+    ret.Add(path);
   }
 }
 
@@ -312,37 +285,6 @@ void ChartManager::FindReachableHypotheses( const ChartHypothesis *hypo, std::ma
 	}
 }
 
-void ChartManager::CreateDeviantPaths(
-    boost::shared_ptr<const ChartTrellisPath> basePath,
-    ChartTrellisDetourQueue &q)
-{
-  CreateDeviantPaths(basePath, basePath->GetFinalNode(), q);
-}
-
-void ChartManager::CreateDeviantPaths(
-    boost::shared_ptr<const ChartTrellisPath> basePath,
-    const ChartTrellisNode &substitutedNode,
-    ChartTrellisDetourQueue &queue)
-{
-  const ChartArcList *arcList = substitutedNode.GetHypothesis().GetArcList();
-  if (arcList) {
-    for (ChartArcList::const_iterator iter = arcList->begin();
-         iter != arcList->end(); ++iter) {
-      const ChartHypothesis &replacement = **iter;
-      queue.Push(new ChartTrellisDetour(basePath, substitutedNode,
-                                        replacement));
-    }
-  }
-  // recusively create deviant paths for child nodes
-  const ChartTrellisNode::NodeChildren &children = substitutedNode.GetChildren();
-  ChartTrellisNode::NodeChildren::const_iterator iter;
-  for (iter = children.begin(); iter != children.end(); ++iter) {
-    const ChartTrellisNode &child = **iter;
-    CreateDeviantPaths(basePath, child, queue);
-  }
-}
-
-  
 void ChartManager::PreCalculateScores() 
 {
   for (size_t i = 0; i < m_translationOptionList.GetSize(); ++i) {
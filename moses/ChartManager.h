@@ -38,7 +38,6 @@ namespace Moses
 {
 
 class ChartHypothesis;
-class ChartTrellisDetourQueue;
 class ChartTrellisNode;
 class ChartTrellisPath;
 class ChartTrellisPathList;
@@ -48,13 +47,6 @@ class ChartTrellisPathList;
 class ChartManager
 {
 private:
-  static void CreateDeviantPaths(boost::shared_ptr<const ChartTrellisPath>,
-                                 ChartTrellisDetourQueue &);
-
-  static void CreateDeviantPaths(boost::shared_ptr<const ChartTrellisPath>,
-                                 const ChartTrellisNode &,
-                                 ChartTrellisDetourQueue &);
-
   InputType const& m_source; /**< source sentence to be translated */
   ChartCellCollection m_hypoStackColl;
   std::auto_ptr<SentenceStats> m_sentenceStats;
@@ -22,13 +22,13 @@
 #pragma once
 
 #include <vector>
+#include "ChartKBestExtractor.h"
 #include "Phrase.h"
 
 namespace Moses
 {
 class ScoreComponentCollection;
 class ChartHypothesis;
-class ChartTrellisDetour;
 
 /**  1 node in the output hypergraph. Used in ChartTrellisPath
  */
@@ -38,7 +38,7 @@ class ChartTrellisNode
   typedef std::vector<ChartTrellisNode*> NodeChildren;
 
   ChartTrellisNode(const ChartHypothesis &hypo);
-  ChartTrellisNode(const ChartTrellisDetour &, ChartTrellisNode *&);
+  ChartTrellisNode(const ChartKBestExtractor::Derivation &);
 
   ~ChartTrellisNode();
 
@@ -54,12 +54,7 @@ class ChartTrellisNode
   ChartTrellisNode(const ChartTrellisNode &);  // Not implemented
   ChartTrellisNode& operator=(const ChartTrellisNode &);  // Not implemented
 
-  ChartTrellisNode(const ChartTrellisNode &, const ChartTrellisNode &,
-                   const ChartHypothesis &, ChartTrellisNode *&);
-
   void CreateChildren();
-  void CreateChildren(const ChartTrellisNode &, const ChartTrellisNode &,
-                      const ChartHypothesis &, ChartTrellisNode *&);
 
   const ChartHypothesis &m_hypo;
   NodeChildren m_children;
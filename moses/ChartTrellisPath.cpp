@@ -22,8 +22,6 @@
 #include "ChartTrellisPath.h"
 
 #include "ChartHypothesis.h"
-#include "ChartTrellisDetour.h"
-#include "ChartTrellisDetourQueue.h"
 #include "ChartTrellisNode.h"
 
 namespace Moses
@@ -31,23 +29,18 @@ namespace Moses
 
 ChartTrellisPath::ChartTrellisPath(const ChartHypothesis &hypo)
     : m_finalNode(new ChartTrellisNode(hypo))
-    , m_deviationPoint(NULL)
     , m_scoreBreakdown(hypo.GetScoreBreakdown())
     , m_totalScore(hypo.GetTotalScore())
 {
 }
 
-ChartTrellisPath::ChartTrellisPath(const ChartTrellisDetour &detour)
-   : m_finalNode(new ChartTrellisNode(detour, m_deviationPoint))
-   , m_scoreBreakdown(detour.GetBasePath().m_scoreBreakdown)
-   , m_totalScore(0)
+ChartTrellisPath::ChartTrellisPath(
+  const ChartKBestExtractor::Derivation &derivation)
+   : m_finalNode(new ChartTrellisNode(
+                   ChartKBestExtractor::GetTopDerivation(derivation)))
+   , m_scoreBreakdown(ChartKBestExtractor::GetScoreBreakdown(derivation))
+   , m_totalScore(m_scoreBreakdown.GetWeightedScore())
 {
-  CHECK(m_deviationPoint);
-  ScoreComponentCollection scoreChange;
-  scoreChange = detour.GetReplacementHypo().GetScoreBreakdown();
-  scoreChange.MinusEquals(detour.GetSubstitutedNode().GetHypothesis().GetScoreBreakdown());
-  m_scoreBreakdown.PlusEquals(scoreChange);
-  m_totalScore = m_scoreBreakdown.GetWeightedScore();
 }
 
 ChartTrellisPath::~ChartTrellisPath()
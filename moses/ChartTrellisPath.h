@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "ChartKBestExtractor.h"
 #include "ScoreComponentCollection.h"
 #include "Phrase.h"
 
@@ -30,8 +31,6 @@ namespace Moses
 {
 
 class ChartHypothesis;
-class ChartTrellisDetour;
-class ChartTrellisDetourQueue;
 class ChartTrellisNode;
 
 /** 1 path through the output hypergraph
@@ -43,14 +42,12 @@ class ChartTrellisPath
 {
  public:
   ChartTrellisPath(const ChartHypothesis &hypo);
-  ChartTrellisPath(const ChartTrellisDetour &detour);
+  ChartTrellisPath(const ChartKBestExtractor::Derivation &derivation);
 
   ~ChartTrellisPath();
 
   const ChartTrellisNode &GetFinalNode() const { return *m_finalNode; }
 
-  const ChartTrellisNode *GetDeviationPoint() const { return m_deviationPoint; }
-
   //! get score for this path throught trellis
   float GetTotalScore() const { return m_totalScore; }
 
@@ -66,7 +63,6 @@ class ChartTrellisPath
   ChartTrellisPath &operator=(const ChartTrellisPath &);  // Not implemented
 
   ChartTrellisNode *m_finalNode;
-  ChartTrellisNode *m_deviationPoint;
   ScoreComponentCollection m_scoreBreakdown;
   float m_totalScore;
 };
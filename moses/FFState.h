@@ -2,6 +2,7 @@
 #define moses_FFState_h
 
 #include "util/check.hh"
+#include <cstddef>
 #include <vector>
 
 
@@ -15,6 +16,14 @@ class FFState
 public:
   virtual ~FFState();
   virtual int Compare(const FFState& other) const = 0;
+
+  /** Hash for recombination in the chart decoder.  States for which Compare
+   *  returns 0 must have the same hash.  The default is always correct but
+   *  means this feature does not help to tell hypotheses apart.
+   */
+  virtual std::size_t Hash() const {
+    return 0;
+  }
 };
 
 class DummyState : public FFState {
@@ -12,11 +12,18 @@
 #include "search/config.hh"
 #include "search/context.hh"
 #include "search/edge_generator.hh"
+#include "search/memory.hh"
 #include "search/rule.hh"
 #include "search/vertex_generator.hh"
 
 #include <boost/lexical_cast.hpp>
 
+#include <limits>
+#include <set>
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#endif
+
 namespace Moses {
 namespace Incremental {
 namespace {
@@ -67,7 +74,7 @@ template <class Best> class HypothesisCallback {
 template <class Model> class Fill : public ChartParserCallback {
   public:
     Fill(search::Context<Model> &context, const std::vector<lm::WordIndex> &vocab_mapping, search::Score oov_weight)
-      : context_(context), vocab_mapping_(vocab_mapping), oov_weight_(oov_weight) {}
+      : context_(context), vocab_mapping_(vocab_mapping), edges_(context.GetMemory()), oov_weight_(oov_weight) {}
 
     void Add(const TargetPhraseCollection &targets, const StackVec &nts, const WordsRange &ignored);
 
@@ -170,14 +177,51 @@ struct ChartCellBaseFactory {
   }
 };
 
+// Search pools are kept per thread so their memory is reused across sentences.  
+#ifdef WITH_THREADS
+boost::thread_specific_ptr<search::Memory> thread_memory;
+#else
+std::auto_ptr<search::Memory> thread_memory;
+#endif
+
+// Like ChartManager::CalcNBest, at most size times the n-best factor
+// derivations are considered for a distinct n-best list of the given size, or
+// 1000 times if the factor is 0.  Saturates instead of overflowing.  
+unsigned int DistinctNBestLimit(std::size_t size) {
+  const std::size_t factor = StaticData::Instance().GetNBestFactor();
+  const std::size_t multiple = factor ? factor : 1000;
+  const std::size_t most = std::numeric_limits<unsigned int>::max();
+  if (size && multiple > most / size) return most;
+  return size * multiple;
+}
+
+// With distinct n-best lists, derivations that have the same string are
+// dropped, so as many are kept at each vertex as will be extracted.  
+search::NBestConfig NBestConfigFromStaticData() {
+  const StaticData &data = StaticData::Instance();
+  search::NBestConfig config(data.GetNBestSize());
+  if (data.GetDistinctNBest()) {
+    config.keep = DistinctNBestLimit(config.size);
+  }
+  return config;
+}
+
+search::Memory &ThreadMemory() {
+  if (!thread_memory.get()) thread_memory.reset(new search::Memory());
+  thread_memory->NewSentence();
+  return *thread_memory;
+}
+
 } // namespace
 
 Manager::Manager(const InputType &source, const TranslationSystem &system) :
   source_(source),
   system_(system),
+  memory_(ThreadMemory()),
   cells_(source, ChartCellBaseFactory()),
   parser_(source, system, cells_),
-  n_best_(search::NBestConfig(StaticData::Instance().GetNBestSize())) {}
+  single_best_(memory_.FinalPool()),
+  n_best_(NBestConfigFromStaticData(), memory_.FinalPool()) {}
 
 Manager::~Manager() {
   system_.CleanUpAfterSentenceProcessing(source_);
@@ -187,8 +231,8 @@ template <class Model, class Best> search::History Manager::PopulateBest(const M
   const LanguageModel &abstract = **system_.GetLanguageModels().begin();
   const float oov_weight = abstract.OOVFeatureEnabled() ? abstract.GetOOVWeight() : 0.0;
   const StaticData &data = StaticData::Instance();
-  search::Config config(abstract.GetWeight(), data.GetCubePruningPopLimit(), search::NBestConfig(data.GetNBestSize()));
-  search::Context<Model> context(config, model);
+  search::Config config(abstract.GetWeight(), data.GetCubePruningPopLimit(), NBestConfigFromStaticData());
+  search::Context<Model> context(config, memory_, model);
 
   size_t size = source_.GetSize();
   boost::object_pool<search::Vertex> vertex_pool(std::max<size_t>(size * size / 2, 32));
@@ -208,6 +252,24 @@ template <class Model, class Best> search::History Manager::PopulateBest(const M
   return filler.RootSearch(out);
 }
 
+// Walk the derivations of root lazily, best first, keeping the first one with
+// each output string.  At most DistinctNBestLimit(size) derivations are
+// considered, the same number NBestConfigFromStaticData keeps.  
+void Manager::ExtractDistinct(search::History root, std::size_t size) {
+  const std::size_t limit = DistinctNBestLimit(size);
+  std::set<Phrase> seen;
+  Phrase phrase;
+  backing_for_single_.clear();
+  for (std::size_t i = 0; backing_for_single_.size() < size && i < limit; ++i) {
+    search::Applied derivation(n_best_.Nth(root, i));
+    if (!derivation.Valid()) break;
+    ToPhrase(derivation, phrase);
+    if (seen.insert(phrase).second) {
+      backing_for_single_.push_back(derivation);
+    }
+  }
+}
+
 template <class Model> void Manager::LMCallback(const Model &model, const std::vector<lm::WordIndex> &words) {
   std::size_t nbest = StaticData::Instance().GetNBestSize();
   if (nbest <= 1) {
@@ -221,13 +283,23 @@ template <class Model> void Manager::LMCallback(const Model &model, const std::v
     completed_nbest_ = &backing_for_single_;
   } else {
     search::History ret = PopulateBest(model, words, n_best_);
-    if (ret) {
+    if (ret && StaticData::Instance().GetDistinctNBest()) {
+      ExtractDistinct(ret, nbest);
+      completed_nbest_ = &backing_for_single_;
+    } else if (ret) {
       completed_nbest_ = &n_best_.Extract(ret);
     } else {
       backing_for_single_.clear();
       completed_nbest_ = &backing_for_single_;
     }
   }
+
+  IFVERBOSE(2) {
+    const search::MemoryStats stats(memory_.Stats());
+    std::cerr << "Incremental search allocated " << stats.edges << " edges, "
+      << stats.hypotheses << " hypotheses, " << stats.vertices << " vertices; "
+      << "memory high-water mark " << stats.high_water << " bytes" << std::endl;
+  }
 }
 
 template void Manager::LMCallback<lm::ngram::ProbingModel>(const lm::ngram::ProbingModel &model, const std::vector<lm::WordIndex> &words);
@@ -2,6 +2,7 @@
 
 #include "lm/word_index.hh"
 #include "search/applied.hh"
+#include "search/memory.hh"
 #include "search/nbest.hh"
 
 #include "moses/ChartCellCollection.h"
@@ -31,18 +32,30 @@ class Manager {
       return *completed_nbest_;
     }
 
+    // Allocation counts and memory high-water mark for this sentence.  
+    search::MemoryStats GetMemoryStats() const {
+      return memory_.Stats();
+    }
+
   private:
     template <class Model, class Best> search::History PopulateBest(const Model &model, const std::vector<lm::WordIndex> &words, Best &out);
 
+    void ExtractDistinct(search::History root, std::size_t size);
+
     const InputType &source_;
     const TranslationSystem &system_;
+
+    // Per-thread pools, reused from one sentence to the next.  
+    search::Memory &memory_;
+
     ChartCellCollectionBase cells_;
     ChartParser parser_;
 
     // Only one of single_best_ or n_best_ will be used, but it was easier to do this than a template. 
     search::SingleBest single_best_;
     // ProcessSentence returns a reference to a vector.  ProcessSentence
-    // doesn't have one, so this is populated and returned.  
+    // doesn't have one, so this is populated and returned.  Also used for
+    // distinct n-best lists.  
     std::vector<search::Applied> backing_for_single_;
 
     search::NBest n_best_;
@@ -46,6 +46,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "Ken.h"
 #include "Backward.h"
+#include "InterpolatedKen.h"
 
 #ifdef LM_LDHT
 #   include "LDHT.h"
@@ -83,6 +84,12 @@ LanguageModel* CreateLanguageModel(LMImplementation lmImplementation
   case ORLM:
     lm = new LanguageModelORLM();
     break;
+  case InterpolatedKen:
+    lm = new LanguageModelInterpolatedKen(lm::ngram::InterpolatedModel::LINEAR);
+    break;
+  case LogLinearKen:
+    lm = new LanguageModelInterpolatedKen(lm::ngram::InterpolatedModel::LOG_LINEAR);
+    break;
   case Remote:
 #ifdef LM_REMOTE
     lm = new LanguageModelRemote();
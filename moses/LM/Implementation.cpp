@@ -24,6 +24,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <memory>
 #include <sstream>
 
+#include <boost/functional/hash.hpp>
+
 #include "moses/FFState.h"
 #include "Implementation.h"
 #include "moses/TypeDef.h"
@@ -371,6 +373,20 @@ public:
     }
     return 0;
   }
+
+  // Must agree with Compare.  Prefix words are only compared on the
+  // factors set in both, so only the prefix length goes into the hash.
+  std::size_t Hash() const {
+    std::size_t seed = 0;
+    if (m_hypo.GetCurrSourceRange().GetStartPos() > 0) {
+      boost::hash_combine(seed, GetPrefix().GetSize());
+    }
+    size_t inputSize = m_hypo.GetManager().GetSource().GetSize();
+    if (m_hypo.GetCurrSourceRange().GetEndPos() < inputSize - 1) {
+      boost::hash_combine(seed, m_lmRightContext->Hash());
+    }
+    return seed;
+  }
 };
 
 } // namespace
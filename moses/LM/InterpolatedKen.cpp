@@ -0,0 +1,182 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <iostream>
+
+#include "lm/enumerate_vocab.hh"
+
+#include "InterpolatedKen.h"
+#include "moses/FactorCollection.h"
+#include "moses/FFState.h"
+#include "moses/StaticData.h"
+#include "moses/TypeDef.h"
+#include "moses/UserMessage.h"
+#include "moses/Util.h"
+
+using namespace std;
+
+namespace Moses
+{
+namespace
+{
+
+struct InterpolatedKenState : public FFState {
+  lm::ngram::InterpolatedState state;
+  int Compare(const FFState &o) const {
+    return state.Compare(static_cast<const InterpolatedKenState&>(o).state);
+  }
+  std::size_t Hash() const {
+    return lm::ngram::hash_value(state);
+  }
+};
+
+class MappingBuilder : public lm::EnumerateVocab
+{
+public:
+  MappingBuilder(FactorCollection &factorCollection, FactorType factorType, std::vector<lm::WordIndex> &mapping)
+    : m_factorCollection(factorCollection), m_factorType(factorType), m_mapping(mapping) {}
+
+  void Add(lm::WordIndex index, const StringPiece &str) {
+    std::size_t factorId = m_factorCollection.AddFactor(Output, m_factorType, str)->GetId();
+    if (m_mapping.size() <= factorId) {
+      // 0 is <unk> :-)
+      m_mapping.resize(factorId + 1);
+    }
+    m_mapping[factorId] = index;
+  }
+
+private:
+  FactorCollection &m_factorCollection;
+  FactorType m_factorType;
+  std::vector<lm::WordIndex> &m_mapping;
+};
+
+} // namespace
+
+LanguageModelInterpolatedKen::LanguageModelInterpolatedKen(lm::ngram::InterpolatedModel::Method method)
+  : m_method(method), m_nullContextState(NULL), m_beginSentenceState(NULL) {}
+
+LanguageModelInterpolatedKen::~LanguageModelInterpolatedKen()
+{
+  delete m_nullContextState;
+  delete m_beginSentenceState;
+}
+
+bool LanguageModelInterpolatedKen::Load(const std::string &filePath, FactorType factorType, size_t /*nGramOrder*/)
+{
+  std::vector<std::string> files;
+  std::vector<float> weights;
+  std::vector<std::string> entries = Tokenize(filePath, ",");
+  for (std::vector<std::string>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+    std::size_t colon = i->rfind(':');
+    if (colon == std::string::npos) {
+      UserMessage::Add("Interpolated KenLM expects file:weight,file:weight,... but got " + *i);
+      return false;
+    }
+    files.push_back(i->substr(0, colon));
+    weights.push_back(Scan<float>(i->substr(colon + 1)));
+  }
+
+  m_filePath = filePath;
+  m_factorType = factorType;
+
+  lm::ngram::Config config;
+  IFVERBOSE(1) {
+    config.messages = &std::cerr;
+  } else {
+    config.messages = NULL;
+  }
+  FactorCollection &factorCollection = FactorCollection::Instance();
+  MappingBuilder builder(factorCollection, m_factorType, m_lmIdLookup);
+  config.enumerate_vocab = &builder;
+  try {
+    m_ngram.reset(new lm::ngram::InterpolatedModel(files, weights, m_method, config));
+  } catch (const std::exception &e) {
+    UserMessage::Add(e.what());
+    return false;
+  }
+  // Context is as long as the longest model needs.
+  m_nGramOrder = m_ngram->Order();
+
+  m_sentenceStart = factorCollection.AddFactor(Output, m_factorType, BOS_);
+  m_sentenceStartArray[m_factorType] = m_sentenceStart;
+  m_sentenceEnd = factorCollection.AddFactor(Output, m_factorType, EOS_);
+  m_sentenceEndArray[m_factorType] = m_sentenceEnd;
+
+  InterpolatedKenState *state = new InterpolatedKenState();
+  state->state = m_ngram->NullContextState();
+  m_nullContextState = state;
+  state = new InterpolatedKenState();
+  state->state = m_ngram->BeginSentenceState();
+  m_beginSentenceState = state;
+  return true;
+}
+
+LMResult LanguageModelInterpolatedKen::GetValueGivenState(const std::vector<const Word*> &contextFactor, FFState &state) const
+{
+  lm::ngram::InterpolatedState &value = static_cast<InterpolatedKenState&>(state).state;
+  const lm::ngram::InterpolatedState in(value);
+  lm::WordIndex word = GetLmID(*contextFactor.back());
+  LMResult ret;
+  ret.score = TransformLMScore(m_ngram->FullScore(in, word, value).prob);
+  ret.unknown = (word == 0);
+  return ret;
+}
+
+LMResult LanguageModelInterpolatedKen::GetValueForgotState(const std::vector<const Word*> &contextFactor, FFState &outState) const
+{
+  if (contextFactor.empty()) {
+    static_cast<InterpolatedKenState&>(outState).state = m_ngram->NullContextState();
+    LMResult ret;
+    ret.score = 0.0;
+    ret.unknown = false;
+    return ret;
+  }
+  // Context in reverse order, as KenLM wants it.
+  lm::WordIndex context[KENLM_MAX_ORDER];
+  std::size_t length = std::min<std::size_t>(contextFactor.size() - 1, KENLM_MAX_ORDER);
+  for (std::size_t i = 0; i < length; ++i) {
+    context[i] = GetLmID(*contextFactor[contextFactor.size() - 2 - i]);
+  }
+  lm::WordIndex word = GetLmID(*contextFactor.back());
+  LMResult ret;
+  ret.score = TransformLMScore(m_ngram->FullScoreForgotState(context, context + length, word, static_cast<InterpolatedKenState&>(outState).state).prob);
+  ret.unknown = (word == 0);
+  return ret;
+}
+
+const FFState *LanguageModelInterpolatedKen::GetNullContextState() const
+{
+  return m_nullContextState;
+}
+
+const FFState *LanguageModelInterpolatedKen::GetBeginSentenceState() const
+{
+  return m_beginSentenceState;
+}
+
+FFState *LanguageModelInterpolatedKen::NewState(const FFState *from) const
+{
+  InterpolatedKenState *ret = new InterpolatedKenState();
+  if (from) ret->state = static_cast<const InterpolatedKenState*>(from)->state;
+  return ret;
+}
+
+}
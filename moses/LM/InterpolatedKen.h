@@ -0,0 +1,74 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_LanguageModelInterpolatedKen_h
+#define moses_LanguageModelInterpolatedKen_h
+
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "lm/interpolated.hh"
+
+#include "SingleFactor.h"
+
+namespace Moses
+{
+
+/** Several KenLM models queried as one feature with one state, so they are
+ *  recombined together instead of splitting hypotheses per model.  filePath is
+ *  a comma-separated list of file:weight, e.g. news.binary:0.7,europarl.binary:0.3
+ */
+class LanguageModelInterpolatedKen : public LanguageModelSingleFactor
+{
+public:
+  explicit LanguageModelInterpolatedKen(lm::ngram::InterpolatedModel::Method method);
+
+  ~LanguageModelInterpolatedKen();
+
+  bool Load(const std::string &filePath, FactorType factorType, size_t nGramOrder);
+
+  LMResult GetValueGivenState(const std::vector<const Word*> &contextFactor, FFState &state) const;
+
+  LMResult GetValueForgotState(const std::vector<const Word*> &contextFactor, FFState &outState) const;
+
+  const FFState *GetNullContextState() const;
+  const FFState *GetBeginSentenceState() const;
+  FFState *NewState(const FFState *from = NULL) const;
+
+protected:
+  lm::WordIndex GetLmID(const Word &word) const {
+    std::size_t factorId = word.GetFactor(m_factorType)->GetId();
+    // 0 is <unk>.
+    return factorId < m_lmIdLookup.size() ? m_lmIdLookup[factorId] : 0;
+  }
+
+  lm::ngram::InterpolatedModel::Method m_method;
+
+  boost::scoped_ptr<lm::ngram::InterpolatedModel> m_ngram;
+
+  std::vector<lm::WordIndex> m_lmIdLookup;
+
+  FFState *m_nullContextState, *m_beginSentenceState;
+};
+
+}
+
+#endif
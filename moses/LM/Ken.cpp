@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <stdlib.h>
 #include "lm/binary_format.hh"
@@ -41,6 +42,12 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/Incremental.h"
 
 #include <boost/shared_ptr.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#else
+#include <boost/scoped_ptr.hpp>
+#endif
 
 using namespace std;
 
@@ -71,6 +78,11 @@ class LanguageModelChartStateKenLM : public FFState {
       return ret;
     }
 
+    std::size_t Hash() const
+    {
+      return lm::ngram::hash_value(m_state);
+    }
+
   private:
     lm::ngram::ChartState m_state;
 };
@@ -96,6 +108,132 @@ private:
 
 } // namespace
 
+/* Direct-mapped cache of FullScore keyed by input state and word.  Documents
+ * repeat n-grams across sentences, so entries are never cleared.  Each thread
+ * has its own table, so lookups take no lock.  Duplicate() shares the cache,
+ * and hit statistics are printed when the last copy goes away.
+ */
+class KenLMCache
+{
+public:
+  KenLMCache(const std::string &file, std::size_t entries) : m_file(file), m_hits(0), m_misses(0) {
+    // Round up to a power of two so the bucket is a mask.
+    m_size = 1;
+    while (m_size < entries) m_size <<= 1;
+  }
+
+  ~KenLMCache() {
+    // Fold in this thread's counts.  Other threads folded theirs on exit.
+    m_local.reset();
+    uint64_t total = m_hits + m_misses;
+    IFVERBOSE(1) {
+      std::cerr << "KenLM cache for " << m_file << ": " << m_hits << " hits of " << total << " lookups";
+      if (total) std::cerr << " (" << (100.0 * m_hits / total) << "%)";
+      std::cerr << std::endl;
+    }
+  }
+
+  template <class Model> lm::FullScoreReturn FullScore(const Model &model, const lm::ngram::State &in_state, const lm::WordIndex word, lm::ngram::State &out_state) {
+    Table &table = Local();
+    Entry &entry = table.entries[lm::ngram::hash_value(in_state, word) & (m_size - 1)];
+    if (entry.word == word && entry.in == in_state) {
+      ++table.hits;
+      out_state = entry.out;
+      return entry.ret;
+    }
+    ++table.misses;
+    entry.ret = model.FullScore(in_state, word, out_state);
+    entry.in = in_state;
+    entry.word = word;
+    entry.out = out_state;
+    return entry.ret;
+  }
+
+private:
+  struct Entry {
+    // No word has this index, so an unused entry never matches.
+    Entry() : word(std::numeric_limits<lm::WordIndex>::max()) {}
+    lm::ngram::State in;
+    lm::WordIndex word;
+    lm::ngram::State out;
+    lm::FullScoreReturn ret;
+  };
+
+  struct Table {
+    Table(KenLMCache &owner, std::size_t size) : owner(owner), entries(size), hits(0), misses(0) {}
+    ~Table() {
+      owner.Fold(hits, misses);
+    }
+    KenLMCache &owner;
+    std::vector<Entry> entries;
+    uint64_t hits, misses;
+  };
+
+  Table &Local() {
+    Table *ret = m_local.get();
+    if (!ret) {
+      ret = new Table(*this, m_size);
+      m_local.reset(ret);
+    }
+    return *ret;
+  }
+
+  void Fold(uint64_t hits, uint64_t misses) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_hits += hits;
+    m_misses += misses;
+  }
+
+  std::string m_file;
+  std::size_t m_size;
+
+#ifdef WITH_THREADS
+  boost::thread_specific_ptr<Table> m_local;
+  boost::mutex m_mutex;
+#else
+  boost::scoped_ptr<Table> m_local;
+#endif
+
+  uint64_t m_hits, m_misses;
+};
+
+namespace {
+
+// The model as RuleScore sees it, with FullScore going through the cache.
+template <class Model> class CachedModel
+{
+public:
+  CachedModel(const Model &model, KenLMCache &cache) : m_model(model), m_cache(cache) {}
+
+  lm::FullScoreReturn FullScore(const lm::ngram::State &in_state, const lm::WordIndex new_word, lm::ngram::State &out_state) const {
+    return m_cache.FullScore(m_model, in_state, new_word, out_state);
+  }
+
+  lm::FullScoreReturn ExtendLeft(const lm::WordIndex *add_rbegin, const lm::WordIndex *add_rend, const float *backoff_in, uint64_t extend_pointer, unsigned char extend_length, float *backoff_out, unsigned char &next_use) const {
+    return m_model.ExtendLeft(add_rbegin, add_rend, backoff_in, extend_pointer, extend_length, backoff_out, next_use);
+  }
+
+  float UnRest(const uint64_t *pointers_begin, const uint64_t *pointers_end, unsigned char first_length) const {
+    return m_model.UnRest(pointers_begin, pointers_end, first_length);
+  }
+
+  unsigned char Order() const {
+    return m_model.Order();
+  }
+
+  const lm::ngram::State &BeginSentenceState() const {
+    return m_model.BeginSentenceState();
+  }
+
+private:
+  const Model &m_model;
+  KenLMCache &m_cache;
+};
+
+} // namespace
+
 template <class Model> LanguageModelKen<Model>::LanguageModelKen(const std::string &file, FactorType factorType, bool lazy) : m_factorType(factorType) {
   lm::ngram::Config config;
   IFVERBOSE(1) {
@@ -111,6 +249,9 @@ template <class Model> LanguageModelKen<Model>::LanguageModelKen(const std::stri
   m_ngram.reset(new Model(file.c_str(), config));
 
   m_beginSentenceFactor = collection.AddFactor(BOS_);
+
+  std::size_t cacheSize = StaticData::Instance().GetKenLMCacheSize();
+  if (cacheSize) m_cache.reset(new KenLMCache(file, cacheSize));
 }
 
 template <class Model> bool LanguageModelKen<Model>::Useable(const Phrase &phrase) const {
@@ -154,6 +295,7 @@ template <class Model> void LanguageModelKen<Model>::IncrementalCallback(Increme
 
 template <class Model> LanguageModelKen<Model>::LanguageModelKen(const LanguageModelKen<Model> &copy_from) :
     m_ngram(copy_from.m_ngram),
+    m_cache(copy_from.m_cache),
     // TODO: don't copy this.      
     m_beginSentenceFactor(copy_from.m_beginSentenceFactor),
     m_factorType(copy_from.m_factorType),
@@ -298,15 +440,22 @@ template <class Model> FFState *LanguageModelKen<Model>::Evaluate(const Hypothes
   const std::size_t end = hypo.GetCurrTargetWordsRange().GetEndPos() + 1;
   const std::size_t adjust_end = std::min(end, begin + m_ngram->Order() - 1);
 
-  std::size_t position = begin;
-  typename Model::State aux_state;
-  typename Model::State *state0 = &ret->state, *state1 = &aux_state;
-
-  float score = m_ngram->Score(in_state, TranslateID(hypo.GetWord(position)), *state0);
-  ++position;
-  for (; position < adjust_end; ++position) {
-    score += m_ngram->Score(*state0, TranslateID(hypo.GetWord(position)), *state1);
-    std::swap(state0, state1);
+  lm::WordIndex ids[KENLM_MAX_ORDER];
+  for (std::size_t position = begin; position < adjust_end; ++position) {
+    ids[position - begin] = TranslateID(hypo.GetWord(position));
+  }
+  float score;
+  if (m_cache) {
+    score = 0.0;
+    lm::ngram::State states[2];
+    const lm::ngram::State *from = &in_state;
+    for (std::size_t i = 0; i < adjust_end - begin; ++i) {
+      score += m_cache->FullScore(*m_ngram, *from, ids[i], states[i % 2]).prob;
+      from = &states[i % 2];
+    }
+    ret->state = *from;
+  } else {
+    score = m_ngram->FullScorePhrase(in_state, ids, ids + (adjust_end - begin), ret->state);
   }
 
   if (hypo.IsSourceCompleted()) {
@@ -319,9 +468,6 @@ template <class Model> FFState *LanguageModelKen<Model>::Evaluate(const Hypothes
     std::vector<lm::WordIndex> indices(m_ngram->Order() - 1);
     const lm::WordIndex *last = LastIDs(hypo, &indices.front());
     m_ngram->GetState(&indices.front(), last, ret->state);
-  } else if (state0 != &ret->state) {
-    // Short enough phrase that we can just reuse the state.  
-    ret->state = *state0;
   }
 
   score = TransformLMScore(score);
@@ -339,8 +485,16 @@ template <class Model> FFState *LanguageModelKen<Model>::Evaluate(const Hypothes
 }
 
 template <class Model> FFState *LanguageModelKen<Model>::EvaluateChart(const ChartHypothesis& hypo, int featureID, ScoreComponentCollection *accumulator) const {
+  if (m_cache) {
+    return EvaluateChart(CachedModel<Model>(*m_ngram, *m_cache), hypo, featureID, accumulator);
+  } else {
+    return EvaluateChart(*m_ngram, hypo, featureID, accumulator);
+  }
+}
+
+template <class Model> template <class Scorer> FFState *LanguageModelKen<Model>::EvaluateChart(const Scorer &model, const ChartHypothesis& hypo, int featureID, ScoreComponentCollection *accumulator) const {
   LanguageModelChartStateKenLM *newState = new LanguageModelChartStateKenLM();
-  lm::ngram::RuleScore<Model> ruleScore(*m_ngram, newState->GetChartState());
+  lm::ngram::RuleScore<Scorer> ruleScore(model, newState->GetChartState());
   const TargetPhrase &target = hypo.GetCurrTargetPhrase();
   const AlignmentInfo::NonTermIndexMap &nonTermIndexMap =
         target.GetAlignNonTerm().GetNonTermIndexMap();
@@ -24,6 +24,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <string>
 
+#include <boost/shared_ptr.hpp>
+
 #include "lm/word_index.hh"
 
 #include "moses/Word.h"
@@ -32,6 +34,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 namespace Moses {
 
   class FFState;
+  class KenLMCache;
 
 //! This will also load. Returns a templated KenLM class
 LanguageModel *ConstructKenLM(const std::string &file, FactorType factorType, bool lazy);
@@ -63,6 +66,9 @@ template <class Model> class LanguageModelKen : public LanguageModel {
 
     boost::shared_ptr<Model> m_ngram;
 
+    // Scores kept across sentences, or NULL if kenlm-cache-size is 0.
+    boost::shared_ptr<KenLMCache> m_cache;
+
     const Factor *m_beginSentenceFactor;
 
     FactorType m_factorType;
@@ -77,6 +83,9 @@ template <class Model> class LanguageModelKen : public LanguageModel {
 
     // Convert last words of hypothesis into vocab ids, returning an end pointer.  
     lm::WordIndex *LastIDs(const Hypothesis &hypo, lm::WordIndex *indices) const;
+
+    // EvaluateChart with model, which is m_ngram or m_ngram behind m_cache.
+    template <class Scorer> FFState *EvaluateChart(const Scorer &model, const ChartHypothesis& hypo, int featureID, ScoreComponentCollection *accumulator) const;
     
     std::vector<lm::WordIndex> m_lmIdLookup;
 
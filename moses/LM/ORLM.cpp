@@ -93,9 +93,7 @@ bool LanguageModelORLM::UpdateORLM(const std::vector<string>& ngram, const int v
   iterate(ngram, nit)
     cerr << *nit << " ";
   cerr << "\"\t" << value << endl; */
-  m_lm->vocab_->MakeOpen();
-  bool res = m_lm->update(ngram, value); 
-  m_lm->vocab_->MakeClosed();
-  return res;
+  // update() opens and closes the vocabulary under the model's lock.
+  return m_lm->update(ngram, value);
 }
 }
@@ -32,7 +32,7 @@ public:
     fout.close();
     delete m_lm;
   }
-  void CleanUpAfterSentenceProcessing() {m_lm->clearCache();} // clear caches
+  void CleanUpAfterSentenceProcessing(const InputType& source) {m_lm->clearCache();} // clear this thread's cache
   void InitializeBeforeSentenceProcessing() { // nothing to do
     //m_lm->initThreadSpecificData(); // Creates thread specific data iff
                                     // compiled with multithreading.
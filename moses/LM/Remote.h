@@ -11,7 +11,10 @@
 namespace Moses
 {
 
-/** @todo ask miles
+/** Queries an LM server over a socket, one n-gram per round trip.  To share
+ *  one KenLM binary between decoder processes on the same machine, load it as
+ *  LazyKen (type 9) in each process instead: the binary is mapped shared, so
+ *  the processes use one copy in the page cache with no server at all.
  */
 class LanguageModelRemote : public LanguageModelPointerState
 {
@@ -37,6 +40,9 @@ public:
     m_cache.tree.clear();
     m_curId = 1000;
   }
+  void CleanUpAfterSentenceProcessing(const InputType& source) {
+    ClearSentenceCache();
+  }
   virtual LMResult GetValue(const std::vector<const Word*> &contextFactor, State* finalState = 0) const;
   bool Load(const std::string &filePath
             , FactorType factorType
@@ -51,6 +51,9 @@ struct PointerState : public FFState {
     else if (other.lmstate < lmstate) return -1;
     return 0;
   }
+  std::size_t Hash() const {
+    return reinterpret_cast<std::size_t>(lmstate);
+  }
 };
 
 LanguageModelPointerState::LanguageModelPointerState()
@@ -124,6 +124,7 @@ Parameter::Parameter()
   AddParam("lmbr-map-weight", "weight given to map solution when doing lattice MBR (default 0)");
   AddParam("lattice-hypo-set", "to use lattice as hypo set during lattice MBR");
   AddParam("clean-lm-cache", "clean language model caches after N translations (default N=1)");
+  AddParam("kenlm-cache-size", "entries in each thread's cache of KenLM scores, kept across sentences (default 0 = no cache)");
   AddParam("use-persistent-cache", "cache translation options across sentences (default true)");
   AddParam("persistent-cache-size", "maximum size of cache for translation options (default 10,000 input phrases)");
   AddParam("recover-input-path", "r", "(conf net/word lattice only) - recover input path corresponding to the best translation");
@@ -160,7 +161,8 @@ Parameter::Parameter()
   AddParam("report-sparse-features", "Indicate which sparse feature functions should report detailed scores in n-best, instead of aggregate");
   AddParam("cube-pruning-lazy-scoring", "cbls", "Don't fully score a hypothesis until it is popped");
   AddParam("parsing-algorithm", "Which parsing algorithm to use. 0=CYK+, 1=scope-3. (default = 0)");
-  AddParam("search-algorithm", "Which search algorithm to use. 0=normal stack, 1=cube pruning, 2=cube growing, 4=stack with batched lm requests (default = 0)");
+  AddParam("search-algorithm", "Which search algorithm to use. 0=normal stack, 1=cube pruning, 2=cube growing, 4=stack with batched lm requests, 6=chart with cell-wide cube growing (default = 0)");
+  AddParam("cube-growing-beam-threshold", "cgbt", "Stop growing a chart cell once the best queued item falls below this fraction of the best popped item. Only used with search-algorithm 6 (default = 0)");
   AddParam("constraint", "Location of the file with target sentences to produce constraining the search");
   AddParam("link-param-count", "Number of parameters on word links when using confusion networks or lattices (default = 1)");
   AddParam("description", "Source language, target language, description");
@@ -0,0 +1,116 @@
+// vim:tabstop=2
+/***********************************************************************
+ Moses - factored phrase-based language decoder
+ Copyright (C) 2013 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "RuleCubeGrowingQueue.h"
+
+#include "ChartCellCollection.h"
+#include "ChartTranslationOptions.h"
+#include "StaticData.h"
+#include "Util.h"
+
+namespace Moses
+{
+
+RuleCubeGrowingQueue::RuleCubeGrowingQueue(
+  const ChartCellCollection &allChartCells, ChartManager &manager)
+  : m_allChartCells(allChartCells)
+  , m_manager(manager)
+  , m_lazyScoring(StaticData::Instance().GetCubePruningLazyScoring())
+  , m_numPops(0)
+  , m_numPushes(0)
+  , m_numDuplicates(0)
+{
+}
+
+RuleCubeGrowingQueue::~RuleCubeGrowingQueue()
+{
+  // every item ever pushed is in the visited set, popped or not
+  RemoveAllInColl(m_visited);
+}
+
+// add the top-left corner item of the rule's cube
+void RuleCubeGrowingQueue::Add(const ChartTranslationOptions &transOpt)
+{
+  RuleCubeItem *item = new RuleCubeItem(transOpt, m_allChartCells);
+  Push(item, transOpt);
+}
+
+ChartHypothesis *RuleCubeGrowingQueue::Pop()
+{
+  RuleCubeGrowingEntry entry = PopEntry();
+  if (m_lazyScoring) {
+    entry.item->CreateHypothesis(*entry.transOpt, m_manager);
+  }
+  return entry.item->ReleaseHypothesis();
+}
+
+RuleCubeGrowingEntry RuleCubeGrowingQueue::PopEntry()
+{
+  RuleCubeGrowingEntry entry = m_queue.top();
+  m_queue.pop();
+  ++m_numPops;
+
+  // grow the cube around the popped item only
+  CreateNeighbors(*entry.item, *entry.transOpt);
+  return entry;
+}
+
+void RuleCubeGrowingQueue::Push(RuleCubeItem *item,
+                                const ChartTranslationOptions &transOpt)
+{
+  std::pair<ItemSet::iterator, bool> result = m_visited.insert(item);
+  if (!result.second) {
+    delete item;  // already seen it
+    ++m_numDuplicates;
+    return;
+  }
+  if (m_lazyScoring) {
+    item->EstimateScore();
+  } else {
+    item->CreateHypothesis(transOpt, m_manager);
+  }
+  m_queue.push(RuleCubeGrowingEntry(item, &transOpt));
+  ++m_numPushes;
+}
+
+void RuleCubeGrowingQueue::CreateNeighbors(
+  const RuleCubeItem &item, const ChartTranslationOptions &transOpt)
+{
+  // create neighbor along translation dimension
+  if (item.GetTranslationDimension().HasMoreTranslations()) {
+    CreateNeighbor(item, -1, transOpt);
+  }
+
+  // create neighbors along all hypothesis dimensions
+  for (size_t i = 0; i < item.GetHypothesisDimensions().size(); ++i) {
+    if (item.GetHypothesisDimensions()[i].HasMoreHypo()) {
+      CreateNeighbor(item, i, transOpt);
+    }
+  }
+}
+
+void RuleCubeGrowingQueue::CreateNeighbor(
+  const RuleCubeItem &item, int dimensionIndex,
+  const ChartTranslationOptions &transOpt)
+{
+  Push(new RuleCubeItem(item, dimensionIndex), transOpt);
+}
+
+}
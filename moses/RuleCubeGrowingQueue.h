@@ -0,0 +1,128 @@
+// vim:tabstop=2
+/***********************************************************************
+ Moses - factored phrase-based language decoder
+ Copyright (C) 2013 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include "RuleCube.h"
+#include "RuleCubeItem.h"
+
+#include <boost/unordered_set.hpp>
+#include <boost/version.hpp>
+
+#include "util/check.hh"
+#include <queue>
+#include <set>
+#include <vector>
+
+namespace Moses
+{
+
+class ChartCellCollection;
+class ChartHypothesis;
+class ChartManager;
+class ChartTranslationOptions;
+
+/** An item in the cell-wide queue together with the rule it belongs to.
+ */
+struct RuleCubeGrowingEntry {
+  RuleCubeGrowingEntry(RuleCubeItem *i, const ChartTranslationOptions *t)
+    : item(i), transOpt(t) {}
+
+  RuleCubeItem *item;
+  const ChartTranslationOptions *transOpt;
+};
+
+/** Define an ordering between queue entries based on their item scores.
+ */
+class RuleCubeGrowingEntryOrderer
+{
+ public:
+  bool operator()(const RuleCubeGrowingEntry &p,
+                  const RuleCubeGrowingEntry &q) const {
+    return p.item->GetScore() < q.item->GetScore();
+  }
+};
+
+/** Cube growing over all the rules of a chart cell (search-algorithm 6).
+ *
+ * Unlike RuleCubeQueue, which keeps a priority queue of RuleCubes that each
+ * hold their own queue and covered set, all items of the cell live in a
+ * single heap.  Neighbours are only created when an item is popped and
+ * duplicates are detected through one hashed visited set shared by every
+ * rule of the cell.  Counts of pops, pushes and duplicate hits are kept so
+ * that they can be reported in the SentenceStats.
+ */
+class RuleCubeGrowingQueue
+{
+ public:
+  RuleCubeGrowingQueue(const ChartCellCollection &, ChartManager &);
+  ~RuleCubeGrowingQueue();
+
+  void Add(const ChartTranslationOptions &);
+  ChartHypothesis *Pop();
+
+  /** Pops the best item and grows the cube around it, like Pop, but without
+   * creating the item's hypothesis.  The item stays owned by the queue.
+   */
+  RuleCubeGrowingEntry PopEntry();
+  bool IsEmpty() const { return m_queue.empty(); }
+
+  float GetTopScore() const {
+    CHECK(!m_queue.empty());
+    return m_queue.top().item->GetScore();
+  }
+
+  size_t GetNumPops() const { return m_numPops; }
+  size_t GetNumPushes() const { return m_numPushes; }
+  size_t GetNumDuplicates() const { return m_numDuplicates; }
+
+ private:
+#if defined(BOOST_VERSION) && (BOOST_VERSION >= 104200)
+  typedef boost::unordered_set<RuleCubeItem*,
+                               RuleCubeItemHasher,
+                               RuleCubeItemEqualityPred
+                              > ItemSet;
+#else
+  typedef std::set<RuleCubeItem*, RuleCubeItemPositionOrderer> ItemSet;
+#endif
+
+  typedef std::priority_queue<RuleCubeGrowingEntry,
+                              std::vector<RuleCubeGrowingEntry>,
+                              RuleCubeGrowingEntryOrderer
+                             > Queue;
+
+  RuleCubeGrowingQueue(const RuleCubeGrowingQueue &);  // Not implemented
+  RuleCubeGrowingQueue &operator=(const RuleCubeGrowingQueue &);  // Not implemented
+
+  void Push(RuleCubeItem *, const ChartTranslationOptions &);
+  void CreateNeighbors(const RuleCubeItem &, const ChartTranslationOptions &);
+  void CreateNeighbor(const RuleCubeItem &, int, const ChartTranslationOptions &);
+
+  const ChartCellCollection &m_allChartCells;
+  ChartManager &m_manager;
+  const bool m_lazyScoring;
+  ItemSet m_visited;
+  Queue m_queue;
+  size_t m_numPops;
+  size_t m_numPushes;
+  size_t m_numDuplicates;
+};
+
+}
@@ -0,0 +1,282 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2013 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "ChartCellCollection.h"
+#include "ChartCellLabel.h"
+#include "ChartHypothesis.h"
+#include "ChartManager.h"
+#include "ChartTranslationOptions.h"
+#include "DummyScoreProducers.h"
+#include "RuleCube.h"
+#include "RuleCubeGrowingQueue.h"
+#include "RuleCubeItem.h"
+#include "RuleCubeQueue.h"
+#include "Sentence.h"
+#include "StaticData.h"
+#include "TargetPhrase.h"
+#include "TargetPhraseCollection.h"
+#include "TranslationSystem.h"
+#include "Util.h"
+#include "WordsRange.h"
+
+using namespace std;
+using namespace Moses;
+
+namespace MosesTest
+{
+
+BOOST_AUTO_TEST_SUITE(rule_cube_growing_queue)
+
+namespace
+{
+
+// A hypothesis of a sub-span with a given score, to fill the stacks that the
+// rules of the toy cell are built on.
+class FixedScoreHypothesis : public ChartHypothesis
+{
+ public:
+  FixedScoreHypothesis(const ChartTranslationOptions &transOpt,
+                       const RuleCubeItem &item, ChartManager &manager,
+                       float score)
+    : ChartHypothesis(transOpt, item, manager) {
+    m_totalScore = score;
+  }
+};
+
+// The words of an item: its target phrase and the hypothesis of each
+// non-terminal.
+typedef vector<const void*> Position;
+
+Position PositionOf(const RuleCubeItem &item)
+{
+  Position position(1, item.GetTranslationDimension().GetTargetPhrase());
+  const vector<HypothesisDimension> &dimensions = item.GetHypothesisDimensions();
+  for (size_t i = 0; i < dimensions.size(); ++i) {
+    position.push_back(dimensions[i].GetHypothesis());
+  }
+  return position;
+}
+
+/* The cell covering "a b", with stacks of hypotheses for "a" and "b" and
+ * three rules: X1 X2 (two targets), X1 b (three targets) and a b (two
+ * targets).  Scores are estimated (cube-pruning-lazy-scoring), so that no
+ * hypothesis has to be scored by feature functions.
+ */
+class ToyCell
+{
+ public:
+  ToyCell()
+    : m_system("toy", &m_wp, &m_uwp, &m_dist)
+    , m_nonTerminal(true)
+    , m_rangeA(0, 0)
+    , m_rangeB(1, 1)
+    , m_rangeAB(0, 1) {
+    StaticData &staticData = StaticData::InstanceNonConst();
+    m_lazyScoring = staticData.GetCubePruningLazyScoring();
+    staticData.SetCubePruningLazyScoring(true);
+
+    vector<FactorType> factors(1, 0);
+    istringstream in("a b\n");
+    m_sentence.Read(in, factors);
+    m_manager.reset(new ChartManager(m_sentence, &m_system));
+    m_cells.reset(new ChartCellCollection(m_sentence, *m_manager));
+
+    // hypotheses of the sub-spans, best first, all made from one lexical rule
+    float lexicalScore = -1.0f;
+    float scoresA[] = { -1.0f, -2.1f, -4.3f };
+    float scoresB[] = { -0.25f, -3.05f };
+    const ChartTranslationOptions &lexical =
+      *NewRule(StackVec(), m_rangeA, &lexicalScore, 1);
+    RuleCubeItem lexicalItem(lexical, *m_cells);
+    for (size_t i = 0; i < 3; ++i) {
+      m_hyposA.push_back(NewHypothesis(lexical, lexicalItem, scoresA[i]));
+    }
+    for (size_t i = 0; i < 2; ++i) {
+      m_hyposB.push_back(NewHypothesis(lexical, lexicalItem, scoresB[i]));
+    }
+    ChartCellLabel::Stack stackA, stackB;
+    stackA.cube = &m_hyposA;
+    stackB.cube = &m_hyposB;
+    m_labelA.reset(new ChartCellLabel(m_rangeA, m_nonTerminal, stackA));
+    m_labelB.reset(new ChartCellLabel(m_rangeB, m_nonTerminal, stackB));
+
+    StackVec both, first;
+    both.push_back(m_labelA.get());
+    both.push_back(m_labelB.get());
+    first.push_back(m_labelA.get());
+    float targets1[] = { -0.11f, -1.7f };
+    float targets2[] = { -0.6f, -0.93f, -2.2f };
+    float targets3[] = { -2.47f, -5.0f };
+    m_rules.push_back(NewRule(both, m_rangeAB, targets1, 2));
+    m_rules.push_back(NewRule(first, m_rangeAB, targets2, 3));
+    m_rules.push_back(NewRule(StackVec(), m_rangeAB, targets3, 2));
+  }
+
+  ~ToyCell() {
+    RemoveAllInColl(m_allRules);
+    RemoveAllInColl(m_targetPhrases);
+    for (size_t i = 0; i < m_hypotheses.size(); ++i) {
+      delete m_hypotheses[i];
+    }
+    m_cells.reset();
+    m_manager.reset();
+    StaticData::InstanceNonConst().SetCubePruningLazyScoring(m_lazyScoring);
+  }
+
+  const vector<ChartTranslationOptions*> &GetRules() const {
+    return m_rules;
+  }
+  const ChartCellCollection &GetCells() const {
+    return *m_cells;
+  }
+  ChartManager &GetManager() {
+    return *m_manager;
+  }
+
+ private:
+  // a rule with one target phrase per score, best first
+  ChartTranslationOptions *NewRule(const StackVec &stackVec,
+                                   const WordsRange &range,
+                                   const float *scores, size_t count) {
+    TargetPhraseCollection *targets = new TargetPhraseCollection();
+    for (size_t i = 0; i < count; ++i) {
+      TargetPhrase *target = new TargetPhrase();
+      target->SetFutureScore(scores[i]);
+      targets->Add(target);
+    }
+    m_targetPhrases.push_back(targets);
+    ChartTranslationOptions *rule =
+      new ChartTranslationOptions(*targets, stackVec, range, 0);
+    m_allRules.push_back(rule);
+    return rule;
+  }
+
+  const ChartHypothesis *NewHypothesis(const ChartTranslationOptions &rule,
+                                       const RuleCubeItem &item, float score) {
+    m_hypotheses.push_back(new FixedScoreHypothesis(rule, item, *m_manager, score));
+    return m_hypotheses.back();
+  }
+
+  WordPenaltyProducer m_wp;
+  UnknownWordPenaltyProducer m_uwp;
+  DistortionScoreProducer m_dist;
+  TranslationSystem m_system;
+  Sentence m_sentence;
+  boost::scoped_ptr<ChartManager> m_manager;
+  boost::scoped_ptr<ChartCellCollection> m_cells;
+  bool m_lazyScoring;
+
+  Word m_nonTerminal;
+  WordsRange m_rangeA, m_rangeB, m_rangeAB;
+  vector<FixedScoreHypothesis*> m_hypotheses;
+  HypoList m_hyposA, m_hyposB;
+  boost::scoped_ptr<ChartCellLabel> m_labelA, m_labelB;
+  vector<TargetPhraseCollection*> m_targetPhrases;
+  vector<ChartTranslationOptions*> m_rules, m_allRules;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(pop_order_matches_rule_cube_queue)
+{
+  ToyCell cell;
+  const vector<ChartTranslationOptions*> &rules = cell.GetRules();
+
+  RuleCubeGrowingQueue growing(cell.GetCells(), cell.GetManager());
+  for (size_t i = 0; i < rules.size(); ++i) {
+    growing.Add(*rules[i]);
+  }
+  vector<Position> growingOrder;
+  vector<float> growingScores;
+  while (!growing.IsEmpty()) {
+    RuleCubeGrowingEntry entry = growing.PopEntry();
+    growingOrder.push_back(PositionOf(*entry.item));
+    growingScores.push_back(entry.item->GetScore());
+  }
+
+  // what RuleCubeQueue does, one cube per rule in a queue ordered by the
+  // cubes' best items, stopping short of creating hypotheses
+  priority_queue<RuleCube*, vector<RuleCube*>, RuleCubeOrderer> cubes;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    cubes.push(new RuleCube(*rules[i], cell.GetCells(), cell.GetManager()));
+  }
+  vector<Position> cubeOrder;
+  vector<float> cubeScores;
+  while (!cubes.empty()) {
+    RuleCube *cube = cubes.top();
+    cubes.pop();
+    RuleCubeItem *item = cube->Pop(cell.GetManager());
+    cubeOrder.push_back(PositionOf(*item));
+    cubeScores.push_back(item->GetScore());
+    if (cube->IsEmpty()) {
+      delete cube;
+    } else {
+      cubes.push(cube);
+    }
+  }
+
+  // 2*3*2 + 3*3 + 2 items, with distinct scores so that the order is unique
+  BOOST_REQUIRE_EQUAL(cubeScores.size(), 23U);
+  vector<float> sorted(cubeScores);
+  sort(sorted.begin(), sorted.end());
+  BOOST_REQUIRE(adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+  BOOST_CHECK_EQUAL_COLLECTIONS(growingScores.begin(), growingScores.end(),
+                                cubeScores.begin(), cubeScores.end());
+  BOOST_CHECK(growingOrder == cubeOrder);
+  for (size_t i = 1; i < growingScores.size(); ++i) {
+    BOOST_CHECK(growingScores[i] < growingScores[i - 1]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(visited_set_drops_duplicates)
+{
+  ToyCell cell;
+  const vector<ChartTranslationOptions*> &rules = cell.GetRules();
+
+  RuleCubeGrowingQueue growing(cell.GetCells(), cell.GetManager());
+  for (size_t i = 0; i < rules.size(); ++i) {
+    growing.Add(*rules[i]);
+  }
+  set<Position> popped;
+  while (!growing.IsEmpty()) {
+    BOOST_CHECK(popped.insert(PositionOf(*growing.PopEntry().item)).second);
+  }
+
+  // Every item is pushed once.  Popping an item offers one neighbour per
+  // dimension that can grow, which is 20, 12 and 1 offers for the three
+  // rules, so 20 - 11, 12 - 8 and 1 - 1 offers find an item already seen.
+  BOOST_CHECK_EQUAL(popped.size(), 23U);
+  BOOST_CHECK_EQUAL(growing.GetNumPops(), 23U);
+  BOOST_CHECK_EQUAL(growing.GetNumPushes(), 23U);
+  BOOST_CHECK_EQUAL(growing.GetNumDuplicates(), 13U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
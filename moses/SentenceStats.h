@@ -45,6 +45,16 @@ struct RecombinationInfo {
   float betterProb, worseProb;
 };
 
+//! Hold info about the cube growing search of one chart cell. Used by SentenceStats class
+struct CellSearchInfo {
+  CellSearchInfo() {} //for std::vector
+  CellSearchInfo(size_t start, size_t end, size_t pops, size_t pushes, size_t duplicates)
+    : startPos(start), endPos(end), numPops(pops), numPushes(pushes), numDuplicates(duplicates) {}
+
+  size_t startPos, endPos;
+  size_t numPops, numPushes, numDuplicates;
+};
+
 /**
  * stats relating to decoder operation on a given sentence
  */
@@ -72,6 +82,7 @@ public:
     m_timeStack = 0;
     m_totalSourceWords = source.GetSize();
     m_recombinationInfos.clear();
+    m_cellSearchInfos.clear();
     m_deletedWords.clear();
     m_insertedWords.clear();
   }
@@ -135,11 +146,17 @@ public:
   const std::vector<std::string>& GetInsertedWords() const {
     return m_insertedWords;
   }
+  const std::vector<CellSearchInfo>& GetCellSearchInfos() const {
+    return m_cellSearchInfos;
+  }
 
   void AddRecombination(const Hypothesis& worseHypo, const Hypothesis& betterHypo) {
     m_recombinationInfos.push_back(RecombinationInfo(worseHypo.GetWordsBitmap().GetNumWordsCovered(),
                                    betterHypo.GetTotalScore(), worseHypo.GetTotalScore()));
   }
+  void AddCellSearch(const CellSearchInfo &info) {
+    m_cellSearchInfos.push_back(info);
+  }
   void AddCreated() {
     m_numHyposCreated++;
   }
@@ -190,6 +207,7 @@ protected:
   // since clock seconds aren't reliable in a multi-threaded environment -Jon
   // (see Manager.cpp for some initial work moving in this direction)
   std::vector<RecombinationInfo> m_recombinationInfos;
+  std::vector<CellSearchInfo> m_cellSearchInfos; //chart cube growing only
   unsigned int m_numHyposCreated;
   unsigned int m_numHyposPruned;
   unsigned int m_numHyposDiscarded;
@@ -209,6 +227,26 @@ protected:
   std::vector<std::string> m_insertedWords; //count inserted words in the final hypothesis
 };
 
+//! per-cell counters of the chart cube growing search
+inline std::ostream& OutputCellSearchInfos(std::ostream& os, const SentenceStats& ss)
+{
+  const std::vector<CellSearchInfo> &infos = ss.GetCellSearchInfos();
+  size_t totalPops = 0, totalPushes = 0, totalDuplicates = 0;
+  for (size_t i = 0; i < infos.size(); ++i) {
+    const CellSearchInfo &info = infos[i];
+    os << "cell [" << info.startPos << ".." << info.endPos << "]"
+       << " pops = " << info.numPops
+       << " pushes = " << info.numPushes
+       << " duplicates = " << info.numDuplicates << std::endl;
+    totalPops += info.numPops;
+    totalPushes += info.numPushes;
+    totalDuplicates += info.numDuplicates;
+  }
+  return os << "total pops = " << totalPops
+         << " pushes = " << totalPushes
+         << " duplicates = " << totalDuplicates << std::endl;
+}
+
 inline std::ostream& operator<<(std::ostream& os, const SentenceStats& ss)
 {
   float totalTime = ss.GetTimeTotal();
@@ -101,6 +101,7 @@ StaticData::StaticData()
   ,m_onlyDistinctNBest(false)
   ,m_factorDelimiter("|") // default delimiter between factors
   ,m_lmEnableOOVFeature(false)
+  ,m_kenlmCacheSize(0)
   ,m_isAlwaysCreateDirectTranslationOption(false)
   ,m_needAlignmentInfo(false)
 {
@@ -407,6 +408,10 @@ bool StaticData::LoadData(Parameter *parameter)
 
   SetBooleanParameter(&m_cubePruningLazyScoring, "cube-pruning-lazy-scoring", false);
 
+  m_cubeGrowingBeamWidth = (m_parameter->GetParam("cube-growing-beam-threshold").size() > 0) ?
+                           TransformScore(Scan<float>(m_parameter->GetParam("cube-growing-beam-threshold")[0]))
+                           : TransformScore(DEFAULT_CUBE_GROWING_BEAM_WIDTH);
+
   // early distortion cost
   SetBooleanParameter( &m_useEarlyDistortionCost, "early-distortion-cost", false );
 
@@ -464,6 +469,8 @@ bool StaticData::LoadData(Parameter *parameter)
 
   m_lmcache_cleanup_threshold = (m_parameter->GetParam("clean-lm-cache").size() > 0) ?
                                 Scan<size_t>(m_parameter->GetParam("clean-lm-cache")[0]) : 1;
+  m_kenlmCacheSize = (m_parameter->GetParam("kenlm-cache-size").size() > 0) ?
+                     Scan<size_t>(m_parameter->GetParam("kenlm-cache-size")[0]) : 0;
 
   m_threadCount = 1;
   const std::vector<std::string> &threadInfo = m_parameter->GetParam("threads");
@@ -1653,7 +1660,7 @@ bool StaticData::LoadDiscrimLMFeature()
   		}
   	}
   	else {
-  		if (m_searchAlgorithm == ChartDecoding && !include_lower_ngrams) {
+  		if (IsChart() && !include_lower_ngrams) {
   			UserMessage::Add("Excluding lower order DLM ngrams is currently not supported for chart decoding.");
   			return false;
   		}
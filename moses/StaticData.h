@@ -202,6 +202,7 @@ protected:
 
   size_t m_lmcache_cleanup_threshold; //! number of translations after which LM claenup is performed (0=never, N=after N translations; default is 1)
   bool m_lmEnableOOVFeature;
+  size_t m_kenlmCacheSize; //! entries in each thread's KenLM score cache (0=no cache)
 
   bool m_timeout; //! use timeout
   size_t m_timeout_threshold; //! seconds after which time out is activated
@@ -232,6 +233,7 @@ protected:
   size_t m_cubePruningPopLimit;
   size_t m_cubePruningDiversity;
   bool m_cubePruningLazyScoring;
+  float m_cubeGrowingBeamWidth;
   size_t m_ruleLimit;
 
   // Whether to load compact phrase table and reordering table into memory
@@ -387,6 +389,12 @@ public:
   bool GetCubePruningLazyScoring() const {
     return m_cubePruningLazyScoring;
   }
+  void SetCubePruningLazyScoring(bool lazyScoring) {
+    m_cubePruningLazyScoring = lazyScoring;
+  }
+  float GetCubeGrowingBeamWidth() const {
+    return m_cubeGrowingBeamWidth;
+  }
   size_t IsPathRecoveryEnabled() const {
     return m_recoverPath;
   }
@@ -502,7 +510,8 @@ public:
     return m_searchAlgorithm;
   }
   bool IsChart() const {
-    return m_searchAlgorithm == ChartDecoding || m_searchAlgorithm == ChartIncremental;
+    return m_searchAlgorithm == ChartDecoding || m_searchAlgorithm == ChartIncremental ||
+           m_searchAlgorithm == ChartCubeGrowing;
   }
   LMList GetLMList() const { 
     return m_languageModel; 
@@ -634,6 +643,10 @@ public:
     return m_lmEnableOOVFeature;
   }
 
+  size_t GetKenLMCacheSize() const {
+    return m_kenlmCacheSize;
+  }
+
   bool GetOutputSearchGraph() const {
     return m_outputSearchGraph;
   }
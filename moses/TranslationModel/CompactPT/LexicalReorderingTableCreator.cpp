@@ -44,6 +44,33 @@ LexicalReorderingTableCreator::LexicalReorderingTableCreator(
   , m_threads(threads)
 #endif
 {  
+  Begin();
+  EncodeScores();
+  Finish();
+}
+
+LexicalReorderingTableCreator::LexicalReorderingTableCreator(
+  std::string outPath, std::string tempfilePath,
+  size_t orderBits, size_t fingerPrintBits, bool multipleScoreTrees,
+  size_t quantize
+#ifdef WITH_THREADS
+  , size_t threads
+#endif
+  )
+  : m_outPath(outPath), m_tempfilePath(tempfilePath),
+  m_orderBits(orderBits), m_fingerPrintBits(fingerPrintBits),
+  m_numScoreComponent(0), m_multipleScoreTrees(multipleScoreTrees),
+  m_quantize(quantize), m_separator(" ||| "),
+  m_hash(m_orderBits, m_fingerPrintBits), m_lastFlushedLine(-1)
+#ifdef WITH_THREADS  
+  , m_threads(threads)
+#endif
+{
+  Begin();
+}
+
+void LexicalReorderingTableCreator::Begin()
+{
   PrintInfo();
     
   m_outFile = std::fopen(m_outPath.c_str(), "w");
@@ -52,15 +79,37 @@ LexicalReorderingTableCreator::LexicalReorderingTableCreator(
   m_hash.BeginSave(m_outFile); 
 
 
-  if(tempfilePath.size()) {
-    MmapAllocator<unsigned char> allocEncoded(util::FMakeTemp(tempfilePath));
+  if(m_tempfilePath.size()) {
+    MmapAllocator<unsigned char> allocEncoded(util::FMakeTemp(m_tempfilePath));
     m_encodedScores = new StringVector<unsigned char, unsigned long, MmapAllocator>(allocEncoded);
   }
   else {
     m_encodedScores = new StringVector<unsigned char, unsigned long, MmapAllocator>();
   }
+  m_compressedScores = NULL;
+  m_addedLines = 0;
+}
+
+void LexicalReorderingTableCreator::AddLine(const std::string &line)
+{
+  std::vector<std::string> tokens;
+  Moses::TokenizeMultiCharSeparator(tokens, line, m_separator);
   
-  EncodeScores();
+  std::string encodedLine = EncodeLine(tokens);
+  
+  std::string e;
+  if(tokens.size() > 2)
+    e = tokens[1];
+  
+  PackedItem packedItem(m_addedLines++, MakeSourceTargetKey(tokens[0], e),
+                        encodedLine, 0);
+  AddEncodedLine(packedItem);
+  FlushEncodedQueue();
+}
+
+void LexicalReorderingTableCreator::Finish()
+{
+  FlushEncodedQueue(true);
   
   std::cerr << "Intermezzo: Calculating Huffman code sets" << std::endl;
   CalcHuffmanCodes();
@@ -68,8 +117,8 @@ LexicalReorderingTableCreator::LexicalReorderingTableCreator(
   std::cerr << "Pass 2/2: Compressing scores" << std::endl;
   
   
-    if(tempfilePath.size()) {
-    MmapAllocator<unsigned char> allocCompressed(util::FMakeTemp(tempfilePath));
+  if(m_tempfilePath.size()) {
+    MmapAllocator<unsigned char> allocCompressed(util::FMakeTemp(m_tempfilePath));
     m_compressedScores = new StringVector<unsigned char, unsigned long, MmapAllocator>(allocCompressed);
   }
   else {
@@ -86,7 +135,8 @@ LexicalReorderingTableCreator::LexicalReorderingTableCreator(
 void LexicalReorderingTableCreator::PrintInfo()
 {  
   std::cerr << "Used options:" << std::endl;
-  std::cerr << "\tText reordering table will be read from: " << m_inPath << std::endl;
+  if(m_inPath.size())
+    std::cerr << "\tText reordering table will be read from: " << m_inPath << std::endl;
   std::cerr << "\tOutput reordering table will be written to: " << m_outPath << std::endl;
   std::cerr << "\tStep size for source landmark phrases: 2^" << m_orderBits << "=" << (1ul << m_orderBits) << std::endl;
   std::cerr << "\tPhrase fingerprint size: " << m_fingerPrintBits << " bits / P(fp)=" << (float(1)/(1ul << m_fingerPrintBits)) << std::endl;
@@ -61,12 +61,16 @@ class LexicalReorderingTableCreator {
     std::string m_lastFlushedSourcePhrase;
     std::vector<std::string> m_lastRange;
     
+    // lines given to AddLine so far
+    long m_addedLines;
+    
 #ifdef WITH_THREADS    
     size_t m_threads;
 #endif
     
     void PrintInfo();
     
+    void Begin();
     void EncodeScores();
     void CalcHuffmanCodes();
     void CompressScores();
@@ -95,6 +99,25 @@ class LexicalReorderingTableCreator {
 #endif   
                                   );
     
+    // Builds the table from lines given to AddLine instead of a file, so
+    // that a scorer can write it without a text table in between.
+    LexicalReorderingTableCreator(std::string outPath,
+                                  std::string tempfilePath,
+                                  size_t orderBits = 10,
+                                  size_t fingerPrintBits = 16,
+                                  bool multipleScoreTrees = true,
+                                  size_t quantize = 0
+#ifdef WITH_THREADS
+                                  , size_t threads = 2
+#endif   
+                                  );
+    
+    // A line of the text table, in its order.
+    void AddLine(const std::string &line);
+    
+    // Compresses the scores and saves the table, after the last AddLine.
+    void Finish();
+    
     ~LexicalReorderingTableCreator();
     
   friend class EncodingTaskReordering;
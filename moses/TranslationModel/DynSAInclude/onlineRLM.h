@@ -8,8 +8,24 @@
 #include "types.h"
 #include "vocab.h"
 
+#ifdef WITH_THREADS
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/tss.hpp>
+#else
+#include <boost/scoped_ptr.hpp>
+#endif
+
 /*
  * DynamicLM manipulates LM
+ *
+ * getProb() may be called from several threads at once.  Each thread has its
+ * own probability cache, so the context pointers it returns are only
+ * comparable within a thread, and clearCache() clears the calling thread's.
+ * update() takes an exclusive lock against concurrent getProb() calls and
+ * starts a new generation of the model.  A thread whose cache is from an older
+ * generation stops reading it at its next cache miss, but keeps its nodes,
+ * which are the contexts of live hypotheses, until clearCache().
  */
 using randlm::BitFilter;
 using randlm::Cache;
@@ -22,10 +38,9 @@ class OnlineRLM: public PerfectHash<T> {
 public:
   OnlineRLM(uint16_t MBs, int width, int bucketRange, count_t order, 
     Moses::Vocab* v, float qBase = 8): PerfectHash<T>(MBs, width, bucketRange, qBase), 
-    vocab_(v), bAdapting_(false), order_(order), corpusSize_(0), alpha_(0) {
+    vocab_(v), bAdapting_(false), order_(order), corpusSize_(0), alpha_(0), generation_(0) {
     CHECK(vocab_ != 0);
     //instantiate quantizer class here
-    cache_ = new Cache<float>(8888.8888, 9999.9999); // unknown_value, null_value
     alpha_ = new float[order_ + 1];
     for(count_t i = 0; i <= order_; ++i) 
       alpha_[i] = i * log10(0.4);
@@ -34,9 +49,8 @@ public:
     bHit_ = new BitFilter(this->cells_);
   }
   OnlineRLM(FileHandler* fin, count_t order): 
-    PerfectHash<T>(fin), bAdapting_(true), order_(order), corpusSize_(0) {
+    PerfectHash<T>(fin), bAdapting_(true), order_(order), corpusSize_(0), generation_(0) {
     load(fin);
-    cache_ = new Cache<float>(8888.8888, 9999.9999); // unknown_value, null_value
     alpha_ = new float[order_ + 1];
     for(count_t i = 0; i <= order_; ++i) 
       alpha_[i] = i * log10(0.4);
@@ -45,7 +59,6 @@ public:
     if(alpha_) delete[] alpha_;
     if(bAdapting_) delete vocab_;
     else vocab_ = NULL;
-    if(cache_) delete cache_;
     delete bPrefix_;
     delete bHit_;
   }
@@ -63,7 +76,13 @@ public:
   uint64_t corpusSize() {return corpusSize_;}
   void corpusSize(uint64_t c) {corpusSize_ = c;}
   void clearCache() {
-    if(cache_) cache_->clear();
+    ThreadCache& local = this->local();
+    local.cache.clear();
+#ifdef WITH_THREADS
+    boost::shared_lock<boost::shared_mutex> lock(accessLock_);
+#endif
+    local.generation = generation_;
+    local.stale = false;
   }
   void save(FileHandler* fout);
   void load(FileHandler* fin);
@@ -79,12 +98,42 @@ protected:
   void markQueried(hpdEntry_t& value);
   bool markPrefix(const wordID_t* IDs, const int len, bool bSet);
 private:
+  // A thread's probability cache and the generation of the model it holds.
+  struct ThreadCache {
+    ThreadCache(): cache(8888.8888, 9999.9999), generation(0), stale(false) {} // unknown_value, null_value
+    Cache<float> cache;
+    uint64_t generation;
+    bool stale; // older than the model, so only written until cleared
+  };
+  // This thread's cache, created on first use.
+  ThreadCache& local() {
+    if(!cache_.get()) {
+      ThreadCache* created = new ThreadCache();
+      {
+#ifdef WITH_THREADS
+        boost::shared_lock<boost::shared_mutex> lock(accessLock_);
+#endif
+        created->generation = generation_;
+      }
+      cache_.reset(created);
+    }
+    return *cache_;
+  }
+  Cache<float>& cache() {
+    return local().cache;
+  }
   const void* getContext(const wordID_t* ngram, int len); 
   const bool bAdapting_; // used to signal adaptation of model
   const count_t order_; // LM order
   uint64_t corpusSize_; // total training corpus size
   float* alpha_;  // backoff constant
-  Cache<float>* cache_;
+  uint64_t generation_; // number of update() calls, read under accessLock_
+#ifdef WITH_THREADS
+  boost::thread_specific_ptr<ThreadCache> cache_;
+  boost::shared_mutex accessLock_; // shared by getProb, exclusive in update
+#else
+  boost::scoped_ptr<ThreadCache> cache_;
+#endif
   BitFilter* bPrefix_;
   BitFilter* bHit_;
 };
@@ -109,6 +158,9 @@ bool OnlineRLM<T>::insert(const std::vector<string>& ngram, const int value) {
 
 template<typename T>
 bool OnlineRLM<T>::update(const std::vector<string>& ngram, const int value) {
+#ifdef WITH_THREADS
+  boost::unique_lock<boost::shared_mutex> lock(accessLock_);
+#endif
   int len = ngram.size();
   std::vector<wordID_t> wrdIDs(len);
   uint64_t index(this->cells_ + 1);
@@ -127,7 +179,8 @@ bool OnlineRLM<T>::update(const std::vector<string>& ngram, const int value) {
     }
     else if(hpdItr != this->dict_.end()) markQueried(hpdItr);
   }
-
+  vocab_->MakeClosed();
+  ++generation_;
   return bIncluded;
 }
 template<typename T>
@@ -274,11 +327,18 @@ float OnlineRLM<T>::getProb(const wordID_t* ngram, int len,
   static const float oovprob = log10(1.0 / (static_cast<float>(vocab_->Size()) - 1));
   float logprob(0);
   const void* context = (state) ? *state : 0;
+  ThreadCache& local = this->local();
+  Cache<float>& cache = local.cache;
   // if full ngram and prob not in cache
-  if(!cache_->checkCacheNgram(ngram, len, &logprob, &context)) {
+  if(local.stale || !cache.checkCacheNgram(ngram, len, &logprob, &context)) {
+#ifdef WITH_THREADS
+    boost::shared_lock<boost::shared_mutex> lock(accessLock_);
+#endif
+    if(local.generation != generation_) local.stale = true;
     // get full prob and put in cache
     int num_fnd(0), den_val(0);
-    int *in = new int[len]; // in[] keeps counts of increasing order numerator 
+    CHECK(len <= MAX_NGRAM_ORDER);
+    int in[MAX_NGRAM_ORDER]; // in[] keeps counts of increasing order numerator 
     for(int i = 0; i < len; ++i) in[i] = 0;
     for(int i = len - 1; i >= 0; --i) {
       if(ngram[i] == vocab_->GetkOOVWordID()) break;  // no need to query if OOV
@@ -319,7 +379,7 @@ float OnlineRLM<T>::getProb(const wordID_t* ngram, int len,
     // need unique context
     context = getContext(&ngram[len - num_fnd], num_fnd);
     // put whatever was found in cache
-    cache_->setCacheNgram(ngram, len, logprob, context);
+    cache.setCacheNgram(ngram, len, logprob, context);
   } // end checkCache
   return logprob; 
 }
@@ -327,13 +387,11 @@ float OnlineRLM<T>::getProb(const wordID_t* ngram, int len,
 template<typename T>
 const void* OnlineRLM<T>::getContext(const wordID_t* ngram, int len) {
   int dummy(0);
-  float* *addresses = new float*[len];  // only interested in addresses of cache
-  CHECK(cache_->getCache2(ngram, len, &addresses[0], &dummy) == len);
+  CHECK(len <= MAX_NGRAM_ORDER);
+  float* addresses[MAX_NGRAM_ORDER];  // only interested in addresses of cache
+  CHECK(cache().getCache2(ngram, len, &addresses[0], &dummy) == len);
   // return address of cache node
-  
-  float *addr0 = addresses[0];
-  free( addresses );
-  return (const void*)addr0;
+  return (const void*)addresses[0];
 }
 
 template<typename T>
@@ -23,7 +23,8 @@ namespace Moses
 {
 
 void ApplicableRuleTrie::Extend(const UTrieNode &root, int minPos,
-                                const SentenceMap &sentMap, bool followsGap)
+                                const SentenceMap &sentMap, bool followsGap,
+                                util::Pool &pool)
 {
   const UTrieNode::TerminalMap &termMap = root.GetTerminalMap();
   for (UTrieNode::TerminalMap::const_iterator p = termMap.begin();
@@ -38,10 +39,9 @@ void ApplicableRuleTrie::Extend(const UTrieNode &root, int minPos,
          r != q->second.end(); ++r) {
       size_t index = *r;
       if (index == (size_t)minPos || (followsGap && index > (size_t)minPos) || minPos == -1) {
-        ApplicableRuleTrie *subTrie = new ApplicableRuleTrie(index, index,
-                                                             child);
-        subTrie->Extend(child, index+1, sentMap, false);
-        m_children.push_back(subTrie);
+        ApplicableRuleTrie *subTrie = Create(pool, index, index, child);
+        subTrie->Extend(child, index+1, sentMap, false, pool);
+        AddChild(subTrie);
       }
     }
   }
@@ -51,10 +51,10 @@ void ApplicableRuleTrie::Extend(const UTrieNode &root, int minPos,
     return;
   }
   int start = followsGap ? -1 : minPos;
-  ApplicableRuleTrie *subTrie = new ApplicableRuleTrie(start, -1, *child);
+  ApplicableRuleTrie *subTrie = Create(pool, start, -1, *child);
   int newMinPos = (minPos == -1 ? 1 : minPos+1);
-  subTrie->Extend(*child, newMinPos, sentMap, true);
-  m_children.push_back(subTrie);
+  subTrie->Extend(*child, newMinPos, sentMap, true, pool);
+  AddChild(subTrie);
 }
 
 }  // namespace Moses
@@ -22,9 +22,9 @@
 #include "SentenceMap.h"
 #include "VarSpanNode.h"
 #include "moses/TranslationModel/RuleTable/UTrieNode.h"
-#include "moses/Util.h"
+#include "util/pool.hh"
 
-#include <vector>
+#include <new>
 
 namespace Moses
 {
@@ -32,28 +32,50 @@ namespace Moses
 struct VarSpanNode;
 
 /** @todo what is this?
+ *
+ * Nodes are allocated from a util::Pool and are never destroyed
+ * individually: the whole trie goes away when the pool is reset.  Children
+ * are kept as a singly-linked list (in insertion order) so that a node owns
+ * no heap memory of its own.
  */
 struct ApplicableRuleTrie
 {
  public:
-  ApplicableRuleTrie(int start, int end, const UTrieNode &node)
-      : m_start(start)
-      , m_end(end)
-      , m_node(&node)
-      , m_vstNode(NULL) {}
-
-  ~ApplicableRuleTrie() {
-    RemoveAllInColl(m_children);
+  static ApplicableRuleTrie *Create(util::Pool &pool, int start, int end,
+                                    const UTrieNode &node) {
+    return new (pool.Allocate(sizeof(ApplicableRuleTrie)))
+        ApplicableRuleTrie(start, end, node);
   }
 
   void Extend(const UTrieNode &root, int minPos, const SentenceMap &sentMap,
-              bool followsGap);
+              bool followsGap, util::Pool &pool);
 
   int m_start;
   int m_end;
   const UTrieNode *m_node;
   const VarSpanNode *m_vstNode;
-  std::vector<ApplicableRuleTrie*> m_children;
+  ApplicableRuleTrie *m_firstChild;
+  ApplicableRuleTrie *m_lastChild;
+  ApplicableRuleTrie *m_nextSibling;
+
+ private:
+  ApplicableRuleTrie(int start, int end, const UTrieNode &node)
+      : m_start(start)
+      , m_end(end)
+      , m_node(&node)
+      , m_vstNode(NULL)
+      , m_firstChild(NULL)
+      , m_lastChild(NULL)
+      , m_nextSibling(NULL) {}
+
+  void AddChild(ApplicableRuleTrie *child) {
+    if (m_lastChild) {
+      m_lastChild->m_nextSibling = child;
+    } else {
+      m_firstChild = child;
+    }
+    m_lastChild = child;
+  }
 };
 
 }
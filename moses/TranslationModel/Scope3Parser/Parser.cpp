@@ -34,9 +34,26 @@
 #include <memory>
 #include <vector>
 
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#endif
+
 namespace Moses
 {
 
+Scope3Parser::ThreadLocalStorage &Scope3Parser::GetThreadLocalStorage()
+{
+#ifdef WITH_THREADS
+  static boost::thread_specific_ptr<ThreadLocalStorage> threadLocal;
+#else
+  static std::auto_ptr<ThreadLocalStorage> threadLocal;
+#endif
+  if (!threadLocal.get()) {
+    threadLocal.reset(new ThreadLocalStorage());
+  }
+  return *threadLocal;
+}
+
 void Scope3Parser::GetChartRuleCollection(
     const WordsRange &range,
     ChartParserCallback &outColl)
@@ -59,11 +76,12 @@ void Scope3Parser::GetChartRuleCollection(
       matchCB.m_tpc = &tpc;
       matchCB(m_emptyStackVec);
     } else {  // Rule has at least one non-terminal.
-      varSpanNode.CalculateRanges(start, end, m_ranges);
-      m_latticeBuilder.Build(start, end, ruleNode, varSpanNode, m_ranges,
-                             *this, m_lattice,
-                             m_quickCheckTable);
-      StackLatticeSearcher<MatchCallback> searcher(m_lattice, m_ranges);
+      std::vector<VarSpanNode::NonTermRange> &ranges = m_local.ranges;
+      std::vector<std::vector<bool> > &quickCheckTable = m_local.quickCheckTable;
+      varSpanNode.CalculateRanges(start, end, ranges);
+      m_local.latticeBuilder.Build(start, end, ruleNode, varSpanNode, ranges,
+                                   *this, m_local.lattice, quickCheckTable);
+      StackLatticeSearcher<MatchCallback> searcher(m_local.lattice, ranges);
       UTrieNode::LabelMap::const_iterator p = labelMap.begin();
       for (; p != labelMap.end(); ++p) {
         const std::vector<int> &labels = p->first;
@@ -71,7 +89,7 @@ void Scope3Parser::GetChartRuleCollection(
         assert(labels.size() == varSpanNode.m_rank);
         bool failCheck = false;
         for (size_t i = 0; i < varSpanNode.m_rank; ++i) {
-          if (!m_quickCheckTable[i][labels[i]]) {
+          if (!quickCheckTable[i][labels[i]]) {
             failCheck = true;
             break;
           }
@@ -93,13 +111,18 @@ void Scope3Parser::Init()
   const Sentence &sentence = dynamic_cast<const Sentence &>(GetSentence());
 
   // Build a map from Words to index-sets.
-  SentenceMap sentMap;
+  SentenceMap &sentMap = m_local.sentMap;
+  sentMap.clear();
   FillSentenceMap(sentence, sentMap);
 
-  // Build a trie containing 'elastic' application contexts
+  // Build a trie containing 'elastic' application contexts.  The trie is
+  // only needed during initialization so its nodes live in the thread's
+  // pool, which is rewound (not freed) for the next sentence.
+  util::Pool &pool = m_local.artPool;
+  pool.Reset();
   const UTrieNode &rootNode = m_ruleTable.GetRootNode();
-  std::auto_ptr<ApplicableRuleTrie> art(new ApplicableRuleTrie(-1, -1, rootNode));
-  art->Extend(rootNode, -1, sentMap, false);
+  ApplicableRuleTrie *art = ApplicableRuleTrie::Create(pool, -1, -1, rootNode);
+  art->Extend(rootNode, -1, sentMap, false, pool);
 
   // Build a trie containing just the non-terminal contexts and insert pointers
   // to its nodes back into the ART trie.  Contiguous non-terminal contexts are
@@ -188,8 +211,8 @@ void Scope3Parser::AddRulesToCells(
     }
   }
 
-  for (std::vector<ApplicableRuleTrie*>::const_iterator p = node.m_children.begin(); p != node.m_children.end(); ++p) {
-    AddRulesToCells(**p, start, maxPos, depth+1);
+  for (const ApplicableRuleTrie *p = node.m_firstChild; p; p = p->m_nextSibling) {
+    AddRulesToCells(*p, start, maxPos, depth+1);
   }
 }
 
@@ -26,6 +26,7 @@
 #include "moses/TranslationModel/RuleTable/UTrie.h"
 #include "moses/StaticData.h"
 #include "ApplicableRuleTrie.h"
+#include "SentenceMap.h"
 #include "StackLattice.h"
 #include "StackLatticeBuilder.h"
 #include "StackLatticeSearcher.h"
@@ -54,6 +55,7 @@ class Scope3Parser : public ChartRuleLookupManager
       : ChartRuleLookupManager(sentence, cellColl)
       , m_ruleTable(ruleTable)
       , m_maxChartSpan(maxChartSpan)
+      , m_local(GetThreadLocalStorage())
   {
     Init();
   }
@@ -81,6 +83,22 @@ class Scope3Parser : public ChartRuleLookupManager
       const TargetPhraseCollection *m_tpc;
   };
 
+  // Scratch space that is rebuilt for every sentence (the sentence map and
+  // the applicable rule trie) or for every rule application (the stack
+  // lattice and friends).  It is kept per thread so that its memory is
+  // reused across sentences instead of being allocated node by node.
+  struct ThreadLocalStorage
+  {
+    util::Pool artPool;
+    SentenceMap sentMap;
+    StackLattice lattice;
+    StackLatticeBuilder latticeBuilder;
+    std::vector<VarSpanNode::NonTermRange> ranges;
+    std::vector<std::vector<bool> > quickCheckTable;
+  };
+
+  static ThreadLocalStorage &GetThreadLocalStorage();
+
   void Init();
   void InitRuleApplicationVector();
   void FillSentenceMap(const Sentence &, SentenceMap &);
@@ -93,10 +111,7 @@ class Scope3Parser : public ChartRuleLookupManager
   std::auto_ptr<VarSpanNode> m_varSpanTrie;
   StackVec m_emptyStackVec;
   const size_t m_maxChartSpan;
-  StackLattice m_lattice;
-  StackLatticeBuilder m_latticeBuilder;
-  std::vector<VarSpanNode::NonTermRange> m_ranges;
-  std::vector<std::vector<bool> > m_quickCheckTable;
+  ThreadLocalStorage &m_local;
 };
 
 }  // namespace Moses
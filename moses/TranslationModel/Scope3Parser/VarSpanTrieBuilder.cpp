@@ -34,10 +34,8 @@ std::auto_ptr<VarSpanNode> VarSpanTrieBuilder::Build(
 {
   std::auto_ptr<VarSpanNode> vstRoot(new VarSpanNode());
   NodeVec vec;
-  const std::vector<ApplicableRuleTrie*> &children = root.m_children;
-  for (std::vector<ApplicableRuleTrie*>::const_iterator p = children.begin();
-       p != children.end(); ++p) {
-    Build(**p, vec, *(vstRoot.get()));
+  for (ApplicableRuleTrie *p = root.m_firstChild; p; p = p->m_nextSibling) {
+    Build(*p, vec, *(vstRoot.get()));
   }
   return vstRoot;
 }
@@ -78,10 +76,8 @@ void VarSpanTrieBuilder::Build(ApplicableRuleTrie &artNode,
     artNode.m_vstNode = &(vstRoot.Insert(vec));
   }
 
-  const std::vector<ApplicableRuleTrie*> &children = artNode.m_children;
-  for (std::vector<ApplicableRuleTrie*>::const_iterator p = children.begin();
-       p != children.end(); ++p) {
-    Build(**p, vec, vstRoot);
+  for (ApplicableRuleTrie *p = artNode.m_firstChild; p; p = p->m_nextSibling) {
+    Build(*p, vec, vstRoot);
   }
 
   // Return vec to its original value.
@@ -55,6 +55,7 @@ namespace Moses
 
 const size_t DEFAULT_CUBE_PRUNING_POP_LIMIT = 1000;
 const size_t DEFAULT_CUBE_PRUNING_DIVERSITY = 0;
+const float DEFAULT_CUBE_GROWING_BEAM_WIDTH = 0.0f;
 const size_t DEFAULT_MAX_HYPOSTACK_SIZE = 200;
 const size_t DEFAULT_MAX_TRANS_OPT_CACHE_SIZE = 10000;
 const size_t DEFAULT_MAX_TRANS_OPT_SIZE	= 5000;
@@ -125,6 +126,8 @@ enum LMImplementation {
   ,LDHTLM = 11
   ,BackwardLM = 12
   ,LazyBackwardLM = 13
+  ,InterpolatedKen = 14
+  ,LogLinearKen = 15
 };
 
 enum PhraseTableImplementation {
@@ -183,6 +186,7 @@ enum SearchAlgorithm {
   ,ChartDecoding    = 3
   ,NormalBatch      = 4
   ,ChartIncremental = 5
+  ,ChartCubeGrowing = 6
 };
 
 enum SourceLabelOverlap {
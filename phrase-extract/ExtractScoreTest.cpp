@@ -0,0 +1,282 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+/* Runs extract-score on a small corpus and compares its phrase table with
+ * that of extract, sort, score and consolidate, and checks what
+ * --LossyCounting keeps.  The programs and test files are given as arguments,
+ * in any order.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define  BOOST_TEST_MODULE MosesTrainingExtractScore
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+namespace
+{
+
+// The argument whose file name is name.
+string Argument(const char *name)
+{
+  int argc = boost::unit_test::framework::master_test_suite().argc;
+  char **argv = boost::unit_test::framework::master_test_suite().argv;
+  for (int i = 1; i < argc; ++i) {
+    const char *slash = strrchr(argv[i], '/');
+    if (!strcmp(slash ? slash + 1 : argv[i], name)) return argv[i];
+  }
+  BOOST_FAIL("Missing argument " << name);
+  return string();
+}
+
+class TempDir
+{
+public:
+  TempDir() {
+    char pattern[] = "/tmp/extract-score-test.XXXXXX";
+    BOOST_REQUIRE(mkdtemp(pattern));
+    m_path = pattern;
+  }
+
+  ~TempDir() {
+    system(("rm -rf " + m_path).c_str());
+  }
+
+  string File(const char *name) const {
+    return m_path + "/" + name;
+  }
+
+private:
+  string m_path;
+};
+
+void Run(const string &command)
+{
+  BOOST_REQUIRE_MESSAGE(system((command + " 2>/dev/null").c_str()) == 0, "Failed: " << command);
+}
+
+void RunFails(const string &command)
+{
+  BOOST_CHECK_MESSAGE(system((command + " 2>/dev/null").c_str()) != 0, "Did not fail: " << command);
+}
+
+size_t CountWords(const string &phrase)
+{
+  istringstream words(phrase);
+  string word;
+  size_t count = 0;
+  while (words >> word) ++count;
+  return count;
+}
+
+// The "|||"-separated fields of a line.
+vector<string> Fields(const string &line)
+{
+  vector<string> fields;
+  size_t begin = 0, end;
+  while ((end = line.find(" ||| ", begin)) != string::npos) {
+    fields.push_back(line.substr(begin, end - begin));
+    begin = end + 5;
+  }
+  fields.push_back(line.substr(begin));
+  return fields;
+}
+
+// The length of a phrase pair as lossy counting sees it: that of its longer
+// phrase.
+size_t PairLength(const string &source, const string &target)
+{
+  return max(CountWords(source), CountWords(target));
+}
+
+// Joint count of each "source ||| target" in a phrase table.
+map<string, double> JointCounts(const string &phraseTable)
+{
+  map<string, double> counts;
+  ifstream in(phraseTable.c_str());
+  string line;
+  while (getline(in, line)) {
+    vector<string> fields = Fields(line);
+    BOOST_REQUIRE(fields.size() >= 5);
+    istringstream last(fields.back());
+    double countE, countF, joint;
+    BOOST_REQUIRE(last >> countE >> countF >> joint);
+    counts[fields[0] + " ||| " + fields[1]] = joint;
+  }
+  return counts;
+}
+
+// Number of extracted phrase pairs of each length in an extract file.
+vector<size_t> PairsByLength(const string &extract, size_t maxLength)
+{
+  vector<size_t> pairs(maxLength + 1, 0);
+  ifstream in(extract.c_str());
+  string line;
+  while (getline(in, line)) {
+    vector<string> fields = Fields(line);
+    BOOST_REQUIRE(fields.size() >= 2);
+    size_t length = PairLength(fields[0], fields[1]);
+    BOOST_REQUIRE(length <= maxLength);
+    ++pairs[length];
+  }
+  return pairs;
+}
+
+// The --LossyCounting option for lengths from to to.
+string LossyOption(size_t from, size_t to, double error, double support)
+{
+  ostringstream option;
+  option << " --LossyCounting " << from << "-" << to << ":" << error << ":" << support;
+  return option.str();
+}
+
+void CheckSameLines(const string &expected, const string &actual)
+{
+  ifstream expectedFile(expected.c_str()), actualFile(actual.c_str());
+  BOOST_REQUIRE(expectedFile && actualFile);
+  string expectedLine, actualLine;
+  size_t lines = 0;
+  while (getline(expectedFile, expectedLine)) {
+    BOOST_REQUIRE_MESSAGE(getline(actualFile, actualLine), "Missing line " << expectedLine);
+    BOOST_REQUIRE_EQUAL(expectedLine, actualLine);
+    ++lines;
+  }
+  BOOST_CHECK(!getline(actualFile, actualLine));
+  BOOST_CHECK(lines > 0);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(same_as_pipeline)
+{
+  TempDir dir;
+  const string corpus = Argument("test.e") + " " + Argument("test.f") + " " + Argument("test.a");
+  const string lexF2E = Argument("test.lex.f2e"), lexE2F = Argument("test.lex.e2f");
+
+  Run(Argument("extract") + " " + corpus + " " + dir.File("extract") + " 5");
+  Run("LC_ALL=C sort " + dir.File("extract") + " > " + dir.File("extract.sorted"));
+  Run("LC_ALL=C sort " + dir.File("extract.inv") + " > " + dir.File("extract.inv.sorted"));
+  Run(Argument("score") + " " + dir.File("extract.sorted") + " " + lexF2E + " " + dir.File("half.f2e"));
+  Run(Argument("score") + " " + dir.File("extract.inv.sorted") + " " + lexE2F + " " + dir.File("half.e2f") + " --Inverse");
+  Run("LC_ALL=C sort " + dir.File("half.e2f") + " > " + dir.File("half.e2f.sorted"));
+  Run(Argument("consolidate") + " " + dir.File("half.f2e") + " " + dir.File("half.e2f.sorted") + " " + dir.File("phrase-table.pipeline"));
+
+  // Small sort blocks so that sorting merges.
+  Run(Argument("extract-score") + " " + corpus + " " + lexF2E + " " + lexE2F + " 5 " + dir.File("phrase-table") +
+      " --Temp " + dir.File("sort") + " --SortMemory 256K --SortBlock 64K");
+
+  CheckSameLines(dir.File("phrase-table.pipeline"), dir.File("phrase-table"));
+}
+
+// Thresholds of 0 keep every pair, so the table is the exact one.
+BOOST_AUTO_TEST_CASE(lossy_counting_without_pruning)
+{
+  TempDir dir;
+  const string command = Argument("extract-score") + " " + Argument("test.e") + " " + Argument("test.f") + " " +
+                         Argument("test.a") + " " + Argument("test.lex.f2e") + " " + Argument("test.lex.e2f") + " 5 ";
+
+  Run(command + dir.File("phrase-table") + " --Temp " + dir.File("sort"));
+  Run(command + dir.File("phrase-table.lossy") + " --Temp " + dir.File("sort") + " --LossyCounting 1-5:0:0");
+  CheckSameLines(dir.File("phrase-table"), dir.File("phrase-table.lossy"));
+}
+
+BOOST_AUTO_TEST_CASE(lossy_counting_prunes)
+{
+  TempDir dir;
+  const string corpus = Argument("test.e") + " " + Argument("test.f") + " " + Argument("test.a");
+  const string command = Argument("extract-score") + " " + corpus + " " + Argument("test.lex.f2e") + " " +
+                         Argument("test.lex.e2f") + " 5 ";
+
+  // N, the number of pairs each counter sees
+  Run(Argument("extract") + " " + corpus + " " + dir.File("extract") + " 5");
+  vector<size_t> pairs = PairsByLength(dir.File("extract"), 5);
+  const double shortPairs = pairs[1] + pairs[2], longPairs = pairs[3] + pairs[4] + pairs[5];
+  BOOST_REQUIRE(shortPairs > 0 && longPairs > 0);
+
+  Run(command + dir.File("phrase-table") + " --Temp " + dir.File("sort"));
+  const map<string, double> exact = JointCounts(dir.File("phrase-table"));
+
+  // With error 0 counts are exact, so exactly the pairs counted at least s*N
+  // times are kept, with their counts.
+  const double shortSupport = 0.004, longSupport = 0.002;
+  Run(command + dir.File("phrase-table.pruned") + " --Temp " + dir.File("sort") +
+      LossyOption(1, 2, 0, shortSupport) + LossyOption(3, 5, 0, longSupport));
+  const map<string, double> pruned = JointCounts(dir.File("phrase-table.pruned"));
+  size_t expected = 0;
+  for (map<string, double>::const_iterator i = exact.begin(); i != exact.end(); ++i) {
+    vector<string> fields = Fields(i->first);
+    bool isShort = PairLength(fields[0], fields[1]) <= 2;
+    double threshold = isShort ? shortSupport * shortPairs : longSupport * longPairs;
+    map<string, double>::const_iterator kept = pruned.find(i->first);
+    if (i->second >= threshold) {
+      ++expected;
+      BOOST_REQUIRE_MESSAGE(kept != pruned.end(), "Missing " << i->first);
+      BOOST_CHECK_EQUAL(kept->second, i->second);
+    } else {
+      BOOST_CHECK_MESSAGE(kept == pruned.end(), "Kept " << i->first);
+    }
+  }
+  BOOST_CHECK_EQUAL(pruned.size(), expected);
+  BOOST_CHECK(expected > 0 && expected < exact.size());
+
+  // With a positive error counts may be too low, but by at most e*N, and no
+  // pair counted less than (s-e)*N is kept.
+  const double error = 0.001, support = 0.004, allPairs = shortPairs + longPairs;
+  Run(command + dir.File("phrase-table.lossy") + " --Temp " + dir.File("sort") + LossyOption(1, 5, error, support));
+  const map<string, double> lossy = JointCounts(dir.File("phrase-table.lossy"));
+  BOOST_CHECK(!lossy.empty() && lossy.size() < exact.size());
+  for (map<string, double>::const_iterator i = lossy.begin(); i != lossy.end(); ++i) {
+    map<string, double>::const_iterator found = exact.find(i->first);
+    BOOST_REQUIRE_MESSAGE(found != exact.end(), "Not extracted " << i->first);
+    BOOST_CHECK(i->second <= found->second);
+    BOOST_CHECK(i->second >= (support - error) * allPairs);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(lossy_counting_rejects_bad_ranges)
+{
+  TempDir dir;
+  const string command = Argument("extract-score") + " " + Argument("test.e") + " " + Argument("test.f") + " " +
+                         Argument("test.a") + " " + Argument("test.lex.f2e") + " " + Argument("test.lex.e2f") + " 5 " +
+                         dir.File("phrase-table") + " --Temp " + dir.File("sort") + " --LossyCounting ";
+
+  // lengths that no range covers
+  RunFails(command + "1-3:0:0");
+  RunFails(command + "2-5:0:0");
+  RunFails(command + "1-2:0:0 --LossyCounting 4-5:0:0");
+  // malformed ranges
+  RunFails(command + "0-5:0:0");
+  RunFails(command + "3-1:0:0");
+  RunFails(command + "1-5:0.01:0.01");
+  RunFails(command + "1-5:0:0:0");
+  RunFails(command + "1-5:x:0");
+  RunFails(command + "1-5");
+
+  // a single length, and a range that reaches past max-length
+  Run(command + "1:0:0 --LossyCounting 2-9:0:0");
+}
@@ -0,0 +1,240 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "LexicalTable.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/file_piece.hh"
+#include "util/tokenize_piece.hh"
+
+using namespace std;
+
+namespace MosesTraining
+{
+
+namespace
+{
+const char kMagic[16] = "moses lex 1\n";
+const uint64_t kInvalidKey = static_cast<uint64_t>(-1);
+const float kMultiplier = 1.5;
+
+struct BinaryHeader {
+  char magic[sizeof(kMagic)];
+  uint64_t givenWords, predictedWords, wordBytes, tableSize;
+};
+
+size_t Align8(size_t size)
+{
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
+// The inverse of ids, with noId where no id maps.
+void InvertIds(const vector<WORD_ID> &ids, WORD_ID noId, vector<WORD_ID> &inverse)
+{
+  inverse.clear();
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (ids[i] >= inverse.size()) inverse.resize(ids[i] + 1, noId);
+    inverse[ids[i]] = i;
+  }
+}
+} // namespace
+
+LexicalTable::LexicalTable() : m_renumbered(false), m_tableOffset(0), m_tableSize(0) {}
+
+void LexicalTable::Load(const string &fileName, Vocabulary &given, Vocabulary &predicted)
+{
+  Load(fileName);
+  vector<WORD_ID> givenIds(m_givenWords.size()), predictedIds(m_predictedWords.size());
+  for (size_t i = 0; i < m_givenWords.size(); ++i) {
+    givenIds[i] = given.storeIfNew(m_givenWords[i]);
+  }
+  for (size_t i = 0; i < m_predictedWords.size(); ++i) {
+    predictedIds[i] = predicted.storeIfNew(m_predictedWords[i]);
+  }
+  MapWords(givenIds, predictedIds);
+}
+
+void LexicalTable::Load(const string &fileName)
+{
+  cerr << "Loading lexical translation table from " << fileName;
+  char magic[sizeof(kMagic)];
+  {
+    util::scoped_fd file(util::OpenReadOrThrow(fileName.c_str()));
+    if (util::ReadOrEOF(file.get(), magic, sizeof(magic)) != sizeof(magic)) magic[0] = 0;
+  }
+  if (!memcmp(magic, kMagic, sizeof(magic))) {
+    LoadBinary(fileName);
+  } else {
+    LoadText(fileName);
+  }
+  cerr << endl;
+}
+
+void LexicalTable::LoadText(const string &fileName)
+{
+  Vocabulary given, predicted;
+  vector<Entry> entries;
+  util::FilePiece in(fileName.c_str());
+  for (int i = 1; ; ++i) {
+    if (i%100000 == 0) cerr << "." << flush;
+    StringPiece line;
+    try {
+      line = in.ReadLine();
+    } catch (const util::EndOfFileException &e) {
+      break;
+    }
+
+    StringPiece token[3];
+    size_t count = 0;
+    for (util::TokenIter<util::AnyCharacter, true> it(line, util::AnyCharacter(" \t")); it; ++it, ++count) {
+      if (count < 3) token[count] = *it;
+    }
+    if (count != 3) {
+      cerr << "line " << i << " in " << fileName
+           << " has wrong number of tokens, skipping:\n"
+           << count << " " << line << endl;
+      continue;
+    }
+
+    Entry entry;
+    WORD_ID wordT = predicted.storeIfNew(token[0].as_string());
+    WORD_ID wordS = given.storeIfNew(token[1].as_string());
+    entry.key = Key(wordS, wordT);
+    entry.prob = atof(token[2].as_string().c_str());
+    entries.push_back(entry);
+  }
+  Build(given.vocab, predicted.vocab, entries);
+}
+
+void LexicalTable::LoadBinary(const string &fileName)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(fileName.c_str()));
+  util::MapRead(util::LAZY, file.get(), 0, util::SizeOrThrow(file.get()), m_memory);
+
+  BinaryHeader header;
+  UTIL_THROW_IF(m_memory.size() < sizeof(header), util::Exception, "Truncated lexical table " << fileName);
+  memcpy(&header, m_memory.begin(), sizeof(header));
+  UTIL_THROW_IF(m_memory.size() < sizeof(header) + Align8(header.wordBytes) + header.tableSize,
+                util::Exception, "Truncated lexical table " << fileName);
+
+  const char *word = m_memory.begin() + sizeof(header);
+  m_givenWords.resize(header.givenWords);
+  for (size_t i = 0; i < m_givenWords.size(); ++i) {
+    m_givenWords[i] = word;
+    word += m_givenWords[i].size() + 1;
+  }
+  m_predictedWords.resize(header.predictedWords);
+  for (size_t i = 0; i < m_predictedWords.size(); ++i) {
+    m_predictedWords[i] = word;
+    word += m_predictedWords[i].size() + 1;
+  }
+
+  m_tableOffset = sizeof(header) + Align8(header.wordBytes);
+  m_tableSize = header.tableSize;
+  m_table = Table(const_cast<char*>(m_memory.begin()) + m_tableOffset, m_tableSize, kInvalidKey);
+  ClearFileIds();
+}
+
+void LexicalTable::MapWords(const vector<WORD_ID> &given, const vector<WORD_ID> &predicted)
+{
+  bool identity = true;
+  for (size_t i = 0; identity && i < given.size(); ++i) identity = (given[i] == i);
+  for (size_t i = 0; identity && i < predicted.size(); ++i) identity = (predicted[i] == i);
+  if (identity) {
+    ClearFileIds();
+    return;
+  }
+
+  // Copying the table to renumber it would lose the pages shared with other
+  // processes, so lookups translate the ids instead.
+  InvertIds(given, m_givenWords.size(), m_givenFileIds);
+  InvertIds(predicted, m_predictedWords.size(), m_predictedFileIds);
+  m_renumbered = true;
+}
+
+void LexicalTable::ClearFileIds()
+{
+  m_renumbered = false;
+  m_givenFileIds.clear();
+  m_predictedFileIds.clear();
+}
+
+void LexicalTable::Build(const vector<string> &givenWords, const vector<string> &predictedWords, const vector<Entry> &entries)
+{
+  m_givenWords = givenWords;
+  m_predictedWords = predictedWords;
+  Allocate(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    // a repeated pair keeps its last probability
+    Table::MutableIterator found;
+    if (m_table.FindOrInsert(entries[i], found)) found->prob = entries[i].prob;
+  }
+  ClearFileIds();
+}
+
+void LexicalTable::Save(const string &fileName) const
+{
+  string words;
+  for (size_t i = 0; i < m_givenWords.size(); ++i) {
+    words.append(m_givenWords[i].c_str(), m_givenWords[i].size() + 1);
+  }
+  for (size_t i = 0; i < m_predictedWords.size(); ++i) {
+    words.append(m_predictedWords[i].c_str(), m_predictedWords[i].size() + 1);
+  }
+
+  BinaryHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.givenWords = m_givenWords.size();
+  header.predictedWords = m_predictedWords.size();
+  header.wordBytes = words.size();
+  header.tableSize = m_tableSize;
+  words.resize(Align8(words.size()), 0);
+
+  util::scoped_fd file(util::CreateOrThrow(fileName.c_str()));
+  util::WriteOrThrow(file.get(), &header, sizeof(header));
+  util::WriteOrThrow(file.get(), words.data(), words.size());
+  util::WriteOrThrow(file.get(), BucketsBegin(), m_tableSize);
+}
+
+void LexicalTable::Allocate(size_t entries)
+{
+  m_tableOffset = 0;
+  m_tableSize = Table::Size(entries, kMultiplier);
+  util::MapAnonymous(m_tableSize, m_memory);
+  m_table = Table(m_memory.get(), m_tableSize, kInvalidKey);
+  m_table.Clear();
+}
+
+const LexicalTable::Entry *LexicalTable::BucketsBegin() const
+{
+  return reinterpret_cast<const Entry*>(m_memory.begin() + m_tableOffset);
+}
+
+const LexicalTable::Entry *LexicalTable::BucketsEnd() const
+{
+  return BucketsBegin() + m_tableSize / sizeof(Entry);
+}
+
+}
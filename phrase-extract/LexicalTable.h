@@ -0,0 +1,130 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "tables-core.h"
+#include "util/mmap.hh"
+#include "util/murmur_hash.hh"
+#include "util/probing_hash_table.hh"
+
+namespace MosesTraining
+{
+
+/* Word translation probabilities p(predicted | given) for lexical weighting,
+ * as in lex.f2e and lex.e2f, whose lines are "predicted given probability".
+ *
+ * Pairs of word ids are kept in a probing hash table of 16-byte entries.  A
+ * binary dump (see Save) holds the words and the hash table as it is in
+ * memory; Load recognises it by its header and maps it instead of parsing, so
+ * processes loading the same table share its pages.  The table is never
+ * rewritten after loading: renumbered words are translated back to the ids of
+ * the file on lookup.
+ */
+class LexicalTable
+{
+public:
+  struct Entry {
+    typedef uint64_t Key;
+    uint64_t key;
+    double prob;
+
+    uint64_t GetKey() const {
+      return key;
+    }
+    void SetKey(uint64_t to) {
+      key = to;
+    }
+  };
+
+  static uint64_t Key(WORD_ID given, WORD_ID predicted) {
+    return (static_cast<uint64_t>(given) << 32) | predicted;
+  }
+
+  LexicalTable();
+
+  // Reads a text or binary table and numbers its words with the ids of the
+  // given vocabularies.
+  void Load(const std::string &fileName, Vocabulary &given, Vocabulary &predicted);
+
+  // Reads a text or binary table, with words numbered as in the file:
+  // GivenWords()[id] and PredictedWords()[id].
+  void Load(const std::string &fileName);
+
+  // Renumbers words: given id i becomes given[i], and the same for predicted.
+  // Lookup then takes the new ids.
+  void MapWords(const std::vector<WORD_ID> &given, const std::vector<WORD_ID> &predicted);
+
+  // Replaces the table.  Words are numbered by their position.
+  void Build(const std::vector<std::string> &givenWords, const std::vector<std::string> &predictedWords, const std::vector<Entry> &entries);
+
+  // Writes a binary dump, with words numbered as in the file.
+  void Save(const std::string &fileName) const;
+
+  const std::vector<std::string> &GivenWords() const {
+    return m_givenWords;
+  }
+  const std::vector<std::string> &PredictedWords() const {
+    return m_predictedWords;
+  }
+
+  // 1.0 if the pair is not in the table.
+  double Lookup(WORD_ID given, WORD_ID predicted) const {
+    if (m_renumbered) {
+      // ids the file does not have become one past its last id
+      given = given < m_givenFileIds.size() ? m_givenFileIds[given] : m_givenWords.size();
+      predicted = predicted < m_predictedFileIds.size() ? m_predictedFileIds[predicted] : m_predictedWords.size();
+    }
+    Table::ConstIterator i;
+    return m_table.Find(Key(given, predicted), i) ? i->prob : 1.0;
+  }
+
+private:
+  struct Hash {
+    uint64_t operator()(uint64_t key) const {
+      return util::MurmurHashNative(&key, sizeof(key));
+    }
+  };
+  typedef util::ProbingHashTable<Entry, Hash> Table;
+
+  void LoadText(const std::string &fileName);
+  void LoadBinary(const std::string &fileName);
+  void Allocate(size_t entries);
+  void ClearFileIds();
+  const Entry *BucketsBegin() const;
+  const Entry *BucketsEnd() const;
+
+  std::vector<std::string> m_givenWords, m_predictedWords;
+
+  // after MapWords, the file id of each new id
+  bool m_renumbered;
+  std::vector<WORD_ID> m_givenFileIds, m_predictedFileIds;
+
+  // the buckets of m_table, allocated or mapped from a binary dump
+  util::scoped_memory m_memory;
+  size_t m_tableOffset, m_tableSize;
+  Table m_table;
+};
+
+}
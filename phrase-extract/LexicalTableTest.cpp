@@ -0,0 +1,167 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "LexicalTable.h"
+#include "tables-core.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define  BOOST_TEST_MODULE MosesTrainingLexicalTable
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace MosesTraining;
+using namespace std;
+
+namespace
+{
+
+// "predicted given probability", with words on both sides and a NULL
+const char kTable[] =
+  "das the 0.7\n"
+  "der the 0.2\n"
+  "haus house 0.9\n"
+  "haus home 0.4\n"
+  "heim home 0.5\n"
+  "das NULL 0.05\n"
+  "the the 0.01\n"
+  "malformed line\n";
+
+const char *kGiven[] = { "the", "house", "home", "NULL", "das", "unseen" };
+const char *kPredicted[] = { "das", "der", "haus", "heim", "the", "unseen" };
+const size_t kWords = 6;
+
+// A text table and its binary dump, in a directory removed afterwards.
+class Files
+{
+public:
+  Files() {
+    char pattern[] = "/tmp/lexical-table-test.XXXXXX";
+    BOOST_REQUIRE(mkdtemp(pattern));
+    m_path = pattern;
+    ofstream out(Text().c_str());
+    out << kTable;
+  }
+
+  ~Files() {
+    system(("rm -rf " + m_path).c_str());
+  }
+
+  string Text() const {
+    return m_path + "/lex.f2e";
+  }
+  string Binary() const {
+    return m_path + "/lex.f2e.bin";
+  }
+
+private:
+  string m_path;
+};
+
+// Word ids of the test words, adding them to vocab.
+vector<WORD_ID> Ids(Vocabulary &vocab, const char **words)
+{
+  vector<WORD_ID> ids;
+  for (size_t i = 0; i < kWords; ++i) ids.push_back(vocab.storeIfNew(words[i]));
+  return ids;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(text)
+{
+  Files files;
+  Vocabulary given, predicted;
+  LexicalTable table;
+  table.Load(files.Text(), given, predicted);
+  BOOST_CHECK_CLOSE(table.Lookup(given.getWordID("the"), predicted.getWordID("das")), 0.7, 1e-9);
+  BOOST_CHECK_CLOSE(table.Lookup(given.getWordID("home"), predicted.getWordID("haus")), 0.4, 1e-9);
+  BOOST_CHECK_CLOSE(table.Lookup(given.getWordID("NULL"), predicted.getWordID("das")), 0.05, 1e-9);
+  BOOST_CHECK_EQUAL(table.Lookup(given.getWordID("house"), predicted.getWordID("das")), 1.0);
+}
+
+// Save, load into a fresh vocabulary that numbers the words differently, and
+// look up every pair of words as the text loader does.
+BOOST_AUTO_TEST_CASE(binary_matches_text)
+{
+  Files files;
+  Vocabulary textGiven, textPredicted;
+  LexicalTable text;
+  text.Load(files.Text(), textGiven, textPredicted);
+  text.Save(files.Binary());
+
+  Vocabulary binaryGiven, binaryPredicted;
+  binaryGiven.storeIfNew("house");
+  binaryGiven.storeIfNew("first");
+  binaryPredicted.storeIfNew("heim");
+  LexicalTable binary;
+  binary.Load(files.Binary(), binaryGiven, binaryPredicted);
+  BOOST_CHECK(binary.GivenWords() == text.GivenWords());
+  BOOST_CHECK(binary.PredictedWords() == text.PredictedWords());
+
+  vector<WORD_ID> textGivenIds = Ids(textGiven, kGiven);
+  vector<WORD_ID> textPredictedIds = Ids(textPredicted, kPredicted);
+  vector<WORD_ID> binaryGivenIds = Ids(binaryGiven, kGiven);
+  vector<WORD_ID> binaryPredictedIds = Ids(binaryPredicted, kPredicted);
+  BOOST_REQUIRE(binaryGivenIds != textGivenIds);
+  size_t found = 0;
+  for (size_t g = 0; g < kWords; ++g) {
+    for (size_t p = 0; p < kWords; ++p) {
+      double expected = text.Lookup(textGivenIds[g], textPredictedIds[p]);
+      BOOST_CHECK_MESSAGE(binary.Lookup(binaryGivenIds[g], binaryPredictedIds[p]) == expected,
+                          "p(" << kPredicted[p] << " | " << kGiven[g] << ")");
+      if (expected != 1.0) ++found;
+    }
+  }
+  BOOST_CHECK_EQUAL(found, 7U);
+}
+
+// Without vocabularies, ids are those of the file until MapWords.
+BOOST_AUTO_TEST_CASE(map_words)
+{
+  Files files;
+  {
+    Vocabulary given, predicted;
+    LexicalTable text;
+    text.Load(files.Text(), given, predicted);
+    text.Save(files.Binary());
+  }
+
+  LexicalTable table;
+  table.Load(files.Binary());
+  const vector<string> &givenWords = table.GivenWords();
+  const vector<string> &predictedWords = table.PredictedWords();
+  BOOST_REQUIRE_EQUAL(givenWords.size(), 4U);
+  BOOST_REQUIRE_EQUAL(predictedWords.size(), 5U);
+  BOOST_CHECK_EQUAL(givenWords[0], "the");
+  BOOST_CHECK_EQUAL(predictedWords[2], "haus");
+  BOOST_CHECK_CLOSE(table.Lookup(0, 0), 0.7, 1e-9);
+
+  // reverse the numbering
+  vector<WORD_ID> given, predicted;
+  for (size_t i = 0; i < givenWords.size(); ++i) given.push_back(givenWords.size() - 1 - i);
+  for (size_t i = 0; i < predictedWords.size(); ++i) predicted.push_back(predictedWords.size() - 1 - i);
+  table.MapWords(given, predicted);
+  BOOST_CHECK_CLOSE(table.Lookup(3, 4), 0.7, 1e-9);
+  BOOST_CHECK_EQUAL(table.Lookup(0, 0), 1.0);
+  BOOST_CHECK_EQUAL(table.Lookup(10, 4), 1.0);
+}
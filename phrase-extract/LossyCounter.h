@@ -0,0 +1,128 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include <stdint.h>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace MosesTraining
+{
+
+/* Approximate frequency counts over a stream, by lossy counting as in
+ *   G. S. Manku and R. Motwani, Approximate Frequency Counts over Data
+ *   Streams, VLDB 2002,
+ * which is also what contrib/eppex uses.  With error e, the stream is cut
+ * into buckets of ceil(1/e) items, and at the end of bucket b every item
+ * whose count plus possible undercount is at most b is dropped.  After N
+ * items
+ *   - a count is at most e*N below the true frequency,
+ *   - ForEachFrequent, with support s > e, reports every item that occurred
+ *     at least s*N times and none that occurred less than (s-e)*N times,
+ *   - at most (1/e) log(e*N) items are kept,
+ * so memory does not grow with the length of the stream.  An error of 0
+ * counts exactly and keeps every item, so memory is not bounded; only with
+ * support 0 as well does ForEachFrequent report every item.
+ */
+template <class Key, class Hash = boost::hash<Key> > class LossyCounter
+{
+public:
+  LossyCounter(double error, double support)
+    : m_error(error), m_support(support),
+      m_bucketWidth(error > 0 ? static_cast<uint64_t>(std::ceil(1 / error)) : 0),
+      m_bucket(1), m_count(0) {}
+
+  void Add(const Key &key) {
+    typename Map::iterator i = m_items.find(key);
+    if (i == m_items.end()) {
+      Entry entry;
+      entry.frequency = 1;
+      entry.maxError = m_bucket - 1;
+      m_items.insert(std::make_pair(key, entry));
+    } else {
+      ++i->second.frequency;
+    }
+    ++m_count;
+    if (m_bucketWidth && m_count % m_bucketWidth == 0) {
+      Prune();
+      ++m_bucket;
+    }
+  }
+
+  // Items added so far (N).
+  uint64_t Count() const {
+    return m_count;
+  }
+
+  // Items kept.
+  size_t Size() const {
+    return m_items.size();
+  }
+
+  // Counts below this are not reported: (s-e)*N.
+  double Threshold() const {
+    return (m_support - m_error) * m_count;
+  }
+
+  // Calls callback(key, count) for each item kept.
+  template <class Callback> void ForEach(Callback &callback) const {
+    for (typename Map::const_iterator i = m_items.begin(); i != m_items.end(); ++i) {
+      callback(i->first, i->second.frequency);
+    }
+  }
+
+  // Calls callback(key, count) for each item counted at least Threshold() times.
+  template <class Callback> void ForEachFrequent(Callback &callback) const {
+    const double threshold = Threshold();
+    for (typename Map::const_iterator i = m_items.begin(); i != m_items.end(); ++i) {
+      if (i->second.frequency >= threshold) callback(i->first, i->second.frequency);
+    }
+  }
+
+private:
+  struct Entry {
+    uint64_t frequency;
+    // how often the item may have occurred before it was last added
+    uint64_t maxError;
+  };
+  typedef boost::unordered_map<Key, Entry, Hash> Map;
+
+  void Prune() {
+    for (typename Map::iterator i = m_items.begin(); i != m_items.end(); ) {
+      if (i->second.frequency + i->second.maxError <= m_bucket) {
+        i = m_items.erase(i);
+      } else {
+        ++i;
+      }
+    }
+  }
+
+  const double m_error, m_support;
+  const uint64_t m_bucketWidth;
+  uint64_t m_bucket;
+  uint64_t m_count;
+  Map m_items;
+};
+
+}
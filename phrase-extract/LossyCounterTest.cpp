@@ -0,0 +1,151 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "LossyCounter.h"
+
+#include <cmath>
+#include <map>
+
+#define  BOOST_TEST_MODULE MosesTrainingLossyCounter
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace MosesTraining;
+using namespace std;
+
+namespace
+{
+
+typedef LossyCounter<unsigned int> Counter;
+
+struct Collect {
+  map<unsigned int, uint64_t> counts;
+  void operator()(unsigned int key, uint64_t count) {
+    counts[key] = count;
+  }
+};
+
+// A skewed stream: item k with probability about 1/k^2.
+class SkewedStream
+{
+public:
+  SkewedStream() : m_state(12345) {}
+
+  unsigned int Next() {
+    m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    double uniform = ((m_state >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return static_cast<unsigned int>(1 / uniform);
+  }
+
+private:
+  uint64_t m_state;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(prunes_at_bucket_boundaries)
+{
+  // error 0.1: buckets of 10 items
+  Counter counter(0.1, 0.2);
+  counter.Add(1);
+  counter.Add(1);
+  for (unsigned int i = 2; i < 9; ++i) counter.Add(i);
+  // nothing is pruned before the bucket is full
+  BOOST_CHECK_EQUAL(counter.Size(), 8U);
+  counter.Add(10);
+  // end of bucket 1: items seen once are dropped, the one seen twice is kept
+  BOOST_CHECK_EQUAL(counter.Size(), 1U);
+
+  // Items first seen in bucket 2 may have been missed once before, so they
+  // need two occurrences in it to survive.
+  counter.Add(11);
+  counter.Add(11);
+  counter.Add(12);
+  counter.Add(1);
+  for (unsigned int i = 0; i < 6; ++i) counter.Add(20 + i);
+  BOOST_CHECK_EQUAL(counter.Count(), 20U);
+  Collect kept;
+  counter.ForEach(kept);
+  BOOST_CHECK_EQUAL(kept.counts.size(), 2U);
+  BOOST_CHECK_EQUAL(kept.counts[1], 3U);
+  BOOST_CHECK_EQUAL(kept.counts[11], 2U);
+}
+
+BOOST_AUTO_TEST_CASE(error_zero_counts_exactly)
+{
+  Counter counter(0, 0);
+  for (unsigned int i = 0; i < 1000; ++i) counter.Add(i);
+  BOOST_CHECK_EQUAL(counter.Size(), 1000U);
+}
+
+BOOST_AUTO_TEST_CASE(no_false_negatives)
+{
+  const double error = 0.001, support = 0.01;
+  Counter counter(error, support);
+  map<unsigned int, uint64_t> exact;
+  SkewedStream stream;
+  for (size_t i = 0; i < 200000; ++i) {
+    unsigned int item = stream.Next();
+    counter.Add(item);
+    ++exact[item];
+  }
+  const double n = static_cast<double>(counter.Count());
+
+  Collect frequent;
+  counter.ForEachFrequent(frequent);
+  size_t above = 0;
+  for (map<unsigned int, uint64_t>::const_iterator i = exact.begin(); i != exact.end(); ++i) {
+    map<unsigned int, uint64_t>::const_iterator found = frequent.counts.find(i->first);
+    if (i->second >= support * n) {
+      // reported, with a count at most e*N too low
+      ++above;
+      BOOST_REQUIRE_MESSAGE(found != frequent.counts.end(), "Missing item " << i->first << " counted " << i->second);
+      BOOST_CHECK(found->second <= i->second);
+      BOOST_CHECK(found->second + error * n >= i->second);
+    } else if (i->second < (support - error) * n) {
+      BOOST_CHECK_MESSAGE(found == frequent.counts.end(), "Reported item " << i->first << " counted " << i->second);
+    }
+  }
+  // the stream is skewed enough for the check to mean something
+  BOOST_CHECK(above > 5);
+}
+
+BOOST_AUTO_TEST_CASE(size_stays_bounded)
+{
+  const double error = 0.001;
+  Counter counter(error, 0.01);
+  SkewedStream stream;
+  size_t maxSize = 0;
+  const size_t items = 500000;
+  for (size_t i = 0; i < items; ++i) {
+    counter.Add(stream.Next());
+    maxSize = max(maxSize, counter.Size());
+  }
+  // (1/e) log(e*N) kept, plus at most one bucket of new items
+  BOOST_CHECK(maxSize <= (1 / error) * (log(error * items) + 1));
+
+  // A stream of distinct items never keeps more than a bucket.
+  Counter distinct(error, 0.01);
+  maxSize = 0;
+  for (unsigned int i = 0; i < items; ++i) {
+    distinct.Add(i);
+    maxSize = max(maxSize, distinct.Size());
+  }
+  BOOST_CHECK_EQUAL(maxSize, 999U);
+}
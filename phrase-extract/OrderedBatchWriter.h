@@ -0,0 +1,75 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace MosesTraining
+{
+
+/* Writes batches of output that worker threads finish in any order in the
+ * order they were numbered, like Moses::OutputCollector.  Batches are
+ * numbered from 0; each is passed to sink(Batch&) once all batches before it
+ * have been, and is then deleted.  The sink runs under the writer's lock, so
+ * it may update totals without locking of its own.
+ */
+template <class Batch, class Sink>
+class OrderedBatchWriter
+{
+public:
+  explicit OrderedBatchWriter(Sink &sink) : m_sink(sink), m_next(0) {}
+
+  ~OrderedBatchWriter() {
+    for (typename std::map<std::size_t, Batch*>::iterator iter = m_done.begin();
+         iter != m_done.end(); ++iter) {
+      delete iter->second;
+    }
+  }
+
+  // takes ownership of batch
+  void Write(std::size_t id, Batch *batch) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
+    m_done[id] = batch;
+    typename std::map<std::size_t, Batch*>::iterator iter;
+    while ((iter = m_done.find(m_next)) != m_done.end()) {
+      m_sink(*iter->second);
+      delete iter->second;
+      m_done.erase(iter);
+      ++m_next;
+    }
+  }
+
+private:
+  Sink &m_sink;
+  std::size_t m_next;
+  std::map<std::size_t, Batch*> m_done;
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+#endif
+};
+
+}
@@ -132,6 +132,28 @@ void PhraseAlignment::create( char line[], int lineID, bool includeSentenceIdFla
   }
 }
 
+void PhraseAlignment::create( const PHRASE &source, const PHRASE &target, const vector< pair< unsigned int, unsigned int > > &alignment, float pairCount, int lineID )
+{
+  assert(phraseS.empty());
+  assert(phraseT.empty());
+
+  phraseS = source;
+  phraseT = target;
+  createAlignVec(phraseS.size(), phraseT.size());
+  for (size_t i=0; i<alignment.size(); i++) {
+    size_t s = alignment[i].first, t = alignment[i].second;
+    if (t >= alignedToT.size() || s >= alignedToS.size()) {
+      cerr << "WARNING: phrase pair " << lineID
+           << " has alignment point (" << s << ", " << t
+           << ") out of bounds (" << phraseS.size() << ", " << phraseT.size() << ")\n";
+      continue;
+    }
+    alignedToT[t].insert( s );
+    alignedToS[s].insert( t );
+  }
+  count = pairCount;
+}
+
 void PhraseAlignment::addNTLength(const std::string &tok)
 {
   vector< string > tokens;
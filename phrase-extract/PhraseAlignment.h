@@ -37,6 +37,8 @@ public:
   std::vector< std::set<size_t> > alignedToS;
 
   void create( char*, int, bool );
+  // from phrases already in vcbS and vcbT, e.g. read from a binary extract file
+  void create( const PHRASE &source, const PHRASE &target, const std::vector< std::pair< unsigned int, unsigned int > > &alignment, float count, int lineID );
   void clear();
   bool equals( const PhraseAlignment& );
   bool match( const PhraseAlignment& );
@@ -46,6 +46,7 @@ class PhraseExtractionOptions {
   bool includeSentenceIdFlag; //include sentence id in extract file
   bool onlyOutputSpanInfo;
   bool gzOutput;
+  bool binaryOutput;
   std::string instanceWeightsFile; //weights for each sentence
 
 public:  
@@ -62,7 +63,8 @@ public:
             translationFlag(true),
             includeSentenceIdFlag(false),
             onlyOutputSpanInfo(false),
-            gzOutput(false){}
+            gzOutput(false),
+            binaryOutput(false){}
  
     //functions for initialization of options
     void initAllModelsOutputFlag(const bool initallModelsOutputFlag){
@@ -101,6 +103,9 @@ public:
     void initGzOutput (const bool initgzOutput){
         gzOutput= initgzOutput;
     }
+    void initBinaryOutput (const bool initbinaryOutput){
+        binaryOutput= initbinaryOutput;
+    }
     void initInstanceWeightsFile(const char* initInstanceWeightsFile) {
       instanceWeightsFile = std::string(initInstanceWeightsFile);
     }
@@ -142,6 +147,9 @@ public:
     bool isGzOutput () const {
         return gzOutput;
     }
+    bool isBinaryOutput () const {
+        return binaryOutput;
+    }
     std::string getInstanceWeightsFile() const {
       return instanceWeightsFile;
     }
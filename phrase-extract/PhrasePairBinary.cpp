@@ -0,0 +1,233 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "PhrasePairBinary.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace MosesTraining
+{
+
+namespace
+{
+const char kHeader[] = "\0moses phrase pairs 1\n";
+const size_t kHeaderSize = sizeof(kHeader) - 1;
+const size_t kBufferSize = 1 << 16;
+} // namespace
+
+void PhrasePairRecord::clear()
+{
+  source.clear();
+  target.clear();
+  alignment.clear();
+  scores.clear();
+  counts.clear();
+  labels.clear();
+}
+
+PhrasePairWriter::PhrasePairWriter(ostream &out, Vocabulary &sourceVocab, Vocabulary &targetVocab, Vocabulary &labelVocab)
+  : m_out(out), m_sourceVocab(sourceVocab), m_targetVocab(targetVocab), m_labelVocab(labelVocab)
+{
+  m_buffer.reserve(kBufferSize * 2);
+  m_buffer.append(kHeader, kHeaderSize);
+}
+
+PhrasePairWriter::~PhrasePairWriter()
+{
+  Flush();
+}
+
+void PhrasePairWriter::Write(const PhrasePairRecord &record)
+{
+  WriteWords(record.source, m_sourceVocab, m_sourceDefined);
+  WriteWords(record.target, m_targetVocab, m_targetDefined);
+  WriteVarint(record.alignment.size());
+  for (size_t i = 0; i < record.alignment.size(); ++i) {
+    WriteVarint(record.alignment[i].first);
+    WriteVarint(record.alignment[i].second);
+  }
+  WriteFloats(record.scores);
+  WriteFloats(record.counts);
+  WriteWords(record.labels, m_labelVocab, m_labelDefined);
+  if (m_buffer.size() >= kBufferSize) Flush();
+}
+
+void PhrasePairWriter::Flush()
+{
+  m_out.write(m_buffer.data(), m_buffer.size());
+  m_buffer.clear();
+}
+
+void PhrasePairWriter::WriteVarint(unsigned int value)
+{
+  while (value >= 0x80) {
+    m_buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  m_buffer.push_back(static_cast<char>(value));
+}
+
+void PhrasePairWriter::WriteFloats(const vector<float> &values)
+{
+  WriteVarint(values.size());
+  if (!values.empty()) {
+    m_buffer.append(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(float));
+  }
+}
+
+// Each word is id << 1, with the low bit set if its text follows.
+void PhrasePairWriter::WriteWords(const vector<WORD_ID> &words, Vocabulary &vocab, vector<bool> &defined)
+{
+  WriteVarint(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    WORD_ID id = words[i];
+    if (id >= defined.size()) defined.resize(vocab.vocab.size() > id ? vocab.vocab.size() : id + 1, false);
+    if (defined[id]) {
+      WriteVarint(id << 1);
+      continue;
+    }
+    defined[id] = true;
+    const string &word = vocab.getWord(id);
+    WriteVarint((id << 1) | 1);
+    WriteVarint(word.size());
+    m_buffer.append(word);
+  }
+}
+
+bool PhrasePairReader::IsBinary(istream &in)
+{
+  return in.peek() == 0;
+}
+
+PhrasePairReader::PhrasePairReader(istream &in)
+  : m_in(in), m_buffer(kBufferSize), m_current(NULL), m_end(NULL)
+{
+  char header[kHeaderSize];
+  ReadBytes(header, kHeaderSize);
+  UTIL_THROW_IF(memcmp(header, kHeader, kHeaderSize), PhrasePairFormatException,
+                "no header, or written by another version");
+}
+
+bool PhrasePairReader::Read(PhrasePairRecord &record)
+{
+  if (m_current == m_end && !Fill()) return false;
+  ReadWords(record.source, m_sourceWords, m_sourceDefined);
+  ReadWords(record.target, m_targetWords, m_targetDefined);
+  record.alignment.resize(ReadVarint());
+  for (size_t i = 0; i < record.alignment.size(); ++i) {
+    record.alignment[i].first = ReadVarint();
+    record.alignment[i].second = ReadVarint();
+  }
+  ReadFloats(record.scores);
+  ReadFloats(record.counts);
+  ReadWords(record.labels, m_labels, m_labelDefined);
+  return true;
+}
+
+string PhrasePairReader::SourceText(const vector<WORD_ID> &words) const
+{
+  string text;
+  for (size_t i = 0; i < words.size(); ++i) {
+    if (i) text += ' ';
+    text += m_sourceWords[words[i]];
+  }
+  return text;
+}
+
+string PhrasePairReader::TargetText(const vector<WORD_ID> &words) const
+{
+  string text;
+  for (size_t i = 0; i < words.size(); ++i) {
+    if (i) text += ' ';
+    text += m_targetWords[words[i]];
+  }
+  return text;
+}
+
+bool PhrasePairReader::Fill()
+{
+  m_in.read(&m_buffer[0], m_buffer.size());
+  m_current = &m_buffer[0];
+  m_end = m_current + m_in.gcount();
+  return m_current != m_end;
+}
+
+unsigned char PhrasePairReader::ReadByte()
+{
+  UTIL_THROW_IF(m_current == m_end && !Fill(), PhrasePairFormatException, "truncated");
+  return static_cast<unsigned char>(*m_current++);
+}
+
+unsigned int PhrasePairReader::ReadVarint()
+{
+  unsigned int value = 0;
+  for (unsigned int shift = 0; ; shift += 7) {
+    unsigned char byte = ReadByte();
+    value |= static_cast<unsigned int>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return value;
+  }
+}
+
+void PhrasePairReader::ReadBytes(char *to, size_t size)
+{
+  while (size) {
+    UTIL_THROW_IF(m_current == m_end && !Fill(), PhrasePairFormatException, "truncated");
+    size_t amount = std::min<size_t>(size, m_end - m_current);
+    memcpy(to, m_current, amount);
+    m_current += amount;
+    to += amount;
+    size -= amount;
+  }
+}
+
+void PhrasePairReader::ReadFloats(vector<float> &values)
+{
+  values.resize(ReadVarint());
+  if (!values.empty()) ReadBytes(reinterpret_cast<char*>(&values[0]), values.size() * sizeof(float));
+}
+
+// Ids need not be defined in order, so defined marks which entries of vocab
+// hold a word rather than a gap.
+void PhrasePairReader::ReadWords(vector<WORD_ID> &words, deque<string> &vocab, vector<bool> &defined)
+{
+  words.resize(ReadVarint());
+  for (size_t i = 0; i < words.size(); ++i) {
+    unsigned int value = ReadVarint();
+    WORD_ID id = value >> 1;
+    if (value & 1) {
+      if (id >= vocab.size()) {
+        vocab.resize(id + 1);
+        defined.resize(id + 1, false);
+      }
+      defined[id] = true;
+      string &word = vocab[id];
+      word.resize(ReadVarint());
+      if (!word.empty()) ReadBytes(&word[0], word.size());
+    } else {
+      UTIL_THROW_IF(id >= defined.size() || !defined[id], PhrasePairFormatException,
+                    "uses word " << id << " before defining it");
+    }
+    words[i] = id;
+  }
+}
+
+}
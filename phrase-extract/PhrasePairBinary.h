@@ -0,0 +1,147 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+/* Binary form of the files passed between extract, score, consolidate and
+ * lexical-reordering-score, so that no stage has to split and reparse
+ * "|||"-delimited text.  A file starts with a header whose first byte is NUL,
+ * which no text extract file starts with, so readers can tell the formats
+ * apart.  Each record holds
+ *   source and target phrases as word ids,
+ *   alignment points,
+ *   scores and counts as native 32-bit floats,
+ *   labels (e.g. the orientation string of extract.o) as ids,
+ * with lengths and ids as varints.  Words and labels are defined inline the
+ * first time the writer uses them, so a file needs no separate vocabulary.
+ * Write to a name ending in .gz to compress it like the text files.
+ */
+
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tables-core.h"
+#include "util/exception.hh"
+
+namespace MosesTraining
+{
+
+class PhrasePairFormatException : public util::Exception
+{
+public:
+  PhrasePairFormatException() throw() {
+    *this << "Invalid binary phrase pair file: ";
+  }
+  ~PhrasePairFormatException() throw() {}
+};
+
+struct PhrasePairRecord {
+  std::vector<WORD_ID> source;
+  std::vector<WORD_ID> target;
+  std::vector<std::pair<unsigned int, unsigned int> > alignment;
+  std::vector<float> scores;
+  std::vector<float> counts;
+  std::vector<WORD_ID> labels;
+
+  void clear();
+};
+
+class PhrasePairWriter
+{
+public:
+  // Ids in records are ids in these vocabularies.
+  PhrasePairWriter(std::ostream &out, Vocabulary &sourceVocab, Vocabulary &targetVocab, Vocabulary &labelVocab);
+
+  ~PhrasePairWriter();
+
+  void Write(const PhrasePairRecord &record);
+
+  // Called by the destructor.
+  void Flush();
+
+private:
+  void WriteVarint(unsigned int value);
+  void WriteFloats(const std::vector<float> &values);
+  void WriteWords(const std::vector<WORD_ID> &words, Vocabulary &vocab, std::vector<bool> &defined);
+
+  std::ostream &m_out;
+  Vocabulary &m_sourceVocab, &m_targetVocab, &m_labelVocab;
+  std::vector<bool> m_sourceDefined, m_targetDefined, m_labelDefined;
+  std::string m_buffer;
+};
+
+class PhrasePairReader
+{
+public:
+  // Whether in holds binary records.  Only peeks, so text can still be read.
+  static bool IsBinary(std::istream &in);
+
+  // Throws PhrasePairFormatException if in does not start with the header.
+  explicit PhrasePairReader(std::istream &in);
+
+  // False at the end of the file.  Throws PhrasePairFormatException if the
+  // file is truncated or uses a word it has not defined.
+  bool Read(PhrasePairRecord &record);
+
+  const std::string &SourceWord(WORD_ID id) const {
+    return m_sourceWords[id];
+  }
+  const std::string &TargetWord(WORD_ID id) const {
+    return m_targetWords[id];
+  }
+  const std::string &Label(WORD_ID id) const {
+    return m_labels[id];
+  }
+
+  // Number of possible ids, for callers that cache per id.
+  size_t SourceBound() const {
+    return m_sourceWords.size();
+  }
+  size_t TargetBound() const {
+    return m_targetWords.size();
+  }
+  size_t LabelBound() const {
+    return m_labels.size();
+  }
+
+  // Words joined by spaces.
+  std::string SourceText(const std::vector<WORD_ID> &words) const;
+  std::string TargetText(const std::vector<WORD_ID> &words) const;
+
+private:
+  bool Fill();
+  unsigned char ReadByte();
+  unsigned int ReadVarint();
+  void ReadBytes(char *to, size_t size);
+  void ReadFloats(std::vector<float> &values);
+  void ReadWords(std::vector<WORD_ID> &words, std::deque<std::string> &vocab, std::vector<bool> &defined);
+
+  std::istream &m_in;
+  // Deques so that returned references stay valid as words are defined.
+  std::deque<std::string> m_sourceWords, m_targetWords, m_labels;
+  std::vector<bool> m_sourceDefined, m_targetDefined, m_labelDefined;
+  std::vector<char> m_buffer;
+  const char *m_current, *m_end;
+};
+
+}
@@ -0,0 +1,218 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "PhrasePairBinary.h"
+#include "tables-core.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define  BOOST_TEST_MODULE MosesTrainingPhrasePairBinary
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace MosesTraining;
+using namespace std;
+
+namespace
+{
+
+const string kHeader("\0moses phrase pairs 1\n", 22);
+
+// Counts the times word appears in a file, as inline definitions do.
+size_t Occurrences(const string &file, const string &word)
+{
+  size_t count = 0;
+  for (size_t at = file.find(word); at != string::npos; at = file.find(word, at + 1)) ++count;
+  return count;
+}
+
+struct Fixture {
+  Fixture() {
+    // enough words for ids that take more than one varint byte
+    for (size_t i = 0; i < 300; ++i) {
+      ostringstream word;
+      word << "w" << i << "_";
+      sourceVocab.storeIfNew("s" + word.str());
+      targetVocab.storeIfNew("t" + word.str());
+    }
+    labelVocab.storeIfNew("mono");
+    labelVocab.storeIfNew("swap");
+
+    PhrasePairRecord record;
+    record.source.push_back(0);
+    record.source.push_back(299);
+    record.target.push_back(150);
+    record.alignment.push_back(make_pair(0U, 0U));
+    record.alignment.push_back(make_pair(1U, 0U));
+    record.scores.push_back(0.25f);
+    record.scores.push_back(1e-7f);
+    record.counts.push_back(3);
+    record.labels.push_back(1);
+    record.labels.push_back(0);
+    records.push_back(record);
+
+    // reuses defined words, with nothing else
+    record.clear();
+    record.source.push_back(299);
+    record.source.push_back(299);
+    record.target.push_back(150);
+    record.target.push_back(64);
+    records.push_back(record);
+
+    record.clear();
+    record.source.push_back(63);
+    record.target.push_back(0);
+    record.alignment.push_back(make_pair(0U, 200U));
+    record.counts.push_back(0.5f);
+    record.labels.push_back(0);
+    records.push_back(record);
+
+    ostringstream out;
+    {
+      PhrasePairWriter writer(out, sourceVocab, targetVocab, labelVocab);
+      for (size_t i = 0; i < records.size(); ++i) writer.Write(records[i]);
+    }
+    file = out.str();
+  }
+
+  Vocabulary sourceVocab, targetVocab, labelVocab;
+  vector<PhrasePairRecord> records;
+  string file;
+};
+
+void CheckSame(const PhrasePairRecord &read, const PhrasePairRecord &written)
+{
+  BOOST_CHECK(read.source == written.source);
+  BOOST_CHECK(read.target == written.target);
+  BOOST_CHECK(read.alignment == written.alignment);
+  BOOST_CHECK_EQUAL_COLLECTIONS(read.scores.begin(), read.scores.end(), written.scores.begin(), written.scores.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(read.counts.begin(), read.counts.end(), written.counts.begin(), written.counts.end());
+  BOOST_CHECK(read.labels == written.labels);
+}
+
+// A file of one record whose source is the given words, encoded by hand.
+string HandWritten(const vector<unsigned int> &encodedWords, const string &definitions)
+{
+  string file = kHeader;
+  file += static_cast<char>(encodedWords.size());
+  for (size_t i = 0; i < encodedWords.size(); ++i) file += static_cast<char>(encodedWords[i]);
+  file += definitions;
+  // no target words, alignment points, scores, counts or labels
+  file += string(5, '\0');
+  return file;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(round_trip, Fixture)
+{
+  istringstream in(file);
+  BOOST_CHECK(PhrasePairReader::IsBinary(in));
+  PhrasePairReader reader(in);
+  PhrasePairRecord read;
+  for (size_t i = 0; i < records.size(); ++i) {
+    BOOST_REQUIRE(reader.Read(read));
+    CheckSame(read, records[i]);
+  }
+  BOOST_CHECK(!reader.Read(read));
+
+  // Ids are the writer's, and the reader knows their words.
+  BOOST_CHECK_EQUAL(reader.SourceWord(299), "sw299_");
+  BOOST_CHECK_EQUAL(reader.TargetWord(64), "tw64_");
+  BOOST_CHECK_EQUAL(reader.Label(1), "swap");
+  BOOST_CHECK_EQUAL(reader.SourceText(records[0].source), "sw0_ sw299_");
+  BOOST_CHECK_EQUAL(reader.TargetText(records[1].target), "tw150_ tw64_");
+  BOOST_CHECK(reader.SourceBound() >= 300);
+  BOOST_CHECK(reader.LabelBound() >= 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(words_are_defined_once, Fixture)
+{
+  BOOST_CHECK_EQUAL(file.compare(0, kHeader.size(), kHeader), 0);
+  BOOST_CHECK_EQUAL(Occurrences(file, "sw299_"), 1U);
+  BOOST_CHECK_EQUAL(Occurrences(file, "tw150_"), 1U);
+  BOOST_CHECK_EQUAL(Occurrences(file, "mono"), 1U);
+  BOOST_CHECK_EQUAL(Occurrences(file, "sw1_"), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(varints)
+{
+  // Word 0 defined as "a", then word 64, whose id takes two bytes.
+  vector<unsigned int> words;
+  words.push_back(1);
+  string file = HandWritten(words, string("\x01" "a", 2));
+  file += string("\x01" "\x81\x01" "\x02" "bc", 6);
+  file += string(5, '\0');
+  istringstream in(file);
+  PhrasePairReader reader(in);
+  PhrasePairRecord read;
+  BOOST_REQUIRE(reader.Read(read));
+  BOOST_REQUIRE(read.source.size() == 1);
+  BOOST_CHECK_EQUAL(reader.SourceWord(read.source[0]), "a");
+  BOOST_REQUIRE(reader.Read(read));
+  BOOST_REQUIRE(read.source.size() == 1);
+  BOOST_CHECK_EQUAL(read.source[0], 64U);
+  BOOST_CHECK_EQUAL(reader.SourceWord(64), "bc");
+}
+
+BOOST_AUTO_TEST_CASE(text_is_not_binary)
+{
+  istringstream in("a b ||| x ||| 0-0\n");
+  BOOST_CHECK(!PhrasePairReader::IsBinary(in));
+  // and nothing was consumed
+  string line;
+  getline(in, line);
+  BOOST_CHECK_EQUAL(line, "a b ||| x ||| 0-0");
+
+  istringstream text("a b ||| x ||| 0-0\n");
+  BOOST_CHECK_THROW(PhrasePairReader reader(text), PhrasePairFormatException);
+}
+
+BOOST_AUTO_TEST_CASE(undefined_words_throw)
+{
+  // word 3 is used but never defined
+  vector<unsigned int> words(1, 3 << 1);
+  istringstream undefined(HandWritten(words, ""));
+  PhrasePairReader reader(undefined);
+  PhrasePairRecord read;
+  BOOST_CHECK_THROW(reader.Read(read), PhrasePairFormatException);
+
+  // word 5 is defined, leaving a gap where words 0 to 4 would be
+  words.clear();
+  words.push_back((5 << 1) | 1);
+  string file = HandWritten(words, string("\x01" "x", 2));
+  file += string("\x01" "\x04", 2) + string(5, '\0');
+  istringstream gap(file);
+  PhrasePairReader gapReader(gap);
+  BOOST_REQUIRE(gapReader.Read(read));
+  BOOST_CHECK_EQUAL(gapReader.SourceWord(5), "x");
+  BOOST_CHECK_THROW(gapReader.Read(read), PhrasePairFormatException);
+}
+
+BOOST_FIXTURE_TEST_CASE(truncated_file_throws, Fixture)
+{
+  istringstream in(file.substr(0, file.size() - 1));
+  PhrasePairReader reader(in);
+  PhrasePairRecord read;
+  BOOST_CHECK(reader.Read(read));
+  BOOST_CHECK(reader.Read(read));
+  BOOST_CHECK_THROW(reader.Read(read), PhrasePairFormatException);
+}
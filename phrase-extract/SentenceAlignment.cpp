@@ -122,5 +122,67 @@ bool SentenceAlignment::create( char targetString[], char sourceString[], char a
   return true;
 }
 
+void SentenceAlignment::findConsistentPhrasePairs(int maxPhraseLength, bool relaxLimit, vector<PhrasePairSpan> &pairs) const
+{
+  int countE = target.size();
+  int countF = source.size();
+
+  // check alignments for target phrase startE...endE
+  for(int startE=0; startE<countE; startE++) {
+    for(int endE=startE;
+        (endE<countE && (relaxLimit || endE<startE+maxPhraseLength));
+        endE++) {
+
+      int minF = 9999;
+      int maxF = -1;
+      vector< int > usedF = alignedCountS;
+      for(int ei=startE; ei<=endE; ei++) {
+        for(size_t i=0; i<alignedToT[ei].size(); i++) {
+          int fi = alignedToT[ei][i];
+          if (fi<minF) {
+            minF = fi;
+          }
+          if (fi>maxF) {
+            maxF = fi;
+          }
+          usedF[ fi ]--;
+        }
+      }
+
+      if (maxF >= 0 && // aligned to any source words at all
+          (relaxLimit || maxF-minF < maxPhraseLength)) { // source phrase within limits
+
+        // check if source words are aligned to out of bound target words
+        bool out_of_bounds = false;
+        for(int fi=minF; fi<=maxF && !out_of_bounds; fi++)
+          if (usedF[fi]>0) {
+            out_of_bounds = true;
+          }
+
+        if (!out_of_bounds) {
+          // start point of source phrase may retreat over unaligned
+          for(int startF=minF;
+              (startF>=0 &&
+               (relaxLimit || startF>maxF-maxPhraseLength) && // within length limit
+               (startF==minF || alignedCountS[startF]==0)); // unaligned
+              startF--)
+            // end point of source phrase may advance over unaligned
+            for(int endF=maxF;
+                (endF<countF &&
+                 (relaxLimit || endF<startF+maxPhraseLength) && // within length limit
+                 (endF==maxF || alignedCountS[endF]==0)); // unaligned
+                endF++) {
+              PhrasePairSpan span;
+              span.startE = startE;
+              span.endE = endE;
+              span.startF = startF;
+              span.endF = endF;
+              pairs.push_back(span);
+            }
+        }
+      }
+    }
+  }
 }
 
+}
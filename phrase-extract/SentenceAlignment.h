@@ -27,6 +27,11 @@
 namespace MosesTraining
 {
 
+// A phrase pair as inclusive word positions on either side of a sentence.
+struct PhrasePairSpan {
+  int startE, endE, startF, endF;
+};
+
 class SentenceAlignment
 {
 public:
@@ -45,6 +50,11 @@ public:
 
   bool create(char targetString[], char sourceString[],
               char alignmentString[], char weightString[], int sentenceID, bool boundaryRules);
+
+  // Appends the phrase pairs consistent with the word alignment, ordered by
+  // target span.  Both phrases have at most maxPhraseLength words unless
+  // relaxLimit is set, in which case the caller checks lengths itself.
+  void findConsistentPhrasePairs(int maxPhraseLength, bool relaxLimit, std::vector<PhrasePairSpan> &pairs) const;
   
 };
 
@@ -24,15 +24,19 @@
 #include <string>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <sstream>
 
 #include "tables-core.h"
 #include "SafeGetline.h"
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
+#include "PhrasePairBinary.h"
 
 #define LINE_MAX_LENGTH 10000
 
 using namespace std;
+using namespace MosesTraining;
 
 bool hierarchicalFlag = false;
 bool onlyDirectFlag = false;
@@ -44,11 +48,21 @@ bool logProbFlag = false;
 bool outputNTLengths = false;
 inline float maybeLogProb( float a ) { return logProbFlag ? log(a) : a; }
 
+// the fields of a line of a phrase table half
+struct HalfLine {
+  string source, target;
+  string scores, sparseScores;
+  string alignment;
+  vector< float > counts;
+  string ntLengths;
+};
+
 char line[LINE_MAX_LENGTH];
 void processFiles( char*, char*, char*, char* );
 void loadCountOfCounts( char* );
 void breakdownCoreAndSparse( string combined, string &core, string &sparse );
-bool getLine( istream &fileP, vector< string > &item );
+bool getLine( istream &fileP, HalfLine &item );
+bool getLine( PhrasePairReader &reader, HalfLine &item );
 vector< string > splitLine();
 vector< int > countBin;
 bool sparseCountBinFeatureFlag = false;
@@ -192,6 +206,17 @@ void processFiles( char* fileNameDirect, char* fileNameIndirect, char* fileNameC
   }
   istream &fileIndirectP = fileIndirect;
 
+  // halves written by score --BinaryOutput
+  auto_ptr<PhrasePairReader> binaryDirect, binaryIndirect;
+  if (PhrasePairReader::IsBinary(fileDirectP) != PhrasePairReader::IsBinary(fileIndirectP)) {
+    cerr << "ERROR: one phrase table half is binary and the other is not" << endl;
+    exit(1);
+  }
+  if (PhrasePairReader::IsBinary(fileDirectP)) {
+    binaryDirect.reset(new PhrasePairReader(fileDirectP));
+    binaryIndirect.reset(new PhrasePairReader(fileIndirectP));
+  }
+
   // open output file: consolidated phrase table
   Moses::OutputFileStream fileConsolidated;
   bool success = fileConsolidated.Open(fileNameConsolidated);
@@ -206,44 +231,45 @@ void processFiles( char* fileNameDirect, char* fileNameIndirect, char* fileNameC
     i++;
     if (i%100000 == 0) cerr << "." << flush;
 
-    vector< string > itemDirect, itemIndirect;
-    if (! getLine(fileIndirectP,itemIndirect) ||
-        ! getLine(fileDirectP,  itemDirect  ))
+    HalfLine itemDirect, itemIndirect;
+    if (binaryDirect.get()) {
+      if (! getLine(*binaryIndirect,itemIndirect) ||
+          ! getLine(*binaryDirect,  itemDirect  ))
+        break;
+    } else if (! getLine(fileIndirectP,itemIndirect) ||
+               ! getLine(fileDirectP,  itemDirect  ))
       break;
 
     // direct: target source alignment probabilities
     // indirect: source target probabilities
 
     // consistency checks
-    if (itemDirect[0].compare( itemIndirect[0] ) != 0) {
+    if (itemDirect.source.compare( itemIndirect.source ) != 0) {
       cerr << "ERROR: target phrase does not match in line " << i << ": '"
-           << itemDirect[0] << "' != '" << itemIndirect[0] << "'" << endl;
+           << itemDirect.source << "' != '" << itemIndirect.source << "'" << endl;
       exit(1);
     }
 
-    if (itemDirect[1].compare( itemIndirect[1] ) != 0) {
+    if (itemDirect.target.compare( itemIndirect.target ) != 0) {
       cerr << "ERROR: source phrase does not match in line " << i << ": '"
-           << itemDirect[1] << "' != '" << itemIndirect[1] << "'" << endl;
+           << itemDirect.target << "' != '" << itemIndirect.target << "'" << endl;
       exit(1);
     }
 
     // output hierarchical phrase pair (with separated labels)
-    fileConsolidated << itemDirect[0] << " ||| " << itemDirect[1] << " |||";
+    fileConsolidated << itemDirect.source << " ||| " << itemDirect.target << " |||";
 
     // SCORES ...
-    string directScores, directSparseScores, indirectScores, indirectSparseScores;
-    breakdownCoreAndSparse( itemDirect[2], directScores, directSparseScores );
-    breakdownCoreAndSparse( itemIndirect[2], indirectScores, indirectSparseScores );
-
-    vector<string> directCounts = tokenize(itemDirect[4].c_str());
-    vector<string> indirectCounts = tokenize(itemIndirect[4].c_str());
-    float countF = atof(directCounts[0].c_str());
-    float countE = atof(indirectCounts[0].c_str());
-    float countEF = atof(indirectCounts[1].c_str());
+    const string &directScores = itemDirect.scores, &directSparseScores = itemDirect.sparseScores;
+    const string &indirectScores = itemIndirect.scores, &indirectSparseScores = itemIndirect.sparseScores;
+
+    float countF = itemDirect.counts[0];
+    float countE = itemIndirect.counts[0];
+    float countEF = itemIndirect.counts[1];
     float n1_F, n1_E;
     if (kneserNeyFlag) {
-      n1_F = atof(directCounts[2].c_str());
-      n1_E = atof(indirectCounts[2].c_str());
+      n1_F = itemDirect.counts[2];
+      n1_E = itemIndirect.counts[2];
     }
 
     // Good Turing discounting
@@ -305,14 +331,14 @@ void processFiles( char* fileNameDirect, char* fileNameIndirect, char* fileNameC
     }
 
     // alignment
-    fileConsolidated << " ||| " << itemDirect[3];
+    fileConsolidated << " ||| " << itemDirect.alignment;
 
     // counts, for debugging
     fileConsolidated << "||| " << countE << " " << countF << " " << countEF; 
 
     if (outputNTLengths)
     {
-      fileConsolidated << " ||| " << itemDirect[5];
+      fileConsolidated << " ||| " << itemDirect.ntLengths;
     }
     
     // count bin feature (as a sparse feature)
@@ -368,7 +394,7 @@ void breakdownCoreAndSparse( string combined, string &core, string &sparse )
   if (sparse.size() > 0 ) sparse = sparse.substr(1);
 }
 
-bool getLine( istream &fileP, vector< string > &item )
+bool getLine( istream &fileP, HalfLine &item )
 {
   if (fileP.eof())
     return false;
@@ -377,7 +403,40 @@ bool getLine( istream &fileP, vector< string > &item )
   if (fileP.eof())
     return false;
 
-  item = splitLine();
+  vector< string > field = splitLine();
+  item.source = field[0];
+  item.target = field[1];
+  breakdownCoreAndSparse( field[2], item.scores, item.sparseScores );
+  item.alignment = field[3];
+  vector< string > counts = tokenize( field[4].c_str() );
+  item.counts.resize( counts.size() );
+  for(size_t i=0; i<counts.size(); i++)
+    item.counts[i] = atof( counts[i].c_str() );
+  item.ntLengths = field.size() > 5 ? field[5] : "";
+
+  return true;
+}
+
+// Takes counts straight from the record; only what is written out is formatted.
+bool getLine( PhrasePairReader &reader, HalfLine &item )
+{
+  static PhrasePairRecord record;
+  if (!reader.Read(record))
+    return false;
+
+  item.source = reader.SourceText(record.source);
+  item.target = reader.TargetText(record.target);
+
+  ostringstream scores, alignment;
+  for(size_t i=0; i<record.scores.size(); i++)
+    scores << (i ? " " : "") << record.scores[i];
+  for(size_t i=0; i<record.alignment.size(); i++)
+    alignment << record.alignment[i].first << "-" << record.alignment[i].second << " ";
+  item.scores = scores.str();
+  item.sparseScores = "";
+  item.alignment = alignment.str();
+  item.counts = record.counts;
+  item.ntLengths = "";
 
   return true;
 }
@@ -25,17 +25,24 @@
 #include "ParseTree.h"
 #include "Subgraph.h"
 
+#include "util/pool.hh"
+
 #include <algorithm>
 #include <cassert>
-#include <memory>
-#include <stack>
+#include <new>
+#include <set>
+
+#include <stdint.h>
 
 namespace Moses {
 namespace GHKM {
 
 AlignmentGraph::AlignmentGraph(const ParseTree *t,
                                const std::vector<std::string> &s,
-                               const Alignment &a)
+                               const Alignment &a,
+                               util::Pool &pool)
+    : m_pool(pool)
+    , m_nodeCount(0)
 {
   // Copy the parse tree nodes and add them to m_targetNodes.
   m_root = CopyParseTree(t);
@@ -44,7 +51,7 @@ AlignmentGraph::AlignmentGraph(const ParseTree *t,
   m_sourceNodes.reserve(s.size());
   for (std::vector<std::string>::const_iterator p(s.begin());
        p != s.end(); ++p) {
-    m_sourceNodes.push_back(new Node(*p, SOURCE));
+    m_sourceNodes.push_back(NewNode(*p, SOURCE));
   }
 
   // Connect source nodes to parse tree leaves according to the given word
@@ -73,32 +80,61 @@ AlignmentGraph::AlignmentGraph(const ParseTree *t,
 
 AlignmentGraph::~AlignmentGraph()
 {
+  // The nodes are in the pool, but their members are not.
   for (std::vector<Node *>::iterator p(m_sourceNodes.begin());
        p != m_sourceNodes.end(); ++p) {
-    delete *p;
+    (*p)->~Node();
   }
   for (std::vector<Node *>::iterator p(m_targetNodes.begin());
        p != m_targetNodes.end(); ++p) {
-    delete *p;
+    (*p)->~Node();
+  }
+}
+
+Node *AlignmentGraph::NewNode(const std::string &label, NodeType type)
+{
+  return new (m_pool.Allocate(sizeof(Node))) Node(label, type, m_nodeCount++);
+}
+
+// Copies the leaves into the pool, with a bitset of their indices.
+const Subgraph *AlignmentGraph::NewSubgraph(
+    const Node *root,
+    const std::vector<const Node *> &leaves)
+{
+  const size_t words = (m_nodeCount + 63) / 64;
+  uint64_t *bits = static_cast<uint64_t *>(
+      m_pool.Allocate(words * sizeof(uint64_t)));
+  std::fill(bits, bits + words, 0);
+  const Node **array = static_cast<const Node **>(
+      m_pool.Allocate(leaves.size() * sizeof(const Node *)));
+  for (size_t i = 0; i < leaves.size(); ++i) {
+    int index = leaves[i]->GetIndex();
+    bits[index / 64] |= static_cast<uint64_t>(1) << (index % 64);
+    array[i] = leaves[i];
   }
+  return new (m_pool.Allocate(sizeof(Subgraph)))
+      Subgraph(root, array, leaves.size(), bits);
 }
 
-Subgraph AlignmentGraph::ComputeMinimalFrontierGraphFragment(
+const Subgraph *AlignmentGraph::ComputeMinimalFrontierGraphFragment(
     Node *root,
-    const std::set<Node *> &frontierSet)
+    const std::vector<bool> &frontierSet)
 {
-  std::stack<Node *> expandableNodes;
-  std::set<const Node *> expandedNodes;
+  // A source node with several parents can be reached more than once.
+  m_expandedNodes.assign(m_nodeCount, false);
+  m_expandableNodes.clear();
+  m_leaves.clear();
 
   if (root->IsSink()) {
-    expandedNodes.insert(root);
+    m_expandedNodes[root->GetIndex()] = true;
+    m_leaves.push_back(root);
   } else {
-    expandableNodes.push(root);
+    m_expandableNodes.push_back(root);
   }
 
-  while (!expandableNodes.empty()) {
-    Node *n = expandableNodes.top();
-    expandableNodes.pop();
+  while (!m_expandableNodes.empty()) {
+    Node *n = m_expandableNodes.back();
+    m_expandableNodes.pop_back();
 
     const std::vector<Node *> &children = n->GetChildren();
 
@@ -106,41 +142,46 @@ Subgraph AlignmentGraph::ComputeMinimalFrontierGraphFragment(
          p != children.end(); ++p) {
       Node *child = *p;
       if (child->IsSink()) {
-        expandedNodes.insert(child);
+        if (!m_expandedNodes[child->GetIndex()]) {
+          m_expandedNodes[child->GetIndex()] = true;
+          m_leaves.push_back(child);
+        }
         continue;
       }
-      std::set<Node *>::const_iterator q = frontierSet.find(child);
-      if (q == frontierSet.end()) { //child is not from the frontier set
-        expandableNodes.push(child);
+      if (!frontierSet[child->GetIndex()]) { //child is not from the frontier set
+        m_expandableNodes.push_back(child);
       } else if (child->GetType() == TARGET) { // still need source word
-        expandableNodes.push(child);
-      } else {
-        expandedNodes.insert(child);
+        m_expandableNodes.push_back(child);
+      } else if (!m_expandedNodes[child->GetIndex()]) {
+        m_expandedNodes[child->GetIndex()] = true;
+        m_leaves.push_back(child);
       }
     }
   }
 
-  return Subgraph(root, expandedNodes);
+  return NewSubgraph(root, m_leaves);
 }
 
 void AlignmentGraph::ExtractMinimalRules(const Options &options)
 {
   // Determine which nodes are frontier nodes.
-  std::set<Node *> frontierSet;
+  std::vector<bool> frontierSet(m_nodeCount, false);
   ComputeFrontierSet(m_root, options, frontierSet);
 
   // Form the minimal frontier graph fragment rooted at each frontier node.
-  std::vector<Subgraph> fragments;
-  fragments.reserve(frontierSet.size());
-  for (std::set<Node *>::iterator p(frontierSet.begin());
-       p != frontierSet.end(); ++p) {
+  for (std::vector<Node *>::iterator p(m_targetNodes.begin());
+       p != m_targetNodes.end(); ++p) {
     Node *root = *p;
-    Subgraph fragment = ComputeMinimalFrontierGraphFragment(root, frontierSet);
-    assert(!fragment.IsTrivial());
+    if (!frontierSet[root->GetIndex()]) {
+      continue;
+    }
+    const Subgraph *fragment =
+        ComputeMinimalFrontierGraphFragment(root, frontierSet);
+    assert(!fragment->IsTrivial());
     // Can it form an SCFG rule?
     // FIXME Does this exclude non-lexical unary rules?
     if (root->GetType() == TREE && !root->GetSpan().empty()) {
-      root->AddRule(new Subgraph(fragment));
+      root->AddRule(fragment);
     }
   }
 }
@@ -168,18 +209,19 @@ void AlignmentGraph::ExtractComposedRules(Node *node, const Options &options)
   }
 
   // Construct an initial composition candidate from the minimal rule.
-  ComposedRule cr(*(rules[0]));
-  if (!cr.GetOpenAttachmentPoint()) {
+  ComposedRule *cr = new (m_pool.Allocate(sizeof(ComposedRule)))
+      ComposedRule(*(rules[0]), m_pool);
+  if (!cr->GetOpenAttachmentPoint()) {
     // No composition possible.
     return;
   }
 
-  std::queue<ComposedRule> queue;
-  queue.push(cr);
-  while (!queue.empty()) {
-    ComposedRule cr = queue.front();
-    queue.pop();
-    const Node *attachmentPoint = cr.GetOpenAttachmentPoint();
+  // Candidates are processed first in, first out.
+  m_composedRules.clear();
+  m_composedRules.push_back(cr);
+  for (size_t next = 0; next < m_composedRules.size(); ++next) {
+    ComposedRule *cr = m_composedRules[next];
+    const Node *attachmentPoint = cr->GetOpenAttachmentPoint();
     assert(attachmentPoint);
     assert(attachmentPoint != node);
     // Create all possible rules by composing this node's minimal rule with the
@@ -189,19 +231,19 @@ void AlignmentGraph::ExtractComposedRules(Node *node, const Options &options)
     for (std::vector<const Subgraph*>::const_iterator p = rules.begin();
          p != rules.end(); ++p) {
       assert((*p)->GetRoot()->GetType() == TREE);
-      ComposedRule *cr2 = cr.AttemptComposition(**p, options);
+      ComposedRule *cr2 = cr->AttemptComposition(**p, options);
       if (cr2) {
-        node->AddRule(new Subgraph(cr2->CreateSubgraph()));
+        cr2->GetLeaves(m_leaves);
+        node->AddRule(NewSubgraph(node, m_leaves));
         if (cr2->GetOpenAttachmentPoint()) {
-          queue.push(*cr2);
+          m_composedRules.push_back(cr2);
         }
-        delete cr2;
       }
     }
     // Done with this attachment point.  Advance to the next, if any.
-    cr.CloseAttachmentPoint();
-    if (cr.GetOpenAttachmentPoint()) {
-      queue.push(cr);
+    cr->CloseAttachmentPoint();
+    if (cr->GetOpenAttachmentPoint()) {
+      m_composedRules.push_back(cr);
     }
   }
 }
@@ -210,7 +252,7 @@ Node *AlignmentGraph::CopyParseTree(const ParseTree *root)
 {
   NodeType nodeType = (root->IsLeaf()) ? TARGET : TREE;
 
-  std::auto_ptr<Node> n(new Node(root->GetLabel(), nodeType));
+  Node *n = NewNode(root->GetLabel(), nodeType);
 
   if (nodeType == TREE) {
     n->SetPcfgScore(root->GetPcfgScore());
@@ -222,14 +264,13 @@ Node *AlignmentGraph::CopyParseTree(const ParseTree *root)
   for (std::vector<ParseTree *>::const_iterator p(children.begin());
        p != children.end(); ++p) {
     Node *child = CopyParseTree(*p);
-    child->AddParent(n.get());
+    child->AddParent(n);
     childNodes.push_back(child);
   }
   n->SetChildren(childNodes);
 
-  Node *p = n.release();
-  m_targetNodes.push_back(p);
-  return p;
+  m_targetNodes.push_back(n);
+  return n;
 }
 
 // Finds the set of frontier nodes.  The definition of a frontier node differs
@@ -243,7 +284,7 @@ Node *AlignmentGraph::CopyParseTree(const ParseTree *root)
 //    it has the same span as its parent.
 void AlignmentGraph::ComputeFrontierSet(Node *root,
                                         const Options &options,
-                                        std::set<Node *> &frontierSet) const
+                                        std::vector<bool> &frontierSet) const
 {
   // Don't include word nodes or unaligned target subtrees.
   if (root->GetType() != TREE || root->GetSpan().empty()) {
@@ -258,7 +299,7 @@ void AlignmentGraph::ComputeFrontierSet(Node *root,
     if (options.allowUnary
         || root->GetParents().empty()
         || root->GetParents()[0]->GetSpan() != root->GetSpan()) {
-      frontierSet.insert(root);
+      frontierSet[root->GetIndex()] = true;
     }
   }
 
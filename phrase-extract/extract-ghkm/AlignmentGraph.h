@@ -22,25 +22,32 @@
 #define EXTRACT_GHKM_ALIGNMENT_GRAPH_H_
 
 #include "Alignment.h"
+#include "Node.h"
 #include "Options.h"
 
-#include <set>
 #include <string>
 #include <vector>
 
+namespace util { class Pool; }
+
 namespace Moses {
 namespace GHKM {
 
+class ComposedRule;
 class Node;
 class ParseTree;
 class Subgraph;
 
+// The nodes of the graph, and the rules extracted from it, are allocated from
+// the pool passed to the constructor, which can be reset once the graph is
+// destroyed.
 class AlignmentGraph
 {
  public:
   AlignmentGraph(const ParseTree *,
                  const std::vector<std::string> &,
-                 const Alignment &);
+                 const Alignment &,
+                 util::Pool &);
 
   ~AlignmentGraph();
 
@@ -55,19 +62,29 @@ class AlignmentGraph
   AlignmentGraph(const AlignmentGraph &);
   AlignmentGraph &operator=(const AlignmentGraph &);
 
+  Node *NewNode(const std::string &, NodeType);
   Node *CopyParseTree(const ParseTree *);
-  void ComputeFrontierSet(Node *, const Options &, std::set<Node *> &) const;
+  void ComputeFrontierSet(Node *, const Options &, std::vector<bool> &) const;
   void CalcComplementSpans(Node *);
   void GetTargetTreeLeaves(Node *, std::vector<Node *> &); 
   void AttachUnalignedSourceWords();
   Node *DetermineAttachmentPoint(int);
-  Subgraph ComputeMinimalFrontierGraphFragment(Node *,
-                                               const std::set<Node *> &);
+  const Subgraph *ComputeMinimalFrontierGraphFragment(
+      Node *, const std::vector<bool> &);
   void ExtractComposedRules(Node *, const Options &);
+  const Subgraph *NewSubgraph(const Node *, const std::vector<const Node *> &);
 
+  util::Pool &m_pool;
   Node *m_root;
   std::vector<Node *> m_sourceNodes;
   std::vector<Node *> m_targetNodes;
+  int m_nodeCount;
+
+  // Reused by the rule extraction functions.
+  std::vector<Node *> m_expandableNodes;
+  std::vector<bool> m_expandedNodes;
+  std::vector<const Node *> m_leaves;
+  std::vector<ComposedRule *> m_composedRules;
 };
 
 }  // namespace GHKM
@@ -23,51 +23,64 @@
 #include "Options.h"
 #include "Subgraph.h"
 
-#include <set>
+#include "util/pool.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
 #include <vector>
-#include <queue>
 
 namespace Moses {
 namespace GHKM {
 
-ComposedRule::ComposedRule(const Subgraph &baseRule)
+ComposedRule::ComposedRule(const Subgraph &baseRule, util::Pool &pool)
     : m_baseRule(baseRule)
+    , m_pool(pool)
+    , m_attachmentPointCount(0)
+    , m_next(0)
     , m_depth(baseRule.GetDepth())
     , m_size(baseRule.GetSize())
     , m_nodeCount(baseRule.GetNodeCount())
 {
-  const std::set<const Node *> &leaves = baseRule.GetLeaves();
-  for (std::set<const Node *>::const_iterator p = leaves.begin();
-       p != leaves.end(); ++p) {
+  m_attachmentPoints = static_cast<const Node **>(
+      pool.Allocate(baseRule.GetLeafCount() * sizeof(const Node *)));
+  for (Subgraph::LeafIterator p = baseRule.BeginLeaves();
+       p != baseRule.EndLeaves(); ++p) {
     if ((*p)->GetType() == TREE) {
-      m_openAttachmentPoints.push(*p);
+      m_attachmentPoints[m_attachmentPointCount++] = *p;
     }
   }
+  m_attachedRules = static_cast<const Subgraph **>(
+      pool.Allocate(m_attachmentPointCount * sizeof(const Subgraph *)));
 }
 
 ComposedRule::ComposedRule(const ComposedRule &other, const Subgraph &rule,
                            int depth)
     : m_baseRule(other.m_baseRule)
-    , m_attachedRules(other.m_attachedRules)
-    , m_openAttachmentPoints(other.m_openAttachmentPoints)
+    , m_pool(other.m_pool)
+    , m_attachmentPoints(other.m_attachmentPoints)
+    , m_attachmentPointCount(other.m_attachmentPointCount)
+    , m_next(other.m_next+1)
     , m_depth(depth)
     , m_size(other.m_size+rule.GetSize())
     , m_nodeCount(other.m_nodeCount+rule.GetNodeCount()-1)
 {
-  m_attachedRules.push_back(&rule);
-  m_openAttachmentPoints.pop();
+  m_attachedRules = static_cast<const Subgraph **>(
+      m_pool.Allocate(m_attachmentPointCount * sizeof(const Subgraph *)));
+  std::copy(other.m_attachedRules, other.m_attachedRules + other.m_next,
+            m_attachedRules);
+  m_attachedRules[other.m_next] = &rule;
 }
 
-const Node *ComposedRule::GetOpenAttachmentPoint()
+const Node *ComposedRule::GetOpenAttachmentPoint() const
 {
-  return m_openAttachmentPoints.empty() ? 0 : m_openAttachmentPoints.front();
+  return m_next < m_attachmentPointCount ? m_attachmentPoints[m_next] : 0;
 }
 
 void ComposedRule::CloseAttachmentPoint()
 {
-  assert(!m_openAttachmentPoints.empty());
-  m_attachedRules.push_back(0);
-  m_openAttachmentPoints.pop();
+  assert(m_next < m_attachmentPointCount);
+  m_attachedRules[m_next++] = 0;
 }
 
 ComposedRule *ComposedRule::AttemptComposition(const Subgraph &rule,
@@ -101,28 +114,27 @@ ComposedRule *ComposedRule::AttemptComposition(const Subgraph &rule,
     return 0;
   }
 
-  return new ComposedRule(*this, rule, newDepth);
+  return new (m_pool.Allocate(sizeof(ComposedRule)))
+      ComposedRule(*this, rule, newDepth);
 }
 
-Subgraph ComposedRule::CreateSubgraph()
+void ComposedRule::GetLeaves(std::vector<const Node *> &leaves) const
 {
-  std::set<const Node *> leaves;
-  const std::set<const Node *> &baseLeaves = m_baseRule.GetLeaves();
+  leaves.clear();
   size_t i = 0;
-  for (std::set<const Node *>::const_iterator p = baseLeaves.begin();
-       p != baseLeaves.end(); ++p) {
+  for (Subgraph::LeafIterator p = m_baseRule.BeginLeaves();
+       p != m_baseRule.EndLeaves(); ++p) {
     const Node *baseLeaf = *p;
-    if (baseLeaf->GetType() == TREE && i < m_attachedRules.size()) {
+    if (baseLeaf->GetType() == TREE && i < m_next) {
       const Subgraph *attachedRule = m_attachedRules[i++];
       if (attachedRule) {
-        leaves.insert(attachedRule->GetLeaves().begin(),
-                      attachedRule->GetLeaves().end());
+        leaves.insert(leaves.end(), attachedRule->BeginLeaves(),
+                      attachedRule->EndLeaves());
         continue;
       }
     }
-    leaves.insert(baseLeaf);
+    leaves.push_back(baseLeaf);
   }
-  return Subgraph(m_baseRule.GetRoot(), leaves);
 }
 
 }  // namespace GHKM
@@ -23,8 +23,10 @@
 
 #include "Subgraph.h"
 
+#include <cstddef>
 #include <vector>
-#include <queue>
+
+namespace util { class Pool; }
 
 namespace Moses {
 namespace GHKM {
@@ -35,11 +37,13 @@ struct Options;
 class ComposedRule
 {
  public:
-  // Form a 'trivial' ComposedRule from a single existing rule.
-  ComposedRule(const Subgraph &baseRule);
+  // Form a 'trivial' ComposedRule from a single existing rule.  Its state, and
+  // that of the rules composed from it, is allocated from pool, so none of
+  // them needs destruction.
+  ComposedRule(const Subgraph &baseRule, util::Pool &pool);
 
   // Returns the first open attachment point if any exist or 0 otherwise.
-  const Node *GetOpenAttachmentPoint();
+  const Node *GetOpenAttachmentPoint() const;
 
   // Close the first open attachment point without attaching a rule.
   void CloseAttachmentPoint();
@@ -47,18 +51,29 @@ class ComposedRule
   // Attempts to produce a new composed rule by attaching a given rule at the
   // first open attachment point.  This will fail if the proposed rule violates
   // the constraints set in the Options object, in which case the function
-  // returns 0.
+  // returns 0.  The new rule is allocated from the pool.
   ComposedRule *AttemptComposition(const Subgraph &, const Options &) const;
 
-  // Constructs a Subgraph object corresponding to the composed rule.
-  Subgraph CreateSubgraph();
+  // Gets the leaves of the composed rule, which is rooted at the base rule's
+  // root.
+  void GetLeaves(std::vector<const Node *> &) const;
 
  private:
   ComposedRule(const ComposedRule &, const Subgraph &, int);
 
+  // Disallow copying
+  ComposedRule(const ComposedRule &);
+  ComposedRule &operator=(const ComposedRule &);
+
   const Subgraph &m_baseRule;
-  std::vector<const Subgraph *> m_attachedRules;
-  std::queue<const Node *> m_openAttachmentPoints;
+  util::Pool &m_pool;
+  // The base rule's tree leaves, shared by all rules composed from it.
+  const Node **m_attachmentPoints;
+  std::size_t m_attachmentPointCount;
+  // The rule attached at each attachment point before m_next, or 0 if the
+  // point was closed without one.
+  const Subgraph **m_attachedRules;
+  std::size_t m_next;
   int m_depth;
   int m_size;
   int m_nodeCount;
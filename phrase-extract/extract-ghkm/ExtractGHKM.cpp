@@ -24,6 +24,7 @@
 #include "Exception.h"
 #include "InputFileStream.h"
 #include "Node.h"
+#include "OrderedBatchWriter.h"
 #include "OutputFileStream.h"
 #include "Options.h"
 #include "ParseTree.h"
@@ -32,7 +33,13 @@
 #include "Span.h"
 #include "XmlTreeParser.h"
 
+#include "moses/ThreadPool.h"
+#include "util/pool.hh"
+
 #include <boost/program_options.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
 
 #include <cassert>
 #include <cstdlib>
@@ -43,9 +50,201 @@
 #include <sstream>
 #include <vector>
 
+#include <time.h>
+
 namespace Moses {
 namespace GHKM {
 
+namespace {
+
+// Seconds on a monotonic clock, for the statistics.
+double WallTime()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Sentences per batch.
+const size_t kBatchSize = 100;
+
+}  // namespace
+
+// Counters reported at the end of extraction.
+struct ExtractGHKM::Statistics {
+  Statistics()
+      : sentences(0)
+      , skipped(0)
+      , rules(0)
+      , maxRules(0)
+      , maxRulesLine(0)
+      , parseTime(0)
+      , extractTime(0)
+      , writeTime(0)
+      , maxTime(0)
+      , maxTimeLine(0) {}
+
+  void Add(const Statistics &);
+
+  size_t sentences;     // sentences that rules were extracted from
+  size_t skipped;
+  size_t rules;         // rules written, i.e. after scope pruning
+  size_t maxRules;      // most rules written for one sentence
+  size_t maxRulesLine;
+  double parseTime;     // tree, token and alignment parsing
+  double extractTime;   // alignment graph construction and rule extraction
+  double writeTime;     // scope pruning and formatting of rules
+  double maxTime;       // longest time spent on one sentence
+  size_t maxTimeLine;
+};
+
+void ExtractGHKM::Statistics::Add(const Statistics &other)
+{
+  sentences += other.sentences;
+  skipped += other.skipped;
+  rules += other.rules;
+  if (other.maxRules > maxRules) {
+    maxRules = other.maxRules;
+    maxRulesLine = other.maxRulesLine;
+  }
+  parseTime += other.parseTime;
+  extractTime += other.extractTime;
+  writeTime += other.writeTime;
+  if (other.maxTime > maxTime) {
+    maxTime = other.maxTime;
+    maxTimeLine = other.maxTimeLine;
+  }
+}
+
+// A run of input lines and everything extracted from them, kept until it is
+// their turn to be written.
+struct ExtractGHKM::Batch {
+  std::vector<size_t> lineNums;
+  std::vector<std::string> targetLines;
+  std::vector<std::string> sourceLines;
+  std::vector<std::string> alignmentLines;
+
+  std::ostringstream fwd;
+  std::ostringstream inv;
+  std::ostringstream log;
+  std::set<std::string> labelSet;
+  std::map<std::string, int> topLabelSet;
+  std::map<std::string, int> wordCount;
+  std::map<std::string, std::string> wordLabel;
+  Statistics stats;
+
+  // Set if a line could not be read.  Later lines are not processed.
+  std::string error;
+};
+
+// Writes batches, which an OrderedBatchWriter passes in input order, and
+// merges their label sets, word counts and statistics into the totals.
+class ExtractGHKM::BatchSink
+{
+ public:
+  BatchSink(std::ostream &fwd, std::ostream &inv,
+            std::set<std::string> &labelSet,
+            std::map<std::string, int> &topLabelSet,
+            std::map<std::string, int> &wordCount,
+            std::map<std::string, std::string> &wordLabel,
+            Statistics &stats)
+      : m_fwd(fwd)
+      , m_inv(inv)
+      , m_labelSet(labelSet)
+      , m_topLabelSet(topLabelSet)
+      , m_wordCount(wordCount)
+      , m_wordLabel(wordLabel)
+      , m_stats(stats) {}
+
+  void operator()(Batch &);
+
+  // The error of the first batch that failed, or empty.  Nothing after it is
+  // written.
+  std::string GetError();
+
+ private:
+  std::ostream &m_fwd;
+  std::ostream &m_inv;
+  std::set<std::string> &m_labelSet;
+  std::map<std::string, int> &m_topLabelSet;
+  std::map<std::string, int> &m_wordCount;
+  std::map<std::string, std::string> &m_wordLabel;
+  Statistics &m_stats;
+  std::string m_error;
+#ifdef WITH_THREADS
+  // The main thread reads the error while workers write batches.
+  boost::mutex m_errorMutex;
+#endif
+};
+
+void ExtractGHKM::BatchSink::operator()(Batch &batch)
+{
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_errorMutex);
+#endif
+    if (!m_error.empty()) {
+      return;
+    }
+    m_error = batch.error;
+  }
+
+  std::cerr << batch.log.str();
+  m_fwd << batch.fwd.str();
+  m_inv << batch.inv.str();
+
+  m_labelSet.insert(batch.labelSet.begin(), batch.labelSet.end());
+  for (std::map<std::string, int>::const_iterator p =
+         batch.topLabelSet.begin(); p != batch.topLabelSet.end(); ++p) {
+    m_topLabelSet[p->first] += p->second;
+  }
+  for (std::map<std::string, int>::const_iterator p = batch.wordCount.begin();
+       p != batch.wordCount.end(); ++p) {
+    m_wordCount[p->first] += p->second;
+  }
+  for (std::map<std::string, std::string>::const_iterator p =
+         batch.wordLabel.begin(); p != batch.wordLabel.end(); ++p) {
+    m_wordLabel[p->first] = p->second;
+  }
+  m_stats.Add(batch.stats);
+}
+
+std::string ExtractGHKM::BatchSink::GetError()
+{
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_errorMutex);
+#endif
+  return m_error;
+}
+
+#ifdef WITH_THREADS
+// Extracts the rules of a batch on a worker thread.
+class ExtractGHKM::ExtractTask : public Task
+{
+ public:
+  ExtractTask(const ExtractGHKM &extractor, const Options &options, size_t id,
+              Batch *batch,
+              MosesTraining::OrderedBatchWriter<Batch, BatchSink> &writer)
+      : m_extractor(extractor)
+      , m_options(options)
+      , m_id(id)
+      , m_batch(batch)
+      , m_writer(writer) {}
+
+  void Run() {
+    m_extractor.ExtractBatch(m_options, *m_batch);
+    m_writer.Write(m_id, m_batch);
+  }
+
+ private:
+  const ExtractGHKM &m_extractor;
+  const Options &m_options;
+  size_t m_id;
+  Batch *m_batch;
+  MosesTraining::OrderedBatchWriter<Batch, BatchSink> &m_writer;
+};
+#endif
+
 int ExtractGHKM::Main(int argc, char *argv[])
 {
   // Process command-line options.
@@ -85,105 +284,234 @@ int ExtractGHKM::Main(int argc, char *argv[])
   std::map<std::string, int> wordCount;
   std::map<std::string, std::string> wordLabel;
 
+  // Rules are extracted from batches of lines, on a thread pool if there is
+  // more than one thread, and written in input order.
+  Statistics stats;
+  BatchSink batchSink(fwdExtractStream, invExtractStream, labelSet,
+                      topLabelSet, wordCount, wordLabel, stats);
+  MosesTraining::OrderedBatchWriter<Batch, BatchSink> batchWriter(batchSink);
+#ifdef WITH_THREADS
+  std::auto_ptr<ThreadPool> pool;
+  if (options.threads > 1) {
+    pool.reset(new ThreadPool(options.threads));
+    pool->SetQueueLimit(options.threads * 2);
+  }
+#endif
+
+  double startTime = WallTime();
   std::string targetLine;
   std::string sourceLine;
   std::string alignmentLine;
-  XmlTreeParser xmlTreeParser(labelSet, topLabelSet);
-  ScfgRuleWriter writer(fwdExtractStream, invExtractStream, options);
   size_t lineNum = options.sentenceOffset;
-  while (true) {
-    std::getline(targetStream, targetLine);
-    std::getline(sourceStream, sourceLine);
-    std::getline(alignmentStream, alignmentLine);
+  size_t batchCount = 0;
+  bool eof = false;
+  while (!eof && batchSink.GetError().empty()) {
+    std::auto_ptr<Batch> batch(new Batch());
+    while (batch->lineNums.size() < kBatchSize) {
+      std::getline(targetStream, targetLine);
+      std::getline(sourceStream, sourceLine);
+      std::getline(alignmentStream, alignmentLine);
+
+      if (targetStream.eof() && sourceStream.eof() && alignmentStream.eof()) {
+        eof = true;
+        break;
+      }
 
-    if (targetStream.eof() && sourceStream.eof() && alignmentStream.eof()) {
+      if (targetStream.eof() || sourceStream.eof() || alignmentStream.eof()) {
+        Error("Files must contain same number of lines");
+      }
+
+      batch->lineNums.push_back(++lineNum);
+      batch->targetLines.push_back(targetLine);
+      batch->sourceLines.push_back(sourceLine);
+      batch->alignmentLines.push_back(alignmentLine);
+    }
+    if (batch->lineNums.empty()) {
       break;
     }
 
-    if (targetStream.eof() || sourceStream.eof() || alignmentStream.eof()) {
-      Error("Files must contain same number of lines");
+#ifdef WITH_THREADS
+    if (pool.get()) {
+      pool->Submit(new ExtractTask(*this, options, batchCount++,
+                                   batch.release(), batchWriter));
+      continue;
     }
+#endif
+    ExtractBatch(options, *batch);
+    batchWriter.Write(batchCount++, batch.release());
+  }
 
-    ++lineNum;
+#ifdef WITH_THREADS
+  if (pool.get()) {
+    pool->Stop(true);
+  }
+#endif
+  if (!batchSink.GetError().empty()) {
+    Error(batchSink.GetError());
+  }
 
-    // Parse target tree.
-    if (targetLine.size() == 0) { 
-      std::cerr << "skipping line " << lineNum << " with empty target tree\n";
-      continue;
-    }
-    std::auto_ptr<ParseTree> t;
-    try {
-      t = xmlTreeParser.Parse(targetLine);
-      assert(t.get());
-    } catch (const Exception &e) {
-      std::ostringstream s;
-      s << "Failed to parse XML tree at line " << lineNum;
-      if (!e.GetMsg().empty()) {
-        s << ": " << e.GetMsg();
-      }
-      Error(s.str());
-    }
+  WriteStatistics(stats, WallTime() - startTime, std::cerr);
 
-    // Read source tokens.
-    std::vector<std::string> sourceTokens(ReadTokens(sourceLine));
-
-    // Read word alignments.
-    Alignment alignment;
-    try {
-      alignment = ReadAlignment(alignmentLine);
-    } catch (const Exception &e) {
-      std::ostringstream s;
-      s << "Failed to read alignment at line " << lineNum << ": ";
-      s << e.GetMsg();
-      Error(s.str());
-    }
-    if (alignment.size() == 0) {
-      std::cerr << "skipping line " << lineNum << " without alignment points\n";
-      continue;
+  if (!options.glueGrammarFile.empty()) {
+    WriteGlueGrammar(labelSet, topLabelSet, glueGrammarStream);
+  }
+
+  if (!options.unknownWordFile.empty()) {
+    WriteUnknownWordLabel(wordCount, wordLabel, options, unknownWordStream);
+  }
+
+  return 0;
+}
+
+void ExtractGHKM::ExtractBatch(const Options &options, Batch &batch) const
+{
+  XmlTreeParser xmlTreeParser(batch.labelSet, batch.topLabelSet);
+  ScfgRuleWriter writer(batch.fwd, batch.inv, options);
+  // Holds one sentence's alignment graph and rules at a time.
+  util::Pool pool;
+  for (size_t i = 0; i < batch.lineNums.size(); ++i) {
+    pool.Reset();
+    if (!ExtractSentence(options, xmlTreeParser, writer, pool,
+                         batch.lineNums[i],
+                         batch.targetLines[i], batch.sourceLines[i],
+                         batch.alignmentLines[i], batch)) {
+      break;
     }
+  }
+  // The input is no longer needed while the batch waits to be written.
+  std::vector<std::string>().swap(batch.targetLines);
+  std::vector<std::string>().swap(batch.sourceLines);
+  std::vector<std::string>().swap(batch.alignmentLines);
+}
 
-    // Record word counts.
-    if (!options.unknownWordFile.empty()) {
-      CollectWordLabelCounts(*t, options, wordCount, wordLabel);
+// Extracts and writes the rules of one sentence.  Returns false, with
+// batch.error set, if the input could not be read.
+bool ExtractGHKM::ExtractSentence(const Options &options,
+                                  XmlTreeParser &xmlTreeParser,
+                                  ScfgRuleWriter &writer,
+                                  util::Pool &pool,
+                                  size_t lineNum,
+                                  const std::string &targetLine,
+                                  const std::string &sourceLine,
+                                  const std::string &alignmentLine,
+                                  Batch &batch) const
+{
+  Statistics &stats = batch.stats;
+  const double startTime = WallTime();
+
+  // Parse target tree.
+  if (targetLine.size() == 0) {
+    batch.log << "skipping line " << lineNum << " with empty target tree\n";
+    ++stats.skipped;
+    return true;
+  }
+  std::auto_ptr<ParseTree> t;
+  try {
+    t = xmlTreeParser.Parse(targetLine);
+    assert(t.get());
+  } catch (const Exception &e) {
+    std::ostringstream s;
+    s << "Failed to parse XML tree at line " << lineNum;
+    if (!e.GetMsg().empty()) {
+      s << ": " << e.GetMsg();
     }
+    batch.error = s.str();
+    return false;
+  }
 
-    // Form an alignment graph from the target tree, source words, and
-    // alignment.
-    AlignmentGraph graph(t.get(), sourceTokens, alignment);
+  // Read source tokens.
+  std::vector<std::string> sourceTokens(ReadTokens(sourceLine));
 
-    // Extract minimal rules, adding each rule to its root node's rule set.
-    graph.ExtractMinimalRules(options);
+  // Read word alignments.
+  Alignment alignment;
+  try {
+    alignment = ReadAlignment(alignmentLine);
+  } catch (const Exception &e) {
+    std::ostringstream s;
+    s << "Failed to read alignment at line " << lineNum << ": ";
+    s << e.GetMsg();
+    batch.error = s.str();
+    return false;
+  }
+  if (alignment.size() == 0) {
+    batch.log << "skipping line " << lineNum << " without alignment points\n";
+    ++stats.skipped;
+    return true;
+  }
 
-    // Extract composed rules.
-    if (!options.minimal) {
-      graph.ExtractComposedRules(options);
-    }
+  // Record word counts.
+  if (!options.unknownWordFile.empty()) {
+    CollectWordLabelCounts(*t, options, batch.wordCount, batch.wordLabel);
+  }
 
-    // Write the rules, subject to scope pruning.
-    const std::vector<Node *> &targetNodes = graph.GetTargetNodes();
-    for (std::vector<Node *>::const_iterator p = targetNodes.begin();
-         p != targetNodes.end(); ++p) {
-      const std::vector<const Subgraph *> &rules = (*p)->GetRules();
-      for (std::vector<const Subgraph *>::const_iterator q = rules.begin();
-           q != rules.end(); ++q) {
-        ScfgRule r(**q);
-        // TODO Can scope pruning be done earlier?
-        if (r.Scope() <= options.maxScope) {
-          writer.Write(r);
-        }
+  const double parsedTime = WallTime();
+
+  // Form an alignment graph from the target tree, source words, and
+  // alignment.
+  AlignmentGraph graph(t.get(), sourceTokens, alignment, pool);
+
+  // Extract minimal rules, adding each rule to its root node's rule set.
+  graph.ExtractMinimalRules(options);
+
+  // Extract composed rules.
+  if (!options.minimal) {
+    graph.ExtractComposedRules(options);
+  }
+
+  const double extractedTime = WallTime();
+
+  // Write the rules, subject to scope pruning.
+  size_t ruleCount = 0;
+  const std::vector<Node *> &targetNodes = graph.GetTargetNodes();
+  for (std::vector<Node *>::const_iterator p = targetNodes.begin();
+       p != targetNodes.end(); ++p) {
+    const std::vector<const Subgraph *> &rules = (*p)->GetRules();
+    for (std::vector<const Subgraph *>::const_iterator q = rules.begin();
+         q != rules.end(); ++q) {
+      ScfgRule r(**q);
+      // TODO Can scope pruning be done earlier?
+      if (r.Scope() <= options.maxScope) {
+        writer.Write(r);
+        ++ruleCount;
       }
     }
   }
 
-  if (!options.glueGrammarFile.empty()) {
-    WriteGlueGrammar(labelSet, topLabelSet, glueGrammarStream);
-  }
+  const double endTime = WallTime();
 
-  if (!options.unknownWordFile.empty()) {
-    WriteUnknownWordLabel(wordCount, wordLabel, options, unknownWordStream);
+  ++stats.sentences;
+  stats.rules += ruleCount;
+  if (ruleCount > stats.maxRules) {
+    stats.maxRules = ruleCount;
+    stats.maxRulesLine = lineNum;
+  }
+  stats.parseTime += parsedTime - startTime;
+  stats.extractTime += extractedTime - parsedTime;
+  stats.writeTime += endTime - extractedTime;
+  if (endTime - startTime > stats.maxTime) {
+    stats.maxTime = endTime - startTime;
+    stats.maxTimeLine = lineNum;
   }
+  return true;
+}
 
-  return 0;
+void ExtractGHKM::WriteStatistics(const Statistics &stats, double wallTime,
+                                  std::ostream &out) const
+{
+  out << "extracted " << stats.rules << " rules from " << stats.sentences
+      << " sentences (" << stats.skipped << " skipped)\n";
+  if (stats.sentences > 0) {
+    out << "rules per sentence: mean "
+        << static_cast<double>(stats.rules) / stats.sentences
+        << ", max " << stats.maxRules << " (line " << stats.maxRulesLine
+        << ")\n";
+    out << "seconds per sentence: max " << stats.maxTime << " (line "
+        << stats.maxTimeLine << ")\n";
+  }
+  out << "seconds spent parsing: " << stats.parseTime
+      << ", extracting: " << stats.extractTime
+      << ", writing rules: " << stats.writeTime
+      << " (summed over threads), total elapsed: " << wallTime << std::endl;
 }
 
 void ExtractGHKM::OpenInputFileOrDie(const std::string &filename,
@@ -292,6 +620,9 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
     ("SentenceOffset",
         po::value(&options.sentenceOffset)->default_value(options.sentenceOffset),
         "set sentence number offset if processing split corpus")
+    ("Threads",
+        po::value(&options.threads)->default_value(options.threads),
+        "extract rules on this many threads")
     ("UnknownWordLabel",
         po::value(&options.unknownWordFile),
         "write unknown word labels to named file")
@@ -364,6 +695,12 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
     std::exit(1);
   }
 
+#ifndef WITH_THREADS
+  if (options.threads > 1) {
+    Error("thread support not compiled in");
+  }
+#endif
+
   // Process Boolean options.
   if (vm.count("AllowUnary")) {
     options.allowUnary = true;
@@ -394,7 +731,7 @@ void ExtractGHKM::Error(const std::string &msg) const
   std::exit(1);
 }
 
-std::vector<std::string> ExtractGHKM::ReadTokens(const std::string &s)
+std::vector<std::string> ExtractGHKM::ReadTokens(const std::string &s) const
 {
   std::vector<std::string> tokens;
 
@@ -460,7 +797,7 @@ void ExtractGHKM::CollectWordLabelCounts(
     ParseTree &root,
     const Options &options,
     std::map<std::string, int> &wordCount,
-    std::map<std::string, std::string> &wordLabel)
+    std::map<std::string, std::string> &wordLabel) const
 {
   std::vector<const ParseTree*> leaves;
   root.GetLeaves(std::back_inserter(leaves));
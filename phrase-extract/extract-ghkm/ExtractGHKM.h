@@ -27,6 +27,8 @@
 #include <string>
 #include <vector>
 
+namespace util { class Pool; }
+
 namespace Moses {
 
 class OutputFileStream;
@@ -35,6 +37,8 @@ namespace GHKM {
 
 struct Options;
 class ParseTree;
+class ScfgRuleWriter;
+class XmlTreeParser;
 
 class ExtractGHKM
 {
@@ -43,15 +47,25 @@ class ExtractGHKM
   const std::string &GetName() const { return m_name; }
   int Main(int argc, char *argv[]);
  private:
+  struct Statistics;
+  struct Batch;
+  class ExtractTask;
+  class BatchSink;
+
   void Error(const std::string &) const;
   void OpenInputFileOrDie(const std::string &, std::ifstream &);
   void OpenOutputFileOrDie(const std::string &, std::ofstream &);
   void OpenOutputFileOrDie(const std::string &, OutputFileStream &);
   void RecordTreeLabels(const ParseTree &, std::set<std::string> &);
+  void ExtractBatch(const Options &, Batch &) const;
+  bool ExtractSentence(const Options &, XmlTreeParser &, ScfgRuleWriter &,
+                       util::Pool &, size_t,
+                       const std::string &, const std::string &,
+                       const std::string &, Batch &) const;
   void CollectWordLabelCounts(ParseTree &,
                               const Options &,
                               std::map<std::string, int> &,
-                              std::map<std::string, std::string> &);
+                              std::map<std::string, std::string> &) const;
   void WriteUnknownWordLabel(const std::map<std::string, int> &,
                              const std::map<std::string, std::string> &,
                              const Options &,
@@ -59,7 +73,8 @@ class ExtractGHKM
   void WriteGlueGrammar(const std::set<std::string> &,
                         const std::map<std::string, int> &,
                         std::ostream &);
-  std::vector<std::string> ReadTokens(const std::string &);
+  void WriteStatistics(const Statistics &, double, std::ostream &) const;
+  std::vector<std::string> ReadTokens(const std::string &) const;
   
   void ProcessOptions(int, char *[], Options &) const;
 
@@ -19,19 +19,9 @@
 
 #include "Node.h"
 
-#include "Subgraph.h"
-
 namespace Moses {
 namespace GHKM {
 
-Node::~Node()
-{
-  for (std::vector<const Subgraph*>::const_iterator p(m_rules.begin());
-       p != m_rules.end(); ++p) {
-    delete *p;
-  }
-}
-
 bool Node::IsPreterminal() const
 {
   return (m_type == TREE
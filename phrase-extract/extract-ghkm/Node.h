@@ -35,18 +35,20 @@ class Subgraph;
 
 enum NodeType { SOURCE, TARGET, TREE };
 
+// A node of an AlignmentGraph.  Its index is its position in the graph, for
+// node sets kept as bitsets.  Rules are owned by the graph.
 class Node
 {
  public:
-  Node(const std::string &label, NodeType type)
+  Node(const std::string &label, NodeType type, int index)
       : m_label(label)
       , m_type(type)
+      , m_index(index)
       , m_pcfgScore(0.0f) {}
 
-  ~Node();
-
   const std::string &GetLabel() const { return m_label; }
   NodeType GetType() const { return m_type; }
+  int GetIndex() const { return m_index; }
   const std::vector<Node*> &GetChildren() const { return m_children; }
   const std::vector<Node*> &GetParents() const { return m_parents; }
   float GetPcfgScore() const { return m_pcfgScore; }
@@ -91,6 +93,7 @@ class Node
 
   std::string m_label;
   NodeType m_type;
+  int m_index;
   std::vector<Node*> m_children;
   std::vector<Node*> m_parents;
   float m_pcfgScore;
@@ -39,6 +39,7 @@ struct Options {
       , minimal(false)
       , pcfg(false)
       , sentenceOffset(0)
+      , threads(1)
       , unpairedExtractFormat(false)
       , unknownWordMinRelFreq(0.03f)
       , unknownWordUniform(false) {}
@@ -61,6 +62,7 @@ struct Options {
   bool minimal;
   bool pcfg;
   int sentenceOffset;
+  int threads;
   bool unpairedExtractFormat;
   std::string unknownWordFile;
   float unknownWordMinRelFreq;
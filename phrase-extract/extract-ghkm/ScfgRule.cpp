@@ -34,12 +34,10 @@ ScfgRule::ScfgRule(const Subgraph &fragment)
 {
   // Source RHS
 
-  const std::set<const Node *> &leaves = fragment.GetLeaves();
-
   std::vector<const Node *> sourceRHSNodes;
-  sourceRHSNodes.reserve(leaves.size());
-  for (std::set<const Node *>::const_iterator p(leaves.begin());
-       p != leaves.end(); ++p) {
+  sourceRHSNodes.reserve(fragment.GetLeafCount());
+  for (Subgraph::LeafIterator p(fragment.BeginLeaves());
+       p != fragment.EndLeaves(); ++p) {
     const Node &leaf = **p;
     if (!leaf.GetSpan().empty()) {
       sourceRHSNodes.push_back(&leaf);
@@ -33,7 +33,7 @@ void Subgraph::GetTargetLeaves(std::vector<const Node *> &result) const
 void Subgraph::GetTargetLeaves(const Node *root,
                                std::vector<const Node *> &result) const
 {
-  if (root->GetType() == TARGET || m_leaves.find(root) != m_leaves.end()) {
+  if (root->GetType() == TARGET || IsLeaf(root)) {
     result.push_back(root);
   } else {
     const std::vector<Node*> &children = root->GetChildren();
@@ -57,7 +57,7 @@ int Subgraph::CountNodes(const Node *n) const
   for (std::vector<Node *>::const_iterator p = children.begin();
        p != children.end(); ++p) {
     const Node *child = *p;
-    if (m_leaves.find(child) == m_leaves.end()) {
+    if (!IsLeaf(child)) {
       count += CountNodes(child);
     } else if (child->GetType() == TREE) {
       ++count;
@@ -78,7 +78,7 @@ int Subgraph::CalcSize(const Node *n) const
   const std::vector<Node*> &children = n->GetChildren();
   for (std::vector<Node *>::const_iterator p = children.begin();
        p != children.end(); ++p) {
-    if (m_leaves.find(*p) == m_leaves.end()) {
+    if (!IsLeaf(*p)) {
       count += CalcSize(*p);
     }
   }
@@ -87,14 +87,14 @@ int Subgraph::CalcSize(const Node *n) const
 
 int Subgraph::CalcDepth(const Node *n) const
 {
-  if (n->GetType() != TREE || n->IsPreterminal() || m_leaves.empty()) {
+  if (n->GetType() != TREE || n->IsPreterminal() || IsTrivial()) {
     return 0;
   }
   int maxChildDepth = 0;
   const std::vector<Node*> &children = n->GetChildren();
   for (std::vector<Node *>::const_iterator p = children.begin();
        p != children.end(); ++p) {
-    if (m_leaves.find(*p) == m_leaves.end()) {
+    if (!IsLeaf(*p)) {
       maxChildDepth = std::max(maxChildDepth, CalcDepth(*p));
     }
   }
@@ -103,12 +103,11 @@ int Subgraph::CalcDepth(const Node *n) const
 
 float Subgraph::CalcPcfgScore() const
 {
-  if (m_root->GetType() != TREE || m_leaves.empty()) {
+  if (m_root->GetType() != TREE || IsTrivial()) {
     return 0.0f;
   }
   float score = m_root->GetPcfgScore();
-  for (std::set<const Node *>::const_iterator p = m_leaves.begin();
-       p != m_leaves.end(); ++p) {
+  for (LeafIterator p = BeginLeaves(); p != EndLeaves(); ++p) {
     const Node *leaf = *p;
     if (leaf->GetType() == TREE) {
       score -= leaf->GetPcfgScore();
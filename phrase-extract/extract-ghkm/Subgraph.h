@@ -23,27 +23,42 @@
 
 #include "Node.h"
 
-#include <set>
+#include <cstddef>
 #include <vector>
 
+#include <stdint.h>
+
 namespace Moses {
 namespace GHKM {
 
 class Node;
 
+// A rule fragment: a root node and the leaves below which it stops.  The
+// leaves are an array of nodes plus a bitset over node indices for membership
+// tests.  Both are owned by the caller (the AlignmentGraph's pool), so a
+// Subgraph is cheap to copy and needs no destruction.
 class Subgraph
 {
  public:
+  typedef const Node *const *LeafIterator;
+
   Subgraph(const Node *root)
       : m_root(root)
+      , m_leaves(0)
+      , m_leafCount(0)
+      , m_leafBits(0)
       , m_depth(0)
       , m_size(root->GetType() == TREE ? 1 : 0)
       , m_nodeCount(1)
       , m_pcfgScore(0.0f) {}
 
-  Subgraph(const Node *root, const std::set<const Node *> &leaves)
+  // leafBits has a bit set for the index of each of the leaves.
+  Subgraph(const Node *root, const Node *const *leaves, std::size_t leafCount,
+           const uint64_t *leafBits)
       : m_root(root)
       , m_leaves(leaves)
+      , m_leafCount(leafCount)
+      , m_leafBits(leafBits)
       , m_depth(-1)
       , m_size(-1)
       , m_nodeCount(-1)
@@ -56,13 +71,20 @@ class Subgraph
   }
 
   const Node *GetRoot() const { return m_root; }
-  const std::set<const Node *> &GetLeaves() const { return m_leaves; }
+  LeafIterator BeginLeaves() const { return m_leaves; }
+  LeafIterator EndLeaves() const { return m_leaves + m_leafCount; }
+  std::size_t GetLeafCount() const { return m_leafCount; }
   int GetDepth() const { return m_depth; }
   int GetSize() const { return m_size; }
   int GetNodeCount() const { return m_nodeCount; }
   float GetPcfgScore() const { return m_pcfgScore; }
 
-  bool IsTrivial() const { return m_leaves.empty(); }
+  bool IsTrivial() const { return m_leafCount == 0; }
+
+  bool IsLeaf(const Node *n) const {
+    return m_leafCount != 0 &&
+           (m_leafBits[n->GetIndex() / 64] >> (n->GetIndex() % 64)) & 1;
+  }
 
   void GetTargetLeaves(std::vector<const Node *> &) const;
 
@@ -74,7 +96,9 @@ class Subgraph
   int CountNodes(const Node *) const;
 
   const Node *m_root;
-  std::set<const Node *> m_leaves;
+  const Node *const *m_leaves;
+  std::size_t m_leafCount;
+  const uint64_t *m_leafBits;
   int m_depth;
   int m_size;
   int m_nodeCount;
@@ -2,6 +2,9 @@
 #include <fstream>
 #include <cassert>
 #include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include "extract-lex.h"
 #include "InputFileStream.h"
 
@@ -20,7 +23,11 @@ int main(int argc, char* argv[])
 {
   cerr << "Starting...\n";
   
-  assert(argc == 6);
+  if (argc != 6 && !(argc == 7 && strcmp(argv[6], "--Binary") == 0)) {
+    cerr << "syntax: extract-lex target source align lex.s2t lex.t2s [--Binary]\n";
+    exit(1);
+  }
+  bool binaryFlag = (argc == 7);
   char* &filePathTarget = argv[1];
   char* &filePathSource = argv[2];
   char* &filePathAlign  = argv[3];
@@ -31,14 +38,6 @@ int main(int argc, char* argv[])
   Moses::InputFileStream streamSource(filePathSource);
   Moses::InputFileStream streamAlign(filePathAlign);
 
-  ofstream streamLexS2T;
-  ofstream streamLexT2S;
-  streamLexS2T.open(filePathLexS2T);
-  streamLexT2S.open(filePathLexT2S);
-
-  fix(streamLexS2T);
-  fix(streamLexT2S);
-
   ExtractLex extractSingleton;
 
   size_t lineCount = 0;
@@ -70,13 +69,26 @@ int main(int argc, char* argv[])
     ++lineCount; 
   }
 
-  extractSingleton.Output(streamLexS2T, streamLexT2S);
-
   streamTarget.Close();
   streamSource.Close();
   streamAlign.Close();
-  streamLexS2T.close();
-  streamLexT2S.close();
+
+  if (binaryFlag) {
+    extractSingleton.OutputBinary(filePathLexS2T, filePathLexT2S);
+  } else {
+    ofstream streamLexS2T;
+    ofstream streamLexT2S;
+    streamLexS2T.open(filePathLexS2T);
+    streamLexT2S.open(filePathLexT2S);
+
+    fix(streamLexS2T);
+    fix(streamLexT2S);
+
+    extractSingleton.Output(streamLexS2T, streamLexT2S);
+
+    streamLexS2T.close();
+    streamLexT2S.close();
+  }
 
   cerr << "\nFinished\n";
 }
@@ -84,12 +96,6 @@ int main(int argc, char* argv[])
 namespace MosesTraining
 {
 
-const std::string *Vocab::GetOrAdd(const std::string &word)
-{
- 	const string *ret = &(*m_coll.insert(word).first);
-  return ret;
-}
-
 void ExtractLex::Process(vector<string> &toksTarget, vector<string> &toksSource, vector<string> &toksAlign, size_t lineCount)
 {
   std::vector<bool> m_sourceAligned(toksSource.size(), false)
@@ -124,8 +130,8 @@ void ExtractLex::Process(vector<string> &toksTarget, vector<string> &toksSource,
     const string &tmpSource = toksSource[ alignPos[0] ];
     const string &tmpTarget = toksTarget[ alignPos[1] ];
  
-    const string *source = m_vocab.GetOrAdd(tmpSource);
-    const string *target = m_vocab.GetOrAdd(tmpTarget);
+    WORD_ID source = m_vocab.storeIfNew(tmpSource);
+    WORD_ID target = m_vocab.storeIfNew(tmpTarget);
 
     Process(target, source);
     
@@ -134,29 +140,23 @@ void ExtractLex::Process(vector<string> &toksTarget, vector<string> &toksSource,
   ProcessUnaligned(toksTarget, toksSource, m_sourceAligned, m_targetAligned);
 }
 
-void ExtractLex::Process(const std::string *target, const std::string *source)
+void ExtractLex::Process(WORD_ID target, WORD_ID source)
 {
-  WordCount &wcS2T = m_collS2T[source];
-  WordCount &wcT2S = m_collT2S[target];
-
-  wcS2T.AddCount(COUNT_INCR);
-  wcT2S.AddCount(COUNT_INCR);
-
-  Process(wcS2T, target);
-  Process(wcT2S, source);
+  Process(m_pairS2T, m_countS2T, source, target);
+  Process(m_pairT2S, m_countT2S, target, source);
 }
 
-void ExtractLex::Process(WordCount &wcIn, const std::string *out)
+void ExtractLex::Process(PairCounts &pairs, std::vector<float> &counts, WORD_ID given, WORD_ID predicted)
 {
-  std::map<const std::string*, WordCount> &collOut = wcIn.GetColl();
-  WordCount &wcOut = collOut[out];
-  wcOut.AddCount(COUNT_INCR);
+  if (given >= counts.size()) counts.resize(given + 1, 0);
+  counts[given] += COUNT_INCR;
+  pairs[LexicalTable::Key(given, predicted)] += COUNT_INCR;
 }
 
 void ExtractLex::ProcessUnaligned(vector<string> &toksTarget, vector<string> &toksSource
                                 , const std::vector<bool> &m_sourceAligned, const std::vector<bool> &m_targetAligned)
 {
-  const string *nullWord = m_vocab.GetOrAdd("NULL"); 
+  WORD_ID nullWord = m_vocab.storeIfNew("NULL");
 
   for (size_t pos = 0; pos < m_sourceAligned.size(); ++pos)
   {
@@ -164,7 +164,7 @@ void ExtractLex::ProcessUnaligned(vector<string> &toksTarget, vector<string> &to
     if (!isAlignedCurr)
     {
       const string &tmpWord = toksSource[pos];
-      const string *sourceWord = m_vocab.GetOrAdd(tmpWord);
+      WORD_ID sourceWord = m_vocab.storeIfNew(tmpWord);
 
       Process(nullWord, sourceWord);
     }
@@ -176,7 +176,7 @@ void ExtractLex::ProcessUnaligned(vector<string> &toksTarget, vector<string> &to
     if (!isAlignedCurr)
     {
       const string &tmpWord = toksTarget[pos];
-      const string *targetWord = m_vocab.GetOrAdd(tmpWord);
+      WORD_ID targetWord = m_vocab.storeIfNew(tmpWord);
 
       Process(targetWord, nullWord);
     }
@@ -184,44 +184,58 @@ void ExtractLex::ProcessUnaligned(vector<string> &toksTarget, vector<string> &to
 
 }
 
-void ExtractLex::Output(std::ofstream &streamLexS2T, std::ofstream &streamLexT2S)
+void ExtractLex::Output(std::ostream &streamLexS2T, std::ostream &streamLexT2S) const
 {
-  Output(m_collS2T, streamLexS2T);
-  Output(m_collT2S, streamLexT2S);
+  Output(m_pairS2T, m_countS2T, streamLexS2T);
+  Output(m_pairT2S, m_countT2S, streamLexT2S);
 }
 
-void ExtractLex::Output(const std::map<const std::string*, WordCount> &coll, std::ofstream &outStream)
+void ExtractLex::OutputBinary(const std::string &fileNameLexS2T, const std::string &fileNameLexT2S) const
 {
-  std::map<const std::string*, WordCount>::const_iterator iterOuter;
-  for (iterOuter = coll.begin(); iterOuter != coll.end(); ++iterOuter)
-  {
-    const string &inStr = *iterOuter->first;
-    const WordCount &inWC = iterOuter->second;
-
-    const std::map<const std::string*, WordCount> &outColl = inWC.GetColl();
+  OutputBinary(m_pairS2T, m_countS2T, fileNameLexS2T);
+  OutputBinary(m_pairT2S, m_countT2S, fileNameLexT2S);
+}
 
-    std::map<const std::string*, WordCount>::const_iterator iterInner;
-    for (iterInner = outColl.begin(); iterInner != outColl.end(); ++iterInner)
-    {
-      const string &outStr = *iterInner->first;
-      const WordCount &outWC = iterInner->second;
+namespace
+{
+bool EntryKeyLess(const LexicalTable::Entry &a, const LexicalTable::Entry &b)
+{
+  return a.key < b.key;
+}
+} // namespace
 
-      float prob = outWC.GetCount() / inWC.GetCount();
-      outStream << outStr << " "  << inStr << " " << prob << endl;
-    }
+// p(predicted | given) for each pair, ordered by given then predicted id
+void ExtractLex::GetEntries(const PairCounts &pairs, const std::vector<float> &counts, std::vector<LexicalTable::Entry> &entries) const
+{
+  entries.clear();
+  entries.reserve(pairs.size());
+  for (PairCounts::const_iterator iter = pairs.begin(); iter != pairs.end(); ++iter) {
+    LexicalTable::Entry entry;
+    entry.key = iter->first;
+    entry.prob = iter->second / counts[iter->first >> 32];
+    entries.push_back(entry);
   }
+  std::sort(entries.begin(), entries.end(), EntryKeyLess);
 }
 
-std::ostream& operator<<(std::ostream &out, const WordCount &obj)
+void ExtractLex::Output(const PairCounts &pairs, const std::vector<float> &counts, std::ostream &outStream) const
 {
-  out << "(" << obj.GetCount() << ")";
-  return out;
+  std::vector<LexicalTable::Entry> entries;
+  GetEntries(pairs, counts, entries);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const string &inStr = m_vocab.vocab[entries[i].key >> 32];
+    const string &outStr = m_vocab.vocab[entries[i].key & 0xffffffff];
+    outStream << outStr << " "  << inStr << " " << entries[i].prob << "\n";
+  }
 }
 
-void WordCount::AddCount(float incr)
+void ExtractLex::OutputBinary(const PairCounts &pairs, const std::vector<float> &counts, const std::string &fileName) const
 {
-  m_count += incr;
+  std::vector<LexicalTable::Entry> entries;
+  GetEntries(pairs, counts, entries);
+  LexicalTable table;
+  table.Build(m_vocab.vocab, m_vocab.vocab, entries);
+  table.Save(fileName);
 }
 
 } // namespace
-
@@ -5,6 +5,12 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "LexicalTable.h"
+#include "tables-core.h"
 
 namespace MosesTraining
 {
@@ -63,58 +69,31 @@ inline void Tokenize( std::vector<T> &output
 	return Scan<T>(output, stringVector );
 }
 
-class WordCount
-{
-	friend std::ostream& operator<<(std::ostream&, const WordCount&);
-public:
-  float m_count;
-
-  std::map<const std::string*, WordCount> m_coll;
-
-  WordCount()
-    :m_count(0)
-  {}
-
-  //WordCount(const WordCount &copy);
-
-  WordCount(float count)
-    :m_count(count)
-  {}
-
-  void AddCount(float incr);
-
-  std::map<const std::string*, WordCount> &GetColl()
-  { return m_coll; }
-  const std::map<const std::string*, WordCount> &GetColl() const
-  { return m_coll; }
-
-  const float GetCount() const
-  { return m_count; }
-
-};
-
-class Vocab
-{
-  std::set<std::string> m_coll;
-public:
-  const std::string *GetOrAdd(const std::string &word);
-};
-
+// Counts of aligned word pairs, with words as ids.
 class ExtractLex
 {
-  Vocab m_vocab;
-  std::map<const std::string*, WordCount> m_collS2T, m_collT2S;
+  // one vocabulary for both languages
+  Vocabulary m_vocab;
+
+  // count(predicted, given) by LexicalTable::Key(given, predicted), and count(given)
+  typedef boost::unordered_map<uint64_t, float> PairCounts;
+  PairCounts m_pairS2T, m_pairT2S;
+  std::vector<float> m_countS2T, m_countT2S;
 
-  void Process(const std::string *target, const std::string *source);
-  void Process(WordCount &wcIn, const std::string *out);
+  void Process(WORD_ID target, WORD_ID source);
+  void Process(PairCounts &pairs, std::vector<float> &counts, WORD_ID given, WORD_ID predicted);
   void ProcessUnaligned(std::vector<std::string> &toksTarget, std::vector<std::string> &toksSource
                         , const std::vector<bool> &m_sourceAligned, const std::vector<bool> &m_targetAligned);
 
-  void Output(const std::map<const std::string*, WordCount> &coll, std::ofstream &outStream);
+  void GetEntries(const PairCounts &pairs, const std::vector<float> &counts, std::vector<LexicalTable::Entry> &entries) const;
+  void Output(const PairCounts &pairs, const std::vector<float> &counts, std::ostream &outStream) const;
+  void OutputBinary(const PairCounts &pairs, const std::vector<float> &counts, const std::string &fileName) const;
 
 public:
   void Process(std::vector<std::string> &toksTarget, std::vector<std::string> &toksSource, std::vector<std::string> &toksAlign, size_t lineCount);
-  void Output(std::ofstream &streamLexS2T, std::ofstream &streamLexT2S);
+  void Output(std::ostream &streamLexS2T, std::ostream &streamLexT2S) const;
+  // LexicalTable dumps instead of text
+  void OutputBinary(const std::string &fileNameLexS2T, const std::string &fileNameLexT2S) const;
 
 };
 
@@ -25,6 +25,7 @@
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
 #include "PhraseExtractionOptions.h"
+#include "PhrasePairBinary.h"
 
 using namespace std;
 using namespace MosesTraining;
@@ -79,15 +80,23 @@ typedef map <int, set<int> > HSentenceVertices;
 
 namespace MosesTraining{
 
+// Vocabularies and writers for --BinaryOutput.
+struct BinaryExtractOutput
+{
+  Vocabulary sourceVocab, targetVocab, labelVocab;
+  auto_ptr<PhrasePairWriter> extract, extractInv, extractOrientation;
+};
+
 class ExtractTask 
 {
 public:
-  ExtractTask(size_t id, SentenceAlignment &sentence,PhraseExtractionOptions &initoptions, Moses::OutputFileStream &extractFile, Moses::OutputFileStream &extractFileInv,Moses::OutputFileStream &extractFileOrientation):
+  ExtractTask(size_t id, SentenceAlignment &sentence,PhraseExtractionOptions &initoptions, Moses::OutputFileStream &extractFile, Moses::OutputFileStream &extractFileInv,Moses::OutputFileStream &extractFileOrientation, BinaryExtractOutput *binaryOutput = NULL):
     m_sentence(sentence),
     m_options(initoptions),
     m_extractFile(extractFile),
     m_extractFileInv(extractFileInv),
-    m_extractFileOrientation(extractFileOrientation){}
+    m_extractFileOrientation(extractFileOrientation),
+    m_binaryOutput(binaryOutput){}
 void Run();
 private:
   vector< string > m_extractedPhrases;
@@ -97,6 +106,7 @@ private:
   void extractBase(SentenceAlignment &);
   void extract(SentenceAlignment &);
   void addPhrase(SentenceAlignment &, int, int, int, int, string &);
+  void addPhraseBinary(SentenceAlignment &, int, int, int, int, string &);
   void writePhrasesToFile();
   
   SentenceAlignment &m_sentence;
@@ -104,6 +114,10 @@ private:
   Moses::OutputFileStream &m_extractFile;
   Moses::OutputFileStream &m_extractFileInv;
   Moses::OutputFileStream &m_extractFileOrientation;
+
+  BinaryExtractOutput *m_binaryOutput;
+  vector< WORD_ID > m_sourceIds, m_targetIds;
+  PhrasePairRecord m_record;
 };
 }
 
@@ -114,7 +128,7 @@ int main(int argc, char* argv[])
 
  if (argc < 6) {
     cerr << "syntax: extract en de align extract max-length [orientation [ --model [wbe|phrase|hier]-[msd|mslr|mono] ] ";
-    cerr<<"| --OnlyOutputSpanInfo | --NoTTable | --GZOutput | --IncludeSentenceId | --SentenceOffset n | --InstanceWeights filename ]\n";
+    cerr<<"| --OnlyOutputSpanInfo | --NoTTable | --GZOutput | --BinaryOutput | --IncludeSentenceId | --SentenceOffset n | --InstanceWeights filename ]\n";
     exit(1);
   }
 
@@ -144,6 +158,8 @@ int main(int argc, char* argv[])
       sentenceOffset = atoi(argv[++i]);
     } else if (strcmp(argv[i], "--GZOutput") == 0) {
       options.initGzOutput(true);  
+    } else if (strcmp(argv[i], "--BinaryOutput") == 0) {
+      options.initBinaryOutput(true);
     } else if (strcmp(argv[i], "--InstanceWeights") == 0) {
       if (i+1 >= argc) {
         cerr << "extract: syntax error, used switch --InstanceWeights without file name" << endl;
@@ -217,6 +233,11 @@ int main(int argc, char* argv[])
     options.initWordType(REO_MSD);
   }
 
+  if (options.isBinaryOutput() && options.isIncludeSentenceIdFlag()) {
+    cerr << "extract: --IncludeSentenceId is not supported with --BinaryOutput" << endl;
+    exit(1);
+  }
+
   // open input files
   Moses::InputFileStream eFile(fileNameE);
   Moses::InputFileStream fFile(fileNameF);
@@ -244,6 +265,18 @@ int main(int argc, char* argv[])
     extractFileOrientation.Open(fileNameExtractOrientation.c_str());
   }
 
+  auto_ptr<BinaryExtractOutput> binaryOutput;
+  if (options.isBinaryOutput() && !options.isOnlyOutputSpanInfo()) {
+    binaryOutput.reset(new BinaryExtractOutput());
+    if (options.isTranslationFlag()) {
+      binaryOutput->extract.reset(new PhrasePairWriter(extractFile, binaryOutput->sourceVocab, binaryOutput->targetVocab, binaryOutput->labelVocab));
+      binaryOutput->extractInv.reset(new PhrasePairWriter(extractFileInv, binaryOutput->targetVocab, binaryOutput->sourceVocab, binaryOutput->labelVocab));
+    }
+    if (options.isOrientationFlag()) {
+      binaryOutput->extractOrientation.reset(new PhrasePairWriter(extractFileOrientation, binaryOutput->sourceVocab, binaryOutput->targetVocab, binaryOutput->labelVocab));
+    }
+  }
+
   int i = sentenceOffset;
   while(true) {
     i++;
@@ -269,7 +302,7 @@ int main(int argc, char* argv[])
       cout << "LOG: PHRASES_BEGIN:" << endl;
     }
 	if (sentence.create( englishString, foreignString, alignmentString, weightString, i, false)) {
-   	ExtractTask *task = new ExtractTask(i-1, sentence, options, extractFile , extractFileInv, extractFileOrientation);
+   	ExtractTask *task = new ExtractTask(i-1, sentence, options, extractFile , extractFileInv, extractFileOrientation, binaryOutput.get());
       task->Run();
       delete task;
 
@@ -281,6 +314,9 @@ int main(int argc, char* argv[])
   fFile.Close();
   aFile.Close();
 
+  // flush binary records before the files are closed
+  binaryOutput.reset();
+
   //az: only close if we actually opened it
   if (!options.isOnlyOutputSpanInfo()) {
     if (options.isTranslationFlag()) {
@@ -297,6 +333,14 @@ int main(int argc, char* argv[])
 namespace MosesTraining
 {
 void ExtractTask::Run() {
+  if (m_binaryOutput) {
+    m_sourceIds.resize(m_sentence.source.size());
+    for (size_t fi = 0; fi < m_sentence.source.size(); ++fi)
+      m_sourceIds[fi] = m_binaryOutput->sourceVocab.storeIfNew(m_sentence.source[fi]);
+    m_targetIds.resize(m_sentence.target.size());
+    for (size_t ei = 0; ei < m_sentence.target.size(); ++ei)
+      m_targetIds[ei] = m_binaryOutput->targetVocab.storeIfNew(m_sentence.target[ei]);
+  }
   extract(m_sentence);
   writePhrasesToFile();
   m_extractedPhrases.clear();
@@ -308,7 +352,6 @@ void ExtractTask::Run() {
 
 void ExtractTask::extract(SentenceAlignment &sentence)
 {
-  int countE = sentence.target.size();
   int countF = sentence.source.size();
 
   HPhraseVector inboundPhrases;
@@ -328,82 +371,38 @@ void ExtractTask::extract(SentenceAlignment &sentence)
   bool relaxLimit = m_options.isHierModel();
   bool buildExtraStructure = m_options.isPhraseModel() || m_options.isHierModel();
 
-  // check alignments for target phrase startE...endE
   // loop over extracted phrases which are compatible with the word-alignments
-  for(int startE=0; startE<countE; startE++) {
-    for(int endE=startE;
-        (endE<countE && (relaxLimit || endE<startE+m_options.maxPhraseLength));
-        endE++) {
-
-      int minF = 9999;
-      int maxF = -1;
-      vector< int > usedF = sentence.alignedCountS;
-      for(int ei=startE; ei<=endE; ei++) {
-        for(size_t i=0; i<sentence.alignedToT[ei].size(); i++) {
-          int fi = sentence.alignedToT[ei][i];
-          if (fi<minF) {
-            minF = fi;
-          }
-          if (fi>maxF) {
-            maxF = fi;
-          }
-          usedF[ fi ]--;
-        }
-      }
-
-      if (maxF >= 0 && // aligned to any source words at all
-          (relaxLimit || maxF-minF < m_options.maxPhraseLength)) { // source phrase within limits
-
-        // check if source words are aligned to out of bound target words
-        bool out_of_bounds = false;
-        for(int fi=minF; fi<=maxF && !out_of_bounds; fi++)
-          if (usedF[fi]>0) {
-            // cout << "ouf of bounds: " << fi << "\n";
-            out_of_bounds = true;
-          }
-
-        // cout << "doing if for ( " << minF << "-" << maxF << ", " << startE << "," << endE << ")\n";
-        if (!out_of_bounds) {
-          // start point of source phrase may retreat over unaligned
-          for(int startF=minF;
-              (startF>=0 &&
-               (relaxLimit || startF>maxF-m_options.maxPhraseLength) && // within length limit
-               (startF==minF || sentence.alignedCountS[startF]==0)); // unaligned
-              startF--)
-            // end point of source phrase may advance over unaligned
-            for(int endF=maxF;
-                (endF<countF &&
-                 (relaxLimit || endF<startF+m_options.maxPhraseLength) && // within length limit
-                 (endF==maxF || sentence.alignedCountS[endF]==0)); // unaligned
-                endF++) { // at this point we have extracted a phrase
-              if(buildExtraStructure) { // phrase || hier
-                if(endE-startE < m_options.maxPhraseLength && endF-startF < m_options.maxPhraseLength) { // within limit
-                  inboundPhrases.push_back(HPhrase(HPhraseVertex(startF,startE),
-                                                   HPhraseVertex(endF,endE)));
-                  insertPhraseVertices(inTopLeft, inTopRight, inBottomLeft, inBottomRight,
-                                       startF, startE, endF, endE);
-                } else
-                  insertPhraseVertices(outTopLeft, outTopRight, outBottomLeft, outBottomRight,
-                                       startF, startE, endF, endE);
-              } else {
-                string orientationInfo = "";
-                if(m_options.isWordModel()) {
-                  REO_POS wordPrevOrient, wordNextOrient;
-                  bool connectedLeftTopP  = isAligned( sentence, startF-1, startE-1 );
-                  bool connectedRightTopP = isAligned( sentence, endF+1,   startE-1 );
-                  bool connectedLeftTopN  = isAligned( sentence, endF+1, endE+1 );
-                  bool connectedRightTopN = isAligned( sentence, startF-1,   endE+1 );
-                  wordPrevOrient = getOrientWordModel(sentence, m_options.isWordType(), connectedLeftTopP, connectedRightTopP, startF, endF, startE, endE, countF, 0, 1, &ge, &lt);
-                  wordNextOrient = getOrientWordModel(sentence, m_options.isWordType(), connectedLeftTopN, connectedRightTopN, endF, startF, endE, startE, 0, countF, -1, &lt, &ge);
-                  orientationInfo += getOrientString(wordPrevOrient, m_options.isWordType()) + " " + getOrientString(wordNextOrient, m_options.isWordType());
-                  if(m_options.isAllModelsOutputFlag())
-                    " | | ";
-                }
-                addPhrase(sentence, startE, endE, startF, endF, orientationInfo);
-              }
-            }
-        }
+  vector<PhrasePairSpan> phrasePairs;
+  sentence.findConsistentPhrasePairs(m_options.maxPhraseLength, relaxLimit, phrasePairs);
+  for(size_t i = 0; i < phrasePairs.size(); i++) { // at this point we have extracted a phrase
+    int startE = phrasePairs[i].startE;
+    int endE = phrasePairs[i].endE;
+    int startF = phrasePairs[i].startF;
+    int endF = phrasePairs[i].endF;
+    if(buildExtraStructure) { // phrase || hier
+      if(endE-startE < m_options.maxPhraseLength && endF-startF < m_options.maxPhraseLength) { // within limit
+        inboundPhrases.push_back(HPhrase(HPhraseVertex(startF,startE),
+                                         HPhraseVertex(endF,endE)));
+        insertPhraseVertices(inTopLeft, inTopRight, inBottomLeft, inBottomRight,
+                             startF, startE, endF, endE);
+      } else
+        insertPhraseVertices(outTopLeft, outTopRight, outBottomLeft, outBottomRight,
+                             startF, startE, endF, endE);
+    } else {
+      string orientationInfo = "";
+      if(m_options.isWordModel()) {
+        REO_POS wordPrevOrient, wordNextOrient;
+        bool connectedLeftTopP  = isAligned( sentence, startF-1, startE-1 );
+        bool connectedRightTopP = isAligned( sentence, endF+1,   startE-1 );
+        bool connectedLeftTopN  = isAligned( sentence, endF+1, endE+1 );
+        bool connectedRightTopN = isAligned( sentence, startF-1,   endE+1 );
+        wordPrevOrient = getOrientWordModel(sentence, m_options.isWordType(), connectedLeftTopP, connectedRightTopP, startF, endF, startE, endE, countF, 0, 1, &ge, &lt);
+        wordNextOrient = getOrientWordModel(sentence, m_options.isWordType(), connectedLeftTopN, connectedRightTopN, endF, startF, endE, startE, 0, countF, -1, &lt, &ge);
+        orientationInfo += getOrientString(wordPrevOrient, m_options.isWordType()) + " " + getOrientString(wordNextOrient, m_options.isWordType());
+        if(m_options.isAllModelsOutputFlag())
+          " | | ";
       }
+      addPhrase(sentence, startE, endE, startF, endF, orientationInfo);
     }
   }
 
@@ -674,6 +673,11 @@ void ExtractTask::addPhrase( SentenceAlignment &sentence, int startE, int endE,
     return;
   }
 
+  if (m_binaryOutput) {
+    addPhraseBinary(sentence, startE, endE, startF, endF, orientationInfo);
+    return;
+  }
+
 for(int fi=startF; fi<=endF; fi++) {
     if (m_options.isTranslationFlag()) outextractstr << sentence.source[fi] << " ";
     if (m_options.isOrientationFlag()) outextractstrOrientation << sentence.source[fi] << " ";
@@ -738,6 +742,42 @@ for(int fi=startF; fi<=endF; fi++) {
 }
 
 
+// same content as addPhrase, written as binary records
+void ExtractTask::addPhraseBinary( SentenceAlignment &sentence, int startE, int endE, int startF, int endF , string &orientationInfo)
+{
+  PhrasePairRecord &record = m_record;
+  record.clear();
+  if (m_options.getInstanceWeightsFile().length()) {
+    record.counts.push_back(atof(sentence.weightString.c_str()));
+  }
+
+  if (m_options.isTranslationFlag()) {
+    record.source.assign(m_sourceIds.begin() + startF, m_sourceIds.begin() + endF + 1);
+    record.target.assign(m_targetIds.begin() + startE, m_targetIds.begin() + endE + 1);
+    for(int ei=startE; ei<=endE; ei++) {
+      for(unsigned int i=0; i<sentence.alignedToT[ei].size(); i++) {
+        int fi = sentence.alignedToT[ei][i];
+        record.alignment.push_back(make_pair(fi-startF, ei-startE));
+      }
+    }
+    m_binaryOutput->extract->Write(record);
+
+    record.source.swap(record.target);
+    for (size_t i = 0; i < record.alignment.size(); ++i) {
+      std::swap(record.alignment[i].first, record.alignment[i].second);
+    }
+    m_binaryOutput->extractInv->Write(record);
+  }
+
+  if (m_options.isOrientationFlag()) {
+    record.source.assign(m_sourceIds.begin() + startF, m_sourceIds.begin() + endF + 1);
+    record.target.assign(m_targetIds.begin() + startE, m_targetIds.begin() + endE + 1);
+    record.alignment.clear();
+    record.labels.push_back(m_binaryOutput->labelVocab.storeIfNew(orientationInfo));
+    m_binaryOutput->extractOrientation->Write(record);
+  }
+}
+
 void ExtractTask::writePhrasesToFile(){
 
     ostringstream outextractFile;
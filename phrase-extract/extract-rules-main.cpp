@@ -45,10 +45,19 @@
 #include "tables-core.h"
 #include "XmlTree.h"
 #include "InputFileStream.h"
+#include "OrderedBatchWriter.h"
 #include "OutputFileStream.h"
+#include "moses/ThreadPool.h"
+#include "util/murmur_hash.hh"
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
 
 #define LINE_MAX_LENGTH 500000
 
+// sentence pairs extracted by one task
+#define SENTENCE_BATCH_SIZE 100
+
 using namespace std;
 using namespace MosesTraining;
 
@@ -60,10 +69,14 @@ class ExtractTask
 private:
   SentenceAlignmentWithSyntax &m_sentence;
   const RuleExtractionOptions &m_options;
-  Moses::OutputFileStream& m_extractFile;
-  Moses::OutputFileStream& m_extractFileInv;
+  ostream& m_extractFile;
+  ostream& m_extractFileInv;
 
   vector< ExtractedRule > m_extractedRules;
+
+  // m_extractedRules by signature of source and target
+  typedef boost::unordered_multimap< uint64_t, size_t > RuleIndex;
+  RuleIndex m_ruleIndex;
   
   // main functions
   void extractRules();
@@ -87,15 +100,20 @@ private:
                            , const WordIndex &indexS, const WordIndex &indexT, HoleCollection &holeColl, ExtractedRule &rule);
   void saveAllHieroPhrases( int startT, int endT, int startS, int endS, HoleCollection &holeColl, int countS);
   
-  inline string IntToString( int i )
+  // appends "s-t " to the alignment, and "t-s " to the inverse alignment
+  inline void addAlignmentPoint( ExtractedRule &rule, int s, int t )
   {
-    stringstream out;
-    out << i;
-    return out.str();
+    char point[32];
+    int length = sprintf(point, "%d-%d ", s, t);
+    rule.alignment.append(point, length);
+    if (!m_options.onlyDirectFlag) {
+      length = sprintf(point, "%d-%d ", t, s);
+      rule.alignmentInv.append(point, length);
+    }
   }
 
 public:
-  ExtractTask(SentenceAlignmentWithSyntax &sentence, const RuleExtractionOptions &options, Moses::OutputFileStream &extractFile, Moses::OutputFileStream &extractFileInv):
+  ExtractTask(SentenceAlignmentWithSyntax &sentence, const RuleExtractionOptions &options, ostream &extractFile, ostream &extractFileInv):
     m_sentence(sentence),
     m_options(options),
     m_extractFile(extractFile),
@@ -104,8 +122,71 @@ public:
 
 };
 
+// Sentence pairs read by the main thread, and what extracting rules from
+// them adds to the extract files and label statistics.  Kept until it is
+// their turn to be written.
+struct SentenceBatch {
+  vector< size_t > sentenceIDs;
+  vector< string > targetLines, sourceLines, alignmentLines;
+
+  ostringstream extract, extractInv;
+  set< string > targetLabelCollection, sourceLabelCollection;
+  map< string, int > targetTopLabelCollection, sourceTopLabelCollection;
+  map< string, int > wordCount;
+  map< string, string > wordLabel;
+};
+
+// Writes a batch, once it is its turn, and adds its label statistics to the
+// totals.
+class BatchSink
+{
+public:
+  BatchSink(ostream &extractFile, ostream &extractFileInv,
+            set< string > &targetLabelCollection, set< string > &sourceLabelCollection,
+            map< string, int > &targetTopLabelCollection, map< string, int > &sourceTopLabelCollection)
+    : m_extractFile(extractFile), m_extractFileInv(extractFileInv),
+      m_targetLabelCollection(targetLabelCollection), m_sourceLabelCollection(sourceLabelCollection),
+      m_targetTopLabelCollection(targetTopLabelCollection), m_sourceTopLabelCollection(sourceTopLabelCollection) {}
+
+  void operator()(SentenceBatch &batch);
+
+private:
+  ostream &m_extractFile;
+  ostream &m_extractFileInv;
+  set< string > &m_targetLabelCollection, &m_sourceLabelCollection;
+  map< string, int > &m_targetTopLabelCollection, &m_sourceTopLabelCollection;
+};
+
+// Writes batches in the order they were read.
+typedef OrderedBatchWriter< SentenceBatch, BatchSink > BatchWriter;
+
+void extractBatch(SentenceBatch &batch, const RuleExtractionOptions &options);
+
+#ifdef WITH_THREADS
+// A batch of sentence pairs, extracted on a worker thread.
+class BatchTask : public Moses::Task
+{
+public:
+  BatchTask(size_t id, SentenceBatch *batch, const RuleExtractionOptions &options, BatchWriter &writer)
+    : m_id(id), m_batch(batch), m_options(options), m_writer(writer) {}
+
+  void Run() {
+    extractBatch(*m_batch, m_options);
+    m_writer.Write(m_id, m_batch);
+  }
+
+private:
+  size_t m_id;
+  SentenceBatch *m_batch;
+  const RuleExtractionOptions &m_options;
+  BatchWriter &m_writer;
+};
+#endif
+
 // stats for glue grammar and unknown word label probabilities
-void collectWordLabelCounts(SentenceAlignmentWithSyntax &sentence );
+map<string,int> wordCount;
+map<string,string> wordLabel;
+void collectWordLabelCounts(SentenceAlignmentWithSyntax &sentence, map<string,int> &wordCount, map<string,string> &wordLabel );
 void writeGlueGrammar(const string &, RuleExtractionOptions &options, set< string > &targetLabelCollection, map< string, int > &targetTopLabelCollection);
 void writeUnknownWordLabel(const string &);
 
@@ -312,41 +393,56 @@ int main(int argc, char* argv[])
   set< string > targetLabelCollection, sourceLabelCollection;
   map< string, int > targetTopLabelCollection, sourceTopLabelCollection;
 
-  // loop through all sentence pairs
-  size_t i=sentenceOffset;
-  while(true) {
-    i++;
-    if (i%1000 == 0) cerr << i << " " << flush;
-
-    char targetString[LINE_MAX_LENGTH];
-    char sourceString[LINE_MAX_LENGTH];
-    char alignmentString[LINE_MAX_LENGTH];
-    SAFE_GETLINE((*tFileP), targetString, LINE_MAX_LENGTH, '\n', __FILE__);
-    if (tFileP->eof()) break;
-    SAFE_GETLINE((*sFileP), sourceString, LINE_MAX_LENGTH, '\n', __FILE__);
-    SAFE_GETLINE((*aFileP), alignmentString, LINE_MAX_LENGTH, '\n', __FILE__);
+#ifdef WITH_THREADS
+  // span info is printed as rules are extracted, so it needs sentence order
+  if (options.onlyOutputSpanInfo) thread_count = 1;
+  Moses::ThreadPool *pool = NULL;
+  if (thread_count > 1) {
+    pool = new Moses::ThreadPool(thread_count);
+    pool->SetQueueLimit(thread_count * 2);
+  }
+#endif
+  BatchSink sink(extractFile, extractFileInv,
+                 targetLabelCollection, sourceLabelCollection,
+                 targetTopLabelCollection, sourceTopLabelCollection);
+  BatchWriter writer(sink);
 
-    SentenceAlignmentWithSyntax sentence
-      (targetLabelCollection, sourceLabelCollection, 
-       targetTopLabelCollection, sourceTopLabelCollection, options);
-    //az: output src, tgt, and alingment line
-    if (options.onlyOutputSpanInfo) {
-      cout << "LOG: SRC: " << sourceString << endl;
-      cout << "LOG: TGT: " << targetString << endl;
-      cout << "LOG: ALT: " << alignmentString << endl;
-      cout << "LOG: PHRASES_BEGIN:" << endl;
+  // loop through all sentence pairs, a batch at a time
+  size_t i=sentenceOffset;
+  char targetString[LINE_MAX_LENGTH];
+  char sourceString[LINE_MAX_LENGTH];
+  char alignmentString[LINE_MAX_LENGTH];
+  for(size_t batchID = 0; !tFileP->eof(); batchID++) {
+    SentenceBatch *batch = new SentenceBatch;
+    while(batch->sentenceIDs.size() < SENTENCE_BATCH_SIZE) {
+      SAFE_GETLINE((*tFileP), targetString, LINE_MAX_LENGTH, '\n', __FILE__);
+      if (tFileP->eof()) break;
+      SAFE_GETLINE((*sFileP), sourceString, LINE_MAX_LENGTH, '\n', __FILE__);
+      SAFE_GETLINE((*aFileP), alignmentString, LINE_MAX_LENGTH, '\n', __FILE__);
+      i++;
+      if (i%1000 == 0) cerr << i << " " << flush;
+
+      batch->sentenceIDs.push_back(i);
+      batch->targetLines.push_back(targetString);
+      batch->sourceLines.push_back(sourceString);
+      batch->alignmentLines.push_back(alignmentString);
     }
 
-    if (sentence.create(targetString, sourceString, alignmentString,"", i, options.boundaryRules)) {
-      if (options.unknownWordLabelFlag) {
-        collectWordLabelCounts(sentence);
-      }
-      ExtractTask *task = new ExtractTask(sentence, options, extractFile, extractFileInv);
-      task->Run();
-      delete task;
+#ifdef WITH_THREADS
+    if (pool) {
+      pool->Submit(new BatchTask(batchID, batch, options, writer));
+      continue;
     }
-    if (options.onlyOutputSpanInfo) cout << "LOG: PHRASES_END:" << endl; //az: mark end of phrases
+#endif
+    extractBatch(*batch, options);
+    writer.Write(batchID, batch);
   }
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+    delete pool;
+  }
+#endif
 
   tFile.Close();
   sFile.Close();
@@ -364,11 +460,60 @@ int main(int argc, char* argv[])
     writeUnknownWordLabel(fileNameUnknownWordLabel);
 }
 
+void extractBatch(SentenceBatch &batch, const RuleExtractionOptions &options)
+{
+  for(size_t i = 0; i < batch.sentenceIDs.size(); i++) {
+    SentenceAlignmentWithSyntax sentence
+      (batch.targetLabelCollection, batch.sourceLabelCollection,
+       batch.targetTopLabelCollection, batch.sourceTopLabelCollection, options);
+    //az: output src, tgt, and alingment line
+    if (options.onlyOutputSpanInfo) {
+      cout << "LOG: SRC: " << batch.sourceLines[i] << endl;
+      cout << "LOG: TGT: " << batch.targetLines[i] << endl;
+      cout << "LOG: ALT: " << batch.alignmentLines[i] << endl;
+      cout << "LOG: PHRASES_BEGIN:" << endl;
+    }
+
+    if (sentence.create(&batch.targetLines[i][0], &batch.sourceLines[i][0], &batch.alignmentLines[i][0], "", batch.sentenceIDs[i], options.boundaryRules)) {
+      if (options.unknownWordLabelFlag) {
+        collectWordLabelCounts(sentence, batch.wordCount, batch.wordLabel);
+      }
+      ExtractTask task(sentence, options, batch.extract, batch.extractInv);
+      task.Run();
+    }
+    if (options.onlyOutputSpanInfo) cout << "LOG: PHRASES_END:" << endl; //az: mark end of phrases
+  }
+
+  batch.targetLines.clear();
+  batch.sourceLines.clear();
+  batch.alignmentLines.clear();
+}
+
+void BatchSink::operator()(SentenceBatch &batch)
+{
+  m_extractFile << batch.extract.str();
+  m_extractFileInv << batch.extractInv.str();
+
+  m_targetLabelCollection.insert(batch.targetLabelCollection.begin(), batch.targetLabelCollection.end());
+  m_sourceLabelCollection.insert(batch.sourceLabelCollection.begin(), batch.sourceLabelCollection.end());
+  typedef map< string, int >::const_iterator I;
+  for(I label = batch.targetTopLabelCollection.begin(); label != batch.targetTopLabelCollection.end(); label++)
+    m_targetTopLabelCollection[ label->first ] += label->second;
+  for(I label = batch.sourceTopLabelCollection.begin(); label != batch.sourceTopLabelCollection.end(); label++)
+    m_sourceTopLabelCollection[ label->first ] += label->second;
+
+  for(I word = batch.wordCount.begin(); word != batch.wordCount.end(); word++)
+    wordCount[ word->first ] += word->second;
+  for(map< string, string >::const_iterator word = batch.wordLabel.begin(); word != batch.wordLabel.end(); word++)
+    wordLabel[ word->first ] = word->second;
+}
+
 void ExtractTask::Run() {
   extractRules();
   consolidateRules();
   writeRulesToFile();
   m_extractedRules.clear();
+  m_ruleIndex.clear();
 }
 
 void ExtractTask::extractRules()
@@ -623,11 +768,7 @@ void ExtractTask::saveHieroAlignment( int startT, int endT, int startS, int endS
     if (p != indexT.end()) { // does word still exist?
       for(unsigned int i=0; i<m_sentence.alignedToT[ti].size(); i++) {
         int si = m_sentence.alignedToT[ti][i];
-        std::string sourceSymbolIndex = IntToString(indexS.find(si)->second);
-        std::string targetSymbolIndex = IntToString(p->second);
-        rule.alignment      += sourceSymbolIndex + "-" + targetSymbolIndex + " ";
-        if (! m_options.onlyDirectFlag)
-          rule.alignmentInv += targetSymbolIndex + "-" + sourceSymbolIndex + " ";
+        addAlignmentPoint(rule, indexS.find(si)->second, p->second);
       }
     }
   }
@@ -636,13 +777,9 @@ void ExtractTask::saveHieroAlignment( int startT, int endT, int startS, int endS
   HoleList::const_iterator iterHole;
   for (iterHole = holeColl.GetHoles().begin(); iterHole != holeColl.GetHoles().end(); ++iterHole) {
     const Hole &hole = *iterHole;
-        
-    std::string sourceSymbolIndex = IntToString(hole.GetPos(0));
-    std::string targetSymbolIndex = IntToString(hole.GetPos(1));
-    rule.alignment      += sourceSymbolIndex + "-" + targetSymbolIndex + " ";
-    if (!m_options.onlyDirectFlag)
-      rule.alignmentInv += targetSymbolIndex + "-" + sourceSymbolIndex + " ";
-  
+
+    addAlignmentPoint(rule, hole.GetPos(0), hole.GetPos(1));
+
     rule.SetSpanLength(hole.GetPos(0), hole.GetSize(0), hole.GetSize(1) ) ;
 
   }
@@ -932,11 +1069,7 @@ void ExtractTask::addRule( int startT, int endT, int startS, int endS, int count
   for(int ti=startT; ti<=endT; ti++) {
     for(unsigned int i=0; i<m_sentence.alignedToT[ti].size(); i++) {
       int si = m_sentence.alignedToT[ti][i];
-      std::string sourceSymbolIndex = IntToString(si-startS);
-      std::string targetSymbolIndex = IntToString(ti-startT);
-      rule.alignment += sourceSymbolIndex + "-" + targetSymbolIndex + " ";
-      if (!m_options.onlyDirectFlag)
-        rule.alignmentInv += targetSymbolIndex + "-" + sourceSymbolIndex + " ";
+      addAlignmentPoint(rule, si-startS, ti-startT);
     }
   }
 
@@ -947,50 +1080,94 @@ void ExtractTask::addRule( int startT, int endT, int startS, int endS, int count
   addRuleToCollection( rule );
 }
 
+namespace
+{
+uint64_t ruleSignature(const ExtractedRule &rule)
+{
+  uint64_t hash = util::MurmurHashNative(rule.source.data(), rule.source.size());
+  return util::MurmurHashNative(rule.target.data(), rule.target.size(), hash);
+}
+
+// identifies the span of a rule, for fractional counting
+struct SpanKey {
+  int startT, endT, startS, endS;
+
+  explicit SpanKey(const ExtractedRule &rule)
+    : startT(rule.startT), endT(rule.endT), startS(rule.startS), endS(rule.endS) {}
+
+  bool operator==(const SpanKey &other) const {
+    return startT == other.startT && endT == other.endT && startS == other.startS && endS == other.endS;
+  }
+};
+
+size_t hash_value(const SpanKey &key)
+{
+  size_t seed = 0;
+  boost::hash_combine(seed, key.startT);
+  boost::hash_combine(seed, key.endT);
+  boost::hash_combine(seed, key.startS);
+  boost::hash_combine(seed, key.endS);
+  return seed;
+}
+} // namespace
+
 void ExtractTask::addRuleToCollection( ExtractedRule &newRule )
 {
+  const uint64_t signature = ruleSignature(newRule);
 
   // no double-counting of identical rules from overlapping spans
   if (!m_options.duplicateRules) {
-    vector<ExtractedRule>::const_iterator rule;
-    for(rule = m_extractedRules.begin(); rule != m_extractedRules.end(); rule++ ) {
-      if (rule->source.compare( newRule.source ) == 0 &&
-          rule->target.compare( newRule.target ) == 0 &&
-          !(rule->endT < newRule.startT || rule->startT > newRule.endT)) { // overlapping
+    std::pair<RuleIndex::const_iterator, RuleIndex::const_iterator> same = m_ruleIndex.equal_range(signature);
+    for(RuleIndex::const_iterator i = same.first; i != same.second; ++i) {
+      const ExtractedRule &rule = m_extractedRules[i->second];
+      if (!(rule.endT < newRule.startT || rule.startT > newRule.endT) && // overlapping
+          rule.source == newRule.source &&
+          rule.target == newRule.target) {
         return;
       }
     }
   }
+  m_ruleIndex.insert(std::make_pair(signature, m_extractedRules.size()));
   m_extractedRules.push_back( newRule );
 }
 
 void ExtractTask::consolidateRules()
 {
   typedef vector<ExtractedRule>::iterator R;
-  map<int, map<int, map<int, map<int,int> > > > spanCount;
+  boost::unordered_map<SpanKey, int> spanCount;
 
   // compute number of rules per span
   if (m_options.fractionalCounting) {
     for(R rule = m_extractedRules.begin(); rule != m_extractedRules.end(); rule++ ) {
-      spanCount[ rule->startT ][ rule->endT ][ rule->startS ][ rule->endS ]++;
+      spanCount[ SpanKey(*rule) ]++;
     }
   }
 
   // compute fractional counts
   for(R rule = m_extractedRules.begin(); rule != m_extractedRules.end(); rule++ ) {
-    rule->count =    1.0/(float) (m_options.fractionalCounting ? spanCount[ rule->startT ][ rule->endT ][ rule->startS ][ rule->endS ] : 1.0 );
-  }
-
-  // consolidate counts
-  map<std::string, map< std::string, map< std::string, float> > > consolidatedCount;
-  for(R rule = m_extractedRules.begin(); rule != m_extractedRules.end(); rule++ ) {
-    consolidatedCount[ rule->source ][ rule->target][ rule->alignment ] += rule->count;
+    rule->count =    1.0/(float) (m_options.fractionalCounting ? spanCount[ SpanKey(*rule) ] : 1.0 );
   }
 
-  for(R rule = m_extractedRules.begin(); rule != m_extractedRules.end(); rule++ ) {
-    float count = consolidatedCount[ rule->source ][ rule->target][ rule->alignment ];
-    rule->count = count;
-    consolidatedCount[ rule->source ][ rule->target][ rule->alignment ] = 0;
+  // consolidate counts: the first occurrence of a rule with the same
+  // alignment gets the sum, the others get 0 and are not written
+  typedef boost::unordered_multimap< uint64_t, size_t > FirstIndex;
+  FirstIndex first;
+  for(size_t i = 0; i < m_extractedRules.size(); ++i) {
+    ExtractedRule &rule = m_extractedRules[i];
+    const uint64_t hash = util::MurmurHashNative(rule.alignment.data(), rule.alignment.size(), ruleSignature(rule));
+    std::pair<FirstIndex::const_iterator, FirstIndex::const_iterator> same = first.equal_range(hash);
+    FirstIndex::const_iterator found = same.first;
+    for(; found != same.second; ++found) {
+      const ExtractedRule &other = m_extractedRules[found->second];
+      if (other.source == rule.source && other.target == rule.target && other.alignment == rule.alignment)
+        break;
+    }
+    if (found == same.second) {
+      first.insert(std::make_pair(hash, i));
+    } else {
+      m_extractedRules[found->second].count += rule.count;
+      rule.count = 0;
+    }
   }
 }
 
@@ -1067,9 +1244,7 @@ void writeGlueGrammar( const string & fileName, RuleExtractionOptions &options,
 // ( labels of singleton words are used to estimate
 //   distribution oflabels for unknown words )
 
-map<string,int> wordCount;
-map<string,string> wordLabel;
-void collectWordLabelCounts( SentenceAlignmentWithSyntax &sentence )
+void collectWordLabelCounts( SentenceAlignmentWithSyntax &sentence, map<string,int> &wordCount, map<string,string> &wordLabel )
 {
   int countT = sentence.target.size();
   for(int ti=0; ti < countT; ti++) {
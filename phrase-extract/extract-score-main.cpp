@@ -0,0 +1,1109 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+/* Phrase extraction and scoring in one process.  This produces the same
+ * phrase table as
+ *   extract e f a extract max-length
+ *   LC_ALL=C sort extract | score - lex.f2e half.f2e
+ *   LC_ALL=C sort extract.inv | score - lex.e2f half.e2f --Inverse
+ *   LC_ALL=C sort half.e2f | consolidate half.f2e - phrase-table
+ * without the intermediate text files.  Only words are interned in memory.
+ * Each extracted phrase pair is a fixed-size record of word ids and an
+ * alignment bitmask, sized by max-length, that util/stream sorts twice: by
+ * target phrase to count count(e), as score --Inverse does, then by source
+ * phrase to score, as score does.  Text is only written for the final table.
+ * Only the phrase table is produced; lexicalized reordering still needs
+ * extract's extract.o.
+ *
+ * With --LossyCounting, phrase pairs are counted in memory by lossy counting
+ * (see LossyCounter.h) instead of being written out, and only pairs that pass
+ * its support threshold are scored, as contrib/eppex does.  Memory then stays
+ * bounded however large the corpus is, and counts are approximate within the
+ * given error.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "util/file.hh"
+#include "util/murmur_hash.hh"
+#include "util/scoped.hh"
+#include "util/string_piece_hash.hh"
+#include "util/stream/chain.hh"
+#include "util/stream/io.hh"
+#include "util/stream/sort.hh"
+#include "util/stream/stream.hh"
+#include "util/usage.hh"
+
+#include "InputFileStream.h"
+#include "LexicalTable.h"
+#include "LossyCounter.h"
+#include "OutputFileStream.h"
+#include "SafeGetline.h"
+#include "SentenceAlignment.h"
+#include "tables-core.h"
+
+using namespace std;
+using namespace MosesTraining;
+
+#define LINE_MAX_LENGTH 500000
+
+namespace MosesTraining
+{
+namespace
+{
+
+typedef uint32_t ID;
+
+// Words of one language.
+class WordVocab : boost::noncopyable
+{
+public:
+  ID Intern(const string &word) {
+    pair<Lookup::iterator, bool> ret = m_lookup.insert(make_pair(word, static_cast<ID>(m_words.size())));
+    if (ret.second) m_words.push_back(word);
+    return ret.first->second;
+  }
+
+  const string &Word(ID id) const {
+    return m_words[id];
+  }
+
+  ID Size() const {
+    return m_words.size();
+  }
+
+private:
+  typedef boost::unordered_map<string, ID> Lookup;
+  Lookup m_lookup;
+  vector<string> m_words;
+};
+
+struct WordTextLess {
+  explicit WordTextLess(const WordVocab &vocab) : m_vocab(vocab) {}
+  bool operator()(ID a, ID b) const {
+    return m_vocab.Word(a) < m_vocab.Word(b);
+  }
+  const WordVocab &m_vocab;
+};
+
+// Sorted position of each id and the id at each position.
+struct Ranking {
+  vector<ID> rank, order;
+
+  template <class Less> void Build(ID size, const Less &less) {
+    order.resize(size);
+    for (ID i = 0; i < size; ++i) order[i] = i;
+    sort(order.begin(), order.end(), less);
+    rank.resize(size);
+    for (ID i = 0; i < size; ++i) rank[order[i]] = i;
+  }
+};
+
+const string kSeparator("|||");
+
+// Ranks below low sort before "|||" and ranks from high on after it.
+struct SeparatorRanks {
+  ID low, high;
+};
+
+/* Ranks words bytewise, so phrases of ranks sort like their text.  Sorted
+ * extract lines continue each phrase with " |||", so where the separator
+ * falls among the words is kept too.
+ */
+struct WordRanking : public Ranking {
+  void Build(const WordVocab &vocab) {
+    Ranking::Build(vocab.Size(), WordTextLess(vocab));
+    separator.low = separator.high = 0;
+    while (separator.low < order.size() && vocab.Word(order[separator.low]) < kSeparator) ++separator.low;
+    separator.high = separator.low;
+    while (separator.high < order.size() && vocab.Word(order[separator.high]) == kSeparator) ++separator.high;
+  }
+
+  SeparatorRanks separator;
+};
+
+// An alignment point within a phrase pair: source position << 8 | target position.
+typedef uint16_t AlignmentPoint;
+const size_t kMaxPhraseLength = 256;
+
+inline size_t PointSource(AlignmentPoint p) {
+  return p >> 8;
+}
+inline size_t PointTarget(AlignmentPoint p) {
+  return p & 0xff;
+}
+
+/* Ranks the alignment points of phrases up to max-length by their text "s-t "
+ * as score prints them.  No point's text is a prefix of another's, so
+ * alignments compared point by point by rank sort like their text.  The
+ * inverse rank is that of the text "t-s " in extract.inv.
+ */
+class PointRanking
+{
+public:
+  explicit PointRanking(size_t maxPhraseLength);
+
+  AlignmentPoint Rank(AlignmentPoint point) const {
+    return m_rank[point];
+  }
+
+  AlignmentPoint InverseRank(AlignmentPoint point) const {
+    return m_inverseRank[point];
+  }
+
+private:
+  vector<AlignmentPoint> m_rank, m_inverseRank;
+};
+
+struct StringIndexLess {
+  explicit StringIndexLess(const vector<string> &text) : m_text(text) {}
+  bool operator()(ID a, ID b) const {
+    return m_text[a] < m_text[b];
+  }
+  const vector<string> &m_text;
+};
+
+PointRanking::PointRanking(size_t maxPhraseLength) : m_rank(1 << 16), m_inverseRank(1 << 16)
+{
+  vector<AlignmentPoint> points;
+  vector<string> text, inverseText;
+  for (size_t s = 0; s < maxPhraseLength; ++s) {
+    for (size_t t = 0; t < maxPhraseLength; ++t) {
+      points.push_back(static_cast<AlignmentPoint>((s << 8) | t));
+      ostringstream point, inverse;
+      point << s << "-" << t << " ";
+      inverse << t << "-" << s << " ";
+      text.push_back(point.str());
+      inverseText.push_back(inverse.str());
+    }
+  }
+  Ranking order, inverseOrder;
+  order.Build(points.size(), StringIndexLess(text));
+  inverseOrder.Build(points.size(), StringIndexLess(inverseText));
+  for (size_t i = 0; i < points.size(); ++i) {
+    m_rank[points[i]] = order.rank[i];
+    m_inverseRank[points[i]] = inverseOrder.rank[i];
+  }
+}
+
+/* An extracted phrase pair with one alignment.  Records have a fixed size so
+ * util/stream can sort them: the header is followed by room for the words of
+ * two phrases of max-length, source first, and by the alignment as a bitmask
+ * with bit t * max-length + s set for the point s-t.  After Remap, words are
+ * word ranks.
+ */
+struct PairHeader {
+  float count;
+  // count(e), set once records are grouped by target phrase
+  float countE;
+  uint8_t sourceLength, targetLength;
+};
+
+class PairLayout
+{
+public:
+  explicit PairLayout(size_t maxPhraseLength)
+    : m_maxPhraseLength(maxPhraseLength),
+      m_alignmentOffset(sizeof(PairHeader) + 2 * maxPhraseLength * sizeof(ID)),
+      m_alignmentBytes((maxPhraseLength * maxPhraseLength + 7) / 8),
+      m_size((m_alignmentOffset + m_alignmentBytes + sizeof(ID) - 1) / sizeof(ID) * sizeof(ID)) {}
+
+  size_t Size() const {
+    return m_size;
+  }
+
+  static PairHeader &Header(void *record) {
+    return *static_cast<PairHeader*>(record);
+  }
+  static const PairHeader &Header(const void *record) {
+    return *static_cast<const PairHeader*>(record);
+  }
+
+  static ID *Source(void *record) {
+    return reinterpret_cast<ID*>(static_cast<uint8_t*>(record) + sizeof(PairHeader));
+  }
+  static const ID *Source(const void *record) {
+    return reinterpret_cast<const ID*>(static_cast<const uint8_t*>(record) + sizeof(PairHeader));
+  }
+
+  static ID *Target(void *record) {
+    return Source(record) + Header(record).sourceLength;
+  }
+  static const ID *Target(const void *record) {
+    return Source(record) + Header(record).sourceLength;
+  }
+
+  uint8_t *Alignment(void *record) const {
+    return static_cast<uint8_t*>(record) + m_alignmentOffset;
+  }
+  const uint8_t *Alignment(const void *record) const {
+    return static_cast<const uint8_t*>(record) + m_alignmentOffset;
+  }
+
+  size_t AlignmentBytes() const {
+    return m_alignmentBytes;
+  }
+
+  // Sets the bits of points in an alignment bitmask.
+  void EncodeAlignment(const vector<AlignmentPoint> &points, uint8_t *alignment) const {
+    memset(alignment, 0, m_alignmentBytes);
+    for (size_t i = 0; i < points.size(); ++i) {
+      size_t bit = PointTarget(points[i]) * m_maxPhraseLength + PointSource(points[i]);
+      alignment[bit >> 3] |= 1 << (bit & 7);
+    }
+  }
+
+  // The points of an alignment bitmask, ordered by target then source as
+  // score prints them.
+  void DecodeAlignment(const void *record, vector<AlignmentPoint> &points) const;
+
+  static bool SameSource(const void *a, const void *b) {
+    return Header(a).sourceLength == Header(b).sourceLength &&
+           std::equal(Source(a), Source(a) + Header(a).sourceLength, Source(b));
+  }
+
+  static bool SameTarget(const void *a, const void *b) {
+    return Header(a).targetLength == Header(b).targetLength &&
+           std::equal(Target(a), Target(a) + Header(a).targetLength, Target(b));
+  }
+
+  bool SamePair(const void *a, const void *b) const {
+    return SameSource(a, b) && SameTarget(a, b) && !memcmp(Alignment(a), Alignment(b), m_alignmentBytes);
+  }
+
+  size_t MaxPhraseLength() const {
+    return m_maxPhraseLength;
+  }
+
+private:
+  size_t m_maxPhraseLength, m_alignmentOffset, m_alignmentBytes, m_size;
+};
+
+// Walks the points of a record's alignment in the order score prints them.
+class AlignmentCursor
+{
+public:
+  AlignmentCursor(const PairLayout &layout, const void *record)
+    : m_alignment(layout.Alignment(record)), m_stride(layout.MaxPhraseLength()), m_bit(0),
+      m_end(PairLayout::Header(record).targetLength * m_stride) {}
+
+  bool Next(AlignmentPoint &point) {
+    for (; m_bit < m_end; ++m_bit) {
+      if (!m_alignment[m_bit >> 3]) {
+        // skip the rest of an empty byte
+        m_bit |= 7;
+        continue;
+      }
+      if (m_alignment[m_bit >> 3] & (1 << (m_bit & 7))) {
+        point = static_cast<AlignmentPoint>(((m_bit % m_stride) << 8) | (m_bit / m_stride));
+        ++m_bit;
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  const uint8_t *m_alignment;
+  size_t m_stride, m_bit, m_end;
+};
+
+void PairLayout::DecodeAlignment(const void *record, vector<AlignmentPoint> &points) const
+{
+  points.clear();
+  AlignmentPoint point;
+  for (AlignmentCursor cursor(*this, record); cursor.Next(point); ) points.push_back(point);
+}
+
+/* Compares phrases of word ranks the way sort compares lines that start with
+ * them and continue with " |||": a phrase that is a prefix of another is
+ * compared as if its next word were "|||".
+ */
+int ComparePhrases(const ID *a, size_t aLength, const ID *b, size_t bLength, const SeparatorRanks &separator)
+{
+  size_t common = std::min(aLength, bLength);
+  for (size_t i = 0; i < common; ++i) {
+    if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+  }
+  if (aLength < bLength) {
+    if (b[common] >= separator.high) return -1;
+    if (b[common] < separator.low) return 1;
+  } else if (bLength < aLength) {
+    if (a[common] < separator.low) return -1;
+    if (a[common] >= separator.high) return 1;
+  }
+  return 0;
+}
+
+/* Alignments end the extract line, so their text compares without a
+ * terminator.  The points are compared by their rank in extract, or in
+ * extract.inv if inverse is set.
+ */
+int CompareAlignments(const PairLayout &layout, const PointRanking &ranking, bool inverse, const void *a, const void *b)
+{
+  if (!memcmp(layout.Alignment(a), layout.Alignment(b), layout.AlignmentBytes())) return 0;
+  AlignmentCursor aCursor(layout, a), bCursor(layout, b);
+  AlignmentPoint aPoint, bPoint;
+  while (true) {
+    bool aMore = aCursor.Next(aPoint), bMore = bCursor.Next(bPoint);
+    if (!aMore || !bMore) return aMore == bMore ? 0 : (aMore ? 1 : -1);
+    if (aPoint != bPoint) {
+      AlignmentPoint aRank = inverse ? ranking.InverseRank(aPoint) : ranking.Rank(aPoint);
+      AlignmentPoint bRank = inverse ? ranking.InverseRank(bPoint) : ranking.Rank(bPoint);
+      return aRank < bRank ? -1 : 1;
+    }
+  }
+}
+
+/* Orders remapped records like the sorted extract text, by source phrase,
+ * target phrase and alignment, or like extract.inv with the target first.
+ */
+class PairOrder : public std::binary_function<const void *, const void *, bool>
+{
+public:
+  PairOrder(const PairLayout &layout, const WordRanking &source, const WordRanking &target, const PointRanking &points, bool targetFirst)
+    : m_layout(layout), m_source(source.separator), m_target(target.separator), m_points(&points), m_targetFirst(targetFirst) {}
+
+  bool operator()(const void *first, const void *second) const {
+    int order = m_targetFirst ? CompareTargets(first, second) : CompareSources(first, second);
+    if (!order) order = m_targetFirst ? CompareSources(first, second) : CompareTargets(first, second);
+    if (!order) order = CompareAlignments(m_layout, *m_points, false, first, second);
+    return order < 0;
+  }
+
+private:
+  int CompareSources(const void *first, const void *second) const {
+    return ComparePhrases(PairLayout::Source(first), PairLayout::Header(first).sourceLength,
+                          PairLayout::Source(second), PairLayout::Header(second).sourceLength, m_source);
+  }
+
+  int CompareTargets(const void *first, const void *second) const {
+    return ComparePhrases(PairLayout::Target(first), PairLayout::Header(first).targetLength,
+                          PairLayout::Target(second), PairLayout::Header(second).targetLength, m_target);
+  }
+
+  PairLayout m_layout;
+  SeparatorRanks m_source, m_target;
+  const PointRanking *m_points;
+  bool m_targetFirst;
+};
+
+// Sums counts of identical phrase pairs when merging.
+class CombineCounts
+{
+public:
+  explicit CombineCounts(const PairLayout &layout) : m_layout(layout) {}
+
+  template <class Compare> bool operator()(void *into, const void *option, const Compare &) const {
+    if (!m_layout.SamePair(into, option)) return false;
+    PairLayout::Header(into).count += PairLayout::Header(option).count;
+    return true;
+  }
+
+private:
+  PairLayout m_layout;
+};
+
+// Error and support of the lossy counter for phrase pairs of lengths from to to.
+struct LossyCountingRange {
+  size_t from, to;
+  double error, support;
+};
+
+// Parses from[-to]:error:support, the format of eppex.
+bool ParseLossyCountingRange(const string &spec, LossyCountingRange &range)
+{
+  char *end;
+  const char *at = spec.c_str();
+  range.from = strtoul(at, &end, 10);
+  range.to = range.from;
+  if (end == at) return false;
+  if (*end == '-') {
+    at = end + 1;
+    range.to = strtoul(at, &end, 10);
+    if (end == at) return false;
+  }
+  if (*end != ':') return false;
+  at = end + 1;
+  range.error = strtod(at, &end);
+  if (end == at || *end != ':') return false;
+  at = end + 1;
+  range.support = strtod(at, &end);
+  if (end == at || *end) return false;
+  return range.from >= 1 && range.from <= range.to &&
+         range.error >= 0 && (range.error == 0 || range.error < range.support);
+}
+
+/* Counts phrase pairs with a lossy counter per range of lengths, where the
+ * length of a pair is that of its longer phrase.  The ranges must cover every
+ * length up to the maximum.  Pairs are keyed by their words and alignment.
+ * As in eppex, the error bound is per pair and alignment; the threshold is
+ * applied to the sum over the alignments of a pair that were kept.
+ */
+class LossyPairCounter : boost::noncopyable
+{
+public:
+  LossyPairCounter(const vector<LossyCountingRange> &ranges, size_t maxPhraseLength);
+
+  ~LossyPairCounter();
+
+  void Add(const ID *source, size_t sourceLength, const ID *target, size_t targetLength, const vector<AlignmentPoint> &alignment) {
+    m_key.resize(2 + (sourceLength + targetLength) * sizeof(ID) + m_layout.AlignmentBytes());
+    m_key[0] = static_cast<char>(sourceLength);
+    m_key[1] = static_cast<char>(targetLength);
+    char *at = &m_key[2];
+    memcpy(at, source, sourceLength * sizeof(ID));
+    at += sourceLength * sizeof(ID);
+    memcpy(at, target, targetLength * sizeof(ID));
+    at += targetLength * sizeof(ID);
+    m_layout.EncodeAlignment(alignment, reinterpret_cast<uint8_t*>(at));
+    m_byLength[std::max(sourceLength, targetLength)]->Add(m_key);
+  }
+
+  // Writes a record, with its count, for each pair and alignment kept of the
+  // pairs that pass their threshold, and frees the counters.
+  void Emit(util::stream::Stream &out);
+
+private:
+  struct KeyHash {
+    size_t operator()(const string &key) const {
+      return util::MurmurHashNative(key.data(), key.size());
+    }
+  };
+  typedef LossyCounter<string, KeyHash> Counter;
+
+  class PairTotals;
+  class Emitter;
+
+  // each counter and the lengths it counts
+  vector<Counter*> m_counters;
+  vector<string> m_lengths;
+  vector<Counter*> m_byLength;
+  PairLayout m_layout;
+  string m_key;
+};
+
+LossyPairCounter::LossyPairCounter(const vector<LossyCountingRange> &ranges, size_t maxPhraseLength)
+  : m_byLength(maxPhraseLength + 1, static_cast<Counter*>(NULL)), m_layout(maxPhraseLength)
+{
+  for (vector<LossyCountingRange>::const_iterator range = ranges.begin(); range != ranges.end(); ++range) {
+    m_counters.push_back(new Counter(range->error, range->support));
+    ostringstream lengths;
+    lengths << range->from;
+    if (range->to != range->from) lengths << "-" << range->to;
+    m_lengths.push_back(lengths.str());
+    for (size_t length = range->from; length <= range->to && length <= maxPhraseLength; ++length) {
+      m_byLength[length] = m_counters.back();
+    }
+  }
+}
+
+LossyPairCounter::~LossyPairCounter()
+{
+  for (size_t i = 0; i < m_counters.size(); ++i) delete m_counters[i];
+}
+
+// Sums the counts of the alignments of each phrase pair.
+class LossyPairCounter::PairTotals
+{
+public:
+  void operator()(const string &key, uint64_t count) {
+    m_totals[PairOf(key)] += count;
+  }
+
+  uint64_t Total(const string &key) const {
+    return m_totals.find(PairOf(key))->second;
+  }
+
+private:
+  static StringPiece PairOf(const string &key) {
+    return StringPiece(key.data(), 2 + (static_cast<unsigned char>(key[0]) + static_cast<unsigned char>(key[1])) * sizeof(ID));
+  }
+
+  boost::unordered_map<StringPiece, uint64_t> m_totals;
+};
+
+// Writes a record for each alignment of the phrase pairs whose total passes the threshold.
+class LossyPairCounter::Emitter
+{
+public:
+  Emitter(const PairTotals &totals, double threshold, const PairLayout &layout, util::stream::Stream &out)
+    : m_totals(totals), m_threshold(threshold), m_layout(layout), m_out(out), m_records(0) {}
+
+  void operator()(const string &key, uint64_t count) {
+    if (m_totals.Total(key) < m_threshold) return;
+    void *record = m_out.Get();
+    PairHeader &header = PairLayout::Header(record);
+    header.count = static_cast<float>(count);
+    header.countE = 0;
+    header.sourceLength = static_cast<unsigned char>(key[0]);
+    header.targetLength = static_cast<unsigned char>(key[1]);
+    const char *at = key.data() + 2;
+    size_t wordBytes = (header.sourceLength + header.targetLength) * sizeof(ID);
+    memcpy(PairLayout::Source(record), at, wordBytes);
+    at += wordBytes;
+    memcpy(m_layout.Alignment(record), at, m_layout.AlignmentBytes());
+    ++m_out;
+    ++m_records;
+  }
+
+  uint64_t Records() const {
+    return m_records;
+  }
+
+private:
+  const PairTotals &m_totals;
+  const double m_threshold;
+  const PairLayout &m_layout;
+  util::stream::Stream &m_out;
+  uint64_t m_records;
+};
+
+void LossyPairCounter::Emit(util::stream::Stream &out)
+{
+  cerr << endl << "Lossy counting of phrase pairs:" << endl;
+  for (size_t i = 0; i < m_counters.size(); ++i) {
+    // The threshold applies to phrase pairs, which are what is scored, rather
+    // than to each of their alignments.
+    PairTotals totals;
+    m_counters[i]->ForEach(totals);
+    Emitter emitter(totals, m_counters[i]->Threshold(), m_layout, out);
+    m_counters[i]->ForEach(emitter);
+    cerr << "  lengths " << m_lengths[i] << ": " << m_counters[i]->Count() << " extracted, "
+         << m_counters[i]->Size() << " kept, " << emitter.Records() << " at or above "
+         << m_counters[i]->Threshold() << endl;
+    delete m_counters[i];
+    m_counters[i] = NULL;
+  }
+}
+
+// Reads the corpus and emits a record for each phrase pair, like extract does,
+// or counts them with lossy, if given, and emits the frequent ones at the end.
+class Extractor
+{
+public:
+  Extractor(const string &fileE, const string &fileF, const string &fileA, size_t maxPhraseLength,
+            WordVocab &sourceWords, WordVocab &targetWords, LossyPairCounter *lossy)
+    : m_fileE(fileE), m_fileF(fileF), m_fileA(fileA), m_maxPhraseLength(maxPhraseLength), m_layout(maxPhraseLength),
+      m_sourceWords(sourceWords), m_targetWords(targetWords), m_lossy(lossy) {}
+
+  void Run(const util::stream::ChainPosition &position);
+
+private:
+  void ExtractSentence(const SentenceAlignment &sentence, util::stream::Stream &out);
+
+  string m_fileE, m_fileF, m_fileA;
+  size_t m_maxPhraseLength;
+  PairLayout m_layout;
+  WordVocab &m_sourceWords, &m_targetWords;
+  LossyPairCounter *m_lossy;
+
+  // Scratch space reused for each sentence.
+  vector<ID> m_sourceIDs, m_targetIDs;
+  vector<PhrasePairSpan> m_phrasePairs;
+  // Absolute source position << 8 | target position within the phrase.
+  vector<uint32_t> m_points;
+  vector<AlignmentPoint> m_relative;
+};
+
+void Extractor::Run(const util::stream::ChainPosition &position)
+{
+  Moses::InputFileStream eFile(m_fileE);
+  Moses::InputFileStream fFile(m_fileF);
+  Moses::InputFileStream aFile(m_fileA);
+  vector<char> englishString(LINE_MAX_LENGTH), foreignString(LINE_MAX_LENGTH), alignmentString(LINE_MAX_LENGTH);
+  char noWeight[] = "";
+
+  util::stream::Stream out(position);
+  for (int i = 1; ; ++i) {
+    if (i % 10000 == 0) cerr << "." << flush;
+    SAFE_GETLINE(eFile, &englishString[0], LINE_MAX_LENGTH, '\n', __FILE__);
+    if (eFile.eof()) break;
+    SAFE_GETLINE(fFile, &foreignString[0], LINE_MAX_LENGTH, '\n', __FILE__);
+    SAFE_GETLINE(aFile, &alignmentString[0], LINE_MAX_LENGTH, '\n', __FILE__);
+    SentenceAlignment sentence;
+    if (sentence.create(&englishString[0], &foreignString[0], &alignmentString[0], noWeight, i, false)) {
+      ExtractSentence(sentence, out);
+    }
+  }
+  if (m_lossy) m_lossy->Emit(out);
+  out.Poison();
+}
+
+void Extractor::ExtractSentence(const SentenceAlignment &sentence, util::stream::Stream &out)
+{
+  m_sourceIDs.resize(sentence.source.size());
+  for (size_t fi = 0; fi < m_sourceIDs.size(); ++fi) m_sourceIDs[fi] = m_sourceWords.Intern(sentence.source[fi]);
+  m_targetIDs.resize(sentence.target.size());
+  for (size_t ei = 0; ei < m_targetIDs.size(); ++ei) m_targetIDs[ei] = m_targetWords.Intern(sentence.target[ei]);
+
+  m_phrasePairs.clear();
+  sentence.findConsistentPhrasePairs(m_maxPhraseLength, false, m_phrasePairs);
+  int startE = -1, endE = -1;
+  for (vector<PhrasePairSpan>::const_iterator span = m_phrasePairs.begin(); span != m_phrasePairs.end(); ++span) {
+    if (span->startE != startE || span->endE != endE) {
+      startE = span->startE;
+      endE = span->endE;
+      // Alignment points sorted by target then source, as score prints them.
+      // The source position is absolute until a source span is chosen.
+      m_points.clear();
+      for (int ei = startE; ei <= endE; ++ei) {
+        size_t begin = m_points.size();
+        for (size_t i = 0; i < sentence.alignedToT[ei].size(); ++i) {
+          m_points.push_back((static_cast<uint32_t>(sentence.alignedToT[ei][i]) << 8) | (ei - startE));
+        }
+        sort(m_points.begin() + begin, m_points.end());
+        m_points.erase(unique(m_points.begin() + begin, m_points.end()), m_points.end());
+      }
+    }
+    m_relative.resize(m_points.size());
+    for (size_t p = 0; p < m_points.size(); ++p) {
+      m_relative[p] = static_cast<AlignmentPoint>((((m_points[p] >> 8) - span->startF) << 8) | (m_points[p] & 0xff));
+    }
+    size_t sourceLength = span->endF - span->startF + 1, targetLength = endE - startE + 1;
+    if (m_lossy) {
+      m_lossy->Add(&m_sourceIDs[span->startF], sourceLength, &m_targetIDs[startE], targetLength, m_relative);
+      continue;
+    }
+    void *record = out.Get();
+    PairHeader &header = PairLayout::Header(record);
+    header.count = 1.0;
+    header.countE = 0;
+    header.sourceLength = sourceLength;
+    header.targetLength = targetLength;
+    std::copy(&m_sourceIDs[span->startF], &m_sourceIDs[span->startF] + sourceLength, PairLayout::Source(record));
+    std::copy(&m_targetIDs[startE], &m_targetIDs[startE] + targetLength, PairLayout::Target(record));
+    m_layout.EncodeAlignment(m_relative, m_layout.Alignment(record));
+    ++out;
+  }
+}
+
+// Replaces word ids with their ranks, so records sort like the extract text.
+class Remap
+{
+public:
+  Remap(const WordRanking &source, const WordRanking &target)
+    : m_source(source), m_target(target) {}
+
+  void Run(const util::stream::ChainPosition &position) {
+    for (util::stream::Stream in(position); in; ++in) {
+      void *record = in.Get();
+      const PairHeader &header = PairLayout::Header(record);
+      ID *source = PairLayout::Source(record), *target = PairLayout::Target(record);
+      for (size_t i = 0; i < header.sourceLength; ++i) source[i] = m_source.rank[source[i]];
+      for (size_t i = 0; i < header.targetLength; ++i) target[i] = m_target.rank[target[i]];
+    }
+  }
+
+private:
+  const WordRanking &m_source, &m_target;
+};
+
+/* Reads records sorted by target phrase and writes them with count(e), the
+ * total count of their target phrase, as score --Inverse counts it.  Only the
+ * records of one target phrase are held at a time.
+ */
+class TargetCounter
+{
+public:
+  explicit TargetCounter(const PairLayout &layout) : m_layout(layout) {}
+
+  void Run(util::stream::Stream &in, util::stream::Stream &out);
+
+private:
+  void Flush(util::stream::Stream &out);
+
+  const PairLayout m_layout;
+  vector<uint8_t> m_group;
+  float m_countE;
+};
+
+void TargetCounter::Run(util::stream::Stream &in, util::stream::Stream &out)
+{
+  m_countE = 0;
+  for (; in; ++in) {
+    const uint8_t *record = static_cast<const uint8_t*>(in.Get());
+    if (!m_group.empty() && !PairLayout::SameTarget(&m_group[0], record)) Flush(out);
+    m_group.insert(m_group.end(), record, record + m_layout.Size());
+    m_countE += PairLayout::Header(record).count;
+  }
+  if (!m_group.empty()) Flush(out);
+  out.Poison();
+}
+
+void TargetCounter::Flush(util::stream::Stream &out)
+{
+  for (size_t i = 0; i < m_group.size(); i += m_layout.Size(), ++out) {
+    PairLayout::Header(&m_group[i]).countE = m_countE;
+    memcpy(out.Get(), &m_group[i], m_layout.Size());
+  }
+  m_group.clear();
+  m_countE = 0;
+}
+
+// Loads lex.f2e or lex.e2f with the ids of the given vocabularies.
+void LoadLexicalTable(LexicalTable &table, const string &fileName, WordVocab &given, WordVocab &predicted)
+{
+  table.Load(fileName);
+  vector<WORD_ID> givenIds(table.GivenWords().size()), predictedIds(table.PredictedWords().size());
+  for (size_t i = 0; i < givenIds.size(); ++i) givenIds[i] = given.Intern(table.GivenWords()[i]);
+  for (size_t i = 0; i < predictedIds.size(); ++i) predictedIds[i] = predicted.Intern(table.PredictedWords()[i]);
+  table.MapWords(givenIds, predictedIds);
+}
+
+/* Reads the records sorted by source phrase and writes the consolidated
+ * phrase table, with the same scores as score, score --Inverse and
+ * consolidate without options.  Only the records of one source phrase are
+ * held at a time.
+ */
+class Scorer
+{
+public:
+  Scorer(const PairLayout &layout, const WordVocab &sourceWords, const WordVocab &targetWords,
+         const WordRanking &sourceRanking, const WordRanking &targetRanking, const PointRanking &points,
+         const LexicalTable &lexF2E, const LexicalTable &lexE2F, ID sourceNull, ID targetNull, ostream &out)
+    : m_layout(layout), m_sourceWords(sourceWords), m_targetWords(targetWords), m_sourceRanking(sourceRanking),
+      m_targetRanking(targetRanking), m_points(points), m_lexF2E(lexF2E), m_lexE2F(lexE2F),
+      m_sourceNull(sourceNull), m_targetNull(targetNull), m_out(out) {}
+
+  void Run(util::stream::Stream &in);
+
+private:
+  void ScoreSource();
+
+  void WritePair(const uint8_t *begin, const uint8_t *end, float countF);
+
+  // Whether the alignment of a comes before that of b in extract.inv.
+  bool InverseLess(const void *a, const void *b) const;
+
+  // Converts the ranks of a phrase to vocabulary ids.
+  static void Words(const ID *ranks, size_t length, const WordRanking &ranking, vector<ID> &words);
+
+  double LexDirect(const vector<AlignmentPoint> &alignment) const;
+
+  double LexInverse(const vector<AlignmentPoint> &alignment);
+
+  void WritePhrase(const vector<ID> &words, const WordVocab &vocab);
+
+  const PairLayout m_layout;
+  const WordVocab &m_sourceWords, &m_targetWords;
+  const WordRanking &m_sourceRanking, &m_targetRanking;
+  const PointRanking &m_points;
+  const LexicalTable &m_lexF2E, &m_lexE2F;
+  const ID m_sourceNull, m_targetNull;
+  ostream &m_out;
+
+  // Records of the current source phrase, in sorted order.
+  vector<uint8_t> m_records;
+
+  // Scratch space reused for each phrase pair.
+  vector<ID> m_source, m_target;
+  vector<AlignmentPoint> m_alignment, m_inverseAlignment;
+  vector<vector<size_t> > m_alignedTo;
+};
+
+void Scorer::Run(util::stream::Stream &in)
+{
+  for (size_t i = 0; in; ++in) {
+    const uint8_t *record = static_cast<const uint8_t*>(in.Get());
+    if (i % 100000 == 0) cerr << "." << flush;
+    ++i;
+    if (!m_records.empty()) {
+      uint8_t *last = &m_records[m_records.size() - m_layout.Size()];
+      if (!PairLayout::SameSource(last, record)) {
+        ScoreSource();
+        m_records.clear();
+      } else if (m_layout.SamePair(last, record)) {
+        // Sorting only combines records while merging, so equal ones may still be adjacent.
+        PairLayout::Header(last).count += PairLayout::Header(record).count;
+        continue;
+      }
+    }
+    m_records.insert(m_records.end(), record, record + m_layout.Size());
+  }
+  if (!m_records.empty()) ScoreSource();
+  cerr << endl;
+}
+
+void Scorer::ScoreSource()
+{
+  const size_t size = m_layout.Size();
+  float countF = 0;
+  for (size_t i = 0; i < m_records.size(); i += size) countF += PairLayout::Header(&m_records[i]).count;
+  const uint8_t *begin = &m_records[0], *end = begin + m_records.size();
+  while (begin != end) {
+    const uint8_t *groupEnd = begin + size;
+    while (groupEnd != end && PairLayout::SameTarget(groupEnd, begin)) groupEnd += size;
+    WritePair(begin, groupEnd, countF);
+    begin = groupEnd;
+  }
+}
+
+void Scorer::WritePair(const uint8_t *begin, const uint8_t *end, float countF)
+{
+  /* Like score, the most frequent alignment wins and ties go to the first in
+   * sorted order.  score --Inverse sorts the inverse text and breaks ties
+   * towards the last, so its choice is made separately.
+   */
+  float countEF = 0;
+  const uint8_t *best = begin, *bestInverse = begin;
+  for (const uint8_t *i = begin; i != end; i += m_layout.Size()) {
+    float count = PairLayout::Header(i).count;
+    countEF += count;
+    if (count > PairLayout::Header(best).count) best = i;
+    if (count > PairLayout::Header(bestInverse).count ||
+        (count == PairLayout::Header(bestInverse).count && InverseLess(bestInverse, i))) {
+      bestInverse = i;
+    }
+  }
+  const PairHeader &header = PairLayout::Header(begin);
+  float countE = header.countE;
+
+  Words(PairLayout::Source(begin), header.sourceLength, m_sourceRanking, m_source);
+  Words(PairLayout::Target(begin), header.targetLength, m_targetRanking, m_target);
+  m_layout.DecodeAlignment(best, m_alignment);
+  m_layout.DecodeAlignment(bestInverse, m_inverseAlignment);
+  double lexDirect = LexDirect(m_alignment);
+  double lexInverse = LexInverse(m_inverseAlignment);
+
+  WritePhrase(m_source, m_sourceWords);
+  m_out << " ||| ";
+  WritePhrase(m_target, m_targetWords);
+  m_out << " |||"
+        << " " << static_cast<float>(countEF / countE)
+        << " " << static_cast<float>(lexInverse)
+        << " " << static_cast<float>(countEF / countF)
+        << " " << static_cast<float>(lexDirect)
+        << " " << 2.718f
+        << " ||| ";
+  for (vector<AlignmentPoint>::const_iterator p = m_alignment.begin(); p != m_alignment.end(); ++p) {
+    m_out << PointSource(*p) << "-" << PointTarget(*p) << " ";
+  }
+  m_out << "||| " << countE << " " << countF << " " << countEF << "\n";
+}
+
+bool Scorer::InverseLess(const void *a, const void *b) const
+{
+  return CompareAlignments(m_layout, m_points, true, a, b) < 0;
+}
+
+void Scorer::Words(const ID *ranks, size_t length, const WordRanking &ranking, vector<ID> &words)
+{
+  words.resize(length);
+  for (size_t i = 0; i < length; ++i) words[i] = ranking.order[ranks[i]];
+}
+
+// lex(e|f): each target word is explained by the average of its aligned source words, or NULL.
+double Scorer::LexDirect(const vector<AlignmentPoint> &alignment) const
+{
+  double lexScore = 1.0;
+  vector<AlignmentPoint>::const_iterator p = alignment.begin();
+  for (size_t ti = 0; ti < m_target.size(); ++ti) {
+    if (p == alignment.end() || PointTarget(*p) != ti) {
+      lexScore *= m_lexF2E.Lookup(m_sourceNull, m_target[ti]);
+      continue;
+    }
+    double thisWordScore = 0;
+    size_t aligned = 0;
+    for (; p != alignment.end() && PointTarget(*p) == ti; ++p, ++aligned) {
+      thisWordScore += m_lexF2E.Lookup(m_source[PointSource(*p)], m_target[ti]);
+    }
+    lexScore *= thisWordScore / (double)aligned;
+  }
+  return lexScore;
+}
+
+// lex(f|e): the same with the roles of source and target swapped.
+double Scorer::LexInverse(const vector<AlignmentPoint> &alignment)
+{
+  if (m_alignedTo.size() < m_source.size()) m_alignedTo.resize(m_source.size());
+  for (size_t si = 0; si < m_source.size(); ++si) m_alignedTo[si].clear();
+  // Points are ordered by target, so each list is ascending like score's set.
+  for (vector<AlignmentPoint>::const_iterator p = alignment.begin(); p != alignment.end(); ++p) {
+    m_alignedTo[PointSource(*p)].push_back(PointTarget(*p));
+  }
+
+  double lexScore = 1.0;
+  for (size_t si = 0; si < m_source.size(); ++si) {
+    const vector<size_t> &targets = m_alignedTo[si];
+    if (targets.empty()) {
+      lexScore *= m_lexE2F.Lookup(m_targetNull, m_source[si]);
+      continue;
+    }
+    double thisWordScore = 0;
+    for (vector<size_t>::const_iterator t = targets.begin(); t != targets.end(); ++t) {
+      thisWordScore += m_lexE2F.Lookup(m_target[*t], m_source[si]);
+    }
+    lexScore *= thisWordScore / (double)targets.size();
+  }
+  return lexScore;
+}
+
+void Scorer::WritePhrase(const vector<ID> &words, const WordVocab &vocab)
+{
+  for (size_t i = 0; i < words.size(); ++i) {
+    if (i) m_out << " ";
+    m_out << vocab.Word(words[i]);
+  }
+}
+
+} // namespace
+} // namespace MosesTraining
+
+int main(int argc, char* argv[])
+{
+  cerr << "PhraseExtractScore: extract and score phrase pairs in one pass\n";
+
+  if (argc < 8) {
+    cerr << "syntax: extract-score en de align lex.f2e lex.e2f max-length phrase-table [--Temp prefix] [--SortMemory size] [--SortBlock size] [--LossyCounting length[-length]:error:support]*\n";
+    exit(1);
+  }
+  string fileNameE = argv[1];
+  string fileNameF = argv[2];
+  string fileNameA = argv[3];
+  string fileNameLexF2E = argv[4];
+  string fileNameLexE2F = argv[5];
+  size_t maxPhraseLength = atoi(argv[6]);
+  string fileNamePhraseTable = argv[7];
+  string tempPrefix = "/tmp/extract-score";
+  uint64_t sortMemory = 1ULL << 30;
+  uint64_t sortBlock = 64ULL << 20;
+  vector<LossyCountingRange> lossyCounting;
+
+  if (maxPhraseLength == 0 || maxPhraseLength >= kMaxPhraseLength) {
+    cerr << "ERROR: max-length must be between 1 and " << (kMaxPhraseLength - 1) << endl;
+    exit(1);
+  }
+  for (int i = 8; i < argc; ++i) {
+    if (strcmp(argv[i], "--Temp") == 0 && i + 1 < argc) {
+      tempPrefix = argv[++i];
+    } else if (strcmp(argv[i], "--SortMemory") == 0 && i + 1 < argc) {
+      sortMemory = util::ParseSize(argv[++i]);
+    } else if (strcmp(argv[i], "--SortBlock") == 0 && i + 1 < argc) {
+      sortBlock = util::ParseSize(argv[++i]);
+    } else if (strcmp(argv[i], "--LossyCounting") == 0 && i + 1 < argc) {
+      LossyCountingRange range;
+      if (!ParseLossyCountingRange(argv[++i], range)) {
+        cerr << "ERROR: --LossyCounting takes length[-length]:error:support, with error 0 or less than support: " << argv[i] << endl;
+        exit(1);
+      }
+      lossyCounting.push_back(range);
+    } else {
+      cerr << "ERROR: unknown option " << argv[i] << endl;
+      exit(1);
+    }
+  }
+  if (sortMemory < 4 * sortBlock) {
+    cerr << "ERROR: --SortMemory must be at least four times --SortBlock" << endl;
+    exit(1);
+  }
+
+  // An exact counter for lengths without a range would grow with the corpus.
+  for (size_t length = 1; length <= maxPhraseLength && !lossyCounting.empty(); ++length) {
+    bool covered = false;
+    for (size_t i = 0; i < lossyCounting.size(); ++i) {
+      covered |= lossyCounting[i].from <= length && length <= lossyCounting[i].to;
+    }
+    if (!covered) {
+      cerr << "ERROR: --LossyCounting ranges must cover every length from 1 to max-length, but none covers " << length << endl;
+      exit(1);
+    }
+  }
+
+  WordVocab sourceWords, targetWords;
+  boost::scoped_ptr<LossyPairCounter> lossy;
+  if (!lossyCounting.empty()) lossy.reset(new LossyPairCounter(lossyCounting, maxPhraseLength));
+  PairLayout layout(maxPhraseLength);
+  util::stream::ChainConfig chainConfig;
+  chainConfig.entry_size = layout.Size();
+  chainConfig.block_count = 2;
+  chainConfig.total_memory = 2 * sortBlock;
+
+  // Extract to a temporary file of records while interning the words.
+  util::scoped_fd extracted(util::MakeTemp(tempPrefix));
+  {
+    util::stream::Chain chain(chainConfig);
+    chain >> Extractor(fileNameE, fileNameF, fileNameA, maxPhraseLength, sourceWords, targetWords, lossy.get())
+          >> util::stream::WriteAndRecycle(extracted.get());
+  }
+  cerr << endl;
+
+  // Ranks make sorted records match sorted text.
+  WordRanking sourceRanking, targetRanking;
+  sourceRanking.Build(sourceWords);
+  targetRanking.Build(targetWords);
+  PointRanking pointRanking(maxPhraseLength);
+
+  // NULL may not have occurred in the corpus, so intern it after ranking.
+  LexicalTable lexF2E, lexE2F;
+  LoadLexicalTable(lexF2E, fileNameLexF2E, sourceWords, targetWords);
+  LoadLexicalTable(lexE2F, fileNameLexE2F, targetWords, sourceWords);
+
+  Moses::OutputFileStream phraseTable;
+  if (!phraseTable.Open(fileNamePhraseTable)) {
+    cerr << "ERROR: could not open file phrase table file " << fileNamePhraseTable << endl;
+    exit(1);
+  }
+
+  Scorer scorer(layout, sourceWords, targetWords, sourceRanking, targetRanking, pointRanking, lexF2E, lexE2F,
+                sourceWords.Intern("NULL"), targetWords.Intern("NULL"), phraseTable);
+  {
+    util::stream::SortConfig sortConfig;
+    sortConfig.temp_prefix = tempPrefix;
+    sortConfig.buffer_size = sortBlock;
+    sortConfig.total_memory = sortMemory;
+
+    // Sort by target phrase to count count(e).
+    util::stream::Chain byTarget(chainConfig);
+    byTarget >> util::stream::PRead(extracted.release(), true)
+             >> Remap(sourceRanking, targetRanking);
+    util::stream::BlockingSort(byTarget, sortConfig, PairOrder(layout, sourceRanking, targetRanking, pointRanking, true), CombineCounts(layout));
+    util::stream::Stream targetSorted;
+    byTarget >> targetSorted >> util::stream::kRecycle;
+
+    // Then by source phrase to score.
+    util::stream::Chain counted(chainConfig);
+    util::stream::Stream withCounts;
+    counted >> withCounts;
+    util::stream::Sort<PairOrder, CombineCounts> bySource(counted, sortConfig, PairOrder(layout, sourceRanking, targetRanking, pointRanking, false), CombineCounts(layout));
+    TargetCounter(layout).Run(targetSorted, withCounts);
+    counted.Wait();
+    byTarget.Wait();
+
+    util::stream::Chain scoring(chainConfig);
+    bySource.Output(scoring);
+    util::stream::Stream in;
+    scoring >> in >> util::stream::kRecycle;
+    scorer.Run(in);
+  }
+  phraseTable.Close();
+  return 0;
+}
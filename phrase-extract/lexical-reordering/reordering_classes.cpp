@@ -10,6 +10,10 @@
 
 #include "reordering_classes.h"
 
+#ifdef HAVE_CMPH
+#include "moses/TranslationModel/CompactPT/LexicalReorderingTableCreator.h"
+#endif
+
 using namespace std;
 
 ModelScore::ModelScore()
@@ -270,81 +274,80 @@ void ScorerLR::createConstSmoothing(double weight, vector<double>& smoothing) co
   }
 }
 
-void Model::score_fe(const string& f, const string& e)
+void Model::score(const vector<double>& counts_prev, const vector<double>& counts_next, string& out) const
 {
-  if (!fe)    //Make sure we do not do anything if it is not a fe model
-    return;
-  fprintf(file,"%s ||| %s ||| ",f.c_str(),e.c_str());
+  char number[64];
   //condition on the previous phrase
   if (previous) {
     vector<double> scores;
-    scorer->score(modelscore->get_scores_fe_prev(), scores);
+    scorer->score(counts_prev, scores);
     double sum = 0;
     for(size_t i=0; i<scores.size(); ++i) {
       scores[i] += smoothing_prev[i];
       sum += scores[i];
     }
     for(size_t i=0; i<scores.size(); ++i) {
-      fprintf(file,"%f ",scores[i]/sum);
+      out.append(number, snprintf(number, sizeof(number), "%f ", scores[i]/sum));
     }
-    //fprintf(file, "||| ");
   }
   //condition on the next phrase
   if (next) {
     vector<double> scores;
-    scorer->score(modelscore->get_scores_fe_next(), scores);
+    scorer->score(counts_next, scores);
     double sum = 0;
     for(size_t i=0; i<scores.size(); ++i) {
       scores[i] += smoothing_next[i];
       sum += scores[i];
     }
     for(size_t i=0; i<scores.size(); ++i) {
-      fprintf(file, "%f ", scores[i]/sum);
+      out.append(number, snprintf(number, sizeof(number), "%f ", scores[i]/sum));
     }
   }
-  fprintf(file,"\n");
+  out += '\n';
+}
+
+void Model::score_fe(const ModelScore& counts, const string& f, const string& e, string& out) const
+{
+  if (!fe)    //Make sure we do not do anything if it is not a fe model
+    return;
+  out += f;
+  out += " ||| ";
+  out += e;
+  out += " ||| ";
+  score(counts.get_scores_fe_prev(), counts.get_scores_fe_next(), out);
 }
 
-void Model::score_f(const string& f)
+void Model::score_f(const ModelScore& counts, const string& f, string& out) const
 {
   if (fe)      //Make sure we do not do anything if it is not a f model
     return;
-  fprintf(file, "%s ||| ", f.c_str());
-  //condition on the previous phrase
-  if (previous) {
-    vector<double> scores;
-    scorer->score(modelscore->get_scores_f_prev(), scores);
-    double sum = 0;
-    for(size_t i=0; i<scores.size(); ++i) {
-      scores[i] += smoothing_prev[i];
-      sum += scores[i];
-    }
-    for(size_t i=0; i<scores.size(); ++i) {
-      fprintf(file, "%f ", scores[i]/sum);
-    }
-    //fprintf(file, "||| ");
-  }
-  //condition on the next phrase
-  if (next) {
-    vector<double> scores;
-    scorer->score(modelscore->get_scores_f_next(), scores);
-    double sum = 0;
-    for(size_t i=0; i<scores.size(); ++i) {
-      scores[i] += smoothing_next[i];
-      sum += scores[i];
-    }
-    for(size_t i=0; i<scores.size(); ++i) {
-      fprintf(file, "%f ", scores[i]/sum);
+  out += f;
+  out += " ||| ";
+  score(counts.get_scores_f_prev(), counts.get_scores_f_next(), out);
+}
+
+void Model::write(const string& lines)
+{
+#ifdef HAVE_CMPH
+  if (compactTable) {
+    for(size_t begin = 0, end; begin < lines.size(); begin = end + 1) {
+      end = lines.find('\n', begin);
+      compactTable->AddLine(lines.substr(begin, end - begin));
     }
+    return;
   }
-  fprintf(file, "\n");
+#endif
+  if (!lines.empty()) gzwrite(file, lines.data(), lines.size());
 }
 
 Model::Model(ModelScore* ms, Scorer* sc, const string& dir, const string& lang, const string& fn)
   : modelscore(ms), scorer(sc), filename(fn)
 {
+#ifdef HAVE_CMPH
+  compactTable = NULL;
+#endif
 
-  file = fopen(filename.c_str(),"w");
+  file = gzopen((filename+".gz").c_str(),"wb");
   if (!file) {
     cerr << "Could not open the model output file: " << filename << endl;
     exit(1);
@@ -370,26 +373,37 @@ Model::Model(ModelScore* ms, Scorer* sc, const string& dir, const string& lang,
 
 Model::~Model()
 {
-  fclose(file);
+  if (file) gzclose(file);
   delete modelscore;
   delete scorer;
 }
 
-void Model::zipFile()
+#ifdef HAVE_CMPH
+void Model::createCompactTable(const string& tempfilePath, size_t threads)
 {
-  fclose(file);
-  file = fopen(filename.c_str(), "rb");
-  gzFile gzfile = gzopen((filename+".gz").c_str(),"wb");
-  char inbuffer[128];
-  int num_read;
-  while ((num_read = fread(inbuffer, 1, sizeof(inbuffer), file)) > 0) {
-    gzwrite(gzfile, inbuffer, num_read);
-  }
-  fclose(file);
-  gzclose(gzfile);
+  gzclose(file);
+  file = NULL;
+  remove((filename+".gz").c_str());
+  compactTable = new Moses::LexicalReorderingTableCreator(filename + ".minlexr", tempfilePath
+#ifdef WITH_THREADS
+      , 10, 16, true, 0, threads
+#endif
+      );
+}
+#endif
 
-  //Remove the unzipped file
-  remove(filename.c_str());
+void Model::close()
+{
+#ifdef HAVE_CMPH
+  if (compactTable) {
+    compactTable->Finish();
+    delete compactTable;
+    compactTable = NULL;
+    return;
+  }
+#endif
+  gzclose(file);
+  file = NULL;
 }
 
 void Model::split_config(const string& config, string& dir, string& lang, string& orient)
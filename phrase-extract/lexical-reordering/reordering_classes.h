@@ -12,8 +12,17 @@
 #include <string>
 #include <fstream>
 
+#include "zlib.h"
+
 #include "util/string_piece.hh"
 
+#ifdef HAVE_CMPH
+namespace Moses
+{
+class LexicalReorderingTableCreator;
+}
+#endif
+
 
 enum ORIENTATION {MONO, SWAP, DRIGHT, DLEFT, OTHER, NOMONO};
 
@@ -116,14 +125,19 @@ public:
 //Contains a modelscore and scorer (which can be of different model types (mslr, msd...)),
 //and file handling.
 //This class also keeps track of bidirectionality, and which language to condition on
+//Scores are formatted from the counts of any ModelScore of the same type as modelscore,
+//so that several threads can score with their own counts.
 class Model
 {
 private:
   ModelScore* modelscore;
   Scorer* scorer;
 
-  std::FILE* file;
+  gzFile file;
   std::string filename;
+#ifdef HAVE_CMPH
+  Moses::LexicalReorderingTableCreator* compactTable;
+#endif
 
   bool fe;
   bool previous;
@@ -134,6 +148,8 @@ private:
 
   static void split_config(const std::string& config, std::string& dir,
                            std::string& lang, std::string& orient);
+  void score(const std::vector<double>& counts_prev, const std::vector<double>& counts_next,
+             std::string& out) const;
 public:
   Model(ModelScore* ms, Scorer* sc, const std::string& dir,
         const std::string& lang, const std::string& fn);
@@ -141,8 +157,16 @@ public:
   static Model* createModel(ModelScore*, const std::string&, const std::string&);
   void createSmoothing(double w);
   void createConstSmoothing(double w);
-  void score_fe(const std::string& f, const std::string& e);
-  void score_f(const std::string& f);
-  void zipFile();
+  //append a line of the reordering table to out
+  void score_fe(const ModelScore& counts, const std::string& f, const std::string& e, std::string& out) const;
+  void score_f(const ModelScore& counts, const std::string& f, std::string& out) const;
+  //write lines from score_fe and score_f, in order
+  void write(const std::string& lines);
+#ifdef HAVE_CMPH
+  //write a compact table (filename.minlexr) instead of a text table; call before write
+  void createCompactTable(const std::string& tempfilePath, size_t threads);
+#endif
+  //finish the table (filename.gz, or the compact table)
+  void close();
 };
 
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -21,10 +22,15 @@
 
 #include "InputFileStream.h"
 #include "reordering_classes.h"
+#include "../OrderedBatchWriter.h"
+#include "../PhrasePairBinary.h"
+#include "moses/ThreadPool.h"
 
 using namespace std;
+using namespace MosesTraining;
 
-void split_line(const StringPiece& line, StringPiece& foreign, StringPiece& english, StringPiece& wbe, StringPiece& phrase, StringPiece& hier, float& weight);
+void split_line(const StringPiece& line, StringPiece& foreign, StringPiece& english, StringPiece& orientations, float& weight);
+void split_orientations(const StringPiece& orientations, const StringPiece& line, StringPiece& wbe, StringPiece& phrase, StringPiece& hier);
 void get_orientations(const StringPiece& pair, StringPiece& previous, StringPiece& next);
 
 class FileFormatException : public util::Exception
@@ -36,6 +42,168 @@ class FileFormatException : public util::Exception
     ~FileFormatException() throw() {}
 };
 
+// Reads extract.o lines, or the records of extract --BinaryOutput.
+class ExtractFile
+{
+  public:
+    explicit ExtractFile(const char* fileName) : m_file(fileName) {
+      if (PhrasePairReader::IsBinary(m_file)) {
+        m_binary.reset(new PhrasePairReader(m_file));
+      } else {
+        m_textFile.reset(new util::FilePiece(fileName));
+      }
+    }
+
+    // orientations is "wbe | phrase | hier" or "wbe", see split_orientations
+    bool Read(StringPiece& foreign, StringPiece& english, StringPiece& orientations, float& weight) {
+      weight = 1;
+      if (!m_binary.get()) {
+        StringPiece line;
+        try {
+          line = m_textFile->ReadLine();
+        } catch (util::EndOfFileException &e) {
+          return false;
+        }
+        split_line(line,foreign,english,orientations,weight);
+        return true;
+      }
+
+      if (!m_binary->Read(m_record)) return false;
+      UTIL_THROW_IF(m_record.labels.empty(), FileFormatException, "binary record without orientations");
+      // records are sorted, so the phrase text changes only between groups
+      if (m_record.source != m_lastSource || m_foreign.empty()) {
+        m_foreign = m_binary->SourceText(m_record.source);
+        m_lastSource = m_record.source;
+      }
+      if (m_record.target != m_lastTarget || m_english.empty()) {
+        m_english = m_binary->TargetText(m_record.target);
+        m_lastTarget = m_record.target;
+      }
+      foreign = m_foreign;
+      english = m_english;
+      orientations = m_binary->Label(m_record.labels[0]);
+      if (!m_record.counts.empty()) weight = m_record.counts[0];
+      return true;
+    }
+
+  private:
+    Moses::InputFileStream m_file;
+    auto_ptr<PhrasePairReader> m_binary;
+    auto_ptr<util::FilePiece> m_textFile;
+    PhrasePairRecord m_record;
+    vector<WORD_ID> m_lastSource, m_lastTarget;
+    string m_foreign, m_english;
+};
+
+// Consecutive lines of the extract file.  A source phrase is never split
+// between batches, so that batches can be scored independently.
+struct Batch {
+  struct PhrasePair {
+    size_t foreign;  // index in foreign
+    string english;
+    size_t end;      // its examples end here
+  };
+  struct Example {
+    size_t orientations;  // offset in orientations
+    size_t size;
+    float weight;
+  };
+
+  vector<string> foreign;
+  vector<PhrasePair> phrasePairs;
+  vector<Example> examples;
+  string orientations;
+
+  // lines of the reordering table, for each model
+  vector<string> output;
+
+  void Add(const StringPiece& f, const StringPiece& e, const StringPiece& o, float weight) {
+    if (foreign.empty() || f != foreign.back()) {
+      foreign.push_back(f.as_string());
+      AddPhrasePair(e);
+    } else if (e != phrasePairs.back().english) {
+      AddPhrasePair(e);
+    }
+    Example example;
+    example.orientations = orientations.size();
+    example.size = o.size();
+    example.weight = weight;
+    examples.push_back(example);
+    orientations.append(o.data(), o.size());
+    phrasePairs.back().end = examples.size();
+  }
+
+  // whether the next line may start a new batch
+  bool Full() const {
+    return examples.size() >= kBatchSize;
+  }
+
+  static const size_t kBatchSize = 10000;
+
+private:
+  void AddPhrasePair(const StringPiece& e) {
+    PhrasePair pair;
+    pair.foreign = foreign.size() - 1;
+    pair.english = e.as_string();
+    phrasePairs.push_back(pair);
+  }
+};
+
+// What is scored: the models and which counts (hier, phrase, wbe) they use.
+class BatchScorer
+{
+  public:
+    BatchScorer(const vector<Model*>& models, const vector<string>& modelCounts, const map<string,string>& countTypes)
+      : m_models(models), m_modelCounts(modelCounts), m_countTypes(countTypes) {}
+
+    void Score(Batch& batch) const;
+
+  private:
+    const vector<Model*>& m_models;
+    const vector<string>& m_modelCounts;
+    const map<string,string>& m_countTypes;
+};
+
+// Writes a batch to the models, once it is its turn.
+class BatchSink
+{
+  public:
+    explicit BatchSink(vector<Model*>& models) : m_models(models) {}
+
+    void operator()(Batch& batch) {
+      for (size_t i=0; i<m_models.size(); ++i) {
+        m_models[i]->write(batch.output[i]);
+      }
+    }
+
+  private:
+    vector<Model*>& m_models;
+};
+
+// Writes batches in the order of the extract file.
+typedef OrderedBatchWriter<Batch, BatchSink> BatchWriter;
+
+#ifdef WITH_THREADS
+// A batch, scored on a worker thread.
+class BatchTask : public Moses::Task
+{
+  public:
+    BatchTask(size_t id, Batch* batch, const BatchScorer& scorer, BatchWriter& writer)
+      : m_id(id), m_batch(batch), m_scorer(scorer), m_writer(writer) {}
+
+    void Run() {
+      m_scorer.Score(*m_batch);
+      m_writer.Write(m_id, m_batch);
+    }
+
+  private:
+    size_t m_id;
+    Batch* m_batch;
+    const BatchScorer& m_scorer;
+    BatchWriter& m_writer;
+};
+#endif
+
 int main(int argc, char* argv[])
 {
 
@@ -43,7 +211,11 @@ int main(int argc, char* argv[])
        << "scores lexical reordering models of several types (hierarchical, phrase-based and word-based-extraction\n";
 
   if (argc < 3) {
-    cerr << "syntax: score_reordering extractFile smoothingValue filepath (--model \"type max-orientation (specification-strings)\" )+\n";
+    cerr << "syntax: score_reordering extractFile smoothingValue filepath (--model \"type max-orientation (specification-strings)\" )+ [--SmoothWithCounts] [--Threads n]"
+#ifdef HAVE_CMPH
+         << " [--Compact [tempdir]]"
+#endif
+         << "\n";
     exit(1);
   }
 
@@ -51,22 +223,51 @@ int main(int argc, char* argv[])
   double smoothingValue = atof(argv[2]);
   string filepath = argv[3];
 
-  util::FilePiece eFile(extractFileName);
+  ExtractFile eFile(extractFileName);
 
   bool smoothWithCounts = false;
+  size_t threads = 1;
+#ifdef HAVE_CMPH
+  bool compact = false;
+  string compactTempPath;
+#endif
   map<string,ModelScore*> modelScores;
+  map<string,string> countTypes;
   vector<Model*> models;
+  vector<string> modelCounts;
   bool hier = false;
   bool phrase = false;
   bool wbe = false;
 
-  StringPiece e,f,w,p,h;
+  StringPiece e,f,o,w,p,h;
   StringPiece prev, next;
 
   int i = 4;
   while (i<argc) {
     if (strcmp(argv[i],"--SmoothWithCounts") == 0) {
       smoothWithCounts = true;
+    } else if (strcmp(argv[i],"--Threads") == 0) {
+      if (i+1 >= argc) {
+        cerr << "score: syntax error, no number of threads given to the option" << argv[i] << endl;
+        exit(1);
+      }
+#ifdef WITH_THREADS
+      threads = atoi(argv[++i]);
+      if (threads < 1) threads = 1;
+#else
+      cerr << "thread support not compiled in." << endl;
+      exit(1);
+#endif
+    } else if (strcmp(argv[i],"--Compact") == 0) {
+#ifdef HAVE_CMPH
+      compact = true;
+      if (i+1 < argc && strncmp(argv[i+1],"--",2) != 0) {
+        compactTempPath = argv[++i];
+      }
+#else
+      cerr << "compact table support (cmph) not compiled in." << endl;
+      exit(1);
+#endif
     } else if (strcmp(argv[i],"--model") == 0) {
       if (i+1 >= argc) {
         cerr << "score: syntax error, no model information provided to the option" << argv[i] << endl;
@@ -76,6 +277,7 @@ int main(int argc, char* argv[])
       string m,t;
       is >> m >> t;
       modelScores[m] = ModelScore::createModelScore(t);
+      countTypes[m] = t;
       if (m.compare("hier") == 0) {
         hier = true;
       } else if (m.compare("phrase") == 0) {
@@ -94,6 +296,7 @@ int main(int argc, char* argv[])
       //Store all models
       while (is >> config) {
         models.push_back(Model::createModel(modelScores[m],config,filepath));
+        modelCounts.push_back(m);
       }
     } else {
       cerr << "illegal option given to lexical reordering model score\n";
@@ -102,19 +305,21 @@ int main(int argc, char* argv[])
     i++;
   }
 
+#ifdef HAVE_CMPH
+  if (compact) {
+    for (size_t i=0; i<models.size(); ++i) {
+      models[i]->createCompactTable(compactTempPath, threads);
+    }
+  }
+#endif
+
   ////////////////////////////////////
   //calculate smoothing
   if (smoothWithCounts) {
-    util::FilePiece eFileForCounts(extractFileName);
-    while (true) {
-      StringPiece line;
-      try {
-        line = eFileForCounts.ReadLine();
-      } catch (util::EndOfFileException &e) {
-        break;
-      }
-      float weight = 1;
-      split_line(line,e,f,w,p,h,weight);
+    ExtractFile eFileForCounts(extractFileName);
+    float weight;
+    while (eFileForCounts.Read(e,f,o,weight)) {
+      split_orientations(o,o,w,p,h);
       if (hier) {
         get_orientations(h, prev, next);
         modelScores["hier"]->add_example(prev,next,weight);
@@ -142,75 +347,122 @@ int main(int argc, char* argv[])
   }
 
   ////////////////////////////////////
-  //calculate scores for reordering table
-  string f_current,e_current;
-  bool first = true;
+  //calculate scores for reordering table, a batch of source phrases at a time
+  BatchScorer scorer(models, modelCounts, countTypes);
+  BatchSink sink(models);
+  BatchWriter writer(sink);
+#ifdef WITH_THREADS
+  Moses::ThreadPool* pool = NULL;
+  if (threads > 1) {
+    pool = new Moses::ThreadPool(threads);
+    pool->SetQueueLimit(threads * 2);
+  }
+#endif
+  size_t batchCount = 0;
+  Batch* batch = new Batch();
+  float weight;
   while (true) {
-    StringPiece line;
-    try {
-      line = eFile.ReadLine();
-    } catch (util::EndOfFileException &e) {
-      break;
+    bool more = eFile.Read(f,e,o,weight);
+    if (!batch->examples.empty() &&
+        (!more || (batch->Full() && f != batch->foreign.back()))) {
+#ifdef WITH_THREADS
+      if (pool) {
+        pool->Submit(new BatchTask(batchCount++, batch, scorer, writer));
+      } else
+#endif
+      {
+        scorer.Score(*batch);
+        writer.Write(batchCount++, batch);
+      }
+      batch = new Batch();
     }
-    float weight = 1;
-    split_line(line,f,e,w,p,h,weight);
-
-    if (first) {
-      f_current = f.as_string(); //FIXME: Avoid the copy.
-      e_current = e.as_string();
-      first = false;
-    } else if (f.compare(f_current) != 0 || e.compare(e_current) != 0) {
-      //fe - score
-      for (size_t i=0; i<models.size(); ++i) {
-        models[i]->score_fe(f_current,e_current);
+    if (!more) break;
+    batch->Add(f,e,o,weight);
+  }
+  delete batch;
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+    delete pool;
+  }
+#endif
+
+  //Zip all files
+  for (size_t i=0; i<models.size(); ++i) {
+    models[i]->close();
+  }
+
+  return 0;
+}
+
+void BatchScorer::Score(Batch& batch) const
+{
+  // counts for this batch
+  map<string,ModelScore*> modelScores;
+  for (map<string,string>::const_iterator it = m_countTypes.begin(); it != m_countTypes.end(); ++it) {
+    modelScores[it->first] = ModelScore::createModelScore(it->second);
+  }
+  ModelScore* hier = modelScores.count("hier") ? modelScores["hier"] : NULL;
+  ModelScore* phrase = modelScores.count("phrase") ? modelScores["phrase"] : NULL;
+  ModelScore* wbe = modelScores.count("wbe") ? modelScores["wbe"] : NULL;
+  vector<const ModelScore*> counts;
+  for (size_t i=0; i<m_models.size(); ++i) {
+    counts.push_back(modelScores[m_modelCounts[i]]);
+  }
+
+  batch.output.resize(m_models.size());
+  StringPiece w,p,h,prev,next;
+  size_t example = 0;
+  for (size_t pair=0; pair<batch.phrasePairs.size(); ++pair) {
+    const Batch::PhrasePair& phrasePair = batch.phrasePairs[pair];
+    // update counts
+    for (; example < phrasePair.end; ++example) {
+      const Batch::Example& ex = batch.examples[example];
+      StringPiece o(batch.orientations.data() + ex.orientations, ex.size);
+      split_orientations(o,o,w,p,h);
+      if (hier) {
+        get_orientations(h, prev, next);
+        hier->add_example(prev,next,ex.weight);
       }
-      //reset
-      for(map<string,ModelScore*>::const_iterator it = modelScores.begin(); it != modelScores.end(); ++it) {
-        it->second->reset_fe();
+      if (phrase) {
+        get_orientations(p, prev, next);
+        phrase->add_example(prev,next,ex.weight);
       }
-
-      if (f.compare(f_current) != 0) {
-        //f - score
-        for (size_t i=0; i<models.size(); ++i) {
-          models[i]->score_f(f_current);
-        }
-        //reset
-        for(map<string,ModelScore*>::const_iterator it = modelScores.begin(); it != modelScores.end(); ++it) {
-          it->second->reset_f();
-        }
+      if (wbe) {
+        get_orientations(w, prev, next);
+        wbe->add_example(prev,next,ex.weight);
       }
-      f_current = f.as_string();
-      e_current = e.as_string();
     }
 
-    // uppdate counts
-    if (hier) {
-      get_orientations(h, prev, next);
-      modelScores["hier"]->add_example(prev,next,weight);
+    //fe - score
+    const string& f = batch.foreign[phrasePair.foreign];
+    for (size_t i=0; i<m_models.size(); ++i) {
+      m_models[i]->score_fe(*counts[i],f,phrasePair.english,batch.output[i]);
     }
-    if (phrase) {
-      get_orientations(p, prev, next);
-      modelScores["phrase"]->add_example(prev,next,weight);
+    //reset
+    for(map<string,ModelScore*>::const_iterator it = modelScores.begin(); it != modelScores.end(); ++it) {
+      it->second->reset_fe();
     }
-    if (wbe) {
-      get_orientations(w, prev, next);
-      modelScores["wbe"]->add_example(prev,next,weight);
+
+    if (pair+1 == batch.phrasePairs.size() || batch.phrasePairs[pair+1].foreign != phrasePair.foreign) {
+      //f - score
+      for (size_t i=0; i<m_models.size(); ++i) {
+        m_models[i]->score_f(*counts[i],f,batch.output[i]);
+      }
+      //reset
+      for(map<string,ModelScore*>::const_iterator it = modelScores.begin(); it != modelScores.end(); ++it) {
+        it->second->reset_f();
+      }
     }
   }
-  //Score the last phrases
-  for (size_t i=0; i<models.size(); ++i) {
-    models[i]->score_fe(f_current,e_current);
-  }
-  for (size_t i=0; i<models.size(); ++i) {
-    models[i]->score_f(f_current);
-  }
 
-  //Zip all files
-  for (size_t i=0; i<models.size(); ++i) {
-    models[i]->zipFile();
+  for(map<string,ModelScore*>::const_iterator it = modelScores.begin(); it != modelScores.end(); ++it) {
+    delete it->second;
   }
-
-  return 0;
+  batch.foreign.clear();
+  batch.phrasePairs.clear();
+  batch.examples.clear();
+  batch.orientations.clear();
 }
 
 template <class It> StringPiece
@@ -224,9 +476,7 @@ void split_line(
   const StringPiece& line,
   StringPiece& foreign,
   StringPiece& english,
-  StringPiece& wbe,
-  StringPiece& phrase,
-  StringPiece& hier,
+  StringPiece& orientations,
   float& weight)
 {
   /*Format is source ||| target ||| orientations
@@ -240,8 +490,24 @@ void split_line(
   util::TokenIter<util::MultiCharacter> pipes(line, util::MultiCharacter(" ||| "));
   foreign = GrabOrDie(pipes,line);
   english = GrabOrDie(pipes,line);
-  StringPiece next = GrabOrDie(pipes,line);
-  
+  orientations = GrabOrDie(pipes,line);
+
+  if (pipes) {
+    // read the weight
+    char* errIndex;
+    StringPiece next = *pipes++;
+    weight = static_cast<float>(strtod(next.data(), &errIndex));
+    UTIL_THROW_IF(errIndex == next.data(), FileFormatException, line.as_string());
+  }
+}
+
+void split_orientations(
+  const StringPiece& next,
+  const StringPiece& line,
+  StringPiece& wbe,
+  StringPiece& phrase,
+  StringPiece& hier)
+{
   util::TokenIter<util::MultiCharacter> singlePipe(next, util::MultiCharacter(" | "));
   wbe = GrabOrDie(singlePipe,line);
   if (singlePipe) {
@@ -251,14 +517,6 @@ void split_line(
     phrase.clear();
     hier.clear();
   }
-
-  if (pipes) {
-    // read the weight
-    char* errIndex;
-    next = *pipes++;
-    weight = static_cast<float>(strtod(next.data(), &errIndex));
-    UTIL_THROW_IF(errIndex == next.data(), FileFormatException, line.as_string());
-  }
 }
 
 void get_orientations(const StringPiece& pair, StringPiece& previous, StringPiece& next)
@@ -27,6 +27,8 @@
 #include <cstring>
 #include <set>
 #include <algorithm>
+#include <deque>
+#include <memory>
 
 #include "SafeGetline.h"
 #include "ScoreFeature.h"
@@ -34,8 +36,17 @@
 #include "domain.h"
 #include "PhraseAlignment.h"
 #include "score.h"
+#include "LexicalTable.h"
 #include "InputFileStream.h"
+#include "OrderedBatchWriter.h"
 #include "OutputFileStream.h"
+#include "PhrasePairBinary.h"
+#include "moses/ThreadPool.h"
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#endif
 
 using namespace std;
 using namespace MosesTraining;
@@ -68,15 +79,78 @@ float minCountHierarchical = 0;
 
 Vocabulary vcbT;
 Vocabulary vcbS;
+
+// --BinaryOutput; labels are unused but the writer needs a vocabulary
+PhrasePairWriter *binaryPhraseTableFile = NULL;
+Vocabulary binaryLabels;
+
+// id of NULL in the lexical translation table
+WORD_ID lexNullWord = 0;
+
+#ifdef WITH_THREADS
+// Held by worker threads while they score and write, and by the reading
+// thread when it has to grow vcbS or vcbT (see ReserveVocabulary).
+boost::shared_mutex vocabularyMutex;
+#endif
+
+// binary extract files have their own word ids, mapped to vcbS and vcbT here
+vector<WORD_ID> binarySourceIds, binaryTargetIds;
   
 } // namespace
 
 vector<string> tokenize( const char [] );
 
+// What scoring some source phrases produces: text or binary phrase pairs,
+// and count of counts for Good Turing and Kneser Ney discounting.
+struct ScoreOutput {
+  explicit ScoreOutput(ostream &text) : phraseTableFile(text), totalDistinct(0) {
+    for(int i=0; i<=COC_MAX; i++) countOfCounts[i] = 0;
+  }
+  ostream &phraseTableFile;
+  vector<PhrasePairRecord> records;
+  int countOfCounts[COC_MAX+1];
+  int totalDistinct;
+};
+
+// Scores the phrase pairs of one source phrase at a time, either right away
+// or, with --Threads, in batches on a thread pool.
+class SourcePhraseScorer
+{
+public:
+  SourcePhraseScorer(ostream &phraseTableFile, size_t threads, const ScoreFeatureManager& featureManager, const MaybeLog& maybeLog);
+
+  // Call before creating a phrase pair of up to this many words.
+  void ReserveVocabulary(size_t words);
+
+  // May take the contents of phrasePairs.
+  void Score(vector< PhraseAlignment > &phrasePairs, bool isSingleton);
+
+  // Call once after the last Score.  Waits for all batches to be written.
+  void Finish();
+
+private:
+  struct Batch;
+  class Task;
+  class BatchSink;
+  typedef OrderedBatchWriter< Batch, BatchSink > Collector;
+
+  ScoreOutput m_output;
+  const ScoreFeatureManager &m_featureManager;
+  const MaybeLog &m_maybeLog;
+#ifdef WITH_THREADS
+  Moses::ThreadPool *m_pool;
+  BatchSink *m_sink;
+  Collector *m_collector;
+  Task *m_task;
+  size_t m_taskCount;
+#endif
+};
+
 void writeCountOfCounts( const string &fileNameCountOfCounts );
-void processPhrasePairs( vector< PhraseAlignment > & , ostream &phraseTableFile, bool isSingleton, const ScoreFeatureManager& featureManager, const MaybeLog& maybeLog);
+void writeScoreOutput( ScoreOutput &output );
+void processPhrasePairs( vector< PhraseAlignment > & , ScoreOutput &output, bool isSingleton, const ScoreFeatureManager& featureManager, const MaybeLog& maybeLog);
 const PhraseAlignment &findBestAlignment(const PhraseAlignmentCollection &phrasePair );
-void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float, int, ostream &phraseTableFile, bool isSingleton, const ScoreFeatureManager& featureManager, const MaybeLog& maybeLog );
+void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float, int, ScoreOutput &output, bool isSingleton, const ScoreFeatureManager& featureManager, const MaybeLog& maybeLog );
 double computeLexicalTranslation( const PHRASE &, const PHRASE &, const PhraseAlignment & );
 double computeUnalignedPenalty( const PHRASE &, const PHRASE &, const PhraseAlignment & );
 set<string> functionWordList;
@@ -86,6 +160,8 @@ void calcNTLengthProb(const vector< PhraseAlignment* > &phrasePairs
                       , map<size_t, map<size_t, float> > &sourceProb
                       , map<size_t, map<size_t, float> > &targetProb);
 void printSourcePhrase(const PHRASE &, const PHRASE &, const PhraseAlignment &, ostream &);
+void outputPhrasePairBinary(const PHRASE &, const PHRASE &, const PhraseAlignment &, const vector<double> &, float, float, int, ScoreOutput &);
+void createPhrasePair(PhraseAlignment &, const PhrasePairRecord &, const PhrasePairReader &, int);
 void printTargetPhrase(const PHRASE &, const PHRASE &, const PhraseAlignment &, ostream &);
 
 int main(int argc, char* argv[])
@@ -95,7 +171,7 @@ int main(int argc, char* argv[])
 
   ScoreFeatureManager featureManager;
   if (argc < 4) {
-    cerr << "syntax: score extract lex phrase-table [--Inverse] [--Hierarchical] [--LogProb] [--NegLogProb] [--NoLex] [--GoodTuring] [--KneserNey] [--NoWordAlignment] [--UnalignedPenalty] [--UnalignedFunctionWordPenalty function-word-file] [--MinCountHierarchical count] [--OutputNTLengths] [--PCFG] [--UnpairedExtractFormat] [--ConditionOnTargetLHS] [--Singleton] [--CrossedNonTerm] \n";
+    cerr << "syntax: score extract lex phrase-table [--Inverse] [--Hierarchical] [--LogProb] [--NegLogProb] [--NoLex] [--GoodTuring] [--KneserNey] [--NoWordAlignment] [--UnalignedPenalty] [--UnalignedFunctionWordPenalty function-word-file] [--MinCountHierarchical count] [--OutputNTLengths] [--PCFG] [--UnpairedExtractFormat] [--ConditionOnTargetLHS] [--Singleton] [--CrossedNonTerm] [--BinaryOutput] [--Threads n] \n";
     cerr << featureManager.usage() << endl;
     exit(1);
   }
@@ -104,6 +180,8 @@ int main(int argc, char* argv[])
   string fileNamePhraseTable = argv[3];
   string fileNameCountOfCounts;
   char* fileNameFunctionWords = NULL;
+  bool binaryOutputFlag = false;
+  size_t threads = 1;
   vector<string> featureArgs; //all unknown args passed to feature manager
 
   for(int i=4; i<argc; i++) {
@@ -166,6 +244,24 @@ int main(int argc, char* argv[])
     } else if (strcmp(argv[i],"--CrossedNonTerm") == 0) {
       crossedNonTerm = true;
       cerr << "crossed non-term reordering feature\n";
+    } else if (strcmp(argv[i],"--BinaryOutput") == 0) {
+      binaryOutputFlag = true;
+      cerr << "writing binary phrase pairs\n";
+    } else if (strcmp(argv[i],"-threads") == 0 ||
+               strcmp(argv[i],"--threads") == 0 ||
+               strcmp(argv[i],"--Threads") == 0) {
+#ifdef WITH_THREADS
+      if (i+1==argc) {
+        cerr << "ERROR: specify the number of threads!\n";
+        exit(1);
+      }
+      threads = atoi(argv[++i]);
+      if (threads < 1) threads = 1;
+      cerr << "scoring with " << threads << " threads\n";
+#else
+      cerr << "thread support not compiled in." << '\n';
+      exit(1);
+#endif
     } else {
       featureArgs.push_back(argv[i]);
       ++i;
@@ -182,8 +278,10 @@ int main(int argc, char* argv[])
   if (!inverseFlag) featureManager.configure(featureArgs);
 
   // lexical translation table
-  if (lexFlag)
-    lexTable.load( fileNameLex );
+  if (lexFlag) {
+    lexTable.Load( fileNameLex, vcbS, vcbT );
+    lexNullWord = vcbS.getWordID("NULL");
+  }
 
   // function word list
   if (unalignedFWFlag)
@@ -203,6 +301,18 @@ int main(int argc, char* argv[])
   }
   istream &extractFileP = extractFile;
 
+  // binary extract files are detected, binary output is asked for;
+  // both only hold phrase-based phrase pairs
+  auto_ptr<PhrasePairReader> binaryExtractFile;
+  if (PhrasePairReader::IsBinary(extractFileP)) {
+    binaryExtractFile.reset(new PhrasePairReader(extractFileP));
+  }
+  if ((binaryExtractFile.get() || binaryOutputFlag) &&
+      (hierarchicalFlag || pcfgFlag || unpairedExtractFormatFlag || conditionOnTargetLhsFlag || outputNTLengths || featureManager.includeSentenceId())) {
+    cerr << "ERROR: binary phrase pairs only support phrase-based models without sentence ids" << endl;
+    exit(1);
+  }
+
   // output file: phrase translation table
 	ostream *phraseTableFile;
 
@@ -219,8 +329,15 @@ int main(int argc, char* argv[])
 		}
 		phraseTableFile = outputFile;
 	}
+  if (binaryOutputFlag) {
+    if (inverseFlag)
+      binaryPhraseTableFile = new PhrasePairWriter(*phraseTableFile, vcbT, vcbS, binaryLabels);
+    else
+      binaryPhraseTableFile = new PhrasePairWriter(*phraseTableFile, vcbS, vcbT, binaryLabels);
+  }
 	
   // loop through all extracted phrase translations
+  SourcePhraseScorer scorer(*phraseTableFile, threads, featureManager, maybeLogProb);
   float lastCount = 0.0f;
   float lastPcfgSum = 0.0f;
   vector< PhraseAlignment > phrasePairsWithSameF;
@@ -229,23 +346,34 @@ int main(int argc, char* argv[])
   char line[LINE_MAX_LENGTH],lastLine[LINE_MAX_LENGTH];
   lastLine[0] = '\0';
   PhraseAlignment *lastPhrasePair = NULL;
+  PhrasePairRecord record;
   while(true) {
-    if (extractFileP.eof()) break;
-    if (++i % 100000 == 0) cerr << "." << flush;
-    SAFE_GETLINE((extractFileP), line, LINE_MAX_LENGTH, '\n', __FILE__);
-    if (extractFileP.eof())	break;
-
-    // identical to last line? just add count
-    if (strcmp(line,lastLine) == 0) {
-      lastPhrasePair->count += lastCount;
-      lastPhrasePair->pcfgSum += lastPcfgSum;
-      continue;
-    }
-    strcpy( lastLine, line );
-
-    // create new phrase pair
     PhraseAlignment phrasePair;
-    phrasePair.create( line, i, featureManager.includeSentenceId());
+    if (binaryExtractFile.get()) {
+      if (!binaryExtractFile->Read(record)) break;
+      if (++i % 100000 == 0) cerr << "." << flush;
+
+      // identical records are merged by the equals() check below
+      scorer.ReserveVocabulary(record.source.size() + record.target.size());
+      createPhrasePair(phrasePair, record, *binaryExtractFile, i);
+    } else {
+      if (extractFileP.eof()) break;
+      if (++i % 100000 == 0) cerr << "." << flush;
+      SAFE_GETLINE((extractFileP), line, LINE_MAX_LENGTH, '\n', __FILE__);
+      if (extractFileP.eof())	break;
+
+      // identical to last line? just add count
+      if (strcmp(line,lastLine) == 0) {
+        lastPhrasePair->count += lastCount;
+        lastPhrasePair->pcfgSum += lastPcfgSum;
+        continue;
+      }
+      strcpy( lastLine, line );
+
+      // create new phrase pair
+      scorer.ReserveVocabulary(LINE_MAX_LENGTH / 2);
+      phrasePair.create( line, i, featureManager.includeSentenceId());
+    }
     lastCount = phrasePair.count;
     lastPcfgSum = phrasePair.pcfgSum;
 
@@ -261,7 +389,7 @@ int main(int argc, char* argv[])
     // if new source phrase, process last batch
     if (lastPhrasePair != NULL &&
         lastPhrasePair->GetSource() != phrasePair.GetSource()) {
-      processPhrasePairs( phrasePairsWithSameF, *phraseTableFile, isSingleton, featureManager, maybeLogProb );
+      scorer.Score( phrasePairsWithSameF, isSingleton );
       
       phrasePairsWithSameF.clear();
       isSingleton = false;
@@ -276,8 +404,10 @@ int main(int argc, char* argv[])
     phrasePairsWithSameF.push_back( phrasePair );
     lastPhrasePair = &phrasePairsWithSameF.back();
   }
-  processPhrasePairs( phrasePairsWithSameF, *phraseTableFile, isSingleton, featureManager, maybeLogProb );
+  scorer.Score( phrasePairsWithSameF, isSingleton );
+  scorer.Finish();
 	
+  delete binaryPhraseTableFile;
 	phraseTableFile->flush();
 	if (phraseTableFile != &cout) {
 		delete phraseTableFile;
@@ -289,6 +419,25 @@ int main(int argc, char* argv[])
   }
 }
 
+// Words of a binary extract file are looked up in vcbS and vcbT once per id.
+static WORD_ID mapBinaryWord(vector<WORD_ID> &ids, WORD_ID id, const string &word, Vocabulary &vocab)
+{
+  static const WORD_ID unmapped = (WORD_ID)-1;
+  if (id >= ids.size()) ids.resize(id + 1, unmapped);
+  if (ids[id] == unmapped) ids[id] = vocab.storeIfNew(word);
+  return ids[id];
+}
+
+void createPhrasePair(PhraseAlignment &phrasePair, const PhrasePairRecord &record, const PhrasePairReader &reader, int lineID)
+{
+  PHRASE source(record.source.size()), target(record.target.size());
+  for (size_t k = 0; k < source.size(); ++k)
+    source[k] = mapBinaryWord(binarySourceIds, record.source[k], reader.SourceWord(record.source[k]), vcbS);
+  for (size_t k = 0; k < target.size(); ++k)
+    target[k] = mapBinaryWord(binaryTargetIds, record.target[k], reader.TargetWord(record.target[k]), vcbT);
+  phrasePair.create(source, target, record.alignment, record.counts.empty() ? 1.0f : record.counts[0], lineID);
+}
+
 void writeCountOfCounts( const string &fileNameCountOfCounts )
 {
   // open file
@@ -310,7 +459,161 @@ void writeCountOfCounts( const string &fileNameCountOfCounts )
 	countOfCountsFile.Close();
 }
 
-void processPhrasePairs( vector< PhraseAlignment > &phrasePair, ostream &phraseTableFile, bool isSingleton, const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb )
+// Writes the binary records of output and adds its count of counts to the totals.
+void writeScoreOutput( ScoreOutput &output )
+{
+  for(size_t i=0; i<output.records.size(); i++) {
+    binaryPhraseTableFile->Write(output.records[i]);
+  }
+  output.records.clear();
+
+  totalDistinct += output.totalDistinct;
+  output.totalDistinct = 0;
+  for(int i=0; i<=COC_MAX; i++) {
+    countOfCounts[i] += output.countOfCounts[i];
+    output.countOfCounts[i] = 0;
+  }
+}
+
+#ifdef WITH_THREADS
+// Scored source phrases, kept until it is their turn to be written.
+struct SourcePhraseScorer::Batch {
+  Batch() : output(text) {}
+  ostringstream text;
+  ScoreOutput output;
+};
+
+// A batch of source phrases, scored on a worker thread.
+class SourcePhraseScorer::Task : public Moses::Task
+{
+public:
+  Task(size_t id, Collector &collector, const ScoreFeatureManager& featureManager, const MaybeLog& maybeLog)
+    : m_id(id), m_collector(collector), m_featureManager(featureManager), m_maybeLog(maybeLog),
+      m_size(0) {}
+
+  void Add(vector< PhraseAlignment > &phrasePairs, bool isSingleton) {
+    m_phrasePairs.push_back(vector< PhraseAlignment >());
+    m_phrasePairs.back().swap(phrasePairs);
+    m_isSingleton.push_back(isSingleton);
+    m_size += m_phrasePairs.back().size();
+  }
+
+  size_t Size() const {
+    return m_size;
+  }
+
+  void Run();
+
+private:
+  size_t m_id;
+  Collector &m_collector;
+  const ScoreFeatureManager &m_featureManager;
+  const MaybeLog &m_maybeLog;
+  deque< vector< PhraseAlignment > > m_phrasePairs;
+  vector< bool > m_isSingleton;
+  size_t m_size;
+};
+
+// Writes batches to the phrase table, in the order of the extract file.
+class SourcePhraseScorer::BatchSink
+{
+public:
+  explicit BatchSink(ostream &phraseTableFile) : m_phraseTableFile(phraseTableFile) {}
+
+  void operator()(Batch &batch) {
+    m_phraseTableFile << batch.text.str();
+    writeScoreOutput(batch.output);
+  }
+
+private:
+  ostream &m_phraseTableFile;
+};
+
+void SourcePhraseScorer::Task::Run()
+{
+  Batch *batch = new Batch();
+  // Held while writing too: binary output looks up the words it defines.
+  boost::shared_lock<boost::shared_mutex> lock(vocabularyMutex);
+  for(size_t i=0; i<m_phrasePairs.size(); i++) {
+    processPhrasePairs( m_phrasePairs[i], batch->output, m_isSingleton[i], m_featureManager, m_maybeLog );
+  }
+  m_phrasePairs.clear();
+  m_collector.Write(m_id, batch);
+}
+
+// phrase pairs per batch
+const size_t SCORE_BATCH_SIZE = 10000;
+#endif
+
+SourcePhraseScorer::SourcePhraseScorer(ostream &phraseTableFile, size_t threads, const ScoreFeatureManager& featureManager, const MaybeLog& maybeLog)
+  : m_output(phraseTableFile), m_featureManager(featureManager), m_maybeLog(maybeLog)
+{
+#ifdef WITH_THREADS
+  m_pool = NULL;
+  m_sink = NULL;
+  m_collector = NULL;
+  m_task = NULL;
+  m_taskCount = 0;
+  if (threads > 1) {
+    m_pool = new Moses::ThreadPool(threads);
+    m_pool->SetQueueLimit(threads * 2);
+    m_sink = new BatchSink(phraseTableFile);
+    m_collector = new Collector(*m_sink);
+    m_task = new Task(m_taskCount++, *m_collector, m_featureManager, m_maybeLog);
+  }
+#endif
+}
+
+void SourcePhraseScorer::ReserveVocabulary(size_t words)
+{
+#ifdef WITH_THREADS
+  if (!m_pool) return;
+  // Workers only look up words of the phrase pairs they were given, which is
+  // safe while words are appended, but not while the vocabulary moves.
+  if (vcbS.vocab.capacity() - vcbS.vocab.size() >= words &&
+      vcbT.vocab.capacity() - vcbT.vocab.size() >= words)
+    return;
+  boost::unique_lock<boost::shared_mutex> lock(vocabularyMutex);
+  vcbS.vocab.reserve(max(vcbS.vocab.capacity() * 2, vcbS.vocab.size() + words));
+  vcbT.vocab.reserve(max(vcbT.vocab.capacity() * 2, vcbT.vocab.size() + words));
+#endif
+}
+
+void SourcePhraseScorer::Score(vector< PhraseAlignment > &phrasePairs, bool isSingleton)
+{
+#ifdef WITH_THREADS
+  if (m_pool) {
+    m_task->Add(phrasePairs, isSingleton);
+    if (m_task->Size() >= SCORE_BATCH_SIZE) {
+      m_pool->Submit(m_task);
+      m_task = new Task(m_taskCount++, *m_collector, m_featureManager, m_maybeLog);
+    }
+    return;
+  }
+#endif
+  processPhrasePairs( phrasePairs, m_output, isSingleton, m_featureManager, m_maybeLog );
+  writeScoreOutput( m_output );
+}
+
+void SourcePhraseScorer::Finish()
+{
+#ifdef WITH_THREADS
+  if (m_pool) {
+    m_pool->Submit(m_task);
+    m_task = NULL;
+    m_pool->Stop(true);
+    delete m_pool;
+    m_pool = NULL;
+    delete m_collector;
+    m_collector = NULL;
+    delete m_sink;
+    m_sink = NULL;
+  }
+#endif
+  writeScoreOutput( m_output );
+}
+
+void processPhrasePairs( vector< PhraseAlignment > &phrasePair, ScoreOutput &output, bool isSingleton, const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb )
 {
   if (phrasePair.size() == 0) return;
 
@@ -351,7 +654,7 @@ void processPhrasePairs( vector< PhraseAlignment > &phrasePair, ostream &phraseT
   for(iter = sortedColl.begin(); iter != sortedColl.end(); ++iter) 
   {
     const PhraseAlignmentCollection &group = **iter;
-    outputPhrasePair( group, totalSource, phrasePairGroup.GetSize(), phraseTableFile, isSingleton, featureManager, maybeLogProb );
+    outputPhrasePair( group, totalSource, phrasePairGroup.GetSize(), output, isSingleton, featureManager, maybeLogProb );
   }
   
 }
@@ -522,11 +825,13 @@ int calcCrossedNonTerm(const PHRASE &phraseS, const PhraseAlignment &bestAlignme
   return 0;
 }
 
-void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCount, int distinctCount, ostream &phraseTableFile, bool isSingleton, const ScoreFeatureManager& featureManager,
+void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCount, int distinctCount, ScoreOutput &output, bool isSingleton, const ScoreFeatureManager& featureManager,
   const MaybeLog& maybeLogProb )
 {
   if (phrasePair.size() == 0) return;
 
+  ostream &phraseTableFile = output.phraseTableFile;
+
   const PhraseAlignment &bestAlignment = findBestAlignment( phrasePair );
     
   // compute count
@@ -539,10 +844,10 @@ void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCo
 
   // collect count of count statistics
   if (goodTuringFlag || kneserNeyFlag) {
-    totalDistinct++;
+    output.totalDistinct++;
     int countInt = count + 0.99999;
     if(countInt <= COC_MAX)
-      countOfCounts[ countInt ]++;
+      output.countOfCounts[ countInt ]++;
   }
 
   // compute PCFG score
@@ -567,51 +872,37 @@ void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCo
     }
   }
 
-  // source phrase (unless inverse)
-  if (! inverseFlag) {
-    printSourcePhrase(phraseS, phraseT, bestAlignment, phraseTableFile);
-    phraseTableFile << " ||| ";
-  }
-
-  // target phrase
-  printTargetPhrase(phraseS, phraseT, bestAlignment, phraseTableFile);
-  phraseTableFile << " ||| ";
-
-  // source phrase (if inverse)
-  if (inverseFlag) {
-    printSourcePhrase(phraseS, phraseT, bestAlignment, phraseTableFile);
-    phraseTableFile << " ||| ";
-  }
-
   // lexical translation probability
+  // (double, so the text is printed exactly as each score was computed)
+  vector<double> denseScores;
   if (lexFlag) {
     double lexScore = computeLexicalTranslation( phraseS, phraseT, bestAlignment);
-    phraseTableFile << maybeLogProb(lexScore );
+    denseScores.push_back(maybeLogProb(lexScore ));
   }
 
   // unaligned word penalty
   if (unalignedFlag) {
     double penalty = computeUnalignedPenalty( phraseS, phraseT, bestAlignment);
-    phraseTableFile << " " << maybeLogProb(penalty );
+    denseScores.push_back(maybeLogProb(penalty ));
   }
 
   // unaligned function word penalty
   if (unalignedFWFlag) {
     double penalty = computeUnalignedFWPenalty( phraseS, phraseT, bestAlignment);
-    phraseTableFile << " " << maybeLogProb(penalty );
+    denseScores.push_back(maybeLogProb(penalty ));
   }
 
   if (singletonFeature) {
-    phraseTableFile << " " << (isSingleton ? 1 : 0);
+    denseScores.push_back(isSingleton ? 1 : 0);
   }
   
   if (crossedNonTerm && !inverseFlag) {
-    phraseTableFile << " " << calcCrossedNonTerm(phraseS, bestAlignment);
+    denseScores.push_back(calcCrossedNonTerm(phraseS, bestAlignment));
   }
   
   // target-side PCFG score
   if (pcfgFlag && !inverseFlag) {
-    phraseTableFile << " " << maybeLogProb(pcfgScore );
+    denseScores.push_back(maybeLogProb(pcfgScore ));
   }
 
   // extra features
@@ -619,8 +910,37 @@ void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCo
   vector<float> extraDense;
   map<string,float> extraSparse;
   featureManager.addFeatures(context, extraDense, extraSparse);
-  for (size_t i = 0; i < extraDense.size(); ++i) {
-    phraseTableFile << " " << extraDense[i];
+  denseScores.insert(denseScores.end(), extraDense.begin(), extraDense.end());
+
+  if (binaryPhraseTableFile) {
+    if (!extraSparse.empty()) {
+      cerr << "ERROR: sparse features can not be written with --BinaryOutput" << endl;
+      exit(1);
+    }
+    outputPhrasePairBinary(phraseS, phraseT, bestAlignment, denseScores, totalCount, count, distinctCount, output);
+    return;
+  }
+
+  // source phrase (unless inverse)
+  if (! inverseFlag) {
+    printSourcePhrase(phraseS, phraseT, bestAlignment, phraseTableFile);
+    phraseTableFile << " ||| ";
+  }
+
+  // target phrase
+  printTargetPhrase(phraseS, phraseT, bestAlignment, phraseTableFile);
+  phraseTableFile << " ||| ";
+
+  // source phrase (if inverse)
+  if (inverseFlag) {
+    printSourcePhrase(phraseS, phraseT, bestAlignment, phraseTableFile);
+    phraseTableFile << " ||| ";
+  }
+
+  // scores, with no space before the lexical probability
+  for (size_t i = 0; i < denseScores.size(); ++i) {
+    if (i > 0 || !lexFlag) phraseTableFile << " ";
+    phraseTableFile << denseScores[i];
   }
 
   for (map<string,float>::const_iterator i = extraSparse.begin();
@@ -703,6 +1023,29 @@ void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCo
   phraseTableFile << endl;
 }
 
+// Same fields as the text line: phrases in output order, word alignment (not
+// in inverse mode), scores, and total count, count and distinct count.
+void outputPhrasePairBinary(const PHRASE &phraseS, const PHRASE &phraseT, const PhraseAlignment &bestAlignment, const vector<double> &scores, float totalCount, float count, int distinctCount, ScoreOutput &output)
+{
+  output.records.push_back(PhrasePairRecord());
+  PhrasePairRecord &binaryRecord = output.records.back();
+  binaryRecord.source = inverseFlag ? phraseT : phraseS;
+  binaryRecord.target = inverseFlag ? phraseS : phraseT;
+  if (!inverseFlag && wordAlignmentFlag) {
+    for(size_t j=0; j<bestAlignment.alignedToT.size(); j++) {
+      const set< size_t > &aligned = bestAlignment.alignedToT[j];
+      for (set< size_t >::const_iterator p(aligned.begin()); p != aligned.end(); ++p) {
+        binaryRecord.alignment.push_back(make_pair(*p, j));
+      }
+    }
+  }
+  binaryRecord.scores.assign(scores.begin(), scores.end());
+  binaryRecord.counts.push_back(totalCount);
+  binaryRecord.counts.push_back(count);
+  if (kneserNeyFlag)
+    binaryRecord.counts.push_back(distinctCount);
+}
+
 double computeUnalignedPenalty( const PHRASE &phraseS, const PHRASE &phraseT, const PhraseAlignment &alignment )
 {
   // unaligned word counter
@@ -760,18 +1103,18 @@ double computeLexicalTranslation( const PHRASE &phraseS, const PHRASE &phraseT,
 {
   // lexical translation probability
   double lexScore = 1.0;
-  int null = vcbS.getWordID("NULL");
+  int null = lexNullWord;
   // all target words have to be explained
   for(size_t ti=0; ti<alignment.alignedToT.size(); ti++) {
     const set< size_t > & srcIndices = alignment.alignedToT[ ti ];
     if (srcIndices.empty()) {
       // explain unaligned word by NULL
-      lexScore *= lexTable.permissiveLookup( null, phraseT[ ti ] );
+      lexScore *= lexTable.Lookup( null, phraseT[ ti ] );
     } else {
       // go through all the aligned words to compute average
       double thisWordScore = 0;
       for (set< size_t >::const_iterator p(srcIndices.begin()); p != srcIndices.end(); ++p) {
-        thisWordScore += lexTable.permissiveLookup( phraseS[ *p ], phraseT[ ti ] );
+        thisWordScore += lexTable.Lookup( phraseS[ *p ], phraseT[ ti ] );
       }
       lexScore *= thisWordScore / (double)srcIndices.size();
     }
@@ -779,42 +1122,6 @@ double computeLexicalTranslation( const PHRASE &phraseS, const PHRASE &phraseT,
   return lexScore;
 }
 
-void LexicalTable::load( const string &fileName )
-{
-  cerr << "Loading lexical translation table from " << fileName;
-  ifstream inFile;
-  inFile.open(fileName.c_str());
-  if (inFile.fail()) {
-    cerr << " - ERROR: could not open file\n";
-    exit(1);
-  }
-  istream *inFileP = &inFile;
-
-  char line[LINE_MAX_LENGTH];
-
-  int i=0;
-  while(true) {
-    i++;
-    if (i%100000 == 0) cerr << "." << flush;
-    SAFE_GETLINE((*inFileP), line, LINE_MAX_LENGTH, '\n', __FILE__);
-    if (inFileP->eof()) break;
-
-    vector<string> token = tokenize( line );
-    if (token.size() != 3) {
-      cerr << "line " << i << " in " << fileName
-           << " has wrong number of tokens, skipping:\n"
-           << token.size() << " " << token[0] << " " << line << endl;
-      continue;
-    }
-
-    double prob = atof( token[2].c_str() );
-    WORD_ID wordT = vcbT.storeIfNew( token[0] );
-    WORD_ID wordS = vcbS.storeIfNew( token[1] );
-    ltable[ wordS ][ wordT ] = prob;
-  }
-  cerr << endl;
-}
-
 void printSourcePhrase(const PHRASE &phraseS, const PHRASE &phraseT,
                        const PhraseAlignment &bestAlignment, ostream &out)
 {
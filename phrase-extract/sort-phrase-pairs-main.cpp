@@ -0,0 +1,393 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2013 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+/* Sorts binary phrase pair files, which LC_ALL=C sort cannot do, and merges
+ * several of them (e.g. the parts written by extract-parallel) into one.
+ * Records are ordered by source phrase, target phrase, alignment and labels.
+ * Phrases compare word by word as text, with a phrase before any longer
+ * phrase it is a prefix of, so files sorted separately line up for
+ * consolidate.  Records that do not fit in --Memory are sorted in runs that
+ * are merged from temporary files.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/iostreams/device/file_descriptor.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "util/file.hh"
+#include "util/usage.hh"
+
+#include "InputFileStream.h"
+#include "OutputFileStream.h"
+#include "PhrasePairBinary.h"
+#include "tables-core.h"
+
+using namespace std;
+using namespace MosesTraining;
+
+namespace
+{
+
+enum { SOURCE, TARGET, LABEL, VOCAB_COUNT };
+
+// Fields of a record, whether packed in memory or read back from a run.
+struct RecordView {
+  const uint32_t *begin[VOCAB_COUNT], *end[VOCAB_COUNT];
+  const uint32_t *alignment, *alignmentEnd;
+};
+
+// Position of each word when the vocabulary is sorted as text.
+class Ranks
+{
+public:
+  void Build(const Vocabulary (&vocab)[VOCAB_COUNT]) {
+    for (size_t v = 0; v < VOCAB_COUNT; ++v) {
+      const vector<string> &words = vocab[v].vocab;
+      vector<uint32_t> order(words.size());
+      for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+      sort(order.begin(), order.end(), WordLess(words));
+      m_rank[v].resize(order.size());
+      for (uint32_t i = 0; i < order.size(); ++i) m_rank[v][order[i]] = i;
+    }
+  }
+
+  bool operator()(const RecordView &a, const RecordView &b) const {
+    return Compare(a, b) < 0;
+  }
+
+  int Compare(const RecordView &a, const RecordView &b) const {
+    int ret;
+    if ((ret = CompareWords(a, b, SOURCE))) return ret;
+    if ((ret = CompareWords(a, b, TARGET))) return ret;
+    if ((ret = CompareIds(a.alignment, a.alignmentEnd, b.alignment, b.alignmentEnd, NULL))) return ret;
+    return CompareWords(a, b, LABEL);
+  }
+
+private:
+  struct WordLess {
+    explicit WordLess(const vector<string> &words) : m_words(words) {}
+    bool operator()(uint32_t a, uint32_t b) const {
+      return m_words[a] < m_words[b];
+    }
+    const vector<string> &m_words;
+  };
+
+  int CompareWords(const RecordView &a, const RecordView &b, size_t v) const {
+    return CompareIds(a.begin[v], a.end[v], b.begin[v], b.end[v], m_rank[v].empty() ? NULL : &m_rank[v][0]);
+  }
+
+  static int CompareIds(const uint32_t *a, const uint32_t *aEnd, const uint32_t *b, const uint32_t *bEnd, const uint32_t *rank) {
+    for (; a != aEnd && b != bEnd; ++a, ++b) {
+      if (*a == *b) continue;
+      uint32_t left = rank ? rank[*a] : *a, right = rank ? rank[*b] : *b;
+      return left < right ? -1 : 1;
+    }
+    if (a != aEnd) return 1;
+    if (b != bEnd) return -1;
+    return 0;
+  }
+
+  vector<uint32_t> m_rank[VOCAB_COUNT];
+};
+
+/* Records packed end to end as 32-bit values: the six field lengths, then
+ * source, target, alignment (source, target pairs), scores, counts and
+ * labels.  Floats are stored as their bits.
+ */
+class RecordArena
+{
+public:
+  void Add(const PhrasePairRecord &record) {
+    m_offsets.push_back(m_data.size());
+    m_data.push_back(record.source.size());
+    m_data.push_back(record.target.size());
+    m_data.push_back(record.alignment.size());
+    m_data.push_back(record.scores.size());
+    m_data.push_back(record.counts.size());
+    m_data.push_back(record.labels.size());
+    m_data.insert(m_data.end(), record.source.begin(), record.source.end());
+    m_data.insert(m_data.end(), record.target.begin(), record.target.end());
+    for (size_t i = 0; i < record.alignment.size(); ++i) {
+      m_data.push_back(record.alignment[i].first);
+      m_data.push_back(record.alignment[i].second);
+    }
+    AddFloats(record.scores);
+    AddFloats(record.counts);
+    m_data.insert(m_data.end(), record.labels.begin(), record.labels.end());
+  }
+
+  size_t Bytes() const {
+    return m_data.size() * sizeof(uint32_t) + m_offsets.size() * sizeof(size_t);
+  }
+
+  bool Empty() const {
+    return m_offsets.empty();
+  }
+
+  void Clear() {
+    m_data.clear();
+    m_offsets.clear();
+  }
+
+  void Sort(const Ranks &ranks) {
+    sort(m_offsets.begin(), m_offsets.end(), OffsetLess(*this, ranks));
+  }
+
+  void WriteAll(PhrasePairWriter &writer) const {
+    PhrasePairRecord record;
+    for (size_t i = 0; i < m_offsets.size(); ++i) {
+      Unpack(m_offsets[i], record);
+      writer.Write(record);
+    }
+  }
+
+private:
+  struct OffsetLess {
+    OffsetLess(const RecordArena &arena, const Ranks &ranks) : m_arena(arena), m_ranks(ranks) {}
+    bool operator()(size_t a, size_t b) const {
+      return m_ranks(m_arena.View(a), m_arena.View(b));
+    }
+    const RecordArena &m_arena;
+    const Ranks &m_ranks;
+  };
+
+  void AddFloats(const vector<float> &values) {
+    for (size_t i = 0; i < values.size(); ++i) {
+      uint32_t bits;
+      memcpy(&bits, &values[i], sizeof(bits));
+      m_data.push_back(bits);
+    }
+  }
+
+  RecordView View(size_t offset) const {
+    const uint32_t *length = &m_data[offset];
+    const uint32_t *at = length + 6;
+    RecordView view;
+    view.begin[SOURCE] = at;
+    view.end[SOURCE] = at += length[0];
+    view.begin[TARGET] = at;
+    view.end[TARGET] = at += length[1];
+    view.alignment = at;
+    view.alignmentEnd = at += 2 * length[2];
+    at += length[3] + length[4];
+    view.begin[LABEL] = at;
+    view.end[LABEL] = at + length[5];
+    return view;
+  }
+
+  void Unpack(size_t offset, PhrasePairRecord &record) const {
+    const uint32_t *length = &m_data[offset];
+    const uint32_t *at = length + 6;
+    record.source.assign(at, at + length[0]);
+    at += length[0];
+    record.target.assign(at, at + length[1]);
+    at += length[1];
+    record.alignment.resize(length[2]);
+    for (size_t i = 0; i < length[2]; ++i, at += 2) {
+      record.alignment[i] = make_pair(at[0], at[1]);
+    }
+    record.scores.resize(length[3]);
+    if (length[3]) memcpy(&record.scores[0], at, length[3] * sizeof(float));
+    at += length[3];
+    record.counts.resize(length[4]);
+    if (length[4]) memcpy(&record.counts[0], at, length[4] * sizeof(float));
+    at += length[4];
+    record.labels.assign(at, at + length[5]);
+  }
+
+  vector<uint32_t> m_data;
+  vector<size_t> m_offsets;
+};
+
+RecordView ViewOf(const PhrasePairRecord &record)
+{
+  RecordView view;
+  const vector<WORD_ID> *fields[VOCAB_COUNT] = {&record.source, &record.target, &record.labels};
+  for (size_t v = 0; v < VOCAB_COUNT; ++v) {
+    view.begin[v] = fields[v]->empty() ? NULL : &(*fields[v])[0];
+    view.end[v] = view.begin[v] + fields[v]->size();
+  }
+  // pair<unsigned int, unsigned int> is laid out as two consecutive values
+  view.alignment = record.alignment.empty() ? NULL : &record.alignment[0].first;
+  view.alignmentEnd = view.alignment + 2 * record.alignment.size();
+  return view;
+}
+
+// A sorted run in a temporary file.
+class Run
+{
+public:
+  explicit Run(int fd)
+    : m_stream(boost::iostreams::file_descriptor_source(fd, boost::iostreams::close_handle)),
+      m_reader(m_stream) {}
+
+  bool Next() {
+    return m_reader.Read(m_record);
+  }
+
+  const PhrasePairRecord &Record() const {
+    return m_record;
+  }
+
+private:
+  boost::iostreams::stream<boost::iostreams::file_descriptor_source> m_stream;
+  PhrasePairReader m_reader;
+  PhrasePairRecord m_record;
+};
+
+struct RunGreater {
+  explicit RunGreater(const Ranks &ranks) : m_ranks(ranks) {}
+  bool operator()(const boost::shared_ptr<Run> &a, const boost::shared_ptr<Run> &b) const {
+    return m_ranks(ViewOf(b->Record()), ViewOf(a->Record()));
+  }
+  const Ranks &m_ranks;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  cerr << "sort-phrase-pairs: sorts and merges binary phrase pair files\n";
+
+  string tempPrefix = "/tmp/sort-phrase-pairs";
+  uint64_t memory = 1ULL << 30;
+  int i = 1;
+  for (; i < argc && !strncmp(argv[i], "--", 2); ++i) {
+    if (!strcmp(argv[i], "--Temp") && i + 1 < argc) {
+      tempPrefix = argv[++i];
+    } else if (!strcmp(argv[i], "--Memory") && i + 1 < argc) {
+      memory = util::ParseSize(argv[++i]);
+    } else {
+      cerr << "ERROR: unknown option " << argv[i] << endl;
+      exit(1);
+    }
+  }
+  if (argc - i < 2) {
+    cerr << "syntax: sort-phrase-pairs [--Temp prefix] [--Memory size] output input [input ...]\n";
+    exit(1);
+  }
+  const char *fileNameOutput = argv[i++];
+
+  Vocabulary vocab[VOCAB_COUNT];
+  Ranks ranks;
+  RecordArena arena;
+  vector<int> runFiles;
+  PhrasePairRecord record;
+  size_t count = 0;
+
+  for (; i < argc; ++i) {
+    Moses::InputFileStream input(argv[i]);
+    if (input.fail()) {
+      cerr << "ERROR: could not open " << argv[i] << endl;
+      exit(1);
+    }
+    if (!PhrasePairReader::IsBinary(input)) {
+      cerr << "ERROR: " << argv[i] << " is not a binary phrase pair file" << endl;
+      exit(1);
+    }
+    PhrasePairReader reader(input);
+    // Ids of this input to ids of the merged vocabularies.
+    vector<WORD_ID> mapping[VOCAB_COUNT];
+    const WORD_ID unknown = static_cast<WORD_ID>(-1);
+    while (reader.Read(record)) {
+      if (++count % 100000 == 0) cerr << "." << flush;
+      vector<WORD_ID> *fields[VOCAB_COUNT] = {&record.source, &record.target, &record.labels};
+      for (size_t v = 0; v < VOCAB_COUNT; ++v) {
+        vector<WORD_ID> &ids = *fields[v];
+        for (size_t w = 0; w < ids.size(); ++w) {
+          if (ids[w] >= mapping[v].size()) mapping[v].resize(ids[w] + 1, unknown);
+          WORD_ID &mapped = mapping[v][ids[w]];
+          if (mapped == unknown) {
+            const string &word = v == SOURCE ? reader.SourceWord(ids[w]) : (v == TARGET ? reader.TargetWord(ids[w]) : reader.Label(ids[w]));
+            mapped = vocab[v].storeIfNew(word);
+          }
+          ids[w] = mapped;
+        }
+      }
+      arena.Add(record);
+      if (arena.Bytes() >= memory) {
+        ranks.Build(vocab);
+        arena.Sort(ranks);
+        int fd = util::MakeTemp(tempPrefix);
+        {
+          boost::iostreams::stream<boost::iostreams::file_descriptor_sink> run(fd, boost::iostreams::never_close_handle);
+          PhrasePairWriter writer(run, vocab[SOURCE], vocab[TARGET], vocab[LABEL]);
+          arena.WriteAll(writer);
+        }
+        util::SeekOrThrow(fd, 0);
+        runFiles.push_back(fd);
+        arena.Clear();
+      }
+    }
+    input.Close();
+  }
+  cerr << endl;
+
+  Moses::OutputFileStream output;
+  if (!output.Open(fileNameOutput)) {
+    cerr << "ERROR: could not open " << fileNameOutput << endl;
+    exit(1);
+  }
+  ranks.Build(vocab);
+  {
+    PhrasePairWriter writer(output, vocab[SOURCE], vocab[TARGET], vocab[LABEL]);
+    arena.Sort(ranks);
+    if (runFiles.empty()) {
+      arena.WriteAll(writer);
+    } else {
+      cerr << "merging " << runFiles.size() + !arena.Empty() << " runs" << endl;
+      // The records still in memory are the last run.
+      if (!arena.Empty()) {
+        int fd = util::MakeTemp(tempPrefix);
+        {
+          boost::iostreams::stream<boost::iostreams::file_descriptor_sink> run(fd, boost::iostreams::never_close_handle);
+          PhrasePairWriter runWriter(run, vocab[SOURCE], vocab[TARGET], vocab[LABEL]);
+          arena.WriteAll(runWriter);
+        }
+        util::SeekOrThrow(fd, 0);
+        runFiles.push_back(fd);
+        arena.Clear();
+      }
+      // Runs were written with the merged vocabularies, so their ids need no mapping.
+      priority_queue<boost::shared_ptr<Run>, vector<boost::shared_ptr<Run> >, RunGreater> queue((RunGreater(ranks)));
+      for (size_t r = 0; r < runFiles.size(); ++r) {
+        boost::shared_ptr<Run> run(new Run(runFiles[r]));
+        if (run->Next()) queue.push(run);
+      }
+      while (!queue.empty()) {
+        boost::shared_ptr<Run> top = queue.top();
+        queue.pop();
+        writer.Write(top->Record());
+        if (top->Next()) queue.push(top);
+      }
+    }
+  }
+  output.Close();
+  return 0;
+}
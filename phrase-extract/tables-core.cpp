@@ -39,7 +39,7 @@ bool isNonTerminal( const WORD &symbol ) {
 
 WORD_ID Vocabulary::storeIfNew( const WORD& word )
 {
-  map<WORD, WORD_ID>::iterator i = lookup.find( word );
+  Lookup::iterator i = lookup.find( word );
 
   if( i != lookup.end() )
     return i->second;
@@ -52,7 +52,7 @@ WORD_ID Vocabulary::storeIfNew( const WORD& word )
 
 WORD_ID Vocabulary::getWordID( const WORD& word )
 {
-  map<WORD, WORD_ID>::iterator i = lookup.find( word );
+  Lookup::iterator i = lookup.find( word );
   if( i == lookup.end() )
     return 0;
   return i->second;
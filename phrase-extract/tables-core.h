@@ -10,8 +10,11 @@
 #include <string>
 #include <queue>
 #include <map>
+#include <vector>
 #include <cmath>
 
+#include <boost/unordered_map.hpp>
+
 extern std::vector<std::string> tokenize( const char*);
 
 namespace MosesTraining
@@ -23,7 +26,8 @@ typedef unsigned int WORD_ID;
 class Vocabulary
 {
 public:
-  std::map<WORD, WORD_ID>  lookup;
+  typedef boost::unordered_map<WORD, WORD_ID> Lookup;
+  Lookup lookup;
   std::vector< WORD > vocab;
   WORD_ID storeIfNew( const WORD& );
   WORD_ID getWordID( const WORD& );
@@ -0,0 +1,60 @@
+e3 e0 e0 e0 e3 e1 e0 É e19 e1
+e0 e1 e0 e1 e0 e0 e0 e0 e9 e0 e2
+e4
+e7 e3 e0 e0 e2 e11 e0 e14 e5 e1
+e0
+e18 e0 e1 e0 e2 e0 É e0
+e1 e0 e0 e1 e0 e1 e8 e0 e0 e0 e1
+e0 e1 e1 e0 e0
+e0 e0 e1 e0 e1 e2 e0 e3 e7 e0
+e2 e0 e0 e3 e0 e3 e0
+e0 e1 e0 e8 e1 É e0 e0 e0 e10 e0 e9 e3
+e7 e0 e0 e9 e0 É e6 e0 e0 e2 e0
+e0 e14 e0 e2 e0 e0
+e0 e0 e1 e0 e0 e0 e0 e0 e3 e0 e0 e6 É
+e0 e0 e0 e0 e0 e10 e1 e2 e0 e2 e1 e1 e0
+e3 e1 e0 e0 e1 e1 e1 e1 e2 e0
+e0 e1 e2 e9 e0 e0 e0 e5 e0 e0
+e3 e0 e1 e1
+e0 e1 e3 e0 e0
+e2 É e0 e0 e0 e0 e0
+e0 e0 e3 e0 e0 e0
+e3 e0 e0 e0 e0
+e3 e0 e0 e2 e0 e0 e0 e15
+e1
+e7 e0 e1 e11 e2 e15
+e0
+e0
+e0 e0 e1 É e3 e1 e1 e0 e0
+e0 e1 e1 e0 e8 e0 e2 e6 e0 e0
+e0 e3 e2
+e0 e11 e0 e0 e0 e0 e7 e0 e1
+e0
+e0 e0 e0 e0 e0 e0 e2 e2 e5 e0 e4 e1
+e6 e1 e0 e0 e9 e1
+É e0 e0
+e2 e0 e1 e2 e0 e0 e1 e1
+e1
+e2 e2 e2 e0 e1
+e11 e24 e1 e2 e28 e1 e0 e0 e4 e0 e0
+e1 e0 e2 e0 e1 e1 e0 e0
+e0 e1 e0 e2
+e1 e3 e28 e0 e1 e8
+e1 e0 e0 e0 e0 e0
+e1
+e0 e0 e0 e20 e0 e3 e1 e0 e0 e0 e0
+É e3 e6 e0 e4 e0 e1 e0
+e26 e0 e1 e3
+e3 e4 e0 e0 e1 e2 É e0 e1 e1 e3 e0 e0
+e1 e1 e0
+e0 e3 e3 e2 É e0 e14 e0 e2 e0 e7 e0
+e0 É e0 e18 e0 e0 e2 e0
+e0 e0 e0 e1 e0 e0 e1 e0 e0 e1 e0 e21 e2 e6
+e0 e0 e0 e4 e1 e7 e0 É e0
+e2
+e0 e0 e0 e0 e0
+e1 e0 e1 e0 e1
+e0 e0 e0 e0 e1 e1 e23 e29 É e0
+e1 e1 e0 e3 e0 e0 e0 e1 e0 e0 e0 e0 e2
+e0 É e1
+e0 e0 e0 e0 e0
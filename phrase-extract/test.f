@@ -0,0 +1,60 @@
+f5 f4 f2 f0 f4 f0 f3 f0
+f2 f0 f4 f0 f16 f4 f0 f0 f7 f0
+f2
+f1 f0 f0 f1 f0 f1 f4 f0 f0 f1
+f0
+ü f1 f1 f1 f0 f0 f0 f7
+f0 f0 f0 f0 f10 f1 f0 f0 f1 f0 f0
+f1 f0 f0 f4 ü f0 f0
+f1 f1 f0 f0 f0 f3 f0 f2 f2 f1 f0
+f0 f2 f0 f0 f0 f0
+f0 f4 f7 f0 f4 f22 f0 f1 f0 f1 f0
+f0 f0 f0 f0 f1 f1 f0 f4 f1 f4 f0
+f0 f0 f0 f1
+f5 f7 f11 f1 f0 f1 f0 f2 f0 f0 f2 f0
+f2 f0 f10 f0 f0 f0 f0 f1 f0 f13 f0
+f0 f1 f0 f2 f0 ü f15 f2 f0 f0
+f3 f1 f2 f0 f0 f0 f3 f0
+f0 f10 f6 f0
+f0 f1 f1 f20
+f1 f0 f1 f2 f2 f8
+f2 f0 f0 f8 f8
+f1 f2 f0 f5 f0 f0
+f0 f2 f1 f0 f0 f1 f0 f0 f8
+f0 f0 f0
+f2 f0 f0 f0 f2 f4 f4
+f0 f1
+f0 f0
+f9 f0 f0 f0 f1 f0 f9
+f0 f0 f0 f1 f1 f0 f10 f0 f0 f0 f26
+f0 f0 f0
+f2 f0 ü f4 f4 f0 f0
+f0 f2 f1
+f14 f0 f0 f0 f0 f0 f6 f3 f0 f0
+f0 f0 f0 f3
+f0 f0 f1 f0
+f1 f3 f0 f0 f4 f1
+f0
+f0 f0 f1
+ü f0 f0 f2 f0 f0 f6 f0 f0 f0
+ü f1 f5 f0 f0 f0 f1 f0
+f0 f0 f0
+f0 f1 f0 f4 f2
+f0 f2 f0 f9 f0 f2
+f0
+f0 f1 f15 f0 f1 f12 f2 f1 f1 f0 f0
+f0 f0 f0 f1 f0 f1 f0 f2 f8 f2
+f3 f0 f0 f1 f0
+ü f5 f0 f0 f1 f3 f0 f7 f4 f4 f0 f0
+f0
+f0 f0 f2 f0 f0 f0 f0 f17 f0 f0 f3
+f14 f4 f2 f0 f0 f0
+f1 f0 f1 f0 f0 f0 f1 f1 f0 f0 f1 f0
+f25 f0 f12 f3 f0 f0 f10 f15 f0
+ü
+f0 f1 f0 f3
+f0 f0 f0 f0
+f0 f6 f0 f0 f0 f2 f1 f0 f6 f14 f0
+f7 f1 f23 f0 f6 f0 f0 f0 f0 f4 f5 f0
+f1 f0
+f0 f0 f0 f0
@@ -0,0 +1,2 @@
+#!/bin/sh
+./bjam -j8 --without-tcmalloc lm lm/builder lm/filter phrase-extract moses//moses_test mira//mira
@@ -61,6 +61,9 @@ class SingleBest {
   public:
     typedef PartialEdge Combine;
 
+    // Completed hypotheses are allocated from pool.  
+    explicit SingleBest(util::Pool &pool) : pool_(pool) {}
+
     void Add(PartialEdge &existing, PartialEdge add) const {
       if (!existing.Valid() || existing.GetScore() < add.GetScore())
         existing = add;
@@ -78,7 +81,7 @@ class SingleBest {
     }
 
   private:
-    util::Pool pool_;
+    util::Pool &pool_;
 };
 
 } // namespace search
@@ -2,6 +2,7 @@
 #define SEARCH_CONTEXT__
 
 #include "search/config.hh"
+#include "search/memory.hh"
 #include "search/vertex.hh"
 
 #include <boost/pool/object_pool.hpp>
@@ -10,7 +11,7 @@ namespace search {
 
 class ContextBase {
   public:
-    explicit ContextBase(const Config &config) : config_(config) {}
+    ContextBase(const Config &config, Memory &memory) : config_(config), memory_(memory) {}
 
     VertexNode *NewVertexNode() {
       VertexNode *ret = vertex_node_pool_.construct();
@@ -28,15 +29,19 @@ class ContextBase {
 
     const Config &GetConfig() const { return config_; }
 
+    Memory &GetMemory() { return memory_; }
+
   private:
     boost::object_pool<VertexNode> vertex_node_pool_;
 
     Config config_;
+
+    Memory &memory_;
 };
 
 template <class Model> class Context : public ContextBase {
   public:
-    Context(const Config &config, const Model &model) : ContextBase(config), model_(model) {}
+    Context(const Config &config, Memory &memory, const Model &model) : ContextBase(config, memory), model_(model) {}
 
     const Model &LanguageModel() const { return model_; }
 
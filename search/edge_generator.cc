@@ -76,7 +76,8 @@ template <class Model> PartialEdge EdgeGenerator::Pop(Context<Model> &context) {
   PartialVertex old_value(top_nt[victim]);
   PartialVertex alternate_changed;
   if (top_nt[victim].Split(alternate_changed)) {
-    PartialEdge alternate(partial_edge_pool_, arity, incomplete + 1);
+    memory_.CountEdge();
+    PartialEdge alternate(memory_.EdgePool(), arity, incomplete + 1);
     alternate.SetScore(top.GetScore() + alternate_changed.Bound() - old_value.Bound());
 
     alternate.SetNote(top.GetNote());
@@ -2,6 +2,7 @@
 #define SEARCH_EDGE_GENERATOR__
 
 #include "search/edge.hh"
+#include "search/memory.hh"
 #include "search/types.hh"
 
 #include <queue>
@@ -18,10 +19,11 @@ template <class Model> class Context;
 
 class EdgeGenerator {
   public:
-    EdgeGenerator() {}
+    explicit EdgeGenerator(Memory &memory) : memory_(memory) {}
 
     PartialEdge AllocateEdge(Arity arity) {
-      return PartialEdge(partial_edge_pool_, arity);
+      memory_.CountEdge();
+      return PartialEdge(memory_.EdgePool(), arity);
     }
 
     void AddEdge(PartialEdge edge) {
@@ -43,10 +45,13 @@ class EdgeGenerator {
         }
       }
       output.FinishedSearch();
+      // Anything left in the queue points into the edge pool.  
+      generate_ = Generate();
+      memory_.FinishedCell();
     }
 
   private:
-    util::Pool partial_edge_pool_;
+    Memory &memory_;
 
     typedef std::priority_queue<PartialEdge> Generate;
     Generate generate_;
@@ -0,0 +1,81 @@
+#ifndef SEARCH_MEMORY__
+#define SEARCH_MEMORY__
+
+#include "util/pool.hh"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace search {
+
+// What the search allocated while decoding one sentence.  
+struct MemoryStats {
+  MemoryStats() : edges(0), hypotheses(0), vertices(0), high_water(0) {}
+
+  // PartialEdges allocated by EdgeGenerator.
+  std::size_t edges;
+  // Hypotheses handed to VertexGenerator.
+  std::size_t hypotheses;
+  // Vertices completed by VertexGenerator.
+  std::size_t vertices;
+  // Most pool memory in use at any one time, in bytes.
+  std::size_t high_water;
+};
+
+// Pools that outlive a sentence.  Keep one per thread and call NewSentence
+// before decoding.  The memory is kept rather than freed so, once warmed up,
+// decoding a sentence does not go back to malloc for edges or hypotheses.  
+class Memory {
+  public:
+    Memory() {}
+
+    // Constant time.  Everything allocated for the previous sentence is gone.  
+    void NewSentence() {
+      edges_.Reset();
+      final_.Reset();
+      stats_ = MemoryStats();
+    }
+
+    // Partial edges only live while a cell is being searched.  
+    util::Pool &EdgePool() { return edges_; }
+
+    // Completed hypotheses live until the sentence has been output.  
+    util::Pool &FinalPool() { return final_; }
+
+    void CountEdge() { ++stats_.edges; }
+    void CountHypothesis() { ++stats_.hypotheses; }
+    void CountVertices(std::size_t count) { stats_.vertices += count; }
+
+    // Edges from this cell are no longer needed.  
+    void FinishedCell() {
+      RecordHighWater();
+      edges_.Reset();
+    }
+
+    MemoryStats Stats() const {
+      MemoryStats ret(stats_);
+      ret.high_water = std::max(ret.high_water, InUse());
+      return ret;
+    }
+
+  private:
+    std::size_t InUse() const {
+      return edges_.Used() + final_.Used();
+    }
+
+    void RecordHighWater() {
+      stats_.high_water = std::max(stats_.high_water, InUse());
+    }
+
+    util::Pool edges_, final_;
+
+    MemoryStats stats_;
+
+    // no copying
+    Memory(const Memory &);
+    Memory &operator=(const Memory &);
+};
+
+} // namespace search
+
+#endif // SEARCH_MEMORY__
@@ -37,6 +37,13 @@ const std::vector<Applied> &NBestList::Extract(util::Pool &pool, std::size_t n)
   return revealed_;
 }
 
+Applied NBestList::Nth(util::Pool &pool, std::size_t index) {
+  while (revealed_.size() <= index && !queue_.empty()) {
+    MoveTop(pool);
+  }
+  return index < revealed_.size() ? revealed_[index] : Applied();
+}
+
 Score NBestList::Visit(util::Pool &pool, std::size_t index) {
   if (index + 1 < revealed_.size())
     return revealed_[index + 1].GetScore() - revealed_[index].GetScore();
@@ -58,6 +65,9 @@ Applied NBestList::Get(util::Pool &pool, std::size_t index) {
   return revealed_[index];
 }
 
+// Lazy k-best: Huang and Chiang, Better k-best Parsing, IWPT 2005, algorithm 3.
+// Successors only advance children up to the first one with a non-zero index,
+// which makes the duplicate check of the original unnecessary.  
 void NBestList::MoveTop(util::Pool &pool) {
   assert(!queue_.empty());
   QueueEntry entry(queue_.top());
@@ -103,4 +113,8 @@ const std::vector<Applied> &NBest::Extract(History history) {
   return static_cast<NBestList*>(history)->Extract(entry_pool_, config_.size);
 }
 
+Applied NBest::Nth(History history, std::size_t index) {
+  return static_cast<NBestList*>(history)->Nth(entry_pool_, index);
+}
+
 } // namespace search
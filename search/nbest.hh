@@ -40,6 +40,10 @@ class NBestList {
 
     const std::vector<Applied> &Extract(util::Pool &pool, std::size_t n);
 
+    // The index-th best derivation, revealing more as needed.  Invalid if
+    // there are not that many.  
+    Applied Nth(util::Pool &pool, std::size_t index);
+
   private:
     Score Visit(util::Pool &pool, std::size_t index);
 
@@ -58,7 +62,7 @@ class NBest {
   public:
     typedef std::vector<PartialEdge> Combine;
 
-    explicit NBest(const NBestConfig &config) : config_(config) {}
+    NBest(const NBestConfig &config, util::Pool &entry_pool) : config_(config), entry_pool_(entry_pool) {}
 
     void Add(std::vector<PartialEdge> &existing, PartialEdge addition) const {
       existing.push_back(addition);
@@ -68,12 +72,15 @@ class NBest {
 
     const std::vector<Applied> &Extract(History root);
 
+    // Pull derivations from root one at a time, e.g. to skip duplicate strings.
+    Applied Nth(History root, std::size_t index);
+
   private:
     const NBestConfig config_;
 
     boost::object_pool<NBestList> list_pool_;
 
-    util::Pool entry_pool_;
+    util::Pool &entry_pool_;
 };
 
 } // namespace search
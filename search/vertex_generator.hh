@@ -1,6 +1,7 @@
 #ifndef SEARCH_VERTEX_GENERATOR__
 #define SEARCH_VERTEX_GENERATOR__
 
+#include "search/context.hh"
 #include "search/edge.hh"
 #include "search/types.hh"
 #include "search/vertex.hh"
@@ -13,18 +14,18 @@ class ChartState;
 
 namespace search {
 
-class ContextBase;
-
 // Output makes the single-best or n-best list.   
 template <class Output> class VertexGenerator {
   public:
     VertexGenerator(ContextBase &context, Vertex &gen, Output &nbest) : context_(context), gen_(gen), nbest_(nbest) {}
 
     void NewHypothesis(PartialEdge partial) {
+      context_.GetMemory().CountHypothesis();
       nbest_.Add(existing_[hash_value(partial.CompletedState())], partial);
     }
 
     void FinishedSearch() {
+      context_.GetMemory().CountVertices(existing_.size());
       gen_.root_.InitRoot();
       for (typename Existing::iterator i(existing_.begin()); i != existing_.end(); ++i) {
         gen_.root_.AppendHypothesis(nbest_.Complete(i->second));
@@ -43,6 +43,16 @@ void SyncOrThrow(void *start, size_t length) {
 #endif
 }
 
+void AdviseRandom(void *start, std::size_t size) {
+#if defined(MADV_RANDOM)
+  // Only a hint, so failure is not an error.
+  madvise(start, size, MADV_RANDOM);
+#else
+  (void)start;
+  (void)size;
+#endif
+}
+
 void UnmapOrThrow(void *start, size_t length) {
 #if defined(_WIN32) || defined(_WIN64)
   UTIL_THROW_IF(!::UnmapViewOfFile(start), ErrnoException, "Failed to unmap a file");
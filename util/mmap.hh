@@ -109,6 +109,10 @@ void *MapZeroedWrite(const char *name, std::size_t size, scoped_fd &file);
 // msync wrapper 
 void SyncOrThrow(void *start, size_t length);
 
+// Hint that a mapping will be read in random order, so faults should not read
+// ahead.  Does nothing where madvise is not available.
+void AdviseRandom(void *start, std::size_t size);
+
 } // namespace util
 
 #endif // UTIL_MMAP__
@@ -2,35 +2,68 @@
 
 #include "util/scoped.hh"
 
+#include <algorithm>
+
 #include <stdlib.h>
 
 namespace util {
 
 Pool::Pool() {
+  next_block_ = 0;
   current_ = NULL;
   current_end_ = NULL;
+  used_ = 0;
+  capacity_ = 0;
 }
 
 Pool::~Pool() {
   FreeAll();
 }
 
+void Pool::Reset() {
+  if (free_list_.empty()) return;
+  const Block &first = free_list_.front();
+  next_block_ = 1;
+  current_ = first.base;
+  current_end_ = first.base + first.size;
+  used_ = first.size;
+}
+
 void Pool::FreeAll() {
-  for (std::vector<void *>::const_iterator i(free_list_.begin()); i != free_list_.end(); ++i) {
-    free(*i);
+  for (std::vector<Block>::const_iterator i(free_list_.begin()); i != free_list_.end(); ++i) {
+    free(i->base);
   }
   free_list_.clear();
+  next_block_ = 0;
   current_ = NULL;
   current_end_ = NULL;
+  used_ = 0;
+  capacity_ = 0;
 }
 
 void *Pool::More(std::size_t size) {
+  // Blocks kept by Reset come first.  One that is too small is skipped.  
+  for (; next_block_ < free_list_.size(); ++next_block_) {
+    const Block &block = free_list_[next_block_];
+    if (block.size > size) {
+      ++next_block_;
+      current_ = block.base + size;
+      current_end_ = block.base + block.size;
+      used_ += block.size;
+      return block.base;
+    }
+  }
   std::size_t amount = std::max(static_cast<size_t>(32) << free_list_.size(), size);
-  uint8_t *ret = static_cast<uint8_t*>(MallocOrThrow(amount));
-  free_list_.push_back(ret);
-  current_ = ret + size;
-  current_end_ = ret + amount;
-  return ret;
+  Block block;
+  block.base = static_cast<uint8_t*>(MallocOrThrow(amount));
+  block.size = amount;
+  free_list_.push_back(block);
+  next_block_ = free_list_.size();
+  current_ = block.base + size;
+  current_end_ = block.base + amount;
+  used_ += amount;
+  capacity_ += amount;
+  return block.base;
 }
 
 } // namespace util
@@ -26,15 +26,36 @@ class Pool {
       }
     }
 
+    // Forget everything allocated but keep the memory for later allocations.
+    // This is constant time, so pools can be reused across sentences.  
+    void Reset();
+
     void FreeAll();
 
+    // Bytes in the blocks handed out since the last Reset or FreeAll.  This is
+    // an upper bound on what was actually allocated.  
+    std::size_t Used() const { return used_; }
+
+    // Bytes held, whether in use or kept by Reset.
+    std::size_t Capacity() const { return capacity_; }
+
   private:
     void *More(std::size_t size);
 
-    std::vector<void *> free_list_;
+    struct Block {
+      uint8_t *base;
+      std::size_t size;
+    };
+
+    std::vector<Block> free_list_;
+
+    // Index into free_list_ of the next block to reuse after a Reset.
+    std::size_t next_block_;
 
     uint8_t *current_, *current_end_;
 
+    std::size_t used_, capacity_;
+
     // no copying
     Pool(const Pool &);
     Pool &operator=(const Pool &);
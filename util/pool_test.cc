@@ -0,0 +1,49 @@
+#include "util/pool.hh"
+
+#define BOOST_TEST_MODULE PoolTest
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+
+namespace util { namespace {
+
+BOOST_AUTO_TEST_CASE(distinct) {
+  Pool pool;
+  std::set<void*> seen;
+  for (unsigned int i = 0; i < 1000; ++i) {
+    BOOST_CHECK(seen.insert(pool.Allocate(24)).second);
+  }
+  BOOST_CHECK(pool.Used() >= 24000);
+  BOOST_CHECK_EQUAL(pool.Used(), pool.Capacity());
+}
+
+BOOST_AUTO_TEST_CASE(reset_reuses) {
+  Pool pool;
+  std::set<void*> first;
+  for (unsigned int i = 0; i < 1000; ++i) {
+    first.insert(pool.Allocate(24));
+  }
+  std::size_t capacity = pool.Capacity();
+  pool.Reset();
+  BOOST_CHECK(pool.Used() < capacity);
+  for (unsigned int i = 0; i < 1000; ++i) {
+    BOOST_CHECK(first.count(pool.Allocate(24)));
+  }
+  // Same pattern after Reset needs no more memory.
+  BOOST_CHECK_EQUAL(capacity, pool.Capacity());
+}
+
+BOOST_AUTO_TEST_CASE(reset_big) {
+  Pool pool;
+  pool.Allocate(10);
+  pool.Reset();
+  // Bigger than any block kept by Reset.
+  char *big = static_cast<char*>(pool.Allocate(100000));
+  big[99999] = 1;
+  BOOST_CHECK(pool.Capacity() >= 100000);
+  pool.FreeAll();
+  BOOST_CHECK_EQUAL(0, pool.Capacity());
+  BOOST_CHECK_EQUAL(0, pool.Used());
+}
+
+}} // namespaces
@@ -0,0 +1,18 @@
+#ifndef UTIL_PREFETCH__
+#define UTIL_PREFETCH__
+
+namespace util {
+
+// Hint that memory at address will be read soon, so a later cache miss can
+// overlap with other work.  Does nothing where the compiler has no hint.
+inline void Prefetch(const void *address) {
+#if defined(__GNUC__)
+  __builtin_prefetch(address);
+#else
+  (void)address;
+#endif
+}
+
+} // namespace util
+
+#endif // UTIL_PREFETCH__
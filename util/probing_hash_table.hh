@@ -2,6 +2,7 @@
 #define UTIL_PROBING_HASH_TABLE__
 
 #include "util/exception.hh"
+#include "util/prefetch.hh"
 
 #include <algorithm>
 #include <cstddef>
@@ -112,6 +113,11 @@ template <class EntryT, class HashT, class EqualT = std::equal_to<typename Entry
       }   
     }
 
+    // Start loading the bucket where a Find for key will begin.
+    template <class Key> void Prefetch(const Key key) const {
+      util::Prefetch(begin_ + (hash_(key) % buckets_));
+    }
+
     template <class Key> bool Find(const Key key, ConstIterator &out) const {
 #ifdef DEBUG
       assert(initialized_);